@@ -9,6 +9,7 @@
 #include "math_utils.h"
 #include "index.h"
 #include "partition.h"
+#include "huge_page_allocator.h"
 #include "program_options_utils.hpp"
 
 namespace po = boost::program_options;
@@ -16,11 +17,12 @@ namespace po = boost::program_options;
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, data_path, index_path_prefix, codebook_prefix, label_file, universal_label,
-        label_type;
-    uint32_t num_threads, R, L, disk_PQ, build_PQ, QD, Lf, filter_threshold;
+        label_type, huge_pages, numa;
+    uint32_t num_threads, R, L, disk_PQ, build_PQ, QD, Lf, filter_threshold, PQ_bits;
     float B, M;
     bool append_reorder_data = false;
     bool use_opq = false;
+    bool locality_layout = false;
 
     po::options_description desc{
         program_options_utils::make_program_description("build_disk_index", "Build a disk-based index.")};
@@ -55,6 +57,10 @@ int main(int argc, char **argv)
                                        program_options_utils::GRAPH_BUILD_COMPLEXITY);
         optional_configs.add_options()("QD", po::value<uint32_t>(&QD)->default_value(0),
                                        " Quantized Dimension for compression");
+        optional_configs.add_options()("PQ_bits", po::value<uint32_t>(&PQ_bits)->default_value(8),
+                                       "Bits per chunk of the in-memory PQ codes used during search, 8 or 4. "
+                                       "4-bit codes take two chunks per byte of the search_DRAM_budget and are "
+                                       "scanned with SIMD lookup tables.");
         optional_configs.add_options()("codebook_prefix", po::value<std::string>(&codebook_prefix)->default_value(""),
                                        "Path prefix for pre-trained codebook");
         optional_configs.add_options()("PQ_disk_bytes", po::value<uint32_t>(&disk_PQ)->default_value(0),
@@ -63,6 +69,10 @@ int main(int argc, char **argv)
         optional_configs.add_options()("append_reorder_data", po::bool_switch()->default_value(false),
                                        "Include full precision data in the index. Use only in "
                                        "conjuction with compressed data on SSD.");
+        optional_configs.add_options()("locality_layout", po::bool_switch()->default_value(false),
+                                       "Place nodes that are close in the graph in the same disk sector, so that "
+                                       "one read brings in useful neighbours. Needs RAM for the whole graph while "
+                                       "writing the disk layout.");
         optional_configs.add_options()("build_PQ_bytes", po::value<uint32_t>(&build_PQ)->default_value(0),
                                        program_options_utils::BUIlD_GRAPH_PQ_BYTES);
         optional_configs.add_options()("use_opq", po::bool_switch()->default_value(false),
@@ -78,6 +88,10 @@ int main(int argc, char **argv)
                                        "internally where each node has a maximum F labels.");
         optional_configs.add_options()("label_type", po::value<std::string>(&label_type)->default_value("uint"),
                                        program_options_utils::LABEL_TYPE_DESCRIPTION);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_DESCRIPTION);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -94,6 +108,8 @@ int main(int argc, char **argv)
             append_reorder_data = true;
         if (vm["use_opq"].as<bool>())
             use_opq = true;
+        if (vm["locality_layout"].as<bool>())
+            locality_layout = true;
     }
     catch (const std::exception &ex)
     {
@@ -135,10 +151,12 @@ int main(int argc, char **argv)
                          std::string(std::to_string(B)) + " " + std::string(std::to_string(M)) + " " +
                          std::string(std::to_string(num_threads)) + " " + std::string(std::to_string(disk_PQ)) + " " +
                          std::string(std::to_string(append_reorder_data)) + " " +
-                         std::string(std::to_string(build_PQ)) + " " + std::string(std::to_string(QD));
+                         std::string(std::to_string(build_PQ)) + " " + std::string(std::to_string(QD)) + " " +
+                         std::string(std::to_string(locality_layout)) + " " + std::string(std::to_string(PQ_bits));
 
     try
     {
+        diskann::set_huge_page_config(diskann::parse_huge_page_config(huge_pages, numa));
         if (label_file != "" && label_type == "ushort")
         {
             if (data_type == std::string("int8"))
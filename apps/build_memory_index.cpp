@@ -19,12 +19,14 @@
 #include "memory_mapper.h"
 #include "ann_exception.h"
 #include "index_factory.h"
+#include "huge_page_allocator.h"
 
 namespace po = boost::program_options;
 
 int main(int argc, char **argv)
 {
-    std::string data_type, dist_fn, data_path, index_path_prefix, label_file, universal_label, label_type;
+    std::string data_type, dist_fn, data_path, index_path_prefix, label_file, universal_label, label_type,
+        graph_store, data_store, huge_pages, numa;
     uint32_t num_threads, R, L, Lf, build_PQ_bytes;
     float alpha;
     bool use_pq_build, use_opq;
@@ -70,6 +72,14 @@ int main(int argc, char **argv)
                                        program_options_utils::FILTERED_LBUILD);
         optional_configs.add_options()("label_type", po::value<std::string>(&label_type)->default_value("uint"),
                                        program_options_utils::LABEL_TYPE_DESCRIPTION);
+        optional_configs.add_options()("graph_store", po::value<std::string>(&graph_store)->default_value("memory"),
+                                       program_options_utils::GRAPH_STORE_DESCRIPTION);
+        optional_configs.add_options()("data_store", po::value<std::string>(&data_store)->default_value("memory"),
+                                       program_options_utils::DATA_STORE_DESCRIPTION);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_DESCRIPTION);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -112,8 +122,63 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    diskann::GraphStoreStrategy graph_strategy;
+    if (graph_store == std::string("memory"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY;
+    }
+    else if (graph_store == std::string("compressed"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::COMPRESSED;
+    }
+    else if (graph_store == std::string("flat"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::FLAT;
+    }
+    else if (graph_store == std::string("packed"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::PACKED;
+    }
+    else
+    {
+        std::cout << "Unsupported graph store. Currently only memory/ compressed/ flat/ packed are supported."
+                  << std::endl;
+        return -1;
+    }
+
+    diskann::DataStoreStrategy data_strategy;
+    if (data_store == std::string("memory"))
+    {
+        data_strategy = diskann::DataStoreStrategy::MEMORY;
+    }
+    else if (data_store == std::string("int8"))
+    {
+        data_strategy = diskann::DataStoreStrategy::QUANTIZED_INT8;
+    }
+    else if (data_store == std::string("fp16"))
+    {
+        data_strategy = diskann::DataStoreStrategy::QUANTIZED_FP16;
+    }
+    else if (data_store == std::string("pq"))
+    {
+        // the index keeps only the build_PQ_bytes codes, no full-precision data
+        if (build_PQ_bytes == 0)
+        {
+            std::cout << "The pq data store needs build_PQ_bytes > 0." << std::endl;
+            return -1;
+        }
+        data_strategy = diskann::DataStoreStrategy::PQ;
+        use_pq_build = false;
+    }
+    else
+    {
+        std::cout << "Unsupported data store. Currently only memory/ int8/ fp16/ pq are supported." << std::endl;
+        return -1;
+    }
+
     try
     {
+        diskann::set_huge_page_config(diskann::parse_huge_page_config(huge_pages, numa));
         diskann::cout << "Starting index build with R: " << R << "  Lbuild: " << L << "  alpha: " << alpha
                       << "  #threads: " << num_threads << std::endl;
 
@@ -136,8 +201,8 @@ int main(int argc, char **argv)
                           .with_metric(metric)
                           .with_dimension(data_dim)
                           .with_max_points(data_num)
-                          .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
-                          .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                          .with_data_load_store_strategy(data_strategy)
+                          .with_graph_load_store_strategy(graph_strategy)
                           .with_data_type(data_type)
                           .with_label_type(label_type)
                           .is_dynamic_index(false)
@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <omp.h>
+#include <boost/program_options.hpp>
+
+#include "index.h"
+#include "index_factory.h"
+#include "huge_page_allocator.h"
+#include "utils.h"
+#include "program_options_utils.hpp"
+
+namespace po = boost::program_options;
+
+template <typename T>
+int range_search_memory_index(diskann::Metric &metric, const std::string &index_path, const std::string &query_file,
+                              const std::string &gt_file, const uint32_t num_threads, const float search_range,
+                              const std::vector<uint32_t> &Lvec, const uint32_t max_list_size)
+{
+    T *query = nullptr;
+    std::vector<std::vector<uint32_t>> groundtruth_ids;
+    size_t query_num, query_dim, query_aligned_dim, gt_num;
+    diskann::load_aligned_bin<T>(query_file, query, query_num, query_dim, query_aligned_dim);
+
+    bool calc_recall_flag = false;
+    if (gt_file != std::string("null") && file_exists(gt_file))
+    {
+        diskann::load_range_truthset(gt_file, groundtruth_ids, gt_num);
+        if (gt_num != query_num)
+        {
+            diskann::cout << "Error. Mismatch in number of queries and ground truth data" << std::endl;
+            return -1;
+        }
+        calc_recall_flag = true;
+    }
+
+    const size_t num_frozen_pts = diskann::get_graph_num_frozen_points(index_path);
+    auto config = diskann::IndexConfigBuilder()
+                      .with_metric(metric)
+                      .with_dimension(query_dim)
+                      .with_max_points(0)
+                      .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
+                      .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                      .with_data_type(diskann_type_to_name<T>())
+                      .with_label_type(diskann_type_to_name<uint32_t>())
+                      .with_tag_type(diskann_type_to_name<uint32_t>())
+                      .is_dynamic_index(false)
+                      .is_enable_tags(false)
+                      .is_concurrent_consolidate(false)
+                      .is_pq_dist_build(false)
+                      .is_use_opq(false)
+                      .with_num_pq_chunks(0)
+                      .with_num_frozen_pts(num_frozen_pts)
+                      .build();
+
+    auto index = diskann::IndexFactory(config).create_instance();
+    index->load(index_path.c_str(), num_threads, *(std::max_element(Lvec.begin(), Lvec.end())));
+    diskann::cout << "Index loaded" << std::endl;
+    diskann::print_huge_page_stats();
+
+    omp_set_num_threads(num_threads);
+
+    diskann::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    diskann::cout.precision(2);
+
+    std::string recall_string = "Recall@rng=" + std::to_string(search_range);
+    diskann::cout << std::setw(6) << "L" << std::setw(16) << "QPS" << std::setw(16) << "Mean Latency"
+                  << std::setw(16) << "99.9 Latency" << std::setw(16) << "Mean Results";
+    if (calc_recall_flag)
+    {
+        diskann::cout << std::setw(16) << recall_string << std::endl;
+    }
+    else
+        diskann::cout << std::endl;
+    diskann::cout << "==============================================================="
+                     "================="
+                  << std::endl;
+
+    std::vector<std::vector<uint32_t>> query_result_ids(query_num);
+    std::vector<float> latency_stats(query_num, 0);
+
+    for (uint32_t test_id = 0; test_id < Lvec.size(); test_id++)
+    {
+        uint32_t L = Lvec[test_id];
+        if (L > max_list_size)
+        {
+            diskann::cout << "Ignoring search with L:" << L << " since it is greater than the max list size "
+                          << max_list_size << std::endl;
+            continue;
+        }
+
+        auto s = std::chrono::high_resolution_clock::now();
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int64_t i = 0; i < (int64_t)query_num; i++)
+        {
+            auto qs = std::chrono::high_resolution_clock::now();
+            std::vector<float> distances;
+            index->range_search(query + i * query_aligned_dim, search_range, L, max_list_size, query_result_ids[i],
+                                distances);
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - qs;
+            latency_stats[i] = (float)(diff.count() * 1000000);
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - s;
+        auto qps = (1.0 * query_num) / (1.0 * diff.count());
+
+        std::vector<float> sorted_latencies(latency_stats);
+        std::sort(sorted_latencies.begin(), sorted_latencies.end());
+        double mean_latency = std::accumulate(sorted_latencies.begin(), sorted_latencies.end(), 0.0) / query_num;
+        float latency_999 = sorted_latencies[(uint64_t)(0.999 * query_num)];
+
+        uint64_t total_results = 0;
+        for (auto &result : query_result_ids)
+            total_results += result.size();
+
+        double recall = 0;
+        double ratio_of_sums = 0;
+        if (calc_recall_flag)
+        {
+            recall = diskann::calculate_range_search_recall((uint32_t)query_num, groundtruth_ids, query_result_ids);
+
+            uint64_t total_positive = 0;
+            for (uint32_t i = 0; i < query_num; i++)
+                total_positive += groundtruth_ids[i].size();
+            ratio_of_sums = (1.0 * total_results) / (1.0 * total_positive);
+        }
+
+        diskann::cout << std::setw(6) << L << std::setw(16) << qps << std::setw(16) << mean_latency << std::setw(16)
+                      << latency_999 << std::setw(16) << (1.0 * total_results) / query_num;
+        if (calc_recall_flag)
+        {
+            diskann::cout << std::setw(16) << recall << "," << ratio_of_sums << std::endl;
+        }
+        else
+            diskann::cout << std::endl;
+    }
+
+    diskann::cout << "Done searching. " << std::endl;
+
+    diskann::aligned_free(query);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, dist_fn, index_path_prefix, query_file, gt_file, huge_pages, numa;
+    uint32_t num_threads, max_list_size;
+    std::vector<uint32_t> Lvec;
+    float range;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "range_search_memory_index", "Searches in-memory DiskANN indexes using ranges")};
+    try
+    {
+        desc.add_options()("help,h", "Print information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("dist_fn", po::value<std::string>(&dist_fn)->required(),
+                                       program_options_utils::DISTANCE_FUNCTION_DESCRIPTION);
+        required_configs.add_options()("index_path_prefix", po::value<std::string>(&index_path_prefix)->required(),
+                                       program_options_utils::INDEX_PATH_PREFIX_DESCRIPTION);
+        required_configs.add_options()("query_file", po::value<std::string>(&query_file)->required(),
+                                       program_options_utils::QUERY_FILE_DESCRIPTION);
+        required_configs.add_options()("search_list,L",
+                                       po::value<std::vector<uint32_t>>(&Lvec)->multitoken()->required(),
+                                       "List of L values the range searches start with, L doubles while at least "
+                                       "half of the candidates are in range");
+        required_configs.add_options()("range_threshold,K", po::value<float>(&range)->required(),
+                                       "Largest distance of a result, smallest inner product for mips");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        optional_configs.add_options()("gt_file", po::value<std::string>(&gt_file)->default_value(std::string("null")),
+                                       program_options_utils::GROUND_TRUTH_FILE_DESCRIPTION);
+        optional_configs.add_options()("max_search_list", po::value<uint32_t>(&max_list_size)->default_value(10000),
+                                       "Largest L a range search may grow to");
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_DESCRIPTION);
+
+        // Merge required and optional parameters
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("mips"))
+    {
+        metric = diskann::Metric::INNER_PRODUCT;
+    }
+    else if (dist_fn == std::string("l2"))
+    {
+        metric = diskann::Metric::L2;
+    }
+    else if (dist_fn == std::string("cosine"))
+    {
+        metric = diskann::Metric::COSINE;
+    }
+    else
+    {
+        std::cout << "Unsupported distance function. Currently only L2/ Inner "
+                     "Product/Cosine are supported."
+                  << std::endl;
+        return -1;
+    }
+
+    if ((data_type != std::string("float")) && (metric == diskann::Metric::INNER_PRODUCT))
+    {
+        std::cout << "Currently support only floating point data for Inner Product." << std::endl;
+        return -1;
+    }
+
+    try
+    {
+        diskann::set_huge_page_config(diskann::parse_huge_page_config(huge_pages, numa));
+
+        if (data_type == std::string("float"))
+            return range_search_memory_index<float>(metric, index_path_prefix, query_file, gt_file, num_threads,
+                                                    range, Lvec, max_list_size);
+        else if (data_type == std::string("int8"))
+            return range_search_memory_index<int8_t>(metric, index_path_prefix, query_file, gt_file, num_threads,
+                                                     range, Lvec, max_list_size);
+        else if (data_type == std::string("uint8"))
+            return range_search_memory_index<uint8_t>(metric, index_path_prefix, query_file, gt_file, num_threads,
+                                                      range, Lvec, max_list_size);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "Index search failed." << std::endl;
+        return -1;
+    }
+}
@@ -24,7 +24,7 @@ namespace po = boost::program_options;
 
 template <typename T>
 void query_loop(const std::string &ip_addr_port, const std::string &query_file, const unsigned nq, const unsigned Ls,
-                const unsigned k_value)
+                const unsigned k_value, const std::string &filter)
 {
     web::http::client::http_client client(U(ip_addr_port));
 
@@ -40,6 +40,8 @@ void query_loop(const std::string &ip_addr_port, const std::string &query_file,
         queryJson[QUERY_ID_KEY] = i;
         queryJson[K_KEY] = k_value;
         queryJson[L_KEY] = Ls;
+        if (!filter.empty())
+            queryJson[FILTER_KEY] = web::json::value::string(utility::conversions::to_string_t(filter));
         for (size_t i = 0; i < ndims; ++i)
         {
             queryJson[VECTOR_KEY][i] = web::json::value::number(vec[i]);
@@ -71,7 +73,7 @@ void query_loop(const std::string &ip_addr_port, const std::string &query_file,
 
 int main(int argc, char *argv[])
 {
-    std::string data_type, query_file, address;
+    std::string data_type, query_file, address, filter;
     uint32_t num_queries;
     uint32_t l_search, k_value;
 
@@ -87,6 +89,8 @@ int main(int argc, char *argv[])
                            "Number of queries to search");
         desc.add_options()("l_search", po::value<uint32_t>(&l_search)->required(), "Value of L");
         desc.add_options()("k_value,K", po::value<uint32_t>(&k_value)->default_value(10), "Value of K (default 10)");
+        desc.add_options()("filter", po::value<std::string>(&filter)->default_value(std::string("")),
+                           "Filter expression of labels with AND, OR, NOT and parentheses (default none)");
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
         if (vm.count("help"))
@@ -104,15 +108,15 @@ int main(int argc, char *argv[])
 
     if (data_type == std::string("float"))
     {
-        query_loop<float>(address, query_file, num_queries, l_search, k_value);
+        query_loop<float>(address, query_file, num_queries, l_search, k_value, filter);
     }
     else if (data_type == std::string("int8"))
     {
-        query_loop<int8_t>(address, query_file, num_queries, l_search, k_value);
+        query_loop<int8_t>(address, query_file, num_queries, l_search, k_value, filter);
     }
     else if (data_type == std::string("uint8"))
     {
-        query_loop<uint8_t>(address, query_file, num_queries, l_search, k_value);
+        query_loop<uint8_t>(address, query_file, num_queries, l_search, k_value, filter);
     }
     else
     {
@@ -41,6 +41,7 @@ int main(int argc, char *argv[])
     std::string data_type, index_file, data_file, address, dist_fn, tags_file;
     uint32_t num_threads;
     uint32_t l_search;
+    bool numa_replicas = false;
 
     po::options_description desc{"Arguments"};
     try
@@ -59,6 +60,8 @@ int main(int argc, char *argv[])
                            "distance function <l2/mips>");
         desc.add_options()("tags_file", po::value<std::string>(&tags_file)->default_value(std::string()),
                            "Tags file location");
+        desc.add_options()("numa_replicas", po::bool_switch(&numa_replicas),
+                           "Load one copy of the index per NUMA node, server threads search the copy of their node");
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
         if (vm.count("help"))
@@ -87,19 +90,22 @@ int main(int argc, char *argv[])
     if (data_type == std::string("float"))
     {
         auto searcher = std::unique_ptr<diskann::BaseSearch>(
-            new diskann::InMemorySearch<float>(data_file, index_file, tags_file, metric, num_threads, l_search));
+            new diskann::InMemorySearch<float>(data_file, index_file, tags_file, metric, num_threads, l_search,
+                                             numa_replicas));
         g_inMemorySearch.push_back(std::move(searcher));
     }
     else if (data_type == std::string("int8"))
     {
         auto searcher = std::unique_ptr<diskann::BaseSearch>(
-            new diskann::InMemorySearch<int8_t>(data_file, index_file, tags_file, metric, num_threads, l_search));
+            new diskann::InMemorySearch<int8_t>(data_file, index_file, tags_file, metric, num_threads, l_search,
+                                             numa_replicas));
         g_inMemorySearch.push_back(std::move(searcher));
     }
     else if (data_type == std::string("uint8"))
     {
         auto searcher = std::unique_ptr<diskann::BaseSearch>(
-            new diskann::InMemorySearch<uint8_t>(data_file, index_file, tags_file, metric, num_threads, l_search));
+            new diskann::InMemorySearch<uint8_t>(data_file, index_file, tags_file, metric, num_threads, l_search,
+                                             numa_replicas));
         g_inMemorySearch.push_back(std::move(searcher));
     }
     else
@@ -37,11 +37,29 @@ void teardown(const utility::string_t &address)
     g_httpServer->close().wait();
 }
 
+template <typename T> void print_sector_cache_stats(const std::shared_ptr<diskann::NodeCache> &sector_cache)
+{
+    if (sector_cache == nullptr)
+        return;
+
+    for (size_t i = 0; i < g_ssdSearch.size(); i++)
+    {
+        auto searcher = dynamic_cast<diskann::PQFlashSearch<T> *>(g_ssdSearch[i].get());
+        uint64_t hits = searcher->get_sector_cache_hits(), misses = searcher->get_sector_cache_misses();
+        std::cout << "Index " << i << " sector cache hits: " << hits << ", misses: " << misses << ", hit rate: "
+                  << (hits + misses > 0 ? (100.0 * hits) / (hits + misses) : 0.0) << "%" << std::endl;
+    }
+    auto stats = sector_cache->get_stats();
+    std::cout << "Sector cache: " << stats.num_cached << "/" << stats.capacity << " sectors cached, admitted: "
+              << stats.admitted << ", rejected: " << stats.rejected << ", evicted: " << stats.evicted << std::endl;
+}
+
 int main(int argc, char *argv[])
 {
     std::string data_type, index_prefix_paths, address, dist_fn, tags_file;
     uint32_t num_nodes_to_cache;
     uint32_t num_threads;
+    uint32_t sector_cache_budget_mb;
 
     po::options_description desc{"Arguments"};
     try
@@ -53,6 +71,9 @@ int main(int argc, char *argv[])
                            "Path prefix for loading index file components");
         desc.add_options()("num_nodes_to_cache", po::value<uint32_t>(&num_nodes_to_cache)->default_value(0),
                            "Number of nodes to cache during search");
+        desc.add_options()("sector_cache_budget_mb", po::value<uint32_t>(&sector_cache_budget_mb)->default_value(0),
+                           "RAM in MB for a sector cache shared by all indices, filled from the sectors read "
+                           "during search. 0 disables it");
         desc.add_options()("num_threads,T", po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
                            "Number of threads used for building index (defaults to "
                            "omp_get_num_procs())");
@@ -118,12 +139,21 @@ int main(int argc, char *argv[])
     index_in.close();
     tags_in.close();
 
+    std::shared_ptr<diskann::NodeCache> sector_cache;
+    if (sector_cache_budget_mb > 0)
+    {
+        sector_cache.reset(
+            new diskann::NodeCache((uint64_t)sector_cache_budget_mb * 1024 * 1024, diskann::defaults::SECTOR_LEN));
+        std::cout << "Sector cache holds " << sector_cache->get_capacity() << " sectors" << std::endl;
+    }
+
     if (data_type == std::string("float"))
     {
         for (auto &index_tag : index_tag_paths)
         {
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<float>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                sector_cache));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
@@ -132,7 +162,8 @@ int main(int argc, char *argv[])
         for (auto &index_tag : index_tag_paths)
         {
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<int8_t>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                sector_cache));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
@@ -141,7 +172,8 @@ int main(int argc, char *argv[])
         for (auto &index_tag : index_tag_paths)
         {
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<uint8_t>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                sector_cache));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
@@ -161,6 +193,12 @@ int main(int argc, char *argv[])
             std::getline(std::cin, line);
             if (line == "exit")
             {
+                if (data_type == std::string("float"))
+                    print_sector_cache_stats<float>(sector_cache);
+                else if (data_type == std::string("int8"))
+                    print_sector_cache_stats<int8_t>(sector_cache);
+                else
+                    print_sector_cache_stats<uint8_t>(sector_cache);
                 teardown(address);
                 g_httpServer->close().wait();
                 exit(0);
@@ -10,6 +10,7 @@
 #include "memory_mapper.h"
 #include "partition.h"
 #include "pq_flash_index.h"
+#include "huge_page_allocator.h"
 #include "timer.h"
 #include "percentile_stats.h"
 #include "program_options_utils.hpp"
@@ -19,6 +20,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "linux_aligned_file_reader.h"
+#include "io_uring_aligned_file_reader.h"
 #else
 #ifdef USE_BING_INFRA
 #include "bing_aligned_file_reader.h"
@@ -53,7 +55,10 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
                       const uint32_t num_threads, const uint32_t recall_at, const uint32_t beamwidth,
                       const uint32_t num_nodes_to_cache, const uint32_t search_io_limit,
                       const std::vector<uint32_t> &Lvec, const float fail_if_recall_below,
-                      const std::vector<std::string> &query_filters, const bool use_reorder_data = false)
+                      const std::vector<std::string> &query_filters, const bool use_reorder_data = false,
+                      const bool use_pipelined_search = false, const std::string &io_backend = "libaio",
+                      const uint32_t dynamic_cache_budget_mb = 0, const uint32_t search_batch_size = 0,
+                      const std::string &visited_set = "auto")
 {
     diskann::cout << "Search parameters: #threads: " << num_threads << ", ";
     if (beamwidth <= 0)
@@ -106,7 +111,18 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
     reader.reset(new diskann::BingAlignedFileReader());
 #endif
 #else
-    reader.reset(new LinuxAlignedFileReader());
+    if (io_backend == "libaio")
+        reader.reset(new LinuxAlignedFileReader());
+#ifdef DISKANN_USE_IO_URING
+    else if (io_backend == "io_uring" || io_backend == "io_uring_sqpoll")
+        reader.reset(new IoUringAlignedFileReader(io_backend == "io_uring_sqpoll"));
+#endif
+    else
+    {
+        diskann::cerr << "Unsupported io_backend " << io_backend
+                      << ". Use libaio, or io_uring/io_uring_sqpoll with a DISKANN_USE_IO_URING build." << std::endl;
+        return -1;
+    }
 #endif
 
     std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> _pFlashIndex(
@@ -118,6 +134,21 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
     {
         return res;
     }
+    _pFlashIndex->set_pipelined_search(use_pipelined_search);
+    if (visited_set == "hash_set")
+        _pFlashIndex->set_visited_set_type(diskann::VisitedSetType::HASH_SET);
+    else if (visited_set == "epoch_array")
+        _pFlashIndex->set_visited_set_type(diskann::VisitedSetType::EPOCH_ARRAY);
+    else if (visited_set == "bitset")
+        _pFlashIndex->set_visited_set_type(diskann::VisitedSetType::BITSET);
+    else if (visited_set == "bloom_filter")
+        _pFlashIndex->set_visited_set_type(diskann::VisitedSetType::BLOOM_FILTER);
+    else if (visited_set != "auto")
+    {
+        diskann::cerr << "Unsupported visited_set " << visited_set
+                      << ". Use auto, hash_set, epoch_array, bitset or bloom_filter." << std::endl;
+        return -1;
+    }
 
     std::vector<uint32_t> node_list;
     diskann::cout << "Caching " << num_nodes_to_cache << " nodes around medoid(s)" << std::endl;
@@ -128,6 +159,9 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
     _pFlashIndex->load_cache_list(node_list);
     node_list.clear();
     node_list.shrink_to_fit();
+    if (dynamic_cache_budget_mb > 0)
+        _pFlashIndex->set_dynamic_cache_budget((uint64_t)dynamic_cache_budget_mb * 1024 * 1024);
+    diskann::print_huge_page_stats();
 
     omp_set_num_threads(num_threads);
 
@@ -224,31 +258,50 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
         std::vector<uint64_t> query_result_ids_64(recall_at * query_num);
         auto s = std::chrono::high_resolution_clock::now();
 
-#pragma omp parallel for schedule(dynamic, 1)
-        for (int64_t i = 0; i < (int64_t)query_num; i++)
+        if (search_batch_size > 0 && !filtered_search)
         {
-            if (!filtered_search)
+            // each thread searches a batch of queries together
+            const int64_t num_batches = (int64_t)DIV_ROUND_UP(query_num, search_batch_size);
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t b = 0; b < num_batches; b++)
             {
-                _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
-                                                 query_result_ids_64.data() + (i * recall_at),
-                                                 query_result_dists[test_id].data() + (i * recall_at),
-                                                 optimized_beamwidth, use_reorder_data, stats + i);
+                const uint64_t start = b * search_batch_size;
+                const uint64_t n = std::min<uint64_t>(search_batch_size, query_num - start);
+                _pFlashIndex->batch_search(query + (start * query_aligned_dim), n, query_aligned_dim, recall_at, L,
+                                           query_result_ids_64.data() + (start * recall_at),
+                                           query_result_dists[test_id].data() + (start * recall_at),
+                                           optimized_beamwidth, use_reorder_data, stats + start);
             }
-            else
+        }
+        else
+        {
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t i = 0; i < (int64_t)query_num; i++)
             {
-                LabelT label_for_search;
-                if (query_filters.size() == 1)
-                { // one label for all queries
-                    label_for_search = _pFlashIndex->get_converted_label(query_filters[0]);
+                if (!filtered_search)
+                {
+                    _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
+                                                     query_result_ids_64.data() + (i * recall_at),
+                                                     query_result_dists[test_id].data() + (i * recall_at),
+                                                     optimized_beamwidth, use_reorder_data, stats + i);
                 }
                 else
-                { // one label for each query
-                    label_for_search = _pFlashIndex->get_converted_label(query_filters[i]);
+                {
+                    LabelT label_for_search;
+                    if (query_filters.size() == 1)
+                    { // one label for all queries
+                        label_for_search = _pFlashIndex->get_converted_label(query_filters[0]);
+                    }
+                    else
+                    { // one label for each query
+                        label_for_search = _pFlashIndex->get_converted_label(query_filters[i]);
+                    }
+                    _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
+                                                     query_result_ids_64.data() + (i * recall_at),
+                                                     query_result_dists[test_id].data() + (i * recall_at),
+                                                     optimized_beamwidth, true, label_for_search, use_reorder_data,
+                                                     stats + i);
                 }
-                _pFlashIndex->cached_beam_search(
-                    query + (i * query_aligned_dim), recall_at, L, query_result_ids_64.data() + (i * recall_at),
-                    query_result_dists[test_id].data() + (i * recall_at), optimized_beamwidth, true, label_for_search,
-                    use_reorder_data, stats + i);
             }
         }
         auto e = std::chrono::high_resolution_clock::now();
@@ -290,6 +343,16 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
         delete[] stats;
     }
 
+    if (dynamic_cache_budget_mb > 0)
+    {
+        auto cache_stats = _pFlashIndex->get_dynamic_cache_stats();
+        uint64_t lookups = cache_stats.hits + cache_stats.misses;
+        diskann::cout << "Dynamic cache: " << cache_stats.num_cached << "/" << cache_stats.capacity
+                      << " nodes cached, hit rate: " << (lookups > 0 ? (100.0 * cache_stats.hits) / lookups : 0.0)
+                      << "%, admitted: " << cache_stats.admitted << ", rejected: " << cache_stats.rejected
+                      << ", evicted: " << cache_stats.evicted << std::endl;
+    }
+
     diskann::cout << "Done searching. Now saving results " << std::endl;
     uint64_t test_id = 0;
     for (auto L : Lvec)
@@ -313,10 +376,11 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, result_path_prefix, query_file, gt_file, filter_label,
-        label_type, query_filters_file;
-    uint32_t num_threads, K, W, num_nodes_to_cache, search_io_limit;
+        label_type, query_filters_file, io_backend, huge_pages, numa, visited_set;
+    uint32_t num_threads, K, W, num_nodes_to_cache, search_io_limit, dynamic_cache_budget_mb, search_batch_size;
     std::vector<uint32_t> Lvec;
     bool use_reorder_data = false;
+    bool use_pipelined_search = false;
     float fail_if_recall_below = 0.0f;
 
     po::options_description desc{
@@ -361,6 +425,27 @@ int main(int argc, char **argv)
         optional_configs.add_options()("use_reorder_data", po::bool_switch()->default_value(false),
                                        "Include full precision data in the index. Use only in "
                                        "conjuction with compressed data on SSD.  Default value: false");
+        optional_configs.add_options()("use_pipelined_search", po::bool_switch()->default_value(false),
+                                       "Keep up to beamwidth reads in flight and expand each node as soon as "
+                                       "its read completes, instead of waiting for the whole beam.  Default value: "
+                                       "false");
+        optional_configs.add_options()("dynamic_cache_budget_mb",
+                                       po::value<uint32_t>(&dynamic_cache_budget_mb)->default_value(0),
+                                       "RAM in MB for a node cache filled from the nodes read during search, "
+                                       "in addition to the num_nodes_to_cache static cache.  Default value: 0");
+        optional_configs.add_options()("search_batch_size",
+                                       po::value<uint32_t>(&search_batch_size)->default_value(0),
+                                       "Search queries in batches of this size that share reads of the same "
+                                       "nodes, instead of one at a time. Ignored for filtered search.  Default "
+                                       "value: 0");
+        optional_configs.add_options()("visited_set", po::value<std::string>(&visited_set)->default_value("auto"),
+                                       "Set of the nodes a query has visited: auto, hash_set, epoch_array, bitset "
+                                       "or bloom_filter. auto picks one from the number of points and threads, "
+                                       "a bloom_filter may skip candidates.  Default value: auto");
+        optional_configs.add_options()("io_backend", po::value<std::string>(&io_backend)->default_value("libaio"),
+                                       "Linux only. Asynchronous IO interface used to read the index: libaio, "
+                                       "io_uring or io_uring_sqpoll. The io_uring backends need a build with "
+                                       "DISKANN_USE_IO_URING.  Default value: libaio");
         optional_configs.add_options()("filter_label",
                                        po::value<std::string>(&filter_label)->default_value(std::string("")),
                                        program_options_utils::FILTER_LABEL_DESCRIPTION);
@@ -372,6 +457,10 @@ int main(int argc, char **argv)
         optional_configs.add_options()("fail_if_recall_below",
                                        po::value<float>(&fail_if_recall_below)->default_value(0.0f),
                                        program_options_utils::FAIL_IF_RECALL_BELOW);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_DESCRIPTION);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -386,6 +475,8 @@ int main(int argc, char **argv)
         po::notify(vm);
         if (vm["use_reorder_data"].as<bool>())
             use_reorder_data = true;
+        if (vm["use_pipelined_search"].as<bool>())
+            use_pipelined_search = true;
     }
     catch (const std::exception &ex)
     {
@@ -446,20 +537,24 @@ int main(int argc, char **argv)
 
     try
     {
+        diskann::set_huge_page_config(diskann::parse_huge_page_config(huge_pages, numa));
         if (!query_filters.empty() && label_type == "ushort")
         {
             if (data_type == std::string("float"))
                 return search_disk_index<float, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    use_pipelined_search, io_backend, dynamic_cache_budget_mb, search_batch_size, visited_set);
             else if (data_type == std::string("int8"))
                 return search_disk_index<int8_t, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    use_pipelined_search, io_backend, dynamic_cache_budget_mb, search_batch_size, visited_set);
             else if (data_type == std::string("uint8"))
                 return search_disk_index<uint8_t, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    use_pipelined_search, io_backend, dynamic_cache_budget_mb, search_batch_size, visited_set);
             else
             {
                 std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
@@ -471,15 +566,21 @@ int main(int argc, char **argv)
             if (data_type == std::string("float"))
                 return search_disk_index<float>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                 num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                fail_if_recall_below, query_filters, use_reorder_data);
+                                                fail_if_recall_below, query_filters, use_reorder_data,
+                                                use_pipelined_search, io_backend, dynamic_cache_budget_mb,
+                                                search_batch_size, visited_set);
             else if (data_type == std::string("int8"))
                 return search_disk_index<int8_t>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                  num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                 fail_if_recall_below, query_filters, use_reorder_data);
+                                                 fail_if_recall_below, query_filters, use_reorder_data,
+                                                 use_pipelined_search, io_backend, dynamic_cache_budget_mb,
+                                                 search_batch_size, visited_set);
             else if (data_type == std::string("uint8"))
                 return search_disk_index<uint8_t>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                   num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                  fail_if_recall_below, query_filters, use_reorder_data);
+                                                  fail_if_recall_below, query_filters, use_reorder_data,
+                                                  use_pipelined_search, io_backend, dynamic_cache_budget_mb,
+                                                  search_batch_size, visited_set);
             else
             {
                 std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
@@ -22,6 +22,8 @@
 #include "utils.h"
 #include "program_options_utils.hpp"
 #include "index_factory.h"
+#include "huge_page_allocator.h"
+#include "numa_replicas.h"
 
 namespace po = boost::program_options;
 
@@ -30,7 +32,10 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                         const std::string &query_file, const std::string &truthset_file, const uint32_t num_threads,
                         const uint32_t recall_at, const bool print_all_recalls, const std::vector<uint32_t> &Lvec,
                         const bool dynamic, const bool tags, const bool show_qps_per_thread,
-                        const std::vector<std::string> &query_filters, const float fail_if_recall_below)
+                        const std::vector<std::string> &query_filters, const float fail_if_recall_below,
+                        const diskann::GraphStoreStrategy graph_strategy,
+                        const diskann::DataStoreStrategy data_strategy, const std::string &rerank_data_file,
+                        const bool numa_replicas)
 {
     using TagT = uint32_t;
     // Load the query file
@@ -74,8 +79,9 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                       .with_metric(metric)
                       .with_dimension(query_dim)
                       .with_max_points(0)
-                      .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
-                      .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                      .with_data_load_store_strategy(data_strategy)
+                      .with_rerank_data_file(rerank_data_file)
+                      .with_graph_load_store_strategy(graph_strategy)
                       .with_data_type(diskann_type_to_name<T>())
                       .with_label_type(diskann_type_to_name<LabelT>())
                       .with_tag_type(diskann_type_to_name<TagT>())
@@ -88,13 +94,18 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                       .with_num_frozen_pts(num_frozen_pts)
                       .build();
 
-    auto index_factory = diskann::IndexFactory(config);
-    auto index = index_factory.create_instance();
-    index->load(index_path.c_str(), num_threads, *(std::max_element(Lvec.begin(), Lvec.end())));
-    std::cout << "Index loaded" << std::endl;
-
-    if (metric == diskann::FAST_L2)
-        index->optimize_index_layout();
+    const uint32_t max_L = *(std::max_element(Lvec.begin(), Lvec.end()));
+    diskann::NumaReplicatedIndex<diskann::AbstractIndex> replicas(
+        numa_replicas ? diskann::get_num_numa_nodes() : 1, [&](uint32_t) {
+            auto index = diskann::IndexFactory(config).create_instance();
+            index->load(index_path.c_str(), num_threads, max_L);
+            return index;
+        });
+    std::cout << "Index loaded";
+    if (replicas.num_replicas() > 1)
+        std::cout << ", one replica on each of " << replicas.num_replicas() << " NUMA nodes";
+    std::cout << std::endl;
+    diskann::print_huge_page_stats();
 
     std::cout << "Using " << num_threads << " threads to search" << std::endl;
     std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
@@ -143,6 +154,7 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
     }
 
     double best_recall = 0.0;
+    replicas.scheduler().pin_omp_threads(num_threads);
 
     for (uint32_t test_id = 0; test_id < Lvec.size(); test_id++)
     {
@@ -163,24 +175,20 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
         for (int64_t i = 0; i < (int64_t)query_num; i++)
         {
             auto qs = std::chrono::high_resolution_clock::now();
+            auto &index = replicas.local();
             if (filtered_search)
             {
                 std::string raw_filter = query_filters.size() == 1 ? query_filters[0] : query_filters[i];
 
-                auto retval = index->search_with_filters(query + i * query_aligned_dim, raw_filter, recall_at, L,
-                                                         query_result_ids[test_id].data() + i * recall_at,
-                                                         query_result_dists[test_id].data() + i * recall_at);
+                auto retval = index.search_with_filters(query + i * query_aligned_dim, raw_filter, recall_at, L,
+                                                        query_result_ids[test_id].data() + i * recall_at,
+                                                        query_result_dists[test_id].data() + i * recall_at);
                 cmp_stats[i] = retval.second;
             }
-            else if (metric == diskann::FAST_L2)
-            {
-                index->search_with_optimized_layout(query + i * query_aligned_dim, recall_at, L,
-                                                    query_result_ids[test_id].data() + i * recall_at);
-            }
             else if (tags)
             {
-                index->search_with_tags(query + i * query_aligned_dim, recall_at, L,
-                                        query_result_tags.data() + i * recall_at, nullptr, res);
+                index.search_with_tags(query + i * query_aligned_dim, recall_at, L,
+                                       query_result_tags.data() + i * recall_at, nullptr, res);
                 for (int64_t r = 0; r < (int64_t)recall_at; r++)
                 {
                     query_result_ids[test_id][recall_at * i + r] = query_result_tags[recall_at * i + r];
@@ -189,8 +197,8 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
             else
             {
                 cmp_stats[i] = index
-                                   ->search(query + i * query_aligned_dim, recall_at, L,
-                                            query_result_ids[test_id].data() + i * recall_at)
+                                   .search(query + i * query_aligned_dim, recall_at, L,
+                                           query_result_ids[test_id].data() + i * recall_at)
                                    .second;
             }
             auto qe = std::chrono::high_resolution_clock::now();
@@ -267,7 +275,8 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, result_path, query_file, gt_file, filter_label, label_type,
-        query_filters_file;
+        query_filters_file, graph_store, data_store, rerank_data_file, huge_pages, numa;
+    bool numa_replicas = false;
     uint32_t num_threads, K;
     std::vector<uint32_t> Lvec;
     bool print_all_recalls, dynamic, tags, show_qps_per_thread;
@@ -320,6 +329,19 @@ int main(int argc, char **argv)
         optional_configs.add_options()("fail_if_recall_below",
                                        po::value<float>(&fail_if_recall_below)->default_value(0.0f),
                                        program_options_utils::FAIL_IF_RECALL_BELOW);
+        optional_configs.add_options()("graph_store", po::value<std::string>(&graph_store)->default_value("memory"),
+                                       program_options_utils::GRAPH_STORE_DESCRIPTION);
+        optional_configs.add_options()("data_store", po::value<std::string>(&data_store)->default_value("memory"),
+                                       program_options_utils::DATA_STORE_DESCRIPTION);
+        optional_configs.add_options()("rerank_data_file",
+                                       po::value<std::string>(&rerank_data_file)->default_value(std::string("")),
+                                       program_options_utils::RERANK_DATA_FILE_DESCRIPTION);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_DESCRIPTION);
+        optional_configs.add_options()("numa_replicas", po::bool_switch(&numa_replicas),
+                                       program_options_utils::NUMA_REPLICAS_DESCRIPTION);
 
         // Output controls
         po::options_description output_controls("Output controls");
@@ -361,19 +383,69 @@ int main(int argc, char **argv)
     {
         metric = diskann::Metric::COSINE;
     }
-    else if ((dist_fn == std::string("fast_l2")) && (data_type == std::string("float")))
+    else if (dist_fn == std::string("fast_l2"))
     {
-        metric = diskann::Metric::FAST_L2;
+        // kept for existing scripts: l2 over the packed layout
+        metric = diskann::Metric::L2;
+        graph_store = "packed";
     }
     else
     {
-        std::cout << "Unsupported distance function. Currently only l2/ cosine are "
-                     "supported in general, and mips/fast_l2 only for floating "
+        std::cout << "Unsupported distance function. Currently only l2/ cosine/ fast_l2 are "
+                     "supported in general, and mips only for floating "
                      "point data."
                   << std::endl;
         return -1;
     }
 
+    diskann::GraphStoreStrategy graph_strategy;
+    if (graph_store == std::string("memory"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY;
+    }
+    else if (graph_store == std::string("compressed"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::COMPRESSED;
+    }
+    else if (graph_store == std::string("flat"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::FLAT;
+    }
+    else if (graph_store == std::string("packed"))
+    {
+        graph_strategy = diskann::GraphStoreStrategy::PACKED;
+    }
+    else
+    {
+        std::cout << "Unsupported graph store. Currently only memory/ compressed/ flat/ packed are supported."
+                  << std::endl;
+        return -1;
+    }
+
+    diskann::DataStoreStrategy data_strategy;
+    if (data_store == std::string("memory"))
+    {
+        data_strategy = diskann::DataStoreStrategy::MEMORY;
+    }
+    else if (data_store == std::string("int8"))
+    {
+        data_strategy = diskann::DataStoreStrategy::QUANTIZED_INT8;
+    }
+    else if (data_store == std::string("fp16"))
+    {
+        data_strategy = diskann::DataStoreStrategy::QUANTIZED_FP16;
+    }
+    else if (data_store == std::string("pq"))
+    {
+        // the number of chunks is read from the pivots saved with the index
+        data_strategy = diskann::DataStoreStrategy::PQ;
+    }
+    else
+    {
+        std::cout << "Unsupported data store. Currently only memory/ int8/ fp16/ pq are supported." << std::endl;
+        return -1;
+    }
+
     if (dynamic && not tags)
     {
         std::cerr << "Tags must be enabled while searching dynamically built indices" << std::endl;
@@ -404,25 +476,29 @@ int main(int argc, char **argv)
 
     try
     {
+        diskann::set_huge_page_config(diskann::parse_huge_page_config(huge_pages, numa));
         if (!query_filters.empty() && label_type == "ushort")
         {
             if (data_type == std::string("int8"))
             {
                 return search_memory_index<int8_t, uint16_t>(
                     metric, index_path_prefix, result_path, query_file, gt_file, num_threads, K, print_all_recalls,
-                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below);
+                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below, graph_strategy,
+                    data_strategy, rerank_data_file, numa_replicas);
             }
             else if (data_type == std::string("uint8"))
             {
                 return search_memory_index<uint8_t, uint16_t>(
                     metric, index_path_prefix, result_path, query_file, gt_file, num_threads, K, print_all_recalls,
-                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below);
+                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below, graph_strategy,
+                    data_strategy, rerank_data_file, numa_replicas);
             }
             else if (data_type == std::string("float"))
             {
-                return search_memory_index<float, uint16_t>(metric, index_path_prefix, result_path, query_file, gt_file,
-                                                            num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                            show_qps_per_thread, query_filters, fail_if_recall_below);
+                return search_memory_index<float, uint16_t>(
+                    metric, index_path_prefix, result_path, query_file, gt_file, num_threads, K, print_all_recalls,
+                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below, graph_strategy,
+                    data_strategy, rerank_data_file, numa_replicas);
             }
             else
             {
@@ -436,19 +512,22 @@ int main(int argc, char **argv)
             {
                 return search_memory_index<int8_t>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                    num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                   show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                   show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                   graph_strategy, data_strategy, rerank_data_file, numa_replicas);
             }
             else if (data_type == std::string("uint8"))
             {
                 return search_memory_index<uint8_t>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                     num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                    show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                    show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                    graph_strategy, data_strategy, rerank_data_file, numa_replicas);
             }
             else if (data_type == std::string("float"))
             {
                 return search_memory_index<float>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                   num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                  show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                  show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                  graph_strategy, data_strategy, rerank_data_file, numa_replicas);
             }
             else
             {
@@ -0,0 +1,162 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <boost/program_options.hpp>
+
+#include "utils.h"
+#include "timer.h"
+#include "distance.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+// random vectors padded to a multiple of 8 dimensions and 64-byte aligned, as
+// an in-memory data store keeps them
+template <typename T> T *make_vectors(size_t npts, size_t dim, std::mt19937 &gen)
+{
+    T *data = nullptr;
+    diskann::alloc_aligned((void **)&data, npts * dim * sizeof(T), 64);
+    std::uniform_int_distribution<int> byte_rand(std::is_same<T, int8_t>::value ? -127 : 0,
+                                                 std::is_same<T, int8_t>::value ? 127 : 255);
+    std::normal_distribution<float> normal_rand{0, 1};
+    for (size_t i = 0; i < npts * dim; i++)
+        data[i] = std::is_same<T, float>::value ? (T)normal_rand(gen) : (T)byte_rand(gen);
+    return data;
+}
+
+// Mimics the expansions of a graph search: every round scores a query against
+// degree random points, which are rarely in cache. Returns the mean
+// nanoseconds per distance of the per-point loop the search used to run
+// (virtual compare, next point prefetched) and of Distance::compare_batch.
+template <typename T>
+std::pair<double, double> time_expansions(const diskann::Distance<T> &distance, const T *data, size_t npts,
+                                          size_t dim, uint32_t degree, uint64_t num_rounds, std::mt19937 &gen)
+{
+    std::uniform_int_distribution<uint32_t> id_rand(0, (uint32_t)npts - 1);
+    std::vector<uint32_t> ids(num_rounds * degree);
+    for (auto &id : ids)
+        id = id_rand(gen);
+    std::vector<float> distances(degree);
+    volatile float sink = 0;
+
+    diskann::Timer timer;
+    for (uint64_t r = 0; r < num_rounds; r++)
+    {
+        const T *query = data + ids[(r * 7919) % ids.size()] * dim;
+        const uint32_t *round_ids = ids.data() + r * degree;
+        for (uint32_t i = 0; i < degree; i++)
+        {
+            if (i + 1 < degree)
+                diskann::prefetch_vector((const char *)(data + round_ids[i + 1] * dim), sizeof(T) * dim);
+            distances[i] = distance.compare(query, data + round_ids[i] * dim, (uint32_t)dim);
+        }
+        sink = sink + distances[degree - 1];
+    }
+    const double per_point_ns = (double)timer.elapsed() * 1000.0 / (double)(num_rounds * degree);
+
+    timer.reset();
+    for (uint64_t r = 0; r < num_rounds; r++)
+    {
+        const T *query = data + ids[(r * 7919) % ids.size()] * dim;
+        distance.compare_batch(query, data, dim, ids.data() + r * degree, degree, (uint32_t)dim, distances.data());
+        sink = sink + distances[degree - 1];
+    }
+    const double batch_ns = (double)timer.elapsed() * 1000.0 / (double)(num_rounds * degree);
+    return std::make_pair(per_point_ns, batch_ns);
+}
+
+template <typename T>
+void run(const char *type, diskann::Metric metric, size_t npts, size_t dim, uint32_t degree, uint64_t num_rounds,
+         std::mt19937 &gen)
+{
+    T *data = make_vectors<T>(npts, dim, gen);
+    std::unique_ptr<diskann::Distance<T>> distance(diskann::get_distance_function<T>(metric));
+    const auto ns = time_expansions(*distance, data, npts, dim, degree, num_rounds, gen);
+    std::cout << std::setw(8) << type << std::setw(8) << dim << std::setw(14) << std::fixed << std::setprecision(2)
+              << ns.first << std::setw(14) << ns.second << std::setw(10) << ns.first / ns.second << std::endl;
+    diskann::aligned_free(data);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> dims;
+    std::string dist_fn;
+    size_t npts;
+    uint32_t degree;
+    uint64_t num_rounds;
+
+    try
+    {
+        po::options_description desc{"Arguments"};
+
+        desc.add_options()("help,h", "Print information on arguments");
+
+        desc.add_options()("dims,D",
+                           po::value<std::vector<uint32_t>>(&dims)->multitoken()->default_value(
+                               std::vector<uint32_t>{96, 100, 128, 200, 384, 768, 960}, "96 100 128 200 384 768 960"),
+                           "Dimensions to benchmark, rounded up to a multiple of 8");
+        desc.add_options()("dist_fn", po::value<std::string>(&dist_fn)->default_value(std::string("l2")),
+                           "Distance function <l2/cosine>");
+        desc.add_options()("npts,N", po::value<size_t>(&npts)->default_value(1000000),
+                           "Number of random vectors, large enough not to fit in cache");
+        desc.add_options()("degree,R", po::value<uint32_t>(&degree)->default_value(64),
+                           "Points scored per expansion");
+        desc.add_options()("num_rounds", po::value<uint64_t>(&num_rounds)->default_value(20000),
+                           "Number of expansions timed per type and dimension");
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("l2"))
+        metric = diskann::Metric::L2;
+    else if (dist_fn == std::string("cosine"))
+        metric = diskann::Metric::COSINE;
+    else
+    {
+        std::cerr << "Unsupported distance function. Use l2 or cosine." << std::endl;
+        return -1;
+    }
+    if (npts == 0 || degree == 0 || num_rounds == 0)
+    {
+        std::cerr << "Need at least 1 vector, 1 point per expansion and 1 expansion" << std::endl;
+        return -1;
+    }
+
+    std::mt19937 gen{42};
+    std::cout << std::setw(8) << "Type" << std::setw(8) << "Dim" << std::setw(14) << "ns/point" << std::setw(14)
+              << "ns/batched" << std::setw(10) << "Speedup" << std::endl;
+    try
+    {
+        for (uint32_t dim : dims)
+        {
+            const size_t padded_dim = ROUND_UP(dim, 8);
+            run<float>("float", metric, npts, padded_dim, degree, num_rounds, gen);
+            run<int8_t>("int8", metric, npts, padded_dim, degree, num_rounds, gen);
+            run<uint8_t>("uint8", metric, npts, padded_dim, degree, num_rounds, gen);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
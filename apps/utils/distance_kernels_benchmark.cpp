@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <boost/program_options.hpp>
+
+#include "utils.h"
+#include "timer.h"
+#include "distance_kernels.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+// random vectors padded to a multiple of 8 dimensions and 64-byte aligned, so
+// that every kernel table accepts them
+template <typename T> T *make_vectors(size_t npts, size_t dim, std::mt19937 &gen)
+{
+    T *data = nullptr;
+    diskann::alloc_aligned((void **)&data, npts * dim * sizeof(T), 64);
+    std::uniform_int_distribution<int> byte_rand(std::is_same<T, int8_t>::value ? -127 : 0,
+                                                 std::is_same<T, int8_t>::value ? 127 : 255);
+    std::normal_distribution<float> normal_rand{0, 1};
+    for (size_t i = 0; i < npts * dim; i++)
+        data[i] = std::is_same<T, float>::value ? (T)normal_rand(gen) : (T)byte_rand(gen);
+    return data;
+}
+
+// mean nanoseconds per call of kernel, comparing consecutive vectors
+template <typename T>
+double time_kernel(float (*kernel)(const T *, const T *, uint32_t), const T *data, size_t npts, size_t dim,
+                   uint64_t num_compares)
+{
+    volatile float sink = 0;
+    diskann::Timer timer;
+    for (uint64_t i = 0; i < num_compares; i++)
+    {
+        const size_t a = i % npts, b = (i + 1) % npts;
+        sink = sink + kernel(data + a * dim, data + b * dim, (uint32_t)dim);
+    }
+    return (double)timer.elapsed() * 1000.0 / (double)num_compares;
+}
+
+void print_row(const char *kernels, const char *name, size_t dim, double ns)
+{
+    std::cout << std::setw(12) << kernels << std::setw(22) << name << std::setw(8) << dim << std::setw(12)
+              << std::fixed << std::setprecision(2) << ns << std::endl;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> dims;
+    size_t npts;
+    uint64_t num_compares;
+
+    try
+    {
+        po::options_description desc{"Arguments"};
+
+        desc.add_options()("help,h", "Print information on arguments");
+
+        desc.add_options()("dims,D",
+                           po::value<std::vector<uint32_t>>(&dims)->multitoken()->default_value(
+                               std::vector<uint32_t>{96, 100, 128, 200, 384, 768, 960}, "96 100 128 200 384 768 960"),
+                           "Dimensions to benchmark, rounded up to a multiple of 8");
+        desc.add_options()("npts,N", po::value<size_t>(&npts)->default_value(4096),
+                           "Number of random vectors compared in turn");
+        desc.add_options()("num_compares", po::value<uint64_t>(&num_compares)->default_value(2000000),
+                           "Number of calls timed per kernel and dimension");
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    if (npts < 2 || num_compares == 0)
+    {
+        std::cerr << "Need at least 2 vectors and 1 comparison" << std::endl;
+        return -1;
+    }
+
+    std::vector<const diskann::DistanceKernels *> tables{&diskann::get_baseline_distance_kernels()};
+    if (diskann::get_avx512_distance_kernels() != nullptr)
+        tables.push_back(diskann::get_avx512_distance_kernels());
+    if (diskann::get_avx512_vnni_distance_kernels() != nullptr)
+        tables.push_back(diskann::get_avx512_vnni_distance_kernels());
+    std::cout << "Dispatched kernels: " << diskann::get_distance_kernels().name << std::endl;
+
+    std::mt19937 gen{42};
+    std::cout << std::setw(12) << "Kernels" << std::setw(22) << "Function" << std::setw(8) << "Dim" << std::setw(12)
+              << "ns/call" << std::endl;
+    try
+    {
+        for (uint32_t dim : dims)
+        {
+            const size_t padded_dim = ROUND_UP(dim, 8);
+            float *floats = make_vectors<float>(npts, padded_dim, gen);
+            int8_t *int8s = make_vectors<int8_t>(npts, padded_dim, gen);
+            uint8_t *uint8s = make_vectors<uint8_t>(npts, padded_dim, gen);
+
+            for (auto table : tables)
+            {
+                print_row(table->name, "l2_float", padded_dim,
+                          time_kernel(table->l2_float, floats, npts, padded_dim, num_compares));
+                print_row(table->name, "inner_product_float", padded_dim,
+                          time_kernel(table->inner_product_float, floats, npts, padded_dim, num_compares));
+                print_row(table->name, "cosine_float", padded_dim,
+                          time_kernel(table->cosine_float, floats, npts, padded_dim, num_compares));
+                print_row(table->name, "l2_int8", padded_dim,
+                          time_kernel(table->l2_int8, int8s, npts, padded_dim, num_compares));
+                print_row(table->name, "cosine_int8", padded_dim,
+                          time_kernel(table->cosine_int8, int8s, npts, padded_dim, num_compares));
+                print_row(table->name, "l2_uint8", padded_dim,
+                          time_kernel(table->l2_uint8, uint8s, npts, padded_dim, num_compares));
+                print_row(table->name, "cosine_uint8", padded_dim,
+                          time_kernel(table->cosine_uint8, uint8s, npts, padded_dim, num_compares));
+            }
+
+            diskann::aligned_free(floats);
+            diskann::aligned_free(int8s);
+            diskann::aligned_free(uint8s);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
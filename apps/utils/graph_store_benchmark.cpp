@@ -0,0 +1,154 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <boost/program_options.hpp>
+
+#include "defaults.h"
+#include "index_factory.h"
+#include "timer.h"
+#include "utils.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+// Builds a static index of the data file with the graph store of strategy and
+// prints the build time and the memory the graph store holds once built.
+template <typename T>
+void run(const char *name, diskann::GraphStoreStrategy strategy, diskann::Metric metric,
+         const std::string &data_path, uint32_t R, uint32_t L, float alpha, uint32_t num_threads)
+{
+    size_t data_num, data_dim;
+    diskann::get_bin_metadata(data_path, data_num, data_dim);
+
+    auto write_params = diskann::IndexWriteParametersBuilder(L, R)
+                            .with_alpha(alpha)
+                            .with_saturate_graph(false)
+                            .with_num_threads(num_threads)
+                            .build();
+    auto config = diskann::IndexConfigBuilder()
+                      .with_metric(metric)
+                      .with_dimension(data_dim)
+                      .with_max_points(data_num)
+                      .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
+                      .with_graph_load_store_strategy(strategy)
+                      .with_data_type(diskann_type_to_name<T>())
+                      .is_dynamic_index(false)
+                      .with_index_write_params(write_params)
+                      .is_enable_tags(false)
+                      .build();
+
+    const size_t num_points = data_num + config.num_frozen_pts;
+    auto data_store = diskann::IndexFactory::construct_datastore<T>(diskann::DataStoreStrategy::MEMORY, num_points,
+                                                                    data_dim, metric);
+    auto graph_store = diskann::IndexFactory::construct_graphstore(
+        strategy, num_points, (size_t)(diskann::defaults::GRAPH_SLACK_FACTOR * 1.05 * R));
+    diskann::AbstractGraphStore *graph = graph_store.get();
+    diskann::Index<T> index(config, std::move(data_store), std::move(graph_store));
+
+    diskann::Timer timer;
+    index.build(data_path.c_str(), data_num);
+    const double build_s = (double)timer.elapsed() / 1000000.0;
+    std::cout << std::setw(12) << name << std::setw(12) << std::fixed << std::setprecision(2) << build_s
+              << std::setw(14) << graph->get_memory_in_bytes() / (1024.0 * 1024.0) << std::endl;
+}
+
+template <typename T>
+void run_all(const std::vector<std::string> &graph_stores, diskann::Metric metric, const std::string &data_path,
+             uint32_t R, uint32_t L, float alpha, uint32_t num_threads)
+{
+    for (const auto &graph_store : graph_stores)
+    {
+        if (graph_store == std::string("memory"))
+            run<T>("memory", diskann::GraphStoreStrategy::MEMORY, metric, data_path, R, L, alpha, num_threads);
+        else if (graph_store == std::string("compressed"))
+            run<T>("compressed", diskann::GraphStoreStrategy::COMPRESSED, metric, data_path, R, L, alpha,
+                   num_threads);
+        else if (graph_store == std::string("flat"))
+            run<T>("flat", diskann::GraphStoreStrategy::FLAT, metric, data_path, R, L, alpha, num_threads);
+        else
+            std::cerr << "Skipping unsupported graph store " << graph_store << std::endl;
+    }
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string data_type, dist_fn, data_path;
+    std::vector<std::string> graph_stores;
+    uint32_t num_threads, R, L;
+    float alpha;
+
+    try
+    {
+        po::options_description desc{"Arguments"};
+
+        desc.add_options()("help,h", "Print information on arguments");
+        desc.add_options()("data_type", po::value<std::string>(&data_type)->required(), "data type <int8/uint8/float>");
+        desc.add_options()("dist_fn", po::value<std::string>(&dist_fn)->default_value(std::string("l2")),
+                           "Distance function <l2/cosine>");
+        desc.add_options()("data_path", po::value<std::string>(&data_path)->required(),
+                           "Input data file in bin format");
+        desc.add_options()("graph_stores",
+                           po::value<std::vector<std::string>>(&graph_stores)
+                               ->multitoken()
+                               ->default_value(std::vector<std::string>{"memory", "compressed"}, "memory compressed"),
+                           "Graph stores to compare <memory/compressed/flat>");
+        desc.add_options()("max_degree,R", po::value<uint32_t>(&R)->default_value(64), "Maximum graph degree");
+        desc.add_options()("Lbuild,L", po::value<uint32_t>(&L)->default_value(100),
+                           "Build complexity, higher value results in better graphs");
+        desc.add_options()("alpha", po::value<float>(&alpha)->default_value(1.2f),
+                           "alpha controls density and diameter of graph");
+        desc.add_options()("num_threads,T", po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                           "Number of threads used for building index (defaults to omp_get_num_procs())");
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("l2"))
+        metric = diskann::Metric::L2;
+    else if (dist_fn == std::string("cosine"))
+        metric = diskann::Metric::COSINE;
+    else
+    {
+        std::cerr << "Unsupported distance function. Use l2 or cosine." << std::endl;
+        return -1;
+    }
+
+    std::cout << std::setw(12) << "Graph" << std::setw(12) << "Build s" << std::setw(14) << "Graph MB" << std::endl;
+    try
+    {
+        if (data_type == std::string("float"))
+            run_all<float>(graph_stores, metric, data_path, R, L, alpha, num_threads);
+        else if (data_type == std::string("int8"))
+            run_all<int8_t>(graph_stores, metric, data_path, R, L, alpha, num_threads);
+        else if (data_type == std::string("uint8"))
+            run_all<uint8_t>(graph_stores, metric, data_path, R, L, alpha, num_threads);
+        else
+        {
+            std::cerr << "Unsupported type. Use float/int8/uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
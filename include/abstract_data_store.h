@@ -13,6 +13,8 @@
 namespace diskann
 {
 
+template <typename T> struct PQScratch;
+
 template <typename data_t> class AbstractDataStore
 {
   public:
@@ -67,6 +69,11 @@ template <typename data_t> class AbstractDataStore
     virtual void set_vector(const location_t i, const data_t *const vector) = 0;
     virtual void prefetch_vector(const location_t loc) = 0;
 
+    // Whether set_vector can encode vectors. Stores that learn their encoding
+    // from the data, like the PQ and INT8 stores, can not until populate_data
+    // or load has trained them.
+    virtual bool is_trained() const;
+
     // internal shuffle operations to move around vectors
     // will bulk-move all the vectors in [old_start_loc, old_start_loc +
     // num_points) to [new_start_loc, new_start_loc + num_points) and set the old
@@ -85,6 +92,25 @@ template <typename data_t> class AbstractDataStore
                               float *distances) const = 0;
     virtual float get_distance(const location_t loc1, const location_t loc2) const = 0;
 
+    // Per-query variants for searches that compare one query against many
+    // batches of locations. preprocess_query is called once with the aligned
+    // query and may keep per-query state in scratch, e.g. the distance tables
+    // of a PQ store; get_distance then reads it back. The defaults ignore
+    // scratch, which may be null for stores that do not need it.
+    virtual void preprocess_query(const data_t *aligned_query, PQScratch<data_t> *scratch) const;
+    virtual void get_distance(const data_t *aligned_query, const location_t *locations, const uint32_t location_count,
+                              float *distances, PQScratch<data_t> *scratch) const;
+
+    // For stores that keep an approximation of the vectors in memory:
+    // recomputes the distances from the query to the locations against the
+    // full-precision vectors. Locations without a full-precision vector get
+    // std::numeric_limits<float>::max(). vector_scratch is a zeroed aligned
+    // buffer of get_aligned_dim() entries. Returns false, leaving distances
+    // untouched, if the store has nothing more exact than get_distance.
+    virtual bool get_full_precision_distance(const data_t *query, const location_t *locations,
+                                             const uint32_t location_count, float *distances,
+                                             data_t *vector_scratch) const;
+
     // stats of the data stored in store
     // Returns the point in the dataset that is closest to the mean of all points
     // in the dataset
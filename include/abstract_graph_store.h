@@ -10,6 +10,26 @@
 namespace diskann
 {
 
+// The neighbours of a node, as returned by get_neighbours_view
+struct NeighbourView
+{
+    const location_t *ids = nullptr;
+    uint32_t degree = 0;
+
+    const location_t *begin() const
+    {
+        return ids;
+    }
+    const location_t *end() const
+    {
+        return ids + degree;
+    }
+    uint32_t size() const
+    {
+        return degree;
+    }
+};
+
 class AbstractGraphStore
 {
   public:
@@ -28,6 +48,19 @@ class AbstractGraphStore
 
     // not synchronised, user should use lock when necvessary.
     virtual std::vector<location_t> get_neighbours(const location_t i) const = 0;
+    // decodes the neighbours of i into a caller-owned buffer and returns the
+    // degree. out is resized to the degree, so a buffer reused across calls
+    // (e.g. one held in the query scratch) does not allocate in steady state.
+    virtual uint32_t get_neighbours(const location_t i, std::vector<location_t> &out) const = 0;
+    // the neighbours of i without copying them, for stores that keep them
+    // decoded, which ignore buffer. others decode them into buffer. valid
+    // until the list of i changes, the graph is resized or buffer is reused.
+    virtual NeighbourView get_neighbours_view(const location_t i, std::vector<location_t> &buffer) const
+    {
+        const uint32_t degree = get_neighbours(i, buffer);
+        return NeighbourView{buffer.data(), degree};
+    }
+    virtual uint32_t get_degree(const location_t i) const = 0;
     virtual void add_neighbour(const location_t i, location_t neighbour_id) = 0;
     virtual void clear_neighbours(const location_t i) = 0;
     virtual void swap_neighbours(const location_t a, location_t b) = 0;
@@ -42,6 +75,16 @@ class AbstractGraphStore
     // set during load
     virtual size_t get_max_range_of_graph() = 0;
 
+    // bytes held by the adjacency lists, including reserved but unused space
+    virtual size_t get_memory_in_bytes() = 0;
+
+    // frees space kept only to make adding edges cheap, once no or few edges
+    // are expected to be added, e.g. when a static index is built. the graph
+    // stays usable, later changes may just be slower.
+    virtual void release_build_memory()
+    {
+    }
+
     // Total internal points _max_points + _num_frozen_points
     size_t get_total_points()
     {
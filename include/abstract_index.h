@@ -71,6 +71,12 @@ class AbstractIndex
     std::pair<uint32_t, uint32_t> search(const data_type *query, const size_t K, const uint32_t L, IDType *indices,
                                          float *distances = nullptr);
 
+    // Points within range of the query, see Index::range_search. IDType is
+    // either uint32_t or uint64_t
+    template <typename data_type, typename IDType>
+    uint32_t range_search(const data_type *query, const float range, const uint32_t min_l_search,
+                          const uint32_t max_l_search, std::vector<IDType> &indices, std::vector<float> &distances);
+
     // Filter support search
     // IndexType is either uint32_t or uint64_t
     template <typename IndexType>
@@ -78,6 +84,14 @@ class AbstractIndex
                                                       const size_t K, const uint32_t L, IndexType *indices,
                                                       float *distances);
 
+    // Search with a filter expression of raw labels, see
+    // Index::search_with_filters and FilterExpression::parse.
+    // IndexType is either uint32_t or uint64_t
+    template <typename IndexType>
+    std::pair<uint32_t, uint32_t> search_with_filter_expression(const DataType &query, const std::string &raw_filter,
+                                                                const size_t K, const uint32_t L,
+                                                                IndexType *indices, float *distances);
+
     // insert points with labels, labels should be present for filtered index
     template <typename data_type, typename tag_type, typename label_type>
     int insert_point(const data_type *point, const tag_type tag, const std::vector<label_type> &labels);
@@ -112,6 +126,10 @@ class AbstractIndex
     virtual std::pair<uint32_t, uint32_t> _search_with_filters(const DataType &query, const std::string &filter_label,
                                                                const size_t K, const uint32_t L, std::any &indices,
                                                                float *distances) = 0;
+    virtual std::pair<uint32_t, uint32_t> _search_with_filter_expression(const DataType &query,
+                                                                          const std::string &raw_filter,
+                                                                          const size_t K, const uint32_t L,
+                                                                          std::any &indices, float *distances) = 0;
     virtual int _insert_point(const DataType &data_point, const TagType tag, Labelvector &labels) = 0;
     virtual int _insert_point(const DataType &data_point, const TagType tag) = 0;
     virtual int _lazy_delete(const TagType &tag) = 0;
@@ -121,6 +139,8 @@ class AbstractIndex
     virtual int _get_vector_by_tag(TagType &tag, DataType &vec) = 0;
     virtual size_t _search_with_tags(const DataType &query, const uint64_t K, const uint32_t L, const TagType &tags,
                                      float *distances, DataVector &res_vectors) = 0;
+    virtual uint32_t _range_search(const DataType &query, const float range, const uint32_t min_l_search,
+                                   const uint32_t max_l_search, std::any &indices, std::vector<float> &distances) = 0;
     virtual void _search_with_optimized_layout(const DataType &query, size_t K, size_t L, uint32_t *indices) = 0;
     virtual void _set_universal_label(const LabelType universal_label) = 0;
 };
@@ -64,10 +64,12 @@ struct IOContext
 #endif
 
 #include <malloc.h>
+#include <algorithm>
 #include <cstdio>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include "tsl/robin_map.h"
+#include <unordered_map>
 #include "utils.h"
 
 // NOTE :: all 3 fields must be 512-aligned
@@ -92,10 +94,6 @@ struct AlignedRead
 
 class AlignedFileReader
 {
-  protected:
-    tsl::robin_map<std::thread::id, IOContext> ctx_map;
-    std::mutex ctx_mut;
-
   public:
     // returns the thread-specific context
     // returns (io_context_t)(-1) if thread is not registered
@@ -109,6 +107,21 @@ class AlignedFileReader
     virtual void deregister_thread() = 0;
     virtual void deregister_all_threads() = 0;
 
+    // returns a new context that is not bound to any thread. the caller owns
+    // it, may use it from any thread as long as one thread uses it at a time,
+    // and must release it with destroy_ctx. readers that can only hand out
+    // thread-bound contexts register the calling thread instead.
+    virtual IOContext create_ctx()
+    {
+        register_thread();
+        return get_ctx();
+    }
+    virtual void destroy_ctx(IOContext &ctx)
+    {
+        std::lock_guard<std::mutex> lock(_sync_completed_mut);
+        _sync_completed.erase(&ctx);
+    }
+
     // Open & close ops
     // Blocking calls
     virtual void open(const std::string &fname) = 0;
@@ -117,4 +130,59 @@ class AlignedFileReader
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     virtual void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false) = 0;
+
+    // issue batch of aligned requests and return without waiting for them.
+    // completions are collected with get_completed_reads on the same ctx.
+    // readers without native async support complete the batch here.
+    virtual void submit_reads(std::vector<AlignedRead> &read_reqs, IOContext &ctx)
+    {
+        read(read_reqs, ctx);
+        std::lock_guard<std::mutex> lock(_sync_completed_mut);
+        auto &done = _sync_completed[&ctx];
+        for (auto &req : read_reqs)
+        {
+            done.push_back(req.buf);
+        }
+    }
+
+    // blocks until at least the given number of submitted requests finish,
+    // and appends the buf of every finished request to completed_bufs.
+    // returns the number of requests appended. the default has completed
+    // every request in submit_reads already, so it does not block.
+    virtual uint64_t get_completed_reads(IOContext &ctx, uint64_t, std::vector<void *> &completed_bufs)
+    {
+        std::lock_guard<std::mutex> lock(_sync_completed_mut);
+        auto iter = _sync_completed.find(&ctx);
+        if (iter == _sync_completed.end())
+            return 0;
+        completed_bufs.insert(completed_bufs.end(), iter->second.begin(), iter->second.end());
+        uint64_t n_done = iter->second.size();
+        _sync_completed.erase(iter);
+        return n_done;
+    }
+
+    // waits for every request submitted on ctx that get_completed_reads has
+    // not returned, and drops them whether they failed or not. a search that
+    // stops with reads in flight, e.g. on a failed read, calls it so that
+    // they do not complete into buffers the next user of ctx reuses, nor
+    // show up in its get_completed_reads. does not throw.
+    virtual void drain_reads(IOContext &ctx)
+    {
+        std::lock_guard<std::mutex> lock(_sync_completed_mut);
+        _sync_completed.erase(&ctx);
+    }
+
+    // hint that reads on the context will mostly target the len bytes at buf,
+    // e.g. the sector scratch paired with it. readers that support it pin and
+    // map the range once instead of on every request; others ignore it.
+    virtual void register_buffer(IOContext &, void *, uint64_t)
+    {
+    }
+
+  private:
+    // requests completed by the default submit_reads and not yet returned by
+    // get_completed_reads, by context. keyed by the address of the context,
+    // which callers keep in place while they have requests pending on it.
+    std::unordered_map<const IOContext *, std::vector<void *>> _sync_completed;
+    std::mutex _sync_completed_mut;
 };
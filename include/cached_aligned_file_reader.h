@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "aligned_file_reader.h"
+#include "node_cache.h"
+#include "tsl/robin_map.h"
+
+// AlignedFileReader that serves reads from a sector cache before passing them
+// on to another reader.
+//
+// The cache is a NodeCache of SECTOR_LEN records keyed by (file, sector), so
+// one cache, and one memory budget, can be shared by the readers of any number
+// of PQFlashIndex objects in a process. Popular sectors of busy indices then
+// displace those of idle ones instead of every index getting a fixed share.
+// Readers that open the same file share its cached sectors while any of them
+// has it open. Files are told apart by device, inode, size and modification
+// time, and a file opened again after all its readers closed it starts cold,
+// so a rewritten file is never served the sectors of its old contents.
+//
+// A request is served from the cache only if all of its sectors are cached;
+// otherwise it goes to the wrapped reader and its sectors are offered to the
+// cache once the read completes. Hits and misses are counted per reader, the
+// cache itself keeps the process-wide counts.
+class CachedAlignedFileReader : public AlignedFileReader
+{
+  public:
+    CachedAlignedFileReader(std::shared_ptr<AlignedFileReader> reader,
+                            std::shared_ptr<diskann::NodeCache> sector_cache);
+    ~CachedAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    IOContext create_ctx();
+    void destroy_ctx(IOContext &ctx);
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous counterpart of read, see AlignedFileReader
+    void submit_reads(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reads(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+    void drain_reads(IOContext &ctx);
+
+    void register_buffer(IOContext &ctx, void *buf, uint64_t len);
+
+    // requests of this reader served from / not found in the sector cache
+    uint64_t get_hits() const;
+    uint64_t get_misses() const;
+    void reset_stats();
+
+  private:
+    // requests on one context between submit_reads and get_completed_reads:
+    // buffers already filled from the cache, and reads passed on to the
+    // wrapped reader, by buffer
+    struct PendingReads
+    {
+        std::vector<void *> served;
+        tsl::robin_map<void *, AlignedRead> in_flight;
+    };
+
+    // copies the sectors of req out of the cache if all of them are cached
+    bool read_from_cache(const AlignedRead &req);
+    void insert_into_cache(const AlignedRead &req);
+    // lets go of the id of the open file, if any
+    void release_file_id();
+
+    // pending requests of ctx, created on first use. only the thread using
+    // ctx touches its entry, _pending_mut guards the map itself.
+    PendingReads &pending_reads(IOContext &ctx);
+    void clear_pending_reads(IOContext &ctx);
+
+    std::shared_ptr<AlignedFileReader> _reader;
+    std::shared_ptr<diskann::NodeCache> _sector_cache;
+    // process-wide id of the open file, the upper bits of every cache key. 0
+    // while no file is open.
+    uint64_t _file_id = 0;
+    std::string _file_identity;
+
+    std::atomic<uint64_t> _hits{0}, _misses{0};
+
+    // keyed by the address of the context, which callers keep in place while
+    // they have requests pending on it
+    std::unordered_map<const IOContext *, PendingReads> _pending;
+    std::mutex _pending_mut;
+};
@@ -18,12 +18,21 @@ const uint32_t NUM_FROZEN_POINTS_DYNAMIC = 1;
 
 // In-mem index related limits
 const float GRAPH_SLACK_FACTOR = 1.3;
+// Append slots per node in the compressed graph store, as a fraction of the
+// reserved degree. Covers the (GRAPH_SLACK_FACTOR - 1) * R back-edges a node
+// can receive between two prunes.
+const float COMPRESSED_GRAPH_TAIL_FRACTION = 0.25f;
 
 // SSD Index related limits
 const uint64_t MAX_GRAPH_DEGREE = 512;
 const uint64_t SECTOR_LEN = 4096;
 const uint64_t MAX_N_SECTOR_READS = 128;
 
+// Memory all the query scratches of an index may take together for visited
+// sets that hold a stamp or a bit per point (see VisitedSet::choose). Beyond
+// it searches use a hash set, or a bloom filter for billion-scale disk indices.
+const uint64_t MAX_VISITED_SET_BYTES = 128 * 1024 * 1024;
+
 // following constants should always be specified, but are useful as a
 // sensible default at cli / python boundaries
 const uint32_t MAX_DEGREE = 64;
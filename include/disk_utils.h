@@ -100,9 +100,24 @@ DISKANN_DLLEXPORT int build_disk_index(
     const std::string &universal_label = "", const uint32_t filter_threshold = 0,
     const uint32_t Lf = 0); // default is empty string for no universal label
 
+// Orders the nodes of graph for the disk layout so that a sector read brings
+// in nodes close to each other in the graph. Sectors are filled one at a
+// time by a breadth-first walk from a seed, and seeds are taken in BFS order
+// from the medoid, then in id order for nodes it does not reach. Returns the
+// layout with layout[position] = id.
+DISKANN_DLLEXPORT std::vector<uint32_t> compute_locality_layout(const std::vector<std::vector<uint32_t>> &graph,
+                                                                uint32_t medoid, uint64_t nnodes_per_sector);
+
+// Writes the disk index of the in-memory index in mem_index_file and the
+// vectors in base_file. With locality_layout, nodes are placed on disk in
+// the order of compute_locality_layout and the order is saved to
+// output_file + "_layout_perm.bin", which PQFlashIndex picks up on load. This
+// holds the whole graph in memory and only applies when several nodes fit in
+// a sector.
 template <typename T>
 DISKANN_DLLEXPORT void create_disk_layout(const std::string base_file, const std::string mem_index_file,
                                           const std::string output_file,
-                                          const std::string reorder_data_file = std::string(""));
+                                          const std::string reorder_data_file = std::string(""),
+                                          const bool locality_layout = false);
 
 } // namespace diskann
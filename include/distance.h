@@ -1,6 +1,8 @@
 #pragma once
 #include "windows_customizations.h"
+#include <cstdint>
 #include <cstring>
+#include <xmmintrin.h>
 
 namespace diskann
 {
@@ -12,6 +14,44 @@ enum Metric
     FAST_L2 = 3
 };
 
+// How many points ahead of the one it compares compare_batch prefetches
+const uint32_t COMPARE_BATCH_PREFETCH_AHEAD = 2;
+
+// The loop of compare_batch: the distances from query to the count points at
+// base + ids[i] * stride, with compare(query, point, length), prefetching the
+// point COMPARE_BATCH_PREFETCH_AHEAD ahead of the one compared.
+template <typename T, typename Compare>
+inline void compare_batch_prefetched(const T *query, const T *base, const size_t stride, const uint32_t *ids,
+                                     const uint32_t count, const uint32_t length, float *distances,
+                                     const Compare &compare)
+{
+    const size_t prefetch_size = ((size_t)length * sizeof(T) / 64) * 64;
+    auto prefetch = [&](const uint32_t i) {
+        const char *vec = (const char *)(base + ids[i] * stride);
+        for (size_t d = 0; d < prefetch_size; d += 64)
+            _mm_prefetch(vec + d, _MM_HINT_T0);
+    };
+    for (uint32_t i = 0; i < count && i < COMPARE_BATCH_PREFETCH_AHEAD; i++)
+        prefetch(i);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i + COMPARE_BATCH_PREFETCH_AHEAD < count)
+            prefetch(i + COMPARE_BATCH_PREFETCH_AHEAD);
+        distances[i] = compare(query, base + ids[i] * stride, length);
+    }
+}
+
+// compare_batch of the distance class Dist, which calls Dist::compare without
+// going through the vtable, so that its kernel is inlined or called directly.
+// The overrides of compare_batch forward to it.
+template <typename Dist, typename T>
+inline void compare_batch_with(const Dist &dist, const T *query, const T *base, const size_t stride,
+                               const uint32_t *ids, const uint32_t count, const uint32_t length, float *distances)
+{
+    compare_batch_prefetched(query, base, stride, ids, count, length, distances,
+                             [&dist](const T *a, const T *b, uint32_t len) { return dist.Dist::compare(a, b, len); });
+}
+
 template <typename T> class Distance
 {
   public:
@@ -26,6 +66,14 @@ template <typename T> class Distance
     DISKANN_DLLEXPORT virtual float compare(const T *a, const T *b, const float normA, const float normB,
                                             uint32_t length) const;
 
+    // Distances from query to the count points at base + ids[i] * stride, see
+    // compare_batch_prefetched. The default calls the virtual compare per
+    // point; the distances that get_distance_function returns override it
+    // with compare_batch_with to call their kernel directly.
+    DISKANN_DLLEXPORT virtual void compare_batch(const T *query, const T *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const;
+
     // For MIPS, normalization adds an extra dimension to the vectors.
     // This function lets callers know if the normalization process
     // changes the dimension.
@@ -78,6 +126,9 @@ class DistanceCosineInt8 : public Distance<int8_t>
     {
     }
     DISKANN_DLLEXPORT virtual float compare(const int8_t *a, const int8_t *b, uint32_t length) const;
+    DISKANN_DLLEXPORT virtual void compare_batch(const int8_t *query, const int8_t *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 class DistanceL2Int8 : public Distance<int8_t>
@@ -87,6 +138,9 @@ class DistanceL2Int8 : public Distance<int8_t>
     {
     }
     DISKANN_DLLEXPORT virtual float compare(const int8_t *a, const int8_t *b, uint32_t size) const;
+    DISKANN_DLLEXPORT virtual void compare_batch(const int8_t *query, const int8_t *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 // AVX implementations. Borrowed from HNSW code.
@@ -106,6 +160,9 @@ class DistanceCosineFloat : public Distance<float>
     {
     }
     DISKANN_DLLEXPORT virtual float compare(const float *a, const float *b, uint32_t length) const;
+    DISKANN_DLLEXPORT virtual void compare_batch(const float *query, const float *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 class DistanceL2Float : public Distance<float>
@@ -120,6 +177,9 @@ class DistanceL2Float : public Distance<float>
 #else
     DISKANN_DLLEXPORT virtual float compare(const float *a, const float *b, uint32_t size) const __attribute__((hot));
 #endif
+    DISKANN_DLLEXPORT virtual void compare_batch(const float *query, const float *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 class AVXDistanceL2Float : public Distance<float>
@@ -156,6 +216,9 @@ class DistanceL2UInt8 : public Distance<uint8_t>
     {
     }
     DISKANN_DLLEXPORT virtual float compare(const uint8_t *a, const uint8_t *b, uint32_t size) const;
+    DISKANN_DLLEXPORT virtual void compare_batch(const uint8_t *query, const uint8_t *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 template <typename T> class DistanceInnerProduct : public Distance<T>
@@ -199,6 +262,9 @@ class AVXDistanceInnerProductFloat : public Distance<float>
     {
     }
     DISKANN_DLLEXPORT virtual float compare(const float *a, const float *b, uint32_t length) const;
+    DISKANN_DLLEXPORT virtual void compare_batch(const float *query, const float *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
 };
 
 class AVXNormalizedCosineDistanceFloat : public Distance<float>
@@ -219,6 +285,9 @@ class AVXNormalizedCosineDistanceFloat : public Distance<float>
         // This will ensure that cosine is between -1 and 1.
         return 1.0f + _innerProduct.compare(a, b, length);
     }
+    DISKANN_DLLEXPORT virtual void compare_batch(const float *query, const float *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
     DISKANN_DLLEXPORT virtual uint32_t post_normalization_dimension(uint32_t orig_dimension) const override;
 
     DISKANN_DLLEXPORT virtual bool preprocessing_required() const;
@@ -230,6 +299,28 @@ class AVXNormalizedCosineDistanceFloat : public Distance<float>
                                                     float *scratch_query_vector) override;
 };
 
+// Calls one kernel of a DistanceKernels table (see distance_kernels.h).
+// get_distance_function returns these when the CPU has AVX-512.
+template <typename T> class KernelDistance : public Distance<T>
+{
+  public:
+    typedef float (*Kernel)(const T *a, const T *b, uint32_t length);
+
+    KernelDistance(diskann::Metric metric, Kernel kernel) : Distance<T>(metric), _kernel(kernel)
+    {
+    }
+    DISKANN_DLLEXPORT virtual float compare(const T *a, const T *b, uint32_t length) const
+    {
+        return _kernel(a, b, length);
+    }
+    DISKANN_DLLEXPORT virtual void compare_batch(const T *query, const T *base, const size_t stride,
+                                                 const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                 float *distances) const override;
+
+  private:
+    Kernel _kernel;
+};
+
 template <typename T> Distance<T> *get_distance_function(Metric m);
 
 } // namespace diskann
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Distance kernels for one instruction set. Every kernel returns a distance,
+// smaller is closer: squared L2, negated inner product, or 1 - cosine
+// similarity. Inputs follow the rules of the Distance class the kernel
+// stands in for; the AVX-512 kernels take any alignment and length.
+struct DistanceKernels
+{
+    const char *name;
+
+    float (*l2_float)(const float *a, const float *b, uint32_t length);
+    float (*inner_product_float)(const float *a, const float *b, uint32_t length);
+    float (*cosine_float)(const float *a, const float *b, uint32_t length);
+
+    float (*l2_int8)(const int8_t *a, const int8_t *b, uint32_t length);
+    float (*cosine_int8)(const int8_t *a, const int8_t *b, uint32_t length);
+
+    float (*l2_uint8)(const uint8_t *a, const uint8_t *b, uint32_t length);
+    float (*cosine_uint8)(const uint8_t *a, const uint8_t *b, uint32_t length);
+};
+
+// The kernels get_distance_function uses on this CPU, chosen once per
+// process: AVX-512 VNNI, AVX-512 (F, BW and VL), or the AVX2/scalar ones
+// the build was compiled for.
+DISKANN_DLLEXPORT const DistanceKernels &get_distance_kernels();
+
+// The individual tables, for tests and benchmarks. The AVX-512 ones are
+// nullptr if this CPU does not support them.
+DISKANN_DLLEXPORT const DistanceKernels &get_baseline_distance_kernels();
+DISKANN_DLLEXPORT const DistanceKernels *get_avx512_distance_kernels();
+DISKANN_DLLEXPORT const DistanceKernels *get_avx512_vnni_distance_kernels();
+} // namespace diskann
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "label_bitmap_index.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+
+// Boolean filter over the labels of a point, such as
+// "region=EU AND (category=a OR category=b) AND NOT discontinued", compiled to
+// a disjunction of clauses, each requiring some labels and excluding others.
+// A search starts from the start points of the labels of each clause and only
+// visits points that match the filter. A point with the universal label has
+// every required label, but is excluded by the labels it actually has.
+template <typename LabelT> class FilterExpression
+{
+  public:
+    struct Clause
+    {
+        std::vector<LabelT> labels;          // sorted, all required
+        std::vector<LabelT> excluded_labels; // sorted, none allowed
+    };
+
+    // Tests points against an expression with the bitmaps of its labels
+    // looked up once, for loops that test many points.
+    class Matcher
+    {
+      public:
+        DISKANN_DLLEXPORT Matcher(const FilterExpression<LabelT> &expression, const LabelBitmapIndex<LabelT> &index,
+                                  const bool use_universal_label, const LabelT &universal_label);
+
+        inline bool matches(const uint32_t point) const
+        {
+            const bool has_universal_label = _use_universal_label && _universal_label.matches(point);
+            uint32_t begin = 0;
+            for (const auto &clause_end : _clause_ends)
+            {
+                bool match = true;
+                for (uint32_t i = begin; match && i < clause_end.first; i++)
+                    match = has_universal_label || _labels[i].matches(point);
+                for (uint32_t i = clause_end.first; match && i < clause_end.second; i++)
+                    match = !_labels[i].matches(point);
+                if (match)
+                    return true;
+                begin = clause_end.second;
+            }
+            return false;
+        }
+
+      private:
+        // required then excluded labels of every clause, one after the other
+        std::vector<typename LabelBitmapIndex<LabelT>::Matcher> _labels;
+        // end of the required and of the excluded labels of each clause
+        std::vector<std::pair<uint32_t, uint32_t>> _clause_ends;
+        const bool _use_universal_label;
+        const typename LabelBitmapIndex<LabelT>::Matcher _universal_label;
+    };
+
+    // The expression that matches no point.
+    FilterExpression() = default;
+
+    DISKANN_DLLEXPORT static FilterExpression<LabelT> label(const LabelT &label);
+    DISKANN_DLLEXPORT static FilterExpression<LabelT> conjunction(const FilterExpression<LabelT> &left,
+                                                                  const FilterExpression<LabelT> &right);
+    DISKANN_DLLEXPORT static FilterExpression<LabelT> disjunction(const FilterExpression<LabelT> &left,
+                                                                  const FilterExpression<LabelT> &right);
+    DISKANN_DLLEXPORT static FilterExpression<LabelT> negation(const FilterExpression<LabelT> &expression);
+
+    // Compiles an expression of raw labels combined with AND, OR, NOT and
+    // parentheses, with NOT binding tightest and AND tighter than OR. Labels
+    // are separated by spaces or parentheses, and convert_label maps each to
+    // its LabelT. Throws ANNException on a malformed expression.
+    DISKANN_DLLEXPORT static FilterExpression<LabelT> parse(
+        const std::string &expression, const std::function<LabelT(const std::string &)> &convert_label);
+
+    const std::vector<Clause> &clauses() const
+    {
+        return _clauses;
+    }
+
+    // has_label(label) tells whether the point has label.
+    template <typename HasLabel> bool matches(const HasLabel &has_label, const bool has_universal_label) const
+    {
+        for (const auto &clause : _clauses)
+        {
+            bool match = true;
+            for (size_t i = 0; match && i < clause.labels.size(); i++)
+                match = has_universal_label || has_label(clause.labels[i]);
+            for (size_t i = 0; match && i < clause.excluded_labels.size(); i++)
+                match = !has_label(clause.excluded_labels[i]);
+            if (match)
+                return true;
+        }
+        return false;
+    }
+
+    // Limit on the clauses of a compiled expression, which can grow
+    // exponentially with the size of the expression, e.g. for ANDs of ORs.
+    static constexpr size_t MAX_CLAUSES = 256;
+
+  private:
+    std::vector<Clause> _clauses;
+};
+
+} // namespace diskann
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Page sizes to try for large allocations, in the order of preference
+// HUGE_1GB > HUGE_2MB > TRANSPARENT > NONE. Each policy falls back to the
+// next one down when the system has no pages of that size to give, so asking
+// for 1GB pages on a machine without a 1GB pool still gets 2MB or transparent
+// huge pages.
+enum class HugePagePolicy
+{
+    NONE,        // regular pages from the aligned allocator
+    TRANSPARENT, // regular mapping, advised to use transparent huge pages
+    HUGE_2MB,    // explicit 2MB pages from the hugetlbfs pool
+    HUGE_1GB     // explicit 1GB pages from the hugetlbfs pool
+};
+
+enum class NumaPolicy
+{
+    NONE,       // first touch, the kernel default
+    INTERLEAVE, // pages spread round robin over all nodes
+    BIND        // pages placed on HugePageConfig::numa_node
+};
+
+// Plain allocations by default, callers opt in to huge pages or NUMA placement
+struct HugePageConfig
+{
+    HugePagePolicy page_policy = HugePagePolicy::NONE;
+    NumaPolicy numa_policy = NumaPolicy::NONE;
+    int numa_node = 0;
+};
+
+// Page sizes and NUMA placement actually obtained by the live large
+// allocations, in bytes. Allocations below HUGE_PAGE_MIN_ALLOCATION are not
+// counted.
+struct HugePageStats
+{
+    size_t regular_bytes = 0;
+    size_t transparent_bytes = 0;
+    size_t huge_2mb_bytes = 0;
+    size_t huge_1gb_bytes = 0;
+    size_t numa_interleaved_bytes = 0;
+    size_t numa_bound_bytes = 0;
+    size_t num_allocations = 0;
+    // large allocations so far that did not get the page size or NUMA
+    // placement asked for, including freed ones
+    size_t num_fallbacks = 0;
+};
+
+// Smaller allocations are served by alloc_aligned as usual
+const size_t HUGE_PAGE_MIN_ALLOCATION = 2 * 1024 * 1024;
+
+// Process wide, applies to the allocations made after the call. The data and
+// graph stores, PQ tables and PQFlashIndex caches allocate through
+// huge_page_alloc, so set this before building or loading an index.
+DISKANN_DLLEXPORT void set_huge_page_config(const HugePageConfig &config);
+DISKANN_DLLEXPORT HugePageConfig get_huge_page_config();
+
+// Binds the allocations of the calling thread to a NUMA node, overriding the
+// process wide NUMA policy, until called again with -1. Used to load one
+// replica of an index per node.
+DISKANN_DLLEXPORT void set_thread_numa_binding(int numa_node);
+
+// Parses the --huge_pages (none, transparent, 2mb, 1gb) and --numa (none,
+// interleave, or a node number to bind to) options of the apps. Throws an
+// ANNException on anything else.
+DISKANN_DLLEXPORT HugePageConfig parse_huge_page_config(const std::string &huge_pages, const std::string &numa);
+
+// Drop-in for alloc_aligned for long lived buffers of index data. The memory
+// is zero filled and must be released with huge_page_free. align must be at
+// most 4096 bytes.
+DISKANN_DLLEXPORT void huge_page_alloc(void **ptr, size_t size, size_t align);
+DISKANN_DLLEXPORT void huge_page_free(void *ptr);
+
+DISKANN_DLLEXPORT HugePageStats get_huge_page_stats();
+DISKANN_DLLEXPORT void print_huge_page_stats();
+
+} // namespace diskann
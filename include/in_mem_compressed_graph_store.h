@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "abstract_graph_store.h"
+
+namespace diskann
+{
+
+// Graph store that keeps each adjacency list as a sorted, delta-encoded
+// streamvbyte block followed by a small uncompressed append tail.
+//
+// Back-edges added by inter_insert go into the tail in place, which lives in a
+// single arena with a fixed number of slots per node. The block is only
+// re-encoded when the tail overflows or when set_neighbours installs a pruned
+// list, so the decode/re-encode cost is paid once per prune instead of once
+// per appended edge. release_build_memory folds the tails into the blocks and
+// frees the arena, after which add_neighbour re-encodes the block every time.
+class InMemCompressedGraphStore : public AbstractGraphStore
+{
+  public:
+    InMemCompressedGraphStore(const size_t total_pts, const size_t reserve_graph_degree);
+
+    // returns tuple of <nodes_read, start, num_frozen_points>
+    virtual std::tuple<uint32_t, uint32_t, size_t> load(const std::string &index_path_prefix,
+                                                        const size_t num_points) override;
+    virtual int store(const std::string &index_path_prefix, const size_t num_points, const size_t num_frozen_points,
+                      const uint32_t start) override;
+
+    virtual std::vector<location_t> get_neighbours(const location_t i) const override;
+    virtual uint32_t get_neighbours(const location_t i, std::vector<location_t> &out) const override;
+    virtual uint32_t get_degree(const location_t i) const override;
+    virtual void add_neighbour(const location_t i, location_t neighbour_id) override;
+    virtual void clear_neighbours(const location_t i) override;
+    virtual void swap_neighbours(const location_t a, location_t b) override;
+
+    virtual void set_neighbours(const location_t i, std::vector<location_t> &neighbors) override;
+
+    virtual size_t resize_graph(const size_t new_size) override;
+    virtual void clear_graph() override;
+
+    virtual size_t get_max_range_of_graph() override;
+    virtual uint32_t get_max_observed_degree() override;
+    virtual size_t get_memory_in_bytes() override;
+    virtual void release_build_memory() override;
+
+  protected:
+    virtual std::tuple<uint32_t, uint32_t, size_t> load_impl(const std::string &filename, size_t expected_num_points);
+
+    int save_graph(const std::string &index_path_prefix, const size_t active_points, const size_t num_frozen_points,
+                   const uint32_t start);
+
+  private:
+    // sorts ids and re-encodes them as the block of node i, emptying its tail.
+    void encode_block(const location_t i, std::vector<location_t> &ids);
+    // folds the tail of node i into its block.
+    void merge_tail(const location_t i);
+
+    size_t _max_range_of_graph = 0;
+    uint32_t _max_observed_degree = 0;
+
+    // sorted, delta-encoded neighbours per node and the number of ids in each
+    std::vector<std::vector<uint8_t>> _blocks;
+    std::vector<uint32_t> _block_degrees;
+
+    // _tail_capacity uncompressed append slots per node, node i owns
+    // [i * _tail_capacity, (i + 1) * _tail_capacity)
+    size_t _tail_capacity;
+    std::vector<location_t> _tails;
+    std::vector<uint32_t> _tail_degrees;
+};
+
+} // namespace diskann
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "abstract_graph_store.h"
+
+namespace diskann
+{
+
+// Uncompressed fixed-degree graph store. Node i owns the row
+// _graph[i * _stride, (i + 1) * _stride): its degree followed by up to
+// _stride - 1 neighbour ids. Rows are padded to a whole number of cache lines
+// and the array is cache-line aligned, so reading a list is a single memcpy
+// from a predictable address with no decode step.
+class InMemFlatGraphStore : public AbstractGraphStore
+{
+  public:
+    InMemFlatGraphStore(const size_t total_pts, const size_t reserve_graph_degree);
+    ~InMemFlatGraphStore();
+
+    // returns tuple of <nodes_read, start, num_frozen_points>
+    virtual std::tuple<uint32_t, uint32_t, size_t> load(const std::string &index_path_prefix,
+                                                        const size_t num_points) override;
+    virtual int store(const std::string &index_path_prefix, const size_t num_points, const size_t num_frozen_points,
+                      const uint32_t start) override;
+
+    virtual std::vector<location_t> get_neighbours(const location_t i) const override;
+    virtual uint32_t get_neighbours(const location_t i, std::vector<location_t> &out) const override;
+    virtual NeighbourView get_neighbours_view(const location_t i, std::vector<location_t> &buffer) const override;
+    virtual uint32_t get_degree(const location_t i) const override;
+    virtual void add_neighbour(const location_t i, location_t neighbour_id) override;
+    virtual void clear_neighbours(const location_t i) override;
+    virtual void swap_neighbours(const location_t a, location_t b) override;
+
+    virtual void set_neighbours(const location_t i, std::vector<location_t> &neighbors) override;
+
+    virtual size_t resize_graph(const size_t new_size) override;
+    virtual void clear_graph() override;
+
+    virtual size_t get_max_range_of_graph() override;
+    virtual uint32_t get_max_observed_degree() override;
+    virtual size_t get_memory_in_bytes() override;
+
+  protected:
+    virtual std::tuple<uint32_t, uint32_t, size_t> load_impl(const std::string &filename, size_t expected_num_points);
+
+    int save_graph(const std::string &index_path_prefix, const size_t active_points, const size_t num_frozen_points,
+                   const uint32_t start);
+
+  private:
+    // reallocates the array with room for num_points rows of max_degree
+    // neighbours each, keeping the lists of the first min(old, new) nodes.
+    void reallocate(const size_t num_points, const size_t max_degree);
+
+    inline uint32_t *row(const location_t i) const
+    {
+        return _graph + (size_t)i * _stride;
+    }
+
+    size_t _max_range_of_graph = 0;
+    uint32_t _max_observed_degree = 0;
+
+    uint32_t *_graph = nullptr;
+    size_t _num_rows = 0;
+    size_t _stride = 0;
+};
+
+} // namespace diskann
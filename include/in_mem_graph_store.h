@@ -20,6 +20,8 @@ class InMemGraphStore : public AbstractGraphStore
                       const uint32_t start) override;
 
     virtual std::vector<location_t> get_neighbours(const location_t i) const override;
+    virtual uint32_t get_neighbours(const location_t i, std::vector<location_t> &out) const override;
+    virtual uint32_t get_degree(const location_t i) const override;
     virtual void add_neighbour(const location_t i, location_t neighbour_id) override;
     virtual void clear_neighbours(const location_t i) override;
     virtual void swap_neighbours(const location_t a, location_t b) override;
@@ -31,6 +33,7 @@ class InMemGraphStore : public AbstractGraphStore
 
     virtual size_t get_max_range_of_graph() override;
     virtual uint32_t get_max_observed_degree() override;
+    virtual size_t get_memory_in_bytes() override;
 
   protected:
     virtual std::tuple<uint32_t, uint32_t, size_t> load_impl(const std::string &filename, size_t expected_num_points);
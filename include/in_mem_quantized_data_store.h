@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "abstract_data_store.h"
+#include "distance.h"
+#include "memory_mapper.h"
+
+namespace diskann
+{
+enum class ScalarQuantization
+{
+    // one byte per dimension, x ~= min[d] + scale[d] * code, with min and
+    // scale taken from the range of each dimension over the populated data
+    INT8,
+    // IEEE half precision, no training needed
+    FP16
+};
+
+// Keeps float vectors scalar quantized in memory, a quarter (INT8) or a half
+// (FP16) of the size of InMemDataStore<float>, and computes distances from a
+// full-precision query to the codes directly.
+//
+// INT8 learns its ranges in populate_data or load; set_vector on a store that
+// was never populated throws, and later vectors are clamped to the learned
+// ranges. save writes the decoded vectors as a regular data file, which loads
+// back to the same codes.
+//
+// If given a rerank_data_file (the full-precision vectors the store was
+// populated from, in the same order) the store memory maps it and serves
+// get_full_precision_distance from it, so that searches can re-rank their
+// candidates exactly while only touching the pages of those candidates.
+class InMemQuantizedDataStore : public AbstractDataStore<float>
+{
+  public:
+    DISKANN_DLLEXPORT InMemQuantizedDataStore(const location_t capacity, const size_t dim,
+                                              const ScalarQuantization quantization,
+                                              std::unique_ptr<Distance<float>> distance_fn,
+                                              const std::string &rerank_data_file = std::string());
+    virtual ~InMemQuantizedDataStore();
+
+    virtual location_t load(const std::string &filename) override;
+    virtual size_t save(const std::string &filename, const location_t num_points) override;
+
+    virtual size_t get_aligned_dim() const override;
+
+    virtual void populate_data(const float *vectors, const location_t num_pts) override;
+    virtual void populate_data(const std::string &filename, const size_t offset) override;
+
+    virtual void extract_data_to_bin(const std::string &filename, const location_t num_pts) override;
+
+    virtual void get_vector(const location_t i, float *target) const override;
+    virtual void set_vector(const location_t i, const float *const vector) override;
+    virtual void prefetch_vector(const location_t loc) override;
+    virtual bool is_trained() const override;
+
+    virtual void move_vectors(const location_t old_location_start, const location_t new_location_start,
+                              const location_t num_points) override;
+    virtual void copy_vectors(const location_t from_loc, const location_t to_loc, const location_t num_points) override;
+
+    virtual float get_distance(const float *query, const location_t loc) const override;
+    virtual float get_distance(const location_t loc1, const location_t loc2) const override;
+    virtual void get_distance(const float *query, const location_t *locations, const uint32_t location_count,
+                              float *distances) const override;
+    virtual bool get_full_precision_distance(const float *query, const location_t *locations,
+                                             const uint32_t location_count, float *distances,
+                                             float *vector_scratch) const override;
+
+    virtual location_t calculate_medoid() const override;
+
+    virtual Distance<float> *get_dist_fn() override;
+
+    virtual size_t get_alignment_factor() const override;
+
+    DISKANN_DLLEXPORT ScalarQuantization get_quantization() const;
+
+  protected:
+    virtual location_t expand(const location_t new_size) override;
+    virtual location_t shrink(const location_t new_size) override;
+
+  private:
+    // copies a vector into an aligned_dim buffer and applies the base point
+    // preprocessing of the metric, e.g. normalization for cosine
+    void preprocess(const float *vector, float *target) const;
+    void update_ranges(const float *vector, std::vector<float> &mins, std::vector<float> &maxs) const;
+    void set_ranges(const std::vector<float> &mins, const std::vector<float> &maxs);
+    void encode(const float *vector, uint8_t *code) const;
+    void decode(const uint8_t *code, float *target) const;
+    float compare(const float *query, const uint8_t *code) const;
+
+    // reads the data file at offset in blocks, training the INT8 ranges on a
+    // first pass, and encodes it into the store
+    location_t populate_from_file(const std::string &filename, const size_t offset);
+    void open_rerank_data(const std::string &rerank_data_file);
+
+    ScalarQuantization _quantization;
+    Metric _metric;
+    size_t _aligned_dim;
+    size_t _code_len;
+    uint8_t *_codes = nullptr;
+
+    // INT8 ranges, aligned_dim long; padding dimensions have zero scale and
+    // min so that they decode to zero
+    std::vector<float> _mins;
+    std::vector<float> _scales;
+    bool _trained = false;
+
+    std::unique_ptr<Distance<float>> _distance_fn;
+
+    std::unique_ptr<MemoryMapper> _rerank_mapper;
+    const float *_rerank_data = nullptr;
+    size_t _rerank_num_points = 0;
+    std::unique_ptr<Distance<float>> _rerank_distance_fn;
+};
+
+} // namespace diskann
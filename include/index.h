@@ -10,7 +10,9 @@
 #endif
 
 #include "distance.h"
+#include "filter_expression.h"
 #include "locking.h"
+#include "label_bitmap_index.h"
 #include "natural_number_map.h"
 #include "natural_number_set.h"
 #include "neighbor.h"
@@ -19,7 +21,9 @@
 #include "windows_customizations.h"
 #include "scratch.h"
 #include "in_mem_data_store.h"
+#include "pq_data_store.h"
 #include "in_mem_graph_store.h"
+#include "packed_node_store.h"
 #include "abstract_index.h"
 
 #define OVERHEAD_FACTOR 1.1
@@ -29,6 +33,8 @@
 namespace diskann
 {
 
+template <typename T, typename TagT, typename LabelT> class IndexSearchIterator;
+
 inline double estimate_ram_usage(size_t size, uint32_t dim, uint32_t datasize, uint32_t degree)
 {
     double size_of_data = ((double)size) * ROUND_UP(dim, 8) * datasize;
@@ -49,6 +55,9 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
      *
      **************************************************************************/
 
+    // pages through a search with iterate_to_fixed_point, see search_iterator.h
+    friend class IndexSearchIterator<T, TagT, LabelT>;
+
   public:
     // Call this when creating and passing Index Config is inconvenient.
     DISKANN_DLLEXPORT Index(Metric m, const size_t dim, const size_t max_points,
@@ -84,6 +93,9 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     DISKANN_DLLEXPORT bool detect_common_filters(uint32_t point_id, bool search_invocation,
                                                  const std::vector<LabelT> &incoming_labels);
 
+    // whether the point at location matches filter, for a search
+    DISKANN_DLLEXPORT bool matches_filter(uint32_t location, const FilterExpression<LabelT> &filter);
+
     // Batch build from a file. Optionally pass tags vector.
     DISKANN_DLLEXPORT void build(const char *filename, const size_t num_points_to_load,
                                  const std::vector<TagT> &tags = std::vector<TagT>());
@@ -108,6 +120,9 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // Get converted integer label from string to int map (_label_map)
     DISKANN_DLLEXPORT LabelT get_converted_label(const std::string &raw_label);
 
+    // Compiles a filter expression of raw labels, see FilterExpression::parse.
+    DISKANN_DLLEXPORT FilterExpression<LabelT> get_converted_filter(const std::string &raw_filter);
+
     // Set starting point of an index before inserting any points incrementally.
     // The data count should be equal to _num_frozen_pts * _aligned_dim.
     DISKANN_DLLEXPORT void set_start_points(const T *data, size_t data_count);
@@ -116,10 +131,13 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // to have higher consistency between index builds.
     DISKANN_DLLEXPORT void set_start_points_at_random(T radius, uint32_t random_seed = 0);
 
-    // For FastL2 search on a static index, we interleave the data with graph
+    // Moves a static index into the packed layout, each vector next to its
+    // adjacency list, see GraphStoreStrategy::PACKED. Use after build or load;
+    // the index then stays read-only. Does nothing if already packed.
     DISKANN_DLLEXPORT void optimize_index_layout();
 
-    // For FastL2 search on optimized layout
+    // Same as search without distances; every search uses the packed layout
+    // once optimize_index_layout has been called.
     DISKANN_DLLEXPORT void search_with_optimized_layout(const T *query, size_t K, size_t L, uint32_t *indices);
 
     // Added search overload that takes L as parameter, so that we
@@ -132,12 +150,35 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     DISKANN_DLLEXPORT size_t search_with_tags(const T *query, const uint64_t K, const uint32_t L, TagT *tags,
                                               float *distances, std::vector<T *> &res_vectors);
 
+    // Finds the points within range of the query, nearest first: distance at
+    // most range, or inner product at least range for INNER_PRODUCT. Starts
+    // with L = min_l_search and doubles L, up to max_l_search, as long as at
+    // least half of the L best candidates are in range. Each larger L resumes
+    // the search from the candidates of the last one. indices and distances
+    // are resized to the number of results, which is returned. If tags is
+    // given, the index must have tags and it gets the tag of each result.
+    template <typename IDType>
+    DISKANN_DLLEXPORT uint32_t range_search(const T *query, const float range, const uint32_t min_l_search,
+                                            const uint32_t max_l_search, std::vector<IDType> &indices,
+                                            std::vector<float> &distances, std::vector<TagT> *tags = nullptr);
+
     // Filter support search
     template <typename IndexType>
     DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> search_with_filters(const T *query, const LabelT &filter_label,
                                                                         const size_t K, const uint32_t L,
                                                                         IndexType *indices, float *distances);
 
+    // Finds the points that match filter. The search starts from the start
+    // point of each label a clause of filter requires, or from the start
+    // points of the index for a clause that requires none, and only visits
+    // points that match filter. If fewer than K points match, the entries of
+    // indices and distances past the results are left as they are.
+    template <typename IndexType>
+    DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> search_with_filters(const T *query,
+                                                                        const FilterExpression<LabelT> &filter,
+                                                                        const size_t K, const uint32_t L,
+                                                                        IndexType *indices, float *distances);
+
     // Will fail if tag already in the index or if tag=0.
     DISKANN_DLLEXPORT int insert_point(const T *point, const TagT tag);
 
@@ -203,6 +244,11 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
                                                                const std::string &filter_label_raw, const size_t K,
                                                                const uint32_t L, std::any &indices,
                                                                float *distances) override;
+    virtual std::pair<uint32_t, uint32_t> _search_with_filter_expression(const DataType &query,
+                                                                         const std::string &raw_filter,
+                                                                         const size_t K, const uint32_t L,
+                                                                         std::any &indices,
+                                                                         float *distances) override;
 
     virtual int _insert_point(const DataType &data_point, const TagType tag) override;
     virtual int _insert_point(const DataType &data_point, const TagType tag, Labelvector &labels) override;
@@ -222,6 +268,10 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     virtual size_t _search_with_tags(const DataType &query, const uint64_t K, const uint32_t L, const TagType &tags,
                                      float *distances, DataVector &res_vectors) override;
 
+    virtual uint32_t _range_search(const DataType &query, const float range, const uint32_t min_l_search,
+                                   const uint32_t max_l_search, std::any &indices,
+                                   std::vector<float> &distances) override;
+
     virtual void _set_universal_label(const LabelType universal_label) override;
 
     // No copy/assign.
@@ -239,6 +289,10 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // determines navigating node of the graph by calculating medoid of datafopt
     uint32_t calculate_entry_point();
 
+    // Throws unless the data store, and the PQ store if any, can encode new
+    // points. PQ pivots come from build(file) or load, not from inserts.
+    void check_stores_trained() const;
+
     void parse_label_file(const std::string &label_file, size_t &num_pts_labels);
 
     std::unordered_map<std::string, LabelT> load_label_map(const std::string &map_file);
@@ -247,10 +301,27 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // with iterate_to_fixed_point.
     std::vector<uint32_t> get_init_ids();
 
+    // Searches until every candidate in the best Lindex of the scratch is
+    // expanded. Candidates already in the scratch are kept, so a search can be
+    // resumed with a larger Lindex. With dropped, the unexpanded candidates
+    // that fall out of the best Lindex are appended to it, see
+    // NeighborPriorityQueue::grow. With use_filter and filter_expression, the
+    // expression filters the points instead of filters, and init_ids are
+    // taken whether they match it or not.
     std::pair<uint32_t, uint32_t> iterate_to_fixed_point(const T *node_coords, const uint32_t Lindex,
                                                          const std::vector<uint32_t> &init_ids,
                                                          InMemQueryScratch<T> *scratch, bool use_filter,
-                                                         const std::vector<LabelT> &filters, bool search_invocation);
+                                                         const std::vector<LabelT> &filters, bool search_invocation,
+                                                         std::vector<Neighbor> *dropped = nullptr,
+                                                         const FilterExpression<LabelT> *filter_expression = nullptr);
+
+    // Re-sorts the candidates of a finished search by full-precision
+    // distance, if the data store holds approximate vectors and can provide
+    // them. Candidates without a full-precision vector keep their approximate
+    // distances, which do not compare with the others, and are moved after
+    // the re-ranked ones in their original order.
+    void rerank_best_l_nodes(InMemQueryScratch<T> *scratch);
+    void rerank_nodes(Neighbor *nodes, size_t num_nodes, InMemQueryScratch<T> *scratch);
 
     void search_for_point_and_prune(int location, uint32_t Lindex, std::vector<uint32_t> &pruned_list,
                                     InMemQueryScratch<T> *scratch, bool use_filter = false,
@@ -322,8 +393,16 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     DISKANN_DLLEXPORT size_t load_data(std::string filename0);
     DISKANN_DLLEXPORT size_t load_tags(const std::string tag_file_name);
     DISKANN_DLLEXPORT size_t load_delete_set(const std::string &filename);
+    // Loads the vectors and the graph from a file written by save for a packed
+    // index, in place of load_data and load_graph.
+    DISKANN_DLLEXPORT size_t load_packed(const std::string &filename);
 #endif
 
+    // Copies the data and graph stores into a PackedNodeStore and swaps them
+    // for views of it. Acquire exclusive _update_lock before calling.
+    void pack_layout();
+    void use_packed_nodes(std::shared_ptr<PackedNodeStore> nodes);
+
   private:
     // Distance functions
     Metric _dist_metric = diskann::L2;
@@ -334,7 +413,10 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // Graph related data structures
     std::unique_ptr<AbstractGraphStore> _graph_store;
 
-    char *_opt_graph = nullptr;
+    // With GraphStoreStrategy::PACKED, or after optimize_index_layout,
+    // _data_store and _graph_store are views of _packed_nodes.
+    bool _packed_layout = false;
+    std::shared_ptr<PackedNodeStore> _packed_nodes;
 
     T *_data = nullptr; // coordinates of all base points
     // Dimensions
@@ -349,9 +431,6 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // See also _start below.
     size_t _num_frozen_pts = 0;
     size_t _frozen_pts_used = 0;
-    size_t _node_size;
-    size_t _data_len;
-    size_t _neighbor_len;
 
     //  Start point of the search. When _num_frozen_pts is greater than zero,
     //  this is the location of the first frozen point. Otherwise, this is a
@@ -372,6 +451,10 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // Location to label is only updated during insert_point(), all other reads are protected by
     // default as a location can only be released at end of consolidate deletes
     std::vector<std::vector<LabelT>> _location_to_labels;
+    // Bitmaps of the same labels for detect_common_filters. Set up by
+    // parse_label_file for indices that are not dynamic, whose labels do not
+    // change after that; empty for dynamic ones.
+    LabelBitmapIndex<LabelT> _label_index;
     tsl::robin_set<LabelT> _labels;
     std::string _labels_file;
     std::unordered_map<LabelT, uint32_t> _label_to_start_id;
@@ -391,14 +474,16 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
 
     // Query scratch data structures
     ConcurrentQueue<InMemQueryScratch<T> *> _query_scratch;
-
-    // Flags for PQ based distance calculation
+    // scratches created for _query_scratch, which share the visited set
+    // budget
+    uint32_t _num_query_scratch = 0;
+
+    // PQ based distance calculation. With pq_dist_build, searches walk the
+    // graph on the codes of _pq_data_store and pruning uses the full vectors
+    // of _data_store; with DataStoreStrategy::PQ, _data_store holds the codes
+    // and there is no _pq_data_store. _pq_dist is set in both cases.
     bool _pq_dist = false;
-    bool _use_opq = false;
-    size_t _num_pq_chunks = 0;
-    uint8_t *_pq_data = nullptr;
-    bool _pq_generated = false;
-    FixedChunkPQTable _pq_table;
+    std::unique_ptr<PQDataStore<T>> _pq_data_store;
 
     //
     // Data structures, locks and flags for dynamic indexing and tags
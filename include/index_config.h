@@ -5,12 +5,26 @@ namespace diskann
 {
 enum class DataStoreStrategy
 {
-    MEMORY
+    MEMORY,
+    // scalar quantized float vectors, see InMemQuantizedDataStore
+    QUANTIZED_INT8,
+    QUANTIZED_FP16,
+    // product quantization codes only, num_pq_chunks bytes per point, see
+    // PQDataStore
+    PQ
 };
 
 enum class GraphStoreStrategy
 {
-    MEMORY
+    MEMORY,
+    COMPRESSED,
+    FLAT,
+    // read-only layout of a static index with every vector next to its
+    // adjacency list, see PackedNodeStore. The index is built or loaded into
+    // regular stores and packed once complete, or loaded from the .packed
+    // file that save writes next to the other index files, which is read
+    // straight into the packed rows without rebuilding them.
+    PACKED
 };
 
 struct IndexConfig
@@ -36,6 +50,10 @@ struct IndexConfig
     std::string tag_type;
     std::string data_type;
 
+    // Full-precision data file that quantized data stores re-rank search
+    // candidates against, empty for none
+    std::string rerank_data_file;
+
     // Params for building index
     std::shared_ptr<IndexWriteParameters> index_write_params;
     // Params for searching index
@@ -47,12 +65,13 @@ struct IndexConfig
                 bool pq_dist_build, bool concurrent_consolidate, bool use_opq, bool filtered_index,
                 std::string &data_type, const std::string &tag_type, const std::string &label_type,
                 std::shared_ptr<IndexWriteParameters> index_write_params,
-                std::shared_ptr<IndexSearchParams> index_search_params)
+                std::shared_ptr<IndexSearchParams> index_search_params, const std::string &rerank_data_file)
         : data_strategy(data_strategy), graph_strategy(graph_strategy), metric(metric), dimension(dimension),
           max_points(max_points), dynamic_index(dynamic_index), enable_tags(enable_tags), pq_dist_build(pq_dist_build),
           concurrent_consolidate(concurrent_consolidate), use_opq(use_opq), filtered_index(filtered_index),
           num_pq_chunks(num_pq_chunks), num_frozen_pts(num_frozen_points), label_type(label_type), tag_type(tag_type),
-          data_type(data_type), index_write_params(index_write_params), index_search_params(index_search_params)
+          data_type(data_type), rerank_data_file(rerank_data_file), index_write_params(index_write_params),
+          index_search_params(index_search_params)
     {
     }
 
@@ -82,6 +101,12 @@ class IndexConfigBuilder
         return *this;
     }
 
+    IndexConfigBuilder &with_rerank_data_file(const std::string &rerank_data_file)
+    {
+        this->_rerank_data_file = rerank_data_file;
+        return *this;
+    }
+
     IndexConfigBuilder &with_dimension(size_t dimension)
     {
         this->_dimension = dimension;
@@ -220,7 +245,7 @@ class IndexConfigBuilder
         return IndexConfig(_data_strategy, _graph_strategy, _metric, _dimension, _max_points, _num_pq_chunks,
                            _num_frozen_pts, _dynamic_index, _enable_tags, _pq_dist_build, _concurrent_consolidate,
                            _use_opq, _filtered_index, _data_type, _tag_type, _label_type, _index_write_params,
-                           _index_search_params);
+                           _index_search_params, _rerank_data_file);
     }
 
     IndexConfigBuilder(const IndexConfigBuilder &) = delete;
@@ -247,6 +272,7 @@ class IndexConfigBuilder
     std::string _label_type{"uint32"};
     std::string _tag_type{"uint32"};
     std::string _data_type;
+    std::string _rerank_data_file;
 
     std::shared_ptr<IndexWriteParameters> _index_write_params;
     std::shared_ptr<IndexSearchParams> _index_search_params;
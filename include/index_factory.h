@@ -1,6 +1,8 @@
 #include "index.h"
 #include "abstract_graph_store.h"
 #include "in_mem_graph_store.h"
+#include "in_mem_compressed_graph_store.h"
+#include "in_mem_flat_graph_store.h"
 
 namespace diskann
 {
@@ -10,13 +12,24 @@ class IndexFactory
     DISKANN_DLLEXPORT explicit IndexFactory(const IndexConfig &config);
     DISKANN_DLLEXPORT std::unique_ptr<AbstractIndex> create_instance();
 
+    // The distance function the in-memory data stores use for metric m
+    template <typename T> DISKANN_DLLEXPORT static std::unique_ptr<Distance<T>> construct_distance(const Metric m);
+
     // Consruct a data store with distance function emplaced within
     template <typename T>
-    DISKANN_DLLEXPORT static std::unique_ptr<AbstractDataStore<T>> construct_datastore(const DataStoreStrategy stratagy,
-                                                                                       const size_t num_points,
-                                                                                       const size_t dimension,
-                                                                                       const Metric m);
+    DISKANN_DLLEXPORT static std::unique_ptr<AbstractDataStore<T>> construct_datastore(
+        const DataStoreStrategy stratagy, const size_t num_points, const size_t dimension, const Metric m,
+        const std::string &rerank_data_file = "");
+
+    // PQ data stores also need the number of chunks and whether to use OPQ
+    template <typename T>
+    DISKANN_DLLEXPORT static std::unique_ptr<PQDataStore<T>> construct_pq_datastore(const size_t num_points,
+                                                                                  const size_t dimension,
+                                                                                  const Metric m,
+                                                                                  const size_t num_pq_chunks,
+                                                                                  const bool use_opq);
 
+    // PACKED gets an InMemGraphStore to build or load into before packing
     DISKANN_DLLEXPORT static std::unique_ptr<AbstractGraphStore> construct_graphstore(
         const GraphStoreStrategy stratagy, const size_t size, const size_t reserve_graph_degree);
 
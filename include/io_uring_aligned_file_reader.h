@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#if !defined(_WINDOWS) && defined(DISKANN_USE_IO_URING)
+
+#include "aligned_file_reader.h"
+#include "thread_io_contexts.h"
+
+// AlignedFileReader on top of io_uring.
+//
+// Every context owns a ring with the index file registered as a fixed file,
+// so requests skip the per-IO file table lookup. Buffers passed to
+// register_buffer are registered with the ring and read with READ_FIXED,
+// which saves pinning and mapping the pages on every request. With SQPOLL a
+// kernel thread, shared by all rings of the reader, polls the submission
+// queues and submission needs no syscall while it is awake.
+//
+// An IOContext of this reader is an opaque handle to its ring and is only
+// meaningful to the reader that created it.
+class IoUringAlignedFileReader : public AlignedFileReader
+{
+  private:
+    struct Ring;
+
+    FileHandle file_desc;
+    io_context_t bad_ctx = (io_context_t)-1;
+    ThreadIOContexts _thread_ctxs{this};
+
+    bool _use_sqpoll;
+    // fd of the first SQPOLL ring, later rings attach to its poller thread
+    std::atomic<int> _sqpoll_wq_fd{-1};
+    // bumped by open(), rings re-register the file when they see a new value
+    std::atomic<uint64_t> _file_generation{0};
+
+    Ring *to_ring(IOContext &ctx);
+    void register_file(Ring *ring);
+
+  public:
+    IoUringAlignedFileReader(bool use_sqpoll = false);
+    ~IoUringAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // contexts owned by the caller instead of a thread, see AlignedFileReader
+    io_context_t create_ctx();
+    void destroy_ctx(io_context_t &ctx);
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous counterpart of read, see AlignedFileReader
+    void submit_reads(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reads(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+    void drain_reads(IOContext &ctx);
+
+    void register_buffer(IOContext &ctx, void *buf, uint64_t len);
+};
+
+#endif
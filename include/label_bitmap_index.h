@@ -0,0 +1,147 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "tsl/robin_map.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+
+// Set of uint32_t ids, compressed roaring-style: the ids are split into chunks
+// by their high 16 bits, and a chunk keeps the low 16 bits of its ids in a
+// sorted array while it holds at most MAX_ARRAY_SIZE of them, and in a 2^16
+// bit bitmap once it holds more. A label held by few points costs about 2
+// bytes per point. MAX_ARRAY_SIZE is well below the 4096 of roaring proper,
+// which only minimizes memory: the arrays stay within a few cache lines, so
+// contains() is a short binary search, for at most 8KB per chunk.
+class RoaringBitmap
+{
+  public:
+    static constexpr uint32_t MAX_ARRAY_SIZE = 256;
+
+    DISKANN_DLLEXPORT void add(const uint32_t id);
+
+    inline bool contains(const uint32_t id) const
+    {
+        const uint16_t key = (uint16_t)(id >> 16);
+        const auto it = std::lower_bound(_keys.begin(), _keys.end(), key);
+        if (it == _keys.end() || *it != key)
+            return false;
+
+        const Chunk &chunk = _chunks[it - _keys.begin()];
+        const uint16_t low = (uint16_t)(id & 0xFFFF);
+        if (!chunk.bits.empty())
+            return (chunk.bits[low >> 6] >> (low & 63)) & 1;
+        return std::binary_search(chunk.array.begin(), chunk.array.end(), low);
+    }
+
+    DISKANN_DLLEXPORT uint64_t cardinality() const;
+    DISKANN_DLLEXPORT uint64_t memory_bytes() const;
+    DISKANN_DLLEXPORT void shrink_to_fit();
+
+  private:
+    struct Chunk
+    {
+        std::vector<uint16_t> array; // sorted low bits of a sparse chunk
+        std::vector<uint64_t> bits;  // 2^16 bits of a dense chunk
+        uint32_t cardinality = 0;
+    };
+
+    // sorted high bits of the chunks, apart from them so that the search for
+    // a chunk stays in a few cache lines
+    std::vector<uint16_t> _keys;
+    std::vector<Chunk> _chunks;
+};
+
+// Labels of the points of an index, for the membership tests of filtered
+// search and build. Points with exactly one label, most points in typical
+// catalogs, keep it in a flat array, so that testing them touches a single
+// LabelT and never the label map or a bitmap. The other points are kept in
+// a RoaringBitmap per label, which then only holds the few points with more
+// than one label.
+template <typename LabelT> class LabelBitmapIndex
+{
+  public:
+    // Tests points against one label, with the bitmap of the label looked up
+    // once, for loops that test many points.
+    class Matcher
+    {
+      public:
+        Matcher(const LabelBitmapIndex<LabelT> &index, const LabelT &label)
+            : _single_labels(index._single_labels.data()), _points(index.multi_label_points(label)), _label(label)
+        {
+        }
+
+        inline bool matches(const uint32_t point) const
+        {
+            const LabelT single_label = _single_labels[point];
+            if (single_label != MULTIPLE_LABELS)
+                return single_label == _label;
+            return _points != nullptr && _points->contains(point);
+        }
+
+      private:
+        const LabelT *_single_labels;
+        const RoaringBitmap *_points;
+        const LabelT _label;
+    };
+
+    // Drops all labels and sets the index up for points 0 to num_points - 1.
+    DISKANN_DLLEXPORT void reset(const uint64_t num_points);
+
+    // Adds the labels of a point without labels so far. Adding points in
+    // increasing order keeps the bitmaps appending.
+    DISKANN_DLLEXPORT void add_point(const uint32_t point, const LabelT *labels, const uint32_t num_labels);
+
+    // Releases the spare capacity left by building the bitmaps.
+    DISKANN_DLLEXPORT void shrink_to_fit();
+
+    inline bool empty() const
+    {
+        return _single_labels.empty();
+    }
+
+    inline bool has_label(const uint32_t point, const LabelT &label) const
+    {
+        const LabelT single_label = _single_labels[point];
+        if (single_label != MULTIPLE_LABELS)
+            return single_label == label;
+        const RoaringBitmap *points = multi_label_points(label);
+        return points != nullptr && points->contains(point);
+    }
+
+    inline Matcher matcher(const LabelT &label) const
+    {
+        return Matcher(*this, label);
+    }
+
+    // every label with the number of points that have it
+    DISKANN_DLLEXPORT void get_label_counts(std::vector<LabelT> &labels, std::vector<uint64_t> &counts) const;
+
+    DISKANN_DLLEXPORT size_t num_labels() const;
+    DISKANN_DLLEXPORT uint64_t memory_bytes() const;
+
+  private:
+    // points with more than one label that have label, null if none
+    const RoaringBitmap *multi_label_points(const LabelT &label) const;
+
+    // in _single_labels for points without labels or with more than one,
+    // whose labels are only in the bitmaps. A point whose one label happens
+    // to be this value is looked up in the bitmaps too, which still works.
+    static constexpr LabelT MULTIPLE_LABELS = std::numeric_limits<LabelT>::max();
+
+    std::vector<LabelT> _single_labels;
+    // position of a label in _bitmaps and _label_counts
+    tsl::robin_map<LabelT, uint32_t> _label_to_bitmap;
+    std::vector<RoaringBitmap> _bitmaps;
+    std::vector<uint64_t> _label_counts;
+};
+
+} // namespace diskann
@@ -5,13 +5,18 @@
 #ifndef _WINDOWS
 
 #include "aligned_file_reader.h"
+#include "thread_io_contexts.h"
 
+// AlignedFileReader on top of libaio. An IOContext of this reader is an
+// opaque handle to the libaio context and the state of its reads in flight,
+// and is only meaningful to the reader that created it.
 class LinuxAlignedFileReader : public AlignedFileReader
 {
   private:
     uint64_t file_sz;
     FileHandle file_desc;
     io_context_t bad_ctx = (io_context_t)-1;
+    ThreadIOContexts _thread_ctxs{this};
 
   public:
     LinuxAlignedFileReader();
@@ -26,6 +31,10 @@ class LinuxAlignedFileReader : public AlignedFileReader
     void deregister_thread();
     void deregister_all_threads();
 
+    // contexts owned by the caller instead of a thread, see AlignedFileReader
+    io_context_t create_ctx();
+    void destroy_ctx(io_context_t &ctx);
+
     // Open & close ops
     // Blocking calls
     void open(const std::string &fname);
@@ -34,6 +43,11 @@ class LinuxAlignedFileReader : public AlignedFileReader
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous counterpart of read, see AlignedFileReader
+    void submit_reads(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reads(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+    void drain_reads(IOContext &ctx);
 };
 
 #endif
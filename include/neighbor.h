@@ -51,12 +51,13 @@ class NeighborPriorityQueue
     // The item will be dropped if it is the same id as an exiting
     // set item or it has a greated distance than the final
     // item in the set. The set cursor that is used to pop() the
-    // next item will be set to the lowest index of an uncheck item
-    void insert(const Neighbor &nbr)
+    // next item will be set to the lowest index of an uncheck item.
+    // Returns whether the item was inserted.
+    bool insert(const Neighbor &nbr)
     {
         if (_size == _capacity && _data[_size - 1] < nbr)
         {
-            return;
+            return false;
         }
 
         size_t lo = 0, hi = _size;
@@ -70,7 +71,7 @@ class NeighborPriorityQueue
             }
             else if (_data[mid].id == nbr.id)
             {
-                return;
+                return false;
             }
             else
             {
@@ -91,6 +92,44 @@ class NeighborPriorityQueue
         {
             _cur = lo;
         }
+        return true;
+    }
+
+    // Inserts the item like insert, for a set that may grow later. Whichever
+    // unexpanded item falls out of a full set, nbr or the last item, is
+    // appended to dropped, so that a search can pick it up again after grow.
+    void insert(const Neighbor &nbr, std::vector<Neighbor> &dropped)
+    {
+        if (_size < _capacity)
+        {
+            insert(nbr);
+            return;
+        }
+        if (_data[_size - 1] < nbr)
+        {
+            dropped.push_back(nbr);
+            return;
+        }
+        // the last item only falls out if nbr goes in, it stays when nbr is
+        // already in the set
+        const Neighbor last = _data[_size - 1];
+        if (insert(nbr) && !last.expanded)
+        {
+            dropped.push_back(last);
+        }
+    }
+
+    // Raises the capacity of the set and inserts the items dropped while it
+    // was smaller. The ones that still do not fit are left in dropped.
+    void grow(size_t capacity, std::vector<Neighbor> &dropped)
+    {
+        reserve(capacity);
+        std::vector<Neighbor> pending;
+        pending.swap(dropped);
+        for (const auto &nbr : pending)
+        {
+            insert(nbr, dropped);
+        }
     }
 
     Neighbor closest_unexpanded()
@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tsl/robin_map.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+
+struct NodeCacheStats
+{
+    uint64_t hits = 0;       // lookups served from the cache
+    uint64_t misses = 0;     // lookups that had to go to disk
+    uint64_t admitted = 0;   // records inserted
+    uint64_t rejected = 0;   // records turned away by the admission filter
+    uint64_t evicted = 0;    // records dropped to make room for admitted ones
+    uint64_t num_cached = 0; // records currently held
+    uint64_t capacity = 0;   // records that fit in the RAM budget
+};
+
+// Bounded, concurrent cache of fixed-size records, such as the bytes of a node
+// as laid out in the disk index or whole sectors of index files, that fills
+// itself from the reads of beam search. Records are keyed by a 64-bit id.
+//
+// Ids are hashed onto shards, each with its own lock, record arena and CLOCK
+// hand, so concurrent queries rarely contend. Every lookup also bumps the id
+// in a per-shard TinyLFU frequency sketch. When a shard is full, a new record
+// is admitted only if its id was seen more often than the CLOCK victim's, so
+// one-off visits during a query cannot flush the frequently visited part of
+// the graph. The sketch halves its counters periodically, letting the cache
+// follow a drifting query distribution.
+class NodeCache
+{
+  public:
+    // holds as many records of record_len bytes as fit in ram_budget_bytes,
+    // including the index and sketch overhead of each record.
+    DISKANN_DLLEXPORT NodeCache(uint64_t ram_budget_bytes, uint64_t record_len);
+    DISKANN_DLLEXPORT ~NodeCache();
+
+    // copies the record of id into out and returns true on a hit.
+    DISKANN_DLLEXPORT bool get(uint64_t id, char *out);
+
+    // offers the record of id, read from disk after a miss, to the cache.
+    // returns true if it was admitted.
+    DISKANN_DLLEXPORT bool insert(uint64_t id, const char *record);
+
+    DISKANN_DLLEXPORT NodeCacheStats get_stats() const;
+    DISKANN_DLLEXPORT void reset_stats();
+
+    DISKANN_DLLEXPORT uint64_t get_capacity() const;
+    DISKANN_DLLEXPORT uint64_t get_record_len() const;
+
+  private:
+    struct Shard;
+
+    Shard &shard_of(uint64_t id) const;
+
+    uint64_t _record_len;
+    uint64_t _capacity = 0;
+    std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+} // namespace diskann
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "huge_page_allocator.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Number of NUMA nodes of the machine. 1 when the library is built without
+// DISKANN_USE_NUMA or the system has no NUMA support.
+DISKANN_DLLEXPORT uint32_t get_num_numa_nodes();
+
+// Restricts the calling thread to the CPUs of a node. Returns false, leaving
+// the thread where it is, if that is not possible.
+DISKANN_DLLEXPORT bool pin_thread_to_numa_node(uint32_t numa_node);
+
+// Assigns search threads to NUMA nodes. A thread is pinned to its node the
+// first time it asks for it and keeps that node for its lifetime, so thread
+// pools such as the REST server's spread over the nodes round robin as their
+// threads pick up requests.
+class NumaThreadScheduler
+{
+  public:
+    DISKANN_DLLEXPORT NumaThreadScheduler(const uint32_t num_nodes);
+
+    // node of the calling thread, below num_nodes
+    DISKANN_DLLEXPORT uint32_t node_of_current_thread();
+
+    // Pins the threads of an OpenMP team of num_threads, giving each node an
+    // equal block of consecutive thread numbers. Call before the parallel
+    // loops of a search, with the number of threads they will use.
+    DISKANN_DLLEXPORT void pin_omp_threads(const uint32_t num_threads);
+
+    uint32_t num_nodes() const
+    {
+        return _num_nodes;
+    }
+
+  private:
+    uint32_t _num_nodes;
+    std::atomic<uint32_t> _next_node{0};
+};
+
+// One copy of a read-only index per NUMA node, each loaded by a thread pinned
+// to its node with its allocations bound there, so that a search thread only
+// touches memory local to its socket. local() returns the copy for the calling
+// thread. With a single replica nothing is pinned or bound and this is a
+// plain wrapper around one index.
+template <typename IndexT> class NumaReplicatedIndex
+{
+  public:
+    // load(node) builds the replica of a node, e.g. by creating and loading
+    // an index from the same files for every node
+    NumaReplicatedIndex(const uint32_t num_replicas, std::function<std::unique_ptr<IndexT>(uint32_t)> load)
+        : _scheduler(num_replicas == 0 ? 1 : num_replicas)
+    {
+        const uint32_t num_nodes = _scheduler.num_nodes();
+        _replicas.resize(num_nodes);
+        if (num_nodes == 1)
+        {
+            _replicas[0] = load(0);
+            return;
+        }
+
+        for (uint32_t node = 0; node < num_nodes; node++)
+        {
+            // one node at a time, the loads would compete for the disk anyway
+            std::exception_ptr error = nullptr;
+            std::thread loader([this, &load, &error, node]() {
+                pin_thread_to_numa_node(node);
+                set_thread_numa_binding((int)node);
+                try
+                {
+                    _replicas[node] = load(node);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                set_thread_numa_binding(-1);
+            });
+            loader.join();
+            if (error != nullptr)
+                std::rethrow_exception(error);
+        }
+    }
+
+    IndexT &local()
+    {
+        if (_replicas.size() == 1)
+            return *_replicas[0];
+        return *_replicas[_scheduler.node_of_current_thread()];
+    }
+
+    IndexT &replica(const uint32_t node)
+    {
+        return *_replicas[node];
+    }
+
+    uint32_t num_replicas() const
+    {
+        return (uint32_t)_replicas.size();
+    }
+
+    NumaThreadScheduler &scheduler()
+    {
+        return _scheduler;
+    }
+
+  private:
+    NumaThreadScheduler _scheduler;
+    std::vector<std::unique_ptr<IndexT>> _replicas;
+};
+
+} // namespace diskann
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "abstract_data_store.h"
+#include "distance.h"
+#include "packed_node_store.h"
+
+namespace diskann
+{
+// The vectors of a PackedNodeStore. Distances are computed straight from the
+// rows, so any metric the distance function supports works as it does with
+// InMemDataStore. The capacity is that of the node store and cannot grow.
+// load and save read and write regular data files.
+template <typename data_t> class PackedDataStore : public AbstractDataStore<data_t>
+{
+  public:
+    DISKANN_DLLEXPORT PackedDataStore(std::shared_ptr<PackedNodeStore> nodes,
+                                      std::unique_ptr<Distance<data_t>> distance_fn);
+
+    virtual location_t load(const std::string &filename) override;
+    virtual size_t save(const std::string &filename, const location_t num_points) override;
+
+    virtual size_t get_aligned_dim() const override;
+
+    virtual void populate_data(const data_t *vectors, const location_t num_pts) override;
+    virtual void populate_data(const std::string &filename, const size_t offset) override;
+
+    virtual void extract_data_to_bin(const std::string &filename, const location_t num_pts) override;
+
+    virtual void get_vector(const location_t i, data_t *target) const override;
+    virtual void set_vector(const location_t i, const data_t *const vector) override;
+    virtual void prefetch_vector(const location_t loc) override;
+
+    virtual void move_vectors(const location_t old_location_start, const location_t new_location_start,
+                              const location_t num_points) override;
+    virtual void copy_vectors(const location_t from_loc, const location_t to_loc, const location_t num_points) override;
+
+    virtual float get_distance(const data_t *query, const location_t loc) const override;
+    virtual float get_distance(const location_t loc1, const location_t loc2) const override;
+    virtual void get_distance(const data_t *query, const location_t *locations, const uint32_t location_count,
+                              float *distances) const override;
+
+    virtual location_t calculate_medoid() const override;
+
+    virtual Distance<data_t> *get_dist_fn() override;
+
+    virtual size_t get_alignment_factor() const override;
+
+  protected:
+    virtual location_t expand(const location_t new_size) override;
+    virtual location_t shrink(const location_t new_size) override;
+
+  private:
+    inline data_t *vector(const location_t i) const
+    {
+        return (data_t *)_nodes->vector(i);
+    }
+
+    location_t populate_from_file(const std::string &filename, const size_t offset);
+
+    std::shared_ptr<PackedNodeStore> _nodes;
+    size_t _aligned_dim;
+    // distance between consecutive vectors, in elements
+    size_t _stride;
+
+    std::unique_ptr<Distance<data_t>> _distance_fn;
+};
+
+} // namespace diskann
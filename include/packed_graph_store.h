@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+
+#include "abstract_graph_store.h"
+#include "packed_node_store.h"
+
+namespace diskann
+{
+
+// The adjacency lists of a PackedNodeStore. Like InMemFlatGraphStore the
+// lists are stored decoded at a fixed stride, but interleaved with the
+// vectors; the number of points and the max degree are those of the node
+// store and cannot grow. load and store read and write regular graph files.
+class PackedGraphStore : public AbstractGraphStore
+{
+  public:
+    DISKANN_DLLEXPORT PackedGraphStore(std::shared_ptr<PackedNodeStore> nodes);
+
+    // returns tuple of <nodes_read, start, num_frozen_points>
+    virtual std::tuple<uint32_t, uint32_t, size_t> load(const std::string &index_path_prefix,
+                                                        const size_t num_points) override;
+    virtual int store(const std::string &index_path_prefix, const size_t num_points, const size_t num_frozen_points,
+                      const uint32_t start) override;
+
+    virtual std::vector<location_t> get_neighbours(const location_t i) const override;
+    virtual uint32_t get_neighbours(const location_t i, std::vector<location_t> &out) const override;
+    virtual NeighbourView get_neighbours_view(const location_t i, std::vector<location_t> &buffer) const override;
+    virtual uint32_t get_degree(const location_t i) const override;
+    virtual void add_neighbour(const location_t i, location_t neighbour_id) override;
+    virtual void clear_neighbours(const location_t i) override;
+    virtual void swap_neighbours(const location_t a, location_t b) override;
+
+    virtual void set_neighbours(const location_t i, std::vector<location_t> &neighbors) override;
+
+    virtual size_t resize_graph(const size_t new_size) override;
+    virtual void clear_graph() override;
+
+    virtual size_t get_max_range_of_graph() override;
+    virtual uint32_t get_max_observed_degree() override;
+    virtual size_t get_memory_in_bytes() override;
+
+  private:
+    void check_degree(const location_t i, const size_t degree) const;
+
+    std::shared_ptr<PackedNodeStore> _nodes;
+    uint32_t _max_observed_degree = 0;
+};
+
+} // namespace diskann
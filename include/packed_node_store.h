@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "types.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Leading bytes of a .packed file, followed by num_points rows of row_size
+// bytes exactly as they are laid out in memory.
+struct PackedLayoutHeader
+{
+    uint64_t num_points;
+    uint64_t num_frozen_points;
+    uint64_t start;
+    uint64_t dim;
+    uint64_t element_size;
+    uint64_t vector_bytes;
+    uint64_t max_degree;
+    uint64_t row_size;
+};
+
+// One buffer holding the vector and the adjacency list of every point next to
+// each other, so that expanding a node and then scoring its neighbours touches
+// one row per point. Row i is
+//   [vector_bytes of padded vector][uint32 degree][max_degree uint32 ids]
+// rounded up to a whole number of cache lines. The buffer comes from
+// huge_page_alloc, so the huge page and NUMA settings of the process apply.
+//
+// The capacity and max degree are fixed at construction, the rows are meant
+// to be filled once from a built index or read back from a file written by
+// save. PackedDataStore and PackedGraphStore share a PackedNodeStore to
+// present it to an Index as its data and graph stores.
+class PackedNodeStore
+{
+  public:
+    DISKANN_DLLEXPORT PackedNodeStore(const size_t capacity, const size_t dim, const size_t element_size,
+                                      const size_t vector_bytes, const size_t max_degree);
+    DISKANN_DLLEXPORT ~PackedNodeStore();
+
+    PackedNodeStore(const PackedNodeStore &) = delete;
+    PackedNodeStore &operator=(const PackedNodeStore &) = delete;
+
+    DISKANN_DLLEXPORT static PackedLayoutHeader read_header(const std::string &filename);
+
+    // copies the rows of a file written by save into a new store with room
+    // for capacity rows, which must be at least the number of rows in the
+    // file. The file is read in one pass into the huge_page_alloc buffer,
+    // it is not mapped.
+    DISKANN_DLLEXPORT static std::shared_ptr<PackedNodeStore> load(const std::string &filename,
+                                                                   const size_t capacity);
+
+    // writes the first num_points rows, returns the number of bytes written
+    DISKANN_DLLEXPORT size_t save(const std::string &filename, const size_t num_points, const size_t num_frozen_points,
+                                  const uint32_t start) const;
+
+    inline char *vector(const location_t i) const
+    {
+        return _rows + (size_t)i * _row_size;
+    }
+
+    // the degree of i followed by its neighbours
+    inline uint32_t *adjacency(const location_t i) const
+    {
+        return (uint32_t *)(_rows + (size_t)i * _row_size + _vector_bytes);
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    size_t dim() const
+    {
+        return _dim;
+    }
+
+    size_t element_size() const
+    {
+        return _element_size;
+    }
+
+    size_t vector_bytes() const
+    {
+        return _vector_bytes;
+    }
+
+    size_t max_degree() const
+    {
+        return _max_degree;
+    }
+
+    size_t row_size() const
+    {
+        return _row_size;
+    }
+
+    size_t get_memory_in_bytes() const
+    {
+        return _allocated_bytes;
+    }
+
+  private:
+    // the rows are zeroed
+    void allocate();
+
+    char *_rows = nullptr;
+    size_t _capacity;
+    size_t _dim;
+    size_t _element_size;
+    size_t _vector_bytes;
+    size_t _max_degree;
+    size_t _row_size;
+
+    size_t _allocated_bytes = 0;
+};
+
+} // namespace diskann
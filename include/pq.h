@@ -7,6 +7,14 @@
 
 #define NUM_PQ_BITS 8
 #define NUM_PQ_CENTROIDS (1 << NUM_PQ_BITS)
+// 4-bit PQ, codes are packed two to a byte and scanned with in-register
+// lookup tables
+#define NUM_PQ_BITS_FAST_SCAN 4
+#define NUM_PQ_CENTROIDS_FAST_SCAN (1 << NUM_PQ_BITS_FAST_SCAN)
+// points per block of gathered 4-bit codes, one per byte of an AVX2 register
+#define PQ_FAST_SCAN_BLOCK 32
+// points per block of gathered 8-bit codes, two AVX2 registers of distances
+#define PQ_TRANSPOSED_BLOCK 16
 #define MAX_OPQ_ITERS 20
 #define NUM_KMEANS_REPS_PQ 12
 #define MAX_PQ_TRAINING_SET_SIZE 256000
@@ -16,9 +24,10 @@ namespace diskann
 {
 class FixedChunkPQTable
 {
-    float *tables = nullptr; // pq_tables = float array of size [256 * ndims]
+    float *tables = nullptr; // pq_tables = float array of size [num_centers * ndims]
     uint64_t ndims = 0;      // ndims = true dimension of vectors
     uint64_t n_chunks = 0;
+    uint64_t num_centers = NUM_PQ_CENTROIDS; // 256, or 16 for 4-bit codes
     bool use_rotation = false;
     uint32_t *chunk_offsets = nullptr;
     float *centroid = nullptr;
@@ -38,31 +47,53 @@ class FixedChunkPQTable
 
     uint32_t get_num_chunks();
 
-    void preprocess_query(float *query_vec);
+    uint32_t get_num_centers();
 
-    // assumes pre-processed query
-    void populate_chunk_distances(const float *query_vec, float *dist_vec);
+    // bytes per compressed vector: one per chunk, or one per two chunks for
+    // 4-bit codes
+    uint64_t get_code_len();
 
+    void preprocess_query(float *query_vec) const;
+
+    // assumes pre-processed query. dist_vec must hold NUM_PQ_CENTROIDS *
+    // n_chunks floats. For 4-bit codes the uint8 tables read by
+    // pq_dist_lookup_fast_scan are stored after the float ones.
+    void populate_chunk_distances(const float *query_vec, float *dist_vec) const;
+
+    // the following assume 8-bit codes
     float l2_distance(const float *query_vec, uint8_t *base_vec);
 
     float inner_product(const float *query_vec, uint8_t *base_vec);
 
-    // assumes no rotation is involved
-    void inflate_vector(uint8_t *base_vec, float *out_vec);
+    // reconstructs the vector of a code, undoing the rotation if there is one
+    void inflate_vector(const uint8_t *base_vec, float *out_vec) const;
+
+    // 8-bit codes only: encodes vec (ndims floats, not pre-processed) with the
+    // nearest center of every chunk
+    void compress_vector(const float *vec, uint8_t *out_code) const;
+
+    // 8-bit codes only: squared L2 distance between the reconstructions of
+    // two codes. The centroid and rotation do not change it.
+    float symmetric_l2_distance(const uint8_t *code_a, const uint8_t *code_b) const;
 
     void populate_chunk_inner_products(const float *query_vec, float *dist_vec);
+
+  private:
+    void quantize_fast_scan_tables(float *dist_vec) const;
 };
 
 template <typename T> struct PQScratch
 {
     float *aligned_pqtable_dist_scratch = nullptr; // MUST BE AT LEAST [256 * NCHUNKS]
     float *aligned_dist_scratch = nullptr;         // MUST BE AT LEAST diskann MAX_DEGREE
-    uint8_t *aligned_pq_coord_scratch = nullptr;   // MUST BE AT LEAST  [N_CHUNKS * MAX_DEGREE]
+    uint8_t *aligned_pq_coord_scratch = nullptr;   // MUST BE AT LEAST  [N_CHUNKS * ROUND_UP(MAX_DEGREE, 32)]
     float *rotated_query = nullptr;
     float *aligned_query_float = nullptr;
 
     PQScratch(size_t graph_degree, size_t aligned_dim)
     {
+        // 4-bit codes are gathered and scanned in whole blocks
+        graph_degree = ROUND_UP(graph_degree, PQ_FAST_SCAN_BLOCK);
         diskann::alloc_aligned((void **)&aligned_pq_coord_scratch,
                                (size_t)graph_degree * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t), 256);
         diskann::alloc_aligned((void **)&aligned_pqtable_dist_scratch, 256 * (size_t)MAX_PQ_CHUNKS * sizeof(float),
@@ -74,8 +105,19 @@ template <typename T> struct PQScratch
         memset(aligned_query_float, 0, aligned_dim * sizeof(float));
         memset(rotated_query, 0, aligned_dim * sizeof(float));
     }
+    PQScratch(const PQScratch &) = delete;
+    PQScratch &operator=(const PQScratch &) = delete;
 
-    void set(size_t dim, T *query, const float norm = 1.0f)
+    ~PQScratch()
+    {
+        diskann::aligned_free(aligned_pq_coord_scratch);
+        diskann::aligned_free(aligned_pqtable_dist_scratch);
+        diskann::aligned_free(aligned_dist_scratch);
+        diskann::aligned_free(aligned_query_float);
+        diskann::aligned_free(rotated_query);
+    }
+
+    void set(size_t dim, const T *query, const float norm = 1.0f)
     {
         for (size_t d = 0; d < dim; ++d)
         {
@@ -87,6 +129,12 @@ template <typename T> struct PQScratch
     }
 };
 
+// aggregate_coords gathers the codes of ids chunk-major, in blocks of
+// PQ_TRANSPOSED_BLOCK points: byte i of row j of a block is chunk j of its
+// i-th point, and the points past the last id are zero. pq_dist_lookup reads
+// that layout, so a chunk's codes for a block are scored with one load and
+// table gathers. out must hold ROUND_UP(#ids, PQ_TRANSPOSED_BLOCK) * ndims
+// bytes.
 void aggregate_coords(const std::vector<unsigned> &ids, const uint8_t *all_coords, const uint64_t ndims, uint8_t *out);
 
 void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_nchunks, const float *pq_dists,
@@ -99,6 +147,18 @@ void aggregate_coords(const unsigned *ids, const uint64_t n_ids, const uint8_t *
 void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_nchunks, const float *pq_dists,
                     float *dists_out);
 
+// 4-bit counterparts of aggregate_coords and pq_dist_lookup. The codes of ids
+// are gathered transposed, in blocks of PQ_FAST_SCAN_BLOCK points: byte i of
+// row j of a block is the j-th code byte of its i-th point. out must hold
+// ROUND_UP(n_ids, PQ_FAST_SCAN_BLOCK) * DIV_ROUND_UP(n_chunks, 2) bytes.
+// Distances are summed in uint16 from uint8 tables, so they are approximate;
+// pq_dists is filled by FixedChunkPQTable::populate_chunk_distances.
+void aggregate_coords_fast_scan(const uint32_t *ids, const uint64_t n_ids, const uint8_t *all_coords,
+                                const uint64_t n_chunks, uint8_t *out);
+
+void pq_dist_lookup_fast_scan(const uint8_t *pq_blocks, const size_t n_pts, const size_t pq_nchunks,
+                              const float *pq_dists, float *dists_out);
+
 DISKANN_DLLEXPORT int generate_pq_pivots(const float *const train_data, size_t num_train, unsigned dim,
                                          unsigned num_centers, unsigned num_pq_chunks, unsigned max_k_means_reps,
                                          std::string pq_pivots_path, bool make_zero_mean = false);
@@ -107,6 +167,8 @@ DISKANN_DLLEXPORT int generate_opq_pivots(const float *train_data, size_t num_tr
                                           unsigned num_pq_chunks, std::string opq_pivots_path,
                                           bool make_zero_mean = false);
 
+// with NUM_PQ_CENTROIDS_FAST_SCAN centers the codes are written packed, two
+// chunks to a byte (low nibble first)
 template <typename T>
 int generate_pq_data_from_pivots(const std::string &data_file, unsigned num_centers, unsigned num_pq_chunks,
                                  const std::string &pq_pivots_path, const std::string &pq_compressed_vectors_path,
@@ -121,5 +183,6 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, const diskann::Metric compareMetric,
                              const double p_val, const uint64_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix = "");
+                             const std::string &codebook_prefix = "",
+                             const uint32_t num_pq_centers = NUM_PQ_CENTROIDS);
 } // namespace diskann
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "abstract_data_store.h"
+#include "distance.h"
+#include "pq.h"
+
+namespace diskann
+{
+// Keeps the vectors of an in-memory index as 8-bit product quantization codes,
+// num_pq_chunks bytes per point. Searches compare a query against the codes
+// with per-query ADC tables: preprocess_query fills them into the PQScratch of
+// the query and the batch get_distance with that scratch looks them up.
+// get_distance between two locations is the symmetric distance of their codes.
+//
+// The pivots are trained from a data file by populate_data or load, and saved
+// next to the pivots of generate_quantized_data as
+// <file>_pq<N>_pivots.bin (or _opq<N>). Once trained, populate_data from
+// memory and set_vector encode new points on the fly; on an untrained store
+// they throw. save writes the decoded vectors as a regular data file and the
+// pivots to <file>_pq_pivots.bin, which load picks up instead of retraining.
+//
+// With num_pq_chunks = 0 the number of chunks is taken from the pivots that
+// load finds, for searching an index without knowing how it was built.
+//
+// Supports L2 and cosine. Cosine normalizes float vectors before encoding and
+// returns half the squared L2 distance, i.e. 1 - cos, as the other stores do.
+template <typename data_t> class PQDataStore : public AbstractDataStore<data_t>
+{
+  public:
+    DISKANN_DLLEXPORT PQDataStore(const location_t capacity, const size_t dim, const size_t num_pq_chunks,
+                                  const bool use_opq, std::unique_ptr<Distance<data_t>> distance_fn);
+    virtual ~PQDataStore();
+
+    virtual location_t load(const std::string &filename) override;
+    virtual size_t save(const std::string &filename, const location_t num_points) override;
+
+    virtual size_t get_aligned_dim() const override;
+
+    virtual void populate_data(const data_t *vectors, const location_t num_pts) override;
+    virtual void populate_data(const std::string &filename, const size_t offset) override;
+
+    virtual void extract_data_to_bin(const std::string &filename, const location_t num_pts) override;
+
+    virtual void get_vector(const location_t i, data_t *target) const override;
+    virtual void set_vector(const location_t i, const data_t *const vector) override;
+    virtual void prefetch_vector(const location_t loc) override;
+    virtual bool is_trained() const override;
+
+    virtual void move_vectors(const location_t old_location_start, const location_t new_location_start,
+                              const location_t num_points) override;
+    virtual void copy_vectors(const location_t from_loc, const location_t to_loc, const location_t num_points) override;
+
+    virtual float get_distance(const data_t *query, const location_t loc) const override;
+    virtual float get_distance(const location_t loc1, const location_t loc2) const override;
+    virtual void get_distance(const data_t *query, const location_t *locations, const uint32_t location_count,
+                              float *distances) const override;
+
+    virtual void preprocess_query(const data_t *aligned_query, PQScratch<data_t> *scratch) const override;
+    virtual void get_distance(const data_t *aligned_query, const location_t *locations, const uint32_t location_count,
+                              float *distances, PQScratch<data_t> *scratch) const override;
+
+    virtual location_t calculate_medoid() const override;
+
+    virtual Distance<data_t> *get_dist_fn() override;
+
+    virtual size_t get_alignment_factor() const override;
+
+    DISKANN_DLLEXPORT size_t get_num_chunks() const;
+
+    // copies the trained pivots, and the OPQ rotation if any, to pivots_file
+    DISKANN_DLLEXPORT void save_pivots(const std::string &pivots_file) const;
+
+  protected:
+    virtual location_t expand(const location_t new_size) override;
+    virtual location_t shrink(const location_t new_size) override;
+
+  private:
+    // converts a vector to float and applies the base point preprocessing of
+    // the metric, normalization for cosine over floats
+    void preprocess(const data_t *vector, float *target) const;
+    void encode(const data_t *vector, uint8_t *code) const;
+    void check_trained() const;
+    void allocate_codes();
+
+    void load_pivots(const std::string &pivots_file);
+    // samples the data file and trains the pivots into the file that
+    // generate_quantized_data would use for it
+    void train(const std::string &filename, const size_t offset, const size_t num_points);
+    location_t populate_from_file(const std::string &filename, const size_t offset);
+
+    size_t _num_chunks;
+    bool _use_opq;
+    Metric _metric;
+    bool _normalize;
+    size_t _aligned_dim;
+    uint8_t *_codes = nullptr;
+
+    std::unique_ptr<FixedChunkPQTable> _pq_table;
+    std::string _pivots_file;
+    bool _trained = false;
+
+    std::unique_ptr<Distance<data_t>> _distance_fn;
+};
+
+} // namespace diskann
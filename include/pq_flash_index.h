@@ -6,7 +6,10 @@
 
 #include "aligned_file_reader.h"
 #include "concurrent_queue.h"
+#include "filter_expression.h"
+#include "label_bitmap_index.h"
 #include "neighbor.h"
+#include "node_cache.h"
 #include "parameters.h"
 #include "percentile_stats.h"
 #include "pq.h"
@@ -21,8 +24,14 @@
 namespace diskann
 {
 
+template <typename T, typename LabelT> class PQFlashSearchIterator;
+
 template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 {
+    // pages through a search with the steps of cached_beam_search, see
+    // search_iterator.h
+    friend class PQFlashSearchIterator<T, LabelT>;
+
   public:
     DISKANN_DLLEXPORT PQFlashIndex(std::shared_ptr<AlignedFileReader> &fileReader,
                                    diskann::Metric metric = diskann::Metric::L2);
@@ -46,6 +55,14 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 
     DISKANN_DLLEXPORT void load_cache_list(std::vector<uint32_t> &node_list);
 
+    // Adds a dynamic node cache of up to ram_budget_bytes next to the static
+    // one built by load_cache_list. It is filled from the nodes read by
+    // cached_beam_search, with frequency-based admission, so it follows the
+    // live query distribution. 0 removes it. Safe to call while searches are
+    // running: each search keeps the cache it started with.
+    DISKANN_DLLEXPORT void set_dynamic_cache_budget(uint64_t ram_budget_bytes);
+    DISKANN_DLLEXPORT NodeCacheStats get_dynamic_cache_stats();
+
 #ifdef EXEC_ENV_OLS
     DISKANN_DLLEXPORT void generate_cache_list_from_sample_queries(MemoryMappedFiles &files, std::string sample_bin,
                                                                    uint64_t l_search, uint64_t beamwidth,
@@ -81,8 +98,44 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                               const uint32_t io_limit, const bool use_reorder_data = false,
                                               QueryStats *stats = nullptr);
 
+    // Only visits and returns the points that match filter, starting from the
+    // closest medoid of the labels each clause of filter requires. If fewer
+    // than k_search points match, the remaining res_ids are set to the
+    // largest uint64_t and res_dists to the largest float.
+    DISKANN_DLLEXPORT void cached_beam_search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                              uint64_t *res_ids, float *res_dists, const uint64_t beam_width,
+                                              const FilterExpression<LabelT> &filter,
+                                              const bool use_reorder_data = false, QueryStats *stats = nullptr);
+
+    DISKANN_DLLEXPORT void cached_beam_search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                              uint64_t *res_ids, float *res_dists, const uint64_t beam_width,
+                                              const FilterExpression<LabelT> &filter, const uint32_t io_limit,
+                                              const bool use_reorder_data = false, QueryStats *stats = nullptr);
+
+    // Searches num_queries queries, stored query_aligned_dim apart, together:
+    // all queries advance one hop at a time, the nodes the batch needs in a
+    // hop are read once however many queries asked for them, and the PQ codes
+    // of the neighbours of a node are gathered once for all queries expanding
+    // it. Writes k_search results per query to res_ids and res_dists; stats,
+    // if not null, must have num_queries entries. Trades latency for IOs and
+    // is meant for offline and batch workloads. Memory grows with the batch,
+    // mostly by 1KB per PQ chunk per query for the PQ distance tables.
+    DISKANN_DLLEXPORT void batch_search(const T *queries, const uint64_t num_queries, const uint64_t query_aligned_dim,
+                                        const uint64_t k_search, const uint64_t l_search, uint64_t *res_ids,
+                                        float *res_dists, const uint64_t beam_width,
+                                        const bool use_reorder_data = false, QueryStats *stats = nullptr);
+
     DISKANN_DLLEXPORT LabelT get_converted_label(const std::string &filter_label);
 
+    // Compiles a filter expression of raw labels, see FilterExpression::parse.
+    DISKANN_DLLEXPORT FilterExpression<LabelT> get_converted_filter(const std::string &raw_filter);
+
+    // Finds the points within range of the query. Starts with a candidate list
+    // of min_l_search and doubles it, up to max_l_search, while at least half
+    // of it is in range. Each larger list resumes the search where the last
+    // one stopped rather than starting over, so the nodes read along the way
+    // are read once. Returns the number of results, sized into indices and
+    // distances.
     DISKANN_DLLEXPORT uint32_t range_search(const T *query1, const double range, const uint64_t min_l_search,
                                             const uint64_t max_l_search, std::vector<uint64_t> &indices,
                                             std::vector<float> &distances, const uint64_t min_beam_width,
@@ -90,6 +143,27 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 
     DISKANN_DLLEXPORT uint64_t get_data_dim();
 
+    // When enabled, cached_beam_search keeps up to beam_width reads in flight
+    // and expands each node as soon as its read completes, instead of waiting
+    // for the whole beam. Needs a reader with asynchronous read support to
+    // overlap IO with compute; other readers fall back to batch behaviour.
+    DISKANN_DLLEXPORT void set_pipelined_search(bool use_pipelined_search);
+
+    // Overrides the visited set of every query, which load picks with
+    // VisitedSet::choose from the number of points and threads within
+    // defaults::MAX_VISITED_SET_BYTES. HASH_SET holds only the nodes a query
+    // visits. EPOCH_ARRAY and BITSET are faster but take 2 bytes and 1 bit
+    // per point of the index for each thread. BLOOM_FILTER, picked for
+    // billion-point indices, is small and fast but may skip a candidate,
+    // which lowers recall. Waits for running queries and sets the thread
+    // data up again.
+    DISKANN_DLLEXPORT void set_visited_set_type(VisitedSetType visited_set_type);
+
+    // grows or shrinks the pool of per-query scratch and IO contexts to
+    // nthreads, so that many queries can run concurrently. shrinking waits for
+    // running queries to hand back their thread data.
+    DISKANN_DLLEXPORT void resize_thread_data(uint64_t nthreads);
+
     std::shared_ptr<AlignedFileReader> &reader;
 
     DISKANN_DLLEXPORT diskann::Metric get_metric();
@@ -111,11 +185,17 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
   protected:
     DISKANN_DLLEXPORT void use_medoids_data_as_centroids();
     DISKANN_DLLEXPORT void setup_thread_data(uint64_t nthreads, uint64_t visited_reserve = 4096);
+    // the visited set type for num_sets visited sets alive at once
+    DISKANN_DLLEXPORT VisitedSetType choose_visited_set_type(uint64_t num_sets);
+
+    // scratch and IO context for one query at a time, set up like the ones
+    // in _thread_data. release_thread_data frees one.
+    DISKANN_DLLEXPORT SSDThreadData<T> *new_thread_data(uint64_t visited_reserve);
+    DISKANN_DLLEXPORT void release_thread_data(SSDThreadData<T> *data);
 
     DISKANN_DLLEXPORT void set_universal_label(const LabelT &label);
 
   private:
-    DISKANN_DLLEXPORT inline bool point_has_label(uint32_t point_id, LabelT label_id);
     std::unordered_map<std::string, LabelT> load_label_map(std::basic_istream<char> &infile);
     DISKANN_DLLEXPORT void parse_label_file(std::basic_istream<char> &infile, size_t &num_pts_labels);
     DISKANN_DLLEXPORT void get_label_file_metadata(const std::string &fileContent, uint32_t &num_pts,
@@ -124,6 +204,9 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                                   const uint32_t nthreads);
     void reset_stream_for_reading(std::basic_istream<char> &infile);
 
+    // position of node_id in the graph part of the disk index
+    DISKANN_DLLEXPORT uint64_t get_node_location(uint64_t node_id);
+
     // sector # on disk where node_id is present with in the graph part
     DISKANN_DLLEXPORT uint64_t get_node_sector(uint64_t node_id);
 
@@ -136,6 +219,37 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // returns region of `node_buf` containing [COORD(T)]
     DISKANN_DLLEXPORT T *offset_to_node_coords(char *node_buf);
 
+    // cached_beam_search with or without filter
+    void beam_search(const T *query, const uint64_t k_search, const uint64_t l_search, uint64_t *res_ids,
+                     float *res_dists, const uint64_t beam_width, const FilterExpression<LabelT> *filter,
+                     const uint32_t io_limit, const bool use_reorder_data, QueryStats *stats);
+
+    // The steps of cached_beam_search, apart so that range_search can resume
+    // a search with a larger L. init_beam_search prepares the query in the
+    // scratch of data and seeds a retset of l_search with the closest medoid,
+    // or with the closest medoid of each clause of filter if not null, and
+    // returns the norm of the query.
+    float init_beam_search(const T *query, SSDThreadData<T> *data, const uint64_t l_search,
+                           const FilterExpression<LabelT> *filter);
+
+    // Expands the closest candidates until none is left in the retset or
+    // io_limit nodes were read, skipping the points that do not match filter
+    // if not null. With keep_dropped, the unexpanded candidates that fall out
+    // of the full retset are kept in the scratch.
+    void expand_beam_search(SSDThreadData<T> *data, const uint64_t beam_width, const FilterExpression<LabelT> *filter,
+                            const uint32_t io_limit, const bool keep_dropped, QueryStats *stats);
+
+    // distance reported for the full precision distance of a result
+    float to_output_distance(const float distance, const float query_norm);
+
+    // query <-> node distances in PQ space for the in-memory codes of ids,
+    // pq_dists as filled by _pq_table.populate_chunk_distances
+    DISKANN_DLLEXPORT void compute_pq_dists(const uint32_t *ids, const uint64_t n_ids, const float *pq_dists,
+                                            uint8_t *pq_coord_scratch, float *dists_out);
+
+    // node `i` is stored at position `i`, or at _node_locations[i] if the
+    // index was written with a locality layout. for the node at position `i`:
+    //
     // index info for multi-node sectors
     // nhood of node `i` is in sector: [i / nnodes_per_sector]
     // offset in sector: [(i % nnodes_per_sector) * max_node_len]
@@ -152,6 +266,8 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     uint64_t _max_node_len = 0;
     uint64_t _nnodes_per_sector = 0; // 0 for multi-sector nodes, >0 for multi-node sectors
     uint64_t _max_degree = 0;
+    // id -> position on disk, empty if nodes are stored in id order
+    std::vector<uint32_t> _node_locations;
 
     // Data used for searching with re-order vectors
     uint64_t _ndims_reorder_vecs = 0;
@@ -177,12 +293,14 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 
     // PQ data
     // _n_chunks = # of chunks ndims is split into
-    // data: char * _n_chunks
+    // data: char * _n_chunks, or char * ceil(_n_chunks / 2) for 4-bit codes
     // chunk_size = chunk size of each dimension chunk
-    // pq_tables = float* [[2^8 * [chunk_size]] * _n_chunks]
+    // pq_tables = float* [[2^8 (or 2^4) * [chunk_size]] * _n_chunks]
     uint8_t *data = nullptr;
     uint64_t _n_chunks;
     FixedChunkPQTable _pq_table;
+    // 4-bit codes, scanned with pq_dist_lookup_fast_scan
+    bool _pq_fast_scan = false;
 
     // distance comparator
     std::shared_ptr<Distance<T>> _dist_cmp;
@@ -213,21 +331,29 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     T *_coord_cache_buf = nullptr;
     tsl::robin_map<uint32_t, T *> _coord_cache;
 
+    // runtime cache of whole node records, see set_dynamic_cache_budget.
+    // read and swapped with std::atomic_load / std::atomic_store only
+    std::shared_ptr<NodeCache> _dynamic_cache;
+
     // thread-specific scratch
     ConcurrentQueue<SSDThreadData<T> *> _thread_data;
-    uint64_t _max_nthreads;
+    std::atomic<uint64_t> _max_nthreads{0};
     bool _load_flag = false;
     bool _count_visited_nodes = false;
     bool _reorder_data_exists = false;
+    bool _use_pipelined_search = false;
+    // chosen by setup_thread_data unless set_visited_set_type fixed it
+    VisitedSetType _visited_set_type = VisitedSetType::HASH_SET;
+    bool _visited_set_type_fixed = false;
+    // the visited_reserve of setup_thread_data, for thread data set up later
+    uint64_t _visited_reserve = 4096;
     uint64_t _reoreder_data_offset = 0;
 
     // filter support
-    uint32_t *_pts_to_label_offsets = nullptr;
-    uint32_t *_pts_to_label_counts = nullptr;
-    LabelT *_pts_to_labels = nullptr;
+    LabelBitmapIndex<LabelT> _label_index;
     std::unordered_map<LabelT, std::vector<uint32_t>> _filter_to_medoid_ids;
     bool _use_universal_label = false;
-    LabelT _universal_filter_label;
+    LabelT _universal_filter_label = 0;
     tsl::robin_set<uint32_t> _dummy_pts;
     tsl::robin_set<uint32_t> _has_dummy_pts;
     tsl::robin_map<uint32_t, uint32_t> _dummy_to_real_map;
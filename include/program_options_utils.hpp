@@ -20,7 +20,8 @@ const std::string make_program_description(const char *executable_name, const ch
 // Required parameters
 const char *DATA_TYPE_DESCRIPTION = "data type, one of {int8, uint8, float} - float is single precision (32 bit)";
 const char *DISTANCE_FUNCTION_DESCRIPTION =
-    "distance function {l2, mips, fast_l2, cosine}.  'fast l2' and 'mips' only support data_type float";
+    "distance function {l2, mips, fast_l2, cosine}.  'mips' only supports data_type float, 'fast_l2' searches an "
+    "in-memory index with l2 over the packed graph store";
 const char *INDEX_PATH_PREFIX_DESCRIPTION = "Path prefix to the index, e.g. '/mnt/data/my_ann_index'";
 const char *RESULT_PATH_DESCRIPTION =
     "Path prefix for saving results of the queries, e.g. '/mnt/data/query_file_X.bin'";
@@ -77,5 +78,29 @@ const char *UNIVERSAL_LABEL =
     "in the labels file instead of listing all labels for a node.  DiskANN will not automatically assign a "
     "universal label to a node.";
 const char *FILTERED_LBUILD = "Build complexity for filtered points, higher value results in better graphs";
+const char *GRAPH_STORE_DESCRIPTION =
+    "In-memory graph layout, one of {memory, compressed, flat, packed}. compressed keeps sorted delta-encoded lists "
+    "with in-place appends, flat is an uncompressed fixed-degree array with no decode cost. packed is read-only, for "
+    "static indices with the memory data store: every vector sits next to its adjacency list, on huge pages if "
+    "available, and save also writes a .packed file that loads directly. All layouts read and write the same graph "
+    "file. Default value: memory";
+const char *DATA_STORE_DESCRIPTION =
+    "In-memory vector layout, one of {memory, int8, fp16, pq}. int8 and fp16 keep scalar quantized float vectors, "
+    "a quarter and a half of the memory of full-precision ones. pq keeps only build_PQ_bytes product quantization "
+    "codes per point, for any data type. Default value: memory";
+const char *RERANK_DATA_FILE_DESCRIPTION =
+    "Full-precision data file, in the order of the index points, to re-rank the candidates of searches over an "
+    "int8 or fp16 data store. Memory mapped, only the pages of the candidates are read. Default: no re-ranking";
+const char *HUGE_PAGES_DESCRIPTION =
+    "Page size for the vectors, graph, PQ codes and caches of the index, one of {none, transparent, 2mb, 1gb}. 2mb "
+    "and 1gb take explicit huge pages reserved through hugetlbfs and fall back to smaller pages when none are free. "
+    "Default value: none";
+const char *NUMA_DESCRIPTION =
+    "NUMA placement of the same allocations, one of {none, interleave} or the number of the node to bind them to. "
+    "Needs a build with DISKANN_USE_NUMA, ignored otherwise. Default value: none";
+const char *NUMA_REPLICAS_DESCRIPTION =
+    "Load one copy of the index on each NUMA node and pin the search threads to the nodes, each searching its local "
+    "copy. Takes a copy of the index memory per node. Needs a build with DISKANN_USE_NUMA, a single copy is loaded "
+    "otherwise.";
 
 } // namespace program_options_utils
@@ -7,7 +7,9 @@
 #include <vector>
 #include <stdexcept>
 
+#include <cached_aligned_file_reader.h>
 #include <index.h>
+#include <numa_replicas.h>
 #include <pq_flash_index.h>
 
 namespace diskann
@@ -85,19 +87,23 @@ class BaseSearch
 {
   public:
     BaseSearch(const std::string &tagsFile = nullptr);
+
+    // filter, if not empty, is a filter expression of raw labels, see
+    // FilterExpression::parse. Results past the matching points have the
+    // largest id and distance.
     virtual SearchResult search(const float *query, const unsigned int dimensions, const unsigned int K,
-                                const unsigned int Ls)
+                                const unsigned int Ls, const std::string &filter)
     {
         throw SearchNotImplementedException("float");
     }
     virtual SearchResult search(const int8_t *query, const unsigned int dimensions, const unsigned int K,
-                                const unsigned int Ls)
+                                const unsigned int Ls, const std::string &filter)
     {
         throw SearchNotImplementedException("int8_t");
     }
 
     virtual SearchResult search(const uint8_t *query, const unsigned int dimensions, const unsigned int K,
-                                const unsigned int Ls)
+                                const unsigned int Ls, const std::string &filter)
     {
         throw SearchNotImplementedException("uint8_t");
     }
@@ -112,29 +118,40 @@ class BaseSearch
 template <typename T> class InMemorySearch : public BaseSearch
 {
   public:
+    // with numa_replicas the index is loaded once per NUMA node and every
+    // server thread searches the copy of the node it is pinned to
     InMemorySearch(const std::string &baseFile, const std::string &indexFile, const std::string &tagsFile, Metric m,
-                   uint32_t num_threads, uint32_t search_l);
+                   uint32_t num_threads, uint32_t search_l, bool numa_replicas = false);
     virtual ~InMemorySearch();
 
-    SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls);
+    SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls,
+                        const std::string &filter);
 
   private:
     unsigned int _dimensions, _numPoints;
-    std::unique_ptr<diskann::Index<T>> _index;
+    std::unique_ptr<diskann::NumaReplicatedIndex<diskann::Index<T>>> _index;
 };
 
 template <typename T> class PQFlashSearch : public BaseSearch
 {
   public:
+    // reads go through sector_cache if one is given, which may be shared with
+    // other searchers in the process
     PQFlashSearch(const std::string &indexPrefix, const unsigned num_nodes_to_cache, const unsigned num_threads,
-                  const std::string &tagsFile, Metric m);
+                  const std::string &tagsFile, Metric m, std::shared_ptr<NodeCache> sector_cache = nullptr);
     virtual ~PQFlashSearch();
 
-    SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls);
+    SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls,
+                        const std::string &filter);
+
+    // reads of this index served from / not found in the sector cache
+    uint64_t get_sector_cache_hits() const;
+    uint64_t get_sector_cache_misses() const;
 
   private:
     unsigned int _dimensions, _numPoints;
     std::unique_ptr<diskann::PQFlashIndex<T>> _index;
     std::shared_ptr<AlignedFileReader> reader;
+    std::shared_ptr<CachedAlignedFileReader> _cached_reader;
 };
 } // namespace diskann
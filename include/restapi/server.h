@@ -27,7 +27,7 @@ class Server
 
     template <class T>
     void parseJson(const utility::string_t &body, unsigned int &k, int64_t &queryId, T *&queryVector,
-                   unsigned int &dimensions, unsigned &Ls);
+                   unsigned int &dimensions, unsigned &Ls, std::string &filter);
 
     web::json::value idsToJsonArray(const diskann::SearchResult &result);
     web::json::value distancesToJsonArray(const diskann::SearchResult &result);
@@ -5,8 +5,6 @@
 
 #include <vector>
 
-#include "boost_dynamic_bitset_fwd.h"
-// #include "boost/dynamic_bitset.hpp"
 #include "tsl/robin_set.h"
 #include "tsl/robin_map.h"
 #include "tsl/sparse_map.h"
@@ -16,6 +14,7 @@
 #include "defaults.h"
 #include "neighbor.h"
 #include "pq.h"
+#include "visited_set.h"
 
 namespace diskann
 {
@@ -49,6 +48,10 @@ template <typename T> class InMemQueryScratch
     {
         return _aligned_query;
     }
+    inline T *rerank_vector()
+    {
+        return _rerank_vector;
+    }
     inline PQScratch<T> *pq_scratch()
     {
         return _pq_scratch;
@@ -65,13 +68,9 @@ template <typename T> class InMemQueryScratch
     {
         return _occlude_factor;
     }
-    inline tsl::robin_set<uint32_t> &inserted_into_pool_rs()
-    {
-        return _inserted_into_pool_rs;
-    }
-    inline boost::dynamic_bitset<> &inserted_into_pool_bs()
+    inline VisitedSet &inserted_into_pool()
     {
-        return *_inserted_into_pool_bs;
+        return _inserted_into_pool;
     }
     inline std::vector<uint32_t> &id_scratch()
     {
@@ -81,6 +80,10 @@ template <typename T> class InMemQueryScratch
     {
         return _dist_scratch;
     }
+    inline std::vector<uint32_t> &neighbour_scratch()
+    {
+        return _neighbour_scratch;
+    }
     inline tsl::robin_set<uint32_t> &expanded_nodes_set()
     {
         return _expanded_nodes_set;
@@ -93,6 +96,10 @@ template <typename T> class InMemQueryScratch
     {
         return _occlude_list_output;
     }
+    inline std::vector<Neighbor> &dropped_candidates()
+    {
+        return _dropped_candidates;
+    }
 
   private:
     uint32_t _L;
@@ -101,6 +108,10 @@ template <typename T> class InMemQueryScratch
 
     T *_aligned_query = nullptr;
 
+    // Full-precision vectors are copied here to re-rank candidates, see
+    // AbstractDataStore::get_full_precision_distance. Zeroed on allocation.
+    T *_rerank_vector = nullptr;
+
     PQScratch<T> *_pq_scratch = nullptr;
 
     // _pool stores all neighbors explored from best_L_nodes.
@@ -117,13 +128,9 @@ template <typename T> class InMemQueryScratch
     // _occlude_factor is initialized to maxc size
     std::vector<float> _occlude_factor;
 
-    // Capacity initialized to 20L
-    tsl::robin_set<uint32_t> _inserted_into_pool_rs;
-
-    // Use a pointer here to allow for forward declaration of dynamic_bitset
-    // in public headers to avoid making boost a dependency for clients
-    // of DiskANN.
-    boost::dynamic_bitset<> *_inserted_into_pool_bs;
+    // Points seen by the current search. Set up by iterate_to_fixed_point
+    // for the size of the index, see VisitedSet::choose.
+    VisitedSet _inserted_into_pool;
 
     // _id_scratch.size() must be > R*GRAPH_SLACK_FACTOR for iterate_to_fp
     std::vector<uint32_t> _id_scratch;
@@ -132,10 +139,18 @@ template <typename T> class InMemQueryScratch
     // _dist_scratch should be at least the size of id_scratch
     std::vector<float> _dist_scratch;
 
+    // Adjacency lists are decoded from the graph store into this buffer.
+    // Reserved to R*GRAPH_SLACK_FACTOR; capacity is kept across clear().
+    std::vector<uint32_t> _neighbour_scratch;
+
     //  Buffers used in process delete, capacity increases as needed
     tsl::robin_set<uint32_t> _expanded_nodes_set;
     std::vector<Neighbor> _expanded_nghrs_vec;
     std::vector<uint32_t> _occlude_list_output;
+
+    // Unexpanded candidates that fell out of _best_l_nodes, kept by
+    // IndexSearchIterator to resume the search with a larger L
+    std::vector<Neighbor> _dropped_candidates;
 };
 
 //
@@ -154,9 +169,15 @@ template <typename T> class SSDQueryScratch
 
     PQScratch<T> *_pq_scratch;
 
-    tsl::robin_set<size_t> visited;
+    // set up by PQFlashIndex::setup_thread_data for the size of the index
+    VisitedSet visited;
+    // one per query of the last PQFlashIndex::batch_search
+    std::vector<VisitedSet> batch_visited;
     NeighborPriorityQueue retset;
     std::vector<Neighbor> full_retset;
+    // unexpanded candidates that fell out of retset, kept by range_search and
+    // PQFlashSearchIterator to resume the search with a larger retset
+    std::vector<Neighbor> dropped_candidates;
 
     SSDQueryScratch(size_t aligned_dim, size_t visited_reserve);
     ~SSDQueryScratch();
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "tsl/robin_set.h"
+
+#include "index.h"
+#include "neighbor.h"
+#include "percentile_stats.h"
+#include "pq_flash_index.h"
+#include "scratch.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+
+//
+// Search iterators return the results of a query in pages, closest first, for
+// callers that filter results after the search and cannot tell up front how
+// many they need. The first page searches with a candidate list of L. Each
+// later page grows the list to fit the results returned so far plus the page
+// and resumes the search, with the visited set and the candidates kept in the
+// scratch of the iterator, instead of searching again with a larger K. No
+// result is returned twice. The search is approximate, so a later page may
+// hold a result closer than one of an earlier page.
+//
+// An iterator owns its scratch rather than taking one from the index, so any
+// number of them can be open at once, and start() reuses it for a new query.
+// An iterator must not outlive its index and may be used by one thread at a
+// time.
+//
+
+template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> class IndexSearchIterator
+{
+  public:
+    DISKANN_DLLEXPORT IndexSearchIterator(Index<T, TagT, LabelT> &index, const uint32_t L);
+    DISKANN_DLLEXPORT ~IndexSearchIterator();
+
+    // Drops the state of the last query and starts a search for query.
+    DISKANN_DLLEXPORT void start(const T *query);
+
+    // Sets indices and distances, and tags if not null, to the next k results
+    // of the query, fewer once the search runs out of points. Returns the
+    // number of results.
+    template <typename IdType>
+    DISKANN_DLLEXPORT uint32_t next(const uint32_t k, std::vector<IdType> &indices, std::vector<float> &distances,
+                                    std::vector<TagT> *tags = nullptr);
+
+    DISKANN_DLLEXPORT uint64_t num_returned() const;
+
+  private:
+    // grows the candidate list to L and searches until it is expanded
+    void search_to(const uint32_t L);
+
+    Index<T, TagT, LabelT> &_index;
+    const uint32_t _initial_L;
+    std::unique_ptr<InMemQueryScratch<T>> _scratch;
+
+    // size of the candidate list searched so far, 0 before the first page
+    uint32_t _L = 0;
+    bool _started = false;
+    tsl::robin_set<uint32_t> _returned;
+    // candidates of the current page, reranked before they are returned
+    std::vector<Neighbor> _page;
+};
+
+template <typename T, typename LabelT = uint32_t> class PQFlashSearchIterator
+{
+  public:
+    DISKANN_DLLEXPORT PQFlashSearchIterator(PQFlashIndex<T, LabelT> &index, const uint64_t L,
+                                            const uint64_t beam_width);
+    DISKANN_DLLEXPORT ~PQFlashSearchIterator();
+
+    // Drops the state of the last query and starts a search for query.
+    DISKANN_DLLEXPORT void start(const T *query);
+
+    // Sets indices and distances to the next k results of the query, fewer
+    // once the search runs out of points. Returns the number of results. The
+    // distances are full precision ones of the nodes read from disk; the
+    // reorder data is not used. stats, if not null, adds up the work of the
+    // page.
+    DISKANN_DLLEXPORT uint32_t next(const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances,
+                                    QueryStats *stats = nullptr);
+
+    DISKANN_DLLEXPORT uint64_t num_returned() const;
+
+  private:
+    PQFlashIndex<T, LabelT> &_index;
+    const uint64_t _initial_L;
+    const uint64_t _beam_width;
+    SSDThreadData<T> *_data = nullptr;
+
+    // size of the retset searched so far, 0 before the first page
+    uint64_t _L = 0;
+    bool _started = false;
+    float _query_norm = 0;
+    tsl::robin_set<uint64_t> _returned;
+};
+
+} // namespace diskann
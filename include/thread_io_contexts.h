@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#ifndef _WINDOWS
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "aligned_file_reader.h"
+#include "tsl/robin_map.h"
+
+// The contexts register_thread binds to threads, for readers whose contexts
+// come from create_ctx (LinuxAlignedFileReader, IoUringAlignedFileReader).
+//
+// Each thread keeps its contexts in a thread_local list tagged with the id of
+// the owning registry, so find() needs no lock. The thread and the reader
+// share a context, and whichever lets go first destroys it: the thread when
+// it deregisters or exits, the reader when it deregisters all threads, which
+// readers do before they are destroyed.
+class ThreadIOContexts
+{
+  public:
+    explicit ThreadIOContexts(AlignedFileReader *reader);
+
+    // the context the calling thread registered, or nullptr if there is none
+    IOContext *find();
+
+    // creates a context for the calling thread with create_ctx of the reader.
+    // returns it, or nullptr if the calling thread already has one.
+    IOContext *register_thread();
+    void deregister_thread();
+    void deregister_all_threads();
+
+    struct RegisteredCtx;
+
+  private:
+    AlignedFileReader *_reader;
+    // changed by deregister_all_threads, which orphans the entries of the
+    // registry in every thread
+    std::atomic<uint64_t> _id;
+    // contexts of all threads, guarded by _mut
+    std::mutex _mut;
+    tsl::robin_map<std::thread::id, std::shared_ptr<RegisteredCtx>> _registered;
+};
+
+#endif
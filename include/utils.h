@@ -28,6 +28,7 @@ typedef int FileHandle;
 #include "tsl/robin_set.h"
 #include "types.h"
 #include <any>
+#include <memory>
 
 #ifdef EXEC_ENV_OLS
 #include "content_buf.h"
@@ -303,6 +304,15 @@ inline void aligned_free(void *ptr)
 #endif
 }
 
+// deleter for a std::unique_ptr holding a buffer from alloc_aligned
+struct AlignedFreeDeleter
+{
+    void operator()(void *ptr) const
+    {
+        aligned_free(ptr);
+    }
+};
+
 inline void GenRandom(std::mt19937 &rng, unsigned *addr, unsigned size, unsigned N)
 {
     for (unsigned i = 0; i < size; ++i)
@@ -1181,6 +1191,8 @@ template <> inline const char *diskann_type_to_name<int64_t>()
 
 extern bool AvxSupportedCPU;
 extern bool Avx2SupportedCPU;
+extern bool Avx512SupportedCPU;
+extern bool Avx512VnniSupportedCPU;
 
 inline size_t getMemoryUsage()
 {
@@ -1239,3 +1251,5 @@ inline size_t getMemoryUsage()
 
 extern bool AvxSupportedCPU;
 extern bool Avx2SupportedCPU;
+extern bool Avx512SupportedCPU;
+extern bool Avx512VnniSupportedCPU;
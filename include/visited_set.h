@@ -0,0 +1,247 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "tsl/robin_set.h"
+
+namespace diskann
+{
+enum class VisitedSetType
+{
+    // exact, memory proportional to the number of visits
+    HASH_SET,
+    // exact, one 16-bit stamp per point of the index; clear() bumps the
+    // stamp instead of touching the array
+    EPOCH_ARRAY,
+    // exact, one bit per point of the index; clear() zeroes the bits
+    BITSET,
+    // a few bits per expected visit, but may report an unvisited point as
+    // visited and so skip a candidate; only chosen for billion-scale indices
+    // when choose is allowed to
+    BLOOM_FILTER
+};
+
+// The set of points a search has seen. The type is fixed by init; scratch
+// spaces keep one per thread and clear it between queries.
+class VisitedSet
+{
+  public:
+    VisitedSet()
+    {
+    }
+
+    // A set for num_scratches sets of num_points points that together take at
+    // most memory_budget bytes: EPOCH_ARRAY if one stamp per point fits, else
+    // BITSET if one bit per point fits and the index is small enough for
+    // clear() to stay cheap, else HASH_SET. With allow_bloom_filter, indices
+    // of MIN_BLOOM_FILTER_POINTS or more get a BLOOM_FILTER instead of the
+    // hash set, whose tables grow with the long searches they need.
+    static VisitedSetType choose(const uint64_t num_points, const uint64_t num_scratches,
+                                 const uint64_t memory_budget, const bool allow_bloom_filter = false)
+    {
+        const uint64_t budget_per_scratch = memory_budget / std::max(num_scratches, (uint64_t)1);
+        if (num_points * sizeof(uint16_t) <= budget_per_scratch)
+            return VisitedSetType::EPOCH_ARRAY;
+        if (num_points <= MAX_BITSET_POINTS && num_points / 8 <= budget_per_scratch)
+            return VisitedSetType::BITSET;
+        if (allow_bloom_filter && num_points >= MIN_BLOOM_FILTER_POINTS)
+            return VisitedSetType::BLOOM_FILTER;
+        return VisitedSetType::HASH_SET;
+    }
+
+    // num_points bounds the ids for EPOCH_ARRAY and BITSET; expected_visits
+    // sizes the hash set and the bloom filter
+    void init(const VisitedSetType type, const uint64_t num_points, const uint64_t expected_visits)
+    {
+        _type = type;
+        _initialized = true;
+        _num_points = 0;
+        tsl::robin_set<uint64_t>().swap(_hash_set);
+        std::vector<uint16_t>().swap(_stamps);
+        std::vector<uint64_t>().swap(_bits);
+        std::vector<uint64_t>().swap(_bloom_bits);
+
+        if (type == VisitedSetType::HASH_SET)
+        {
+            _hash_set.reserve(expected_visits);
+        }
+        else if (type == VisitedSetType::EPOCH_ARRAY)
+        {
+            _stamps.assign(num_points, 0);
+            _num_points = num_points;
+            _epoch = 1;
+        }
+        else if (type == VisitedSetType::BITSET)
+        {
+            _bits.assign((num_points + 63) / 64, 0);
+            _num_points = num_points;
+        }
+        else
+        {
+            uint64_t num_bits = MIN_BLOOM_BITS;
+            while (num_bits < expected_visits * BLOOM_BITS_PER_VISIT)
+                num_bits <<= 1;
+            _bloom_bits.assign(num_bits / 64, 0);
+            _bloom_mask = num_bits - 1;
+        }
+    }
+
+    VisitedSetType type() const
+    {
+        return _type;
+    }
+
+    // true if every id below num_points can be inserted without a new init
+    bool covers(const uint64_t num_points) const
+    {
+        if (!_initialized)
+            return false;
+        return (_type != VisitedSetType::EPOCH_ARRAY && _type != VisitedSetType::BITSET) ||
+               num_points <= _num_points;
+    }
+
+    // adds id, returns true if it was not in the set before
+    inline bool insert(const uint64_t id)
+    {
+        if (_type == VisitedSetType::EPOCH_ARRAY)
+        {
+            if (_stamps[id] == _epoch)
+                return false;
+            _stamps[id] = _epoch;
+            return true;
+        }
+        else if (_type == VisitedSetType::BITSET)
+        {
+            const uint64_t mask = 1ULL << (id & 63);
+            if (_bits[id >> 6] & mask)
+                return false;
+            _bits[id >> 6] |= mask;
+            return true;
+        }
+        else if (_type == VisitedSetType::HASH_SET)
+        {
+            return _hash_set.insert(id).second;
+        }
+        else
+        {
+            bool inserted = false;
+            uint64_t h1, h2;
+            bloom_hashes(id, h1, h2);
+            for (uint32_t i = 0; i < BLOOM_NUM_PROBES; i++)
+            {
+                const uint64_t bit = (h1 + i * h2) & _bloom_mask;
+                const uint64_t mask = 1ULL << (bit & 63);
+                inserted |= (_bloom_bits[bit >> 6] & mask) == 0;
+                _bloom_bits[bit >> 6] |= mask;
+            }
+            return inserted;
+        }
+    }
+
+    inline bool contains(const uint64_t id) const
+    {
+        if (_type == VisitedSetType::EPOCH_ARRAY)
+        {
+            return _stamps[id] == _epoch;
+        }
+        else if (_type == VisitedSetType::BITSET)
+        {
+            return (_bits[id >> 6] >> (id & 63)) & 1;
+        }
+        else if (_type == VisitedSetType::HASH_SET)
+        {
+            return _hash_set.find(id) != _hash_set.end();
+        }
+        else
+        {
+            uint64_t h1, h2;
+            bloom_hashes(id, h1, h2);
+            for (uint32_t i = 0; i < BLOOM_NUM_PROBES; i++)
+            {
+                const uint64_t bit = (h1 + i * h2) & _bloom_mask;
+                if ((_bloom_bits[bit >> 6] & (1ULL << (bit & 63))) == 0)
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    void clear()
+    {
+        if (_type == VisitedSetType::EPOCH_ARRAY)
+        {
+            // stamps only need resetting when the epoch wraps around
+            if (++_epoch == 0)
+            {
+                std::fill(_stamps.begin(), _stamps.end(), (uint16_t)0);
+                _epoch = 1;
+            }
+        }
+        else if (_type == VisitedSetType::BITSET)
+        {
+            std::memset(_bits.data(), 0, _bits.size() * sizeof(uint64_t));
+        }
+        else if (_type == VisitedSetType::HASH_SET)
+        {
+            _hash_set.clear();
+        }
+        else
+        {
+            std::memset(_bloom_bits.data(), 0, _bloom_bits.size() * sizeof(uint64_t));
+        }
+    }
+
+    // bytes held by the set, for reporting
+    uint64_t memory_usage() const
+    {
+        return _stamps.capacity() * sizeof(uint16_t) + _bits.capacity() * sizeof(uint64_t) +
+               _bloom_bits.capacity() * sizeof(uint64_t) +
+               _hash_set.bucket_count() * sizeof(uint64_t);
+    }
+
+  private:
+    // clearing a bitset touches all of it, which costs more than a hash set
+    // beyond about this many points
+    static const uint64_t MAX_BITSET_POINTS = 10000000;
+    // smallest index choose gives a bloom filter, when allowed to
+    static const uint64_t MIN_BLOOM_FILTER_POINTS = 1000000000;
+
+    // 4 probes at 32 bits per expected visit give a false positive rate of
+    // about 0.2% when the estimate holds
+    static const uint32_t BLOOM_NUM_PROBES = 4;
+    static const uint64_t BLOOM_BITS_PER_VISIT = 32;
+    static const uint64_t MIN_BLOOM_BITS = 1 << 16;
+
+    // double hashing from the two halves of a 64-bit mix of the id
+    static inline void bloom_hashes(uint64_t id, uint64_t &h1, uint64_t &h2)
+    {
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdULL;
+        id ^= id >> 33;
+        id *= 0xc4ceb9fe1a85ec53ULL;
+        id ^= id >> 33;
+        h1 = id & 0xffffffffULL;
+        h2 = (id >> 32) | 1;
+    }
+
+    VisitedSetType _type = VisitedSetType::HASH_SET;
+    bool _initialized = false;
+
+    tsl::robin_set<uint64_t> _hash_set;
+
+    std::vector<uint16_t> _stamps;
+    uint64_t _num_points = 0;
+    uint16_t _epoch = 1;
+
+    std::vector<uint64_t> _bits;
+
+    std::vector<uint64_t> _bloom_bits;
+    uint64_t _bloom_mask = 0;
+};
+} // namespace diskann
@@ -25,6 +25,8 @@ class WindowsAlignedFileReader : public AlignedFileReader
 #else
     std::string m_filename;
 #endif
+    tsl::robin_map<std::thread::id, IOContext> ctx_map;
+    std::mutex ctx_mut;
 
   protected:
     // virtual IOContext createContext();
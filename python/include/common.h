@@ -3,8 +3,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
 #include <stdint.h>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
@@ -21,4 +25,49 @@ typedef uint32_t DynamicIdType;
 
 template <class IdType> using NeighborsAndDistances = std::pair<py::array_t<IdType>, py::array_t<float>>;
 
+// Results of a batch of range searches, which differ in length: those of query
+// i are at [offsets[i], offsets[i + 1]) of the ids and distances
+template <class IdType>
+using RangeNeighborsAndDistances = std::tuple<py::array_t<uint64_t>, py::array_t<IdType>, py::array_t<float>>;
+
+template <class IdType>
+NeighborsAndDistances<IdType> to_neighbors_and_distances(const std::vector<IdType> &ids,
+                                                         const std::vector<float> &dists)
+{
+    py::array_t<IdType> ids_array(ids.size());
+    py::array_t<float> dists_array(dists.size());
+    std::copy(ids.begin(), ids.end(), ids_array.mutable_data());
+    std::copy(dists.begin(), dists.end(), dists_array.mutable_data());
+    return std::make_pair(ids_array, dists_array);
+}
+
+template <class IdType>
+RangeNeighborsAndDistances<IdType> to_range_neighbors_and_distances(const std::vector<std::vector<IdType>> &ids,
+                                                                    const std::vector<std::vector<float>> &dists)
+{
+    py::array_t<uint64_t> offsets(ids.size() + 1);
+    uint64_t *offsets_ptr = offsets.mutable_data();
+    offsets_ptr[0] = 0;
+    for (size_t i = 0; i < ids.size(); i++)
+        offsets_ptr[i + 1] = offsets_ptr[i] + ids[i].size();
+
+    py::array_t<IdType> ids_array(offsets_ptr[ids.size()]);
+    py::array_t<float> dists_array(offsets_ptr[ids.size()]);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        std::copy(ids[i].begin(), ids[i].end(), ids_array.mutable_data() + offsets_ptr[i]);
+        std::copy(dists[i].begin(), dists[i].end(), dists_array.mutable_data() + offsets_ptr[i]);
+    }
+    return std::make_tuple(offsets, ids_array, dists_array);
+}
+
+// Index::range_search throws on complexities it can not search with, which
+// terminates the process when it happens in an omp parallel region. Batches
+// check them up front.
+inline void check_range_search_complexity(const uint32_t min_complexity, const uint32_t max_complexity)
+{
+    if (min_complexity == 0 || min_complexity > max_complexity)
+        throw std::invalid_argument("min_complexity must be between 1 and max_complexity");
+}
+
 }; // namespace diskannpy
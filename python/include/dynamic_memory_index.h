@@ -40,6 +40,11 @@ class DynamicMemoryIndex
     NeighborsAndDistances<DynamicIdType> batch_search(py::array_t<DT, py::array::c_style | py::array::forcecast> &queries,
                                             uint64_t num_queries, uint64_t knn, uint64_t complexity,
                                             uint32_t num_threads);
+    NeighborsAndDistances<DynamicIdType> range_search(py::array_t<DT, py::array::c_style | py::array::forcecast> &query,
+                                                      float range, uint32_t min_complexity, uint32_t max_complexity);
+    RangeNeighborsAndDistances<DynamicIdType> batch_range_search(
+        py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, uint64_t num_queries, float range,
+        uint32_t min_complexity, uint32_t max_complexity, uint32_t num_threads);
     void consolidate_delete();
     size_t num_points();
 
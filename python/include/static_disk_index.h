@@ -42,6 +42,11 @@ template <typename DT> class StaticDiskIndex
     NeighborsAndDistances<StaticIdType> search(py::array_t<DT, py::array::c_style | py::array::forcecast> &query,
                                                uint64_t knn, uint64_t complexity, uint64_t beam_width);
 
+    // filter_expression combines raw labels with AND, OR, NOT and parentheses
+    NeighborsAndDistances<StaticIdType> search_with_filter_expression(
+        py::array_t<DT, py::array::c_style | py::array::forcecast> &query, uint64_t knn, uint64_t complexity,
+        uint64_t beam_width, const std::string &filter_expression);
+
     NeighborsAndDistances<StaticIdType> batch_search(
         py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, uint64_t num_queries, uint64_t knn,
         uint64_t complexity, uint64_t beam_width, uint32_t num_threads);
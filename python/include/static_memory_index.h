@@ -30,10 +30,23 @@ template <typename DT> class StaticMemoryIndex
         py::array_t<DT, py::array::c_style | py::array::forcecast> &query, uint64_t knn, uint64_t complexity,
         filterT filter);
 
+    // filter_expression combines raw labels with AND, OR, NOT and parentheses
+    NeighborsAndDistances<StaticIdType> search_with_filter_expression(
+        py::array_t<DT, py::array::c_style | py::array::forcecast> &query, uint64_t knn, uint64_t complexity,
+        const std::string &filter_expression);
+
     NeighborsAndDistances<StaticIdType> batch_search(
         py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, uint64_t num_queries, uint64_t knn,
         uint64_t complexity, uint32_t num_threads);
 
+    NeighborsAndDistances<StaticIdType> range_search(
+        py::array_t<DT, py::array::c_style | py::array::forcecast> &query, float range, uint32_t min_complexity,
+        uint32_t max_complexity);
+
+    RangeNeighborsAndDistances<StaticIdType> batch_range_search(
+        py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, uint64_t num_queries, float range,
+        uint32_t min_complexity, uint32_t max_complexity, uint32_t num_threads);
+
   private:
     diskann::Index<DT, StaticIdType, filterT> _index;
 };
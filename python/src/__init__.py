@@ -27,6 +27,7 @@ When reading the `diskannpy` code we refer to the type aliases, though `pdoc` he
 - `VectorDType` - What vector datatypes does `diskannpy` support?
 - `QueryResponse` - What can I expect as a response to my search?
 - `QueryResponseBatch` - What can I expect as a response to my batch search?
+- `RangeQueryResponseBatch` - What can I expect as a response to my batch range search?
 - `VectorIdentifier` - What types do `diskannpy` support as vector identifiers?
 - `VectorIdentifierBatch` - A batch of identifiers of the exact same type. The type can change, but they must **all** change.
 - `VectorLike` - How does a vector look to `diskannpy`, to be inserted or searched with.
@@ -98,6 +99,23 @@ class QueryResponseBatch(NamedTuple):
     """
 
 
+class RangeQueryResponseBatch(NamedTuple):
+    """
+    Tuple with three values, offsets, identifiers and distances. Range searches return a different number of results
+    for every query, so the results of all queries are concatenated into 1d identifiers and distances arrays, and
+    those of query *i* are at positions [offsets[i], offsets[i + 1]) of both
+    """
+
+    offsets: npt.NDArray[np.uint64]
+    """ A `numpy.typing.NDArray[numpy.uint64]` of the number of queries + 1 positions into the other two arrays """
+    identifiers: npt.NDArray[VectorIdentifier]
+    """ A `numpy.typing.NDArray[VectorIdentifier]` array of vector identifiers, 1 dimensional """
+    distances: npt.NDArray[np.float32]
+    """
+    A `numpy.typing.NDAarray[numpy.float32]` of distances as calculated by the distance metric function, 1 dimensional
+    """
+
+
 from . import defaults
 from ._builder import build_disk_index, build_memory_index
 from ._common import valid_dtype
@@ -124,6 +142,7 @@ __all__ = [
     "VectorDType",
     "QueryResponse",
     "QueryResponseBatch",
+    "RangeQueryResponseBatch",
     "VectorIdentifier",
     "VectorIdentifierBatch",
     "VectorLike",
@@ -12,6 +12,7 @@ from . import (
     DistanceMetric,
     QueryResponse,
     QueryResponseBatch,
+    RangeQueryResponseBatch,
     VectorDType,
     VectorIdentifier,
     VectorIdentifierBatch,
@@ -361,6 +362,80 @@ class DynamicMemoryIndex:
         )
         return QueryResponseBatch(identifiers=neighbors, distances=distances)
 
+    def range_search(
+        self, query: VectorLike, range: float, min_complexity: int, max_complexity: int
+    ) -> QueryResponse:
+        """
+        Finds every vector within `range` of a single query vector, nearest first.
+
+        The search starts with a candidate list of `min_complexity` and doubles it, up to `max_complexity`, while at
+        least half of the candidates are in range, so the number of results is not known in advance and the returned
+        arrays are as long as the number of results.
+
+        ### Parameters
+        - **query**: 1d numpy array of the same dimensionality and dtype of the index.
+        - **range**: Largest distance of a result. For the "mips" metric, smallest inner product of a result instead.
+        - **min_complexity**: Size of the candidate list of the first search. Must be > 0.
+        - **max_complexity**: Largest size the candidate list may grow to. Must be at least min_complexity.
+        """
+        _query = _castable_dtype_or_raise(query, expected=self._vector_dtype)
+        _assert(len(_query.shape) == 1, "query vector must be 1-d")
+        _assert(
+            _query.shape[0] == self._dimensions,
+            f"query vector must have the same dimensionality as the index; index dimensionality: {self._dimensions}, "
+            f"query dimensionality: {_query.shape[0]}",
+        )
+        _assert_is_positive_uint32(min_complexity, "min_complexity")
+        _assert_is_positive_uint32(max_complexity, "max_complexity")
+        _assert(min_complexity <= max_complexity, "min_complexity must be at most max_complexity")
+
+        neighbors, distances = self._index.range_search(
+            query=_query, range=range, min_complexity=min_complexity, max_complexity=max_complexity
+        )
+        return QueryResponse(identifiers=neighbors, distances=distances)
+
+    def batch_range_search(
+        self,
+        queries: VectorLikeBatch,
+        range: float,
+        min_complexity: int,
+        max_complexity: int,
+        num_threads: int,
+    ) -> RangeQueryResponseBatch:
+        """
+        Finds every vector within `range` of each of a batch of query vectors, in parallel. See `range_search`.
+
+        ### Parameters
+        - **queries**: 2d numpy array, with column dimensionality matching the index and row dimensionality being the
+          number of queries intended to search for in parallel. Dtype must match dtype of the index.
+        - **range**: Largest distance of a result. For the "mips" metric, smallest inner product of a result instead.
+        - **min_complexity**: Size of the candidate list of the first search. Must be > 0.
+        - **max_complexity**: Largest size the candidate list may grow to. Must be at least min_complexity.
+        - **num_threads**: Number of threads to use when searching this index. (>= 0), 0 = num_threads in system
+        """
+        _queries = _castable_dtype_or_raise(queries, expected=self._vector_dtype)
+        _assert(len(_queries.shape) == 2, "queries must must be 2-d np array")
+        _assert(
+            _queries.shape[1] == self._dimensions,
+            f"query vectors must have the same dimensionality as the index; index dimensionality: {self._dimensions}, "
+            f"query dimensionality: {_queries.shape[1]}",
+        )
+        _assert_is_positive_uint32(min_complexity, "min_complexity")
+        _assert_is_positive_uint32(max_complexity, "max_complexity")
+        _assert(min_complexity <= max_complexity, "min_complexity must be at most max_complexity")
+        _assert_is_nonnegative_uint32(num_threads, "num_threads")
+
+        num_queries, dim = _queries.shape
+        offsets, neighbors, distances = self._index.batch_range_search(
+            queries=_queries,
+            num_queries=num_queries,
+            range=range,
+            min_complexity=min_complexity,
+            max_complexity=max_complexity,
+            num_threads=num_threads,
+        )
+        return RangeQueryResponseBatch(offsets=offsets, identifiers=neighbors, distances=distances)
+
     def save(self, save_path: str, index_prefix: str = "ann"):
         """
         Saves this index to file.
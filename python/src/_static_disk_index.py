@@ -108,7 +108,12 @@ class StaticDiskIndex:
         )
 
     def search(
-        self, query: VectorLike, k_neighbors: int, complexity: int, beam_width: int = 2
+        self,
+        query: VectorLike,
+        k_neighbors: int,
+        complexity: int,
+        beam_width: int = 2,
+        filter_expression: str = "",
     ) -> QueryResponse:
         """
         Searches the index by a single query vector.
@@ -125,6 +130,10 @@ class StaticDiskIndex:
           throughput with a fixed SSD IOps rating, use W=1. For best latency, use W=4,8 or higher complexity search.
           Specifying 0 will optimize the beamwidth depending on the number of threads performing search, but will
           involve some tuning overhead.
+        - **filter_expression**: Only return points whose labels satisfy this expression of labels combined with
+          `AND`, `OR`, `NOT` and parentheses, e.g. `region=EU AND (category=a OR category=b)`, for an index built
+          with filters. Labels are separated by spaces or parentheses. If fewer than `k_neighbors` points match, the
+          remaining identifiers are the largest uint32.
         """
         _query = _castable_dtype_or_raise(query, expected=self._vector_dtype)
         _assert(len(_query.shape) == 1, "query vector must be 1-d")
@@ -138,12 +147,21 @@ class StaticDiskIndex:
             )
             complexity = k_neighbors
 
-        neighbors, distances = self._index.search(
-            query=_query,
-            knn=k_neighbors,
-            complexity=complexity,
-            beam_width=beam_width,
-        )
+        if filter_expression != "":
+            neighbors, distances = self._index.search_with_filter_expression(
+                query=_query,
+                knn=k_neighbors,
+                complexity=complexity,
+                beam_width=beam_width,
+                filter_expression=filter_expression,
+            )
+        else:
+            neighbors, distances = self._index.search(
+                query=_query,
+                knn=k_neighbors,
+                complexity=complexity,
+                beam_width=beam_width,
+            )
         return QueryResponse(identifiers=neighbors, distances=distances)
 
     def batch_search(
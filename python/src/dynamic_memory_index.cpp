@@ -150,6 +150,43 @@ NeighborsAndDistances<DynamicIdType> DynamicMemoryIndex<DT>::batch_search(
     return std::make_pair(ids, dists);
 }
 
+template <class DT>
+NeighborsAndDistances<DynamicIdType> DynamicMemoryIndex<DT>::range_search(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &query, const float range,
+    const uint32_t min_complexity, const uint32_t max_complexity)
+{
+    std::vector<uint32_t> locations;
+    std::vector<DynamicIdType> tags;
+    std::vector<float> dists;
+    _index.range_search(query.data(), range, min_complexity, max_complexity, locations, dists, &tags);
+    return to_neighbors_and_distances(tags, dists);
+}
+
+template <class DT>
+RangeNeighborsAndDistances<DynamicIdType> DynamicMemoryIndex<DT>::batch_range_search(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, const uint64_t num_queries, const float range,
+    const uint32_t min_complexity, const uint32_t max_complexity, const uint32_t num_threads)
+{
+    check_range_search_complexity(min_complexity, max_complexity);
+    std::vector<std::vector<DynamicIdType>> tags(num_queries);
+    std::vector<std::vector<float>> dists(num_queries);
+
+    if (num_threads == 0)
+        omp_set_num_threads(omp_get_num_procs());
+    else
+        omp_set_num_threads(static_cast<int32_t>(num_threads));
+
+#pragma omp parallel for schedule(dynamic, 1) default(none)                                                            \
+    shared(num_queries, queries, range, min_complexity, max_complexity, tags, dists)
+    for (int64_t i = 0; i < (int64_t)num_queries; i++)
+    {
+        std::vector<uint32_t> locations;
+        _index.range_search(queries.data(i), range, min_complexity, max_complexity, locations, dists[i], &tags[i]);
+    }
+
+    return to_range_neighbors_and_distances(tags, dists);
+}
+
 template <class DT> void DynamicMemoryIndex<DT>::consolidate_delete()
 {
     _index.consolidate_deletes(_write_parameters);
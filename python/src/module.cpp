@@ -59,6 +59,12 @@ template <typename T> inline void add_variant(py::module_ &m, const Variant &var
         .def("search", &diskannpy::StaticMemoryIndex<T>::search, "query"_a, "knn"_a, "complexity"_a)
         .def("search_with_filter", &diskannpy::StaticMemoryIndex<T>::search_with_filter, "query"_a, "knn"_a,
              "complexity"_a, "filter"_a)
+        .def("search_with_filter_expression", &diskannpy::StaticMemoryIndex<T>::search_with_filter_expression,
+             "query"_a, "knn"_a, "complexity"_a, "filter_expression"_a)
+        .def("range_search", &diskannpy::StaticMemoryIndex<T>::range_search, "query"_a, "range"_a,
+             "min_complexity"_a, "max_complexity"_a)
+        .def("batch_range_search", &diskannpy::StaticMemoryIndex<T>::batch_range_search, "queries"_a,
+             "num_queries"_a, "range"_a, "min_complexity"_a, "max_complexity"_a, "num_threads"_a)
         .def("batch_search", &diskannpy::StaticMemoryIndex<T>::batch_search, "queries"_a, "num_queries"_a, "knn"_a,
              "complexity"_a, "num_threads"_a);
 
@@ -77,6 +83,10 @@ template <typename T> inline void add_variant(py::module_ &m, const Variant &var
         .def("load", &diskannpy::DynamicMemoryIndex<T>::load, "index_path"_a)
         .def("batch_search", &diskannpy::DynamicMemoryIndex<T>::batch_search, "queries"_a, "num_queries"_a, "knn"_a,
              "complexity"_a, "num_threads"_a)
+        .def("range_search", &diskannpy::DynamicMemoryIndex<T>::range_search, "query"_a, "range"_a,
+             "min_complexity"_a, "max_complexity"_a)
+        .def("batch_range_search", &diskannpy::DynamicMemoryIndex<T>::batch_range_search, "queries"_a,
+             "num_queries"_a, "range"_a, "min_complexity"_a, "max_complexity"_a, "num_threads"_a)
         .def("batch_insert", &diskannpy::DynamicMemoryIndex<T>::batch_insert, "vectors"_a, "ids"_a, "num_inserts"_a,
              "num_threads"_a)
         .def("save", &diskannpy::DynamicMemoryIndex<T>::save, "save_path"_a = "", "compact_before_save"_a = false)
@@ -91,6 +101,8 @@ template <typename T> inline void add_variant(py::module_ &m, const Variant &var
              "cache_mechanism"_a = 1)
         .def("cache_bfs_levels", &diskannpy::StaticDiskIndex<T>::cache_bfs_levels, "num_nodes_to_cache"_a)
         .def("search", &diskannpy::StaticDiskIndex<T>::search, "query"_a, "knn"_a, "complexity"_a, "beam_width"_a)
+        .def("search_with_filter_expression", &diskannpy::StaticDiskIndex<T>::search_with_filter_expression,
+             "query"_a, "knn"_a, "complexity"_a, "beam_width"_a, "filter_expression"_a)
         .def("batch_search", &diskannpy::StaticDiskIndex<T>::batch_search, "queries"_a, "num_queries"_a, "knn"_a,
              "complexity"_a, "beam_width"_a, "num_threads"_a);
 }
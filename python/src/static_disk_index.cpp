@@ -75,6 +75,29 @@ NeighborsAndDistances<StaticIdType> StaticDiskIndex<DT>::search(
     return std::make_pair(ids, dists);
 }
 
+template <typename DT>
+NeighborsAndDistances<StaticIdType> StaticDiskIndex<DT>::search_with_filter_expression(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &query, const uint64_t knn, const uint64_t complexity,
+    const uint64_t beam_width, const std::string &filter_expression)
+{
+    py::array_t<StaticIdType> ids(knn);
+    py::array_t<float> dists(knn);
+
+    std::vector<uint64_t> u64_ids(knn);
+    diskann::QueryStats stats;
+
+    _index.cached_beam_search(query.data(), knn, complexity, u64_ids.data(), dists.mutable_data(), beam_width,
+                              _index.get_converted_filter(filter_expression), false, &stats);
+
+    // fewer than knn points may match, the rest is the largest id
+    auto r = ids.mutable_unchecked<1>();
+    for (uint64_t i = 0; i < knn; ++i)
+        r(i) = u64_ids[i] == std::numeric_limits<uint64_t>::max() ? std::numeric_limits<StaticIdType>::max()
+                                                                  : (StaticIdType)u64_ids[i];
+
+    return std::make_pair(ids, dists);
+}
+
 template <typename DT>
 NeighborsAndDistances<StaticIdType> StaticDiskIndex<DT>::batch_search(
     py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, const uint64_t num_queries, const uint64_t knn,
@@ -63,6 +63,21 @@ NeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::search_with_filter(
     return std::make_pair(ids, dists);
 }
 
+template <typename DT>
+NeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::search_with_filter_expression(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &query, const uint64_t knn, const uint64_t complexity,
+    const std::string &filter_expression)
+{
+    // fewer than knn points may match, the rest stays at these values
+    py::array_t<StaticIdType> ids(knn);
+    py::array_t<float> dists(knn);
+    std::fill(ids.mutable_data(), ids.mutable_data() + knn, std::numeric_limits<StaticIdType>::max());
+    std::fill(dists.mutable_data(), dists.mutable_data() + knn, std::numeric_limits<float>::max());
+    _index.search_with_filters(query.data(), _index.get_converted_filter(filter_expression), knn, complexity,
+                               ids.mutable_data(), dists.mutable_data());
+    return std::make_pair(ids, dists);
+}
+
 template <typename DT>
 NeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::batch_search(
     py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, const uint64_t num_queries, const uint64_t knn,
@@ -84,6 +99,39 @@ NeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::batch_search(
     return std::make_pair(ids, dists);
 }
 
+template <typename DT>
+NeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::range_search(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &query, const float range,
+    const uint32_t min_complexity, const uint32_t max_complexity)
+{
+    std::vector<StaticIdType> ids;
+    std::vector<float> dists;
+    _index.range_search(query.data(), range, min_complexity, max_complexity, ids, dists);
+    return to_neighbors_and_distances(ids, dists);
+}
+
+template <typename DT>
+RangeNeighborsAndDistances<StaticIdType> StaticMemoryIndex<DT>::batch_range_search(
+    py::array_t<DT, py::array::c_style | py::array::forcecast> &queries, const uint64_t num_queries, const float range,
+    const uint32_t min_complexity, const uint32_t max_complexity, const uint32_t num_threads)
+{
+    check_range_search_complexity(min_complexity, max_complexity);
+    const uint32_t _num_threads = num_threads != 0 ? num_threads : omp_get_num_procs();
+    std::vector<std::vector<StaticIdType>> ids(num_queries);
+    std::vector<std::vector<float>> dists(num_queries);
+
+    omp_set_num_threads(static_cast<int32_t>(_num_threads));
+
+#pragma omp parallel for schedule(dynamic, 1) default(none)                                                            \
+    shared(num_queries, queries, range, min_complexity, max_complexity, ids, dists)
+    for (int64_t i = 0; i < (int64_t)num_queries; i++)
+    {
+        _index.range_search(queries.data(i), range, min_complexity, max_complexity, ids[i], dists[i]);
+    }
+
+    return to_range_neighbors_and_distances(ids, dists);
+}
+
 template class StaticMemoryIndex<float>;
 template class StaticMemoryIndex<uint8_t>;
 template class StaticMemoryIndex<int8_t>;
@@ -101,6 +101,49 @@ class TestStaticMemoryIndex(unittest.TestCase):
                 self.assertEqual(ids.shape[0], k)
                 self.assertEqual(dists.shape[0], k)
 
+    def test_range_search(self):
+        metric, dtype, query_vectors, index_vectors, ann_dir, vector_bin_file, _ = self._test_matrix[0]
+        index = dap.StaticMemoryIndex(
+            index_directory=ann_dir,
+            num_threads=16,
+            initial_search_complexity=32,
+        )
+        knn = NearestNeighbors(n_neighbors=10, algorithm="auto", metric=metric)
+        knn.fit(index_vectors)
+        knn_distances, knn_indices = knn.kneighbors(query_vectors)
+
+        # l2 distances of the index are squared, put the 10th neighbor of the first query on the edge
+        radius = float(knn_distances[0][9] ** 2) * 1.0001
+        ids, dists = index.range_search(query_vectors[0], range=radius, min_complexity=8, max_complexity=128)
+        self.assertEqual(ids.shape[0], dists.shape[0])
+        self.assertTrue(np.all(dists <= radius))
+        self.assertTrue(np.all(np.diff(dists) >= 0))
+        recall = len(set(ids) & set(knn_indices[0])) / 10
+        self.assertTrue(recall > 0.70, f"Recall [{recall}] was not over 0.7")
+
+        response = index.batch_range_search(
+            query_vectors, range=radius, min_complexity=8, max_complexity=128, num_threads=16
+        )
+        self.assertIsInstance(response, dap.RangeQueryResponseBatch)
+        offsets, batch_ids, batch_dists = response
+        self.assertEqual(offsets.shape[0], query_vectors.shape[0] + 1)
+        self.assertEqual(offsets[-1], batch_ids.shape[0])
+        self.assertEqual(batch_ids.shape[0], batch_dists.shape[0])
+        self.assertTrue(np.all(batch_dists <= radius))
+        np.testing.assert_array_equal(batch_ids[offsets[0] : offsets[1]], ids)
+
+        # checked by the native index before its parallel region, where a throw would abort the process
+        for min_complexity, max_complexity in [(0, 128), (129, 128)]:
+            with self.assertRaises(ValueError):
+                index._index.batch_range_search(
+                    queries=query_vectors,
+                    num_queries=query_vectors.shape[0],
+                    range=radius,
+                    min_complexity=min_complexity,
+                    max_complexity=max_complexity,
+                    num_threads=16,
+                )
+
     def test_value_ranges_ctor(self):
         (
             metric,
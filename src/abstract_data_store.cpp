@@ -40,6 +40,32 @@ template <typename data_t> location_t AbstractDataStore<data_t>::resize(const lo
     }
 }
 
+template <typename data_t> bool AbstractDataStore<data_t>::is_trained() const
+{
+    return true;
+}
+
+template <typename data_t>
+void AbstractDataStore<data_t>::preprocess_query(const data_t *aligned_query, PQScratch<data_t> *scratch) const
+{
+}
+
+template <typename data_t>
+void AbstractDataStore<data_t>::get_distance(const data_t *aligned_query, const location_t *locations,
+                                             const uint32_t location_count, float *distances,
+                                             PQScratch<data_t> *scratch) const
+{
+    get_distance(aligned_query, locations, location_count, distances);
+}
+
+template <typename data_t>
+bool AbstractDataStore<data_t>::get_full_precision_distance(const data_t *query, const location_t *locations,
+                                                            const uint32_t location_count, float *distances,
+                                                            data_t *vector_scratch) const
+{
+    return false;
+}
+
 template DISKANN_DLLEXPORT class AbstractDataStore<float>;
 template DISKANN_DLLEXPORT class AbstractDataStore<int8_t>;
 template DISKANN_DLLEXPORT class AbstractDataStore<uint8_t>;
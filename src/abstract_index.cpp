@@ -32,6 +32,16 @@ size_t AbstractIndex::search_with_tags(const data_type *query, const uint64_t K,
     return this->_search_with_tags(any_query, K, L, any_tags, distances, any_res_vectors);
 }
 
+template <typename data_type, typename IDType>
+uint32_t AbstractIndex::range_search(const data_type *query, const float range, const uint32_t min_l_search,
+                                     const uint32_t max_l_search, std::vector<IDType> &indices,
+                                     std::vector<float> &distances)
+{
+    auto any_query = std::any(query);
+    auto any_indices = std::any(&indices);
+    return this->_range_search(any_query, range, min_l_search, max_l_search, any_indices, distances);
+}
+
 template <typename IndexType>
 std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filters(const DataType &query, const std::string &raw_label,
                                                                  const size_t K, const uint32_t L, IndexType *indices,
@@ -41,6 +51,16 @@ std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filters(const DataType
     return _search_with_filters(query, raw_label, K, L, any_indices, distances);
 }
 
+template <typename IndexType>
+std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filter_expression(const DataType &query,
+                                                                           const std::string &raw_filter,
+                                                                           const size_t K, const uint32_t L,
+                                                                           IndexType *indices, float *distances)
+{
+    auto any_indices = std::any(indices);
+    return _search_with_filter_expression(query, raw_filter, K, L, any_indices, distances);
+}
+
 template <typename data_type>
 void AbstractIndex::search_with_optimized_layout(const data_type *query, size_t K, size_t L, uint32_t *indices)
 {
@@ -154,6 +174,26 @@ template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search<u
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search<int8_t, uint64_t>(
     const int8_t *query, const size_t K, const uint32_t L, uint64_t *indices, float *distances);
 
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<float, uint32_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances);
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<uint8_t, uint32_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances);
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<int8_t, uint32_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances);
+
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<float, uint64_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances);
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<uint8_t, uint64_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances);
+template DISKANN_DLLEXPORT uint32_t AbstractIndex::range_search<int8_t, uint64_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances);
+
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filters<uint32_t>(
     const DataType &query, const std::string &raw_label, const size_t K, const uint32_t L, uint32_t *indices,
     float *distances);
@@ -162,6 +202,14 @@ template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_w
     const DataType &query, const std::string &raw_label, const size_t K, const uint32_t L, uint64_t *indices,
     float *distances);
 
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filter_expression<uint32_t>(
+    const DataType &query, const std::string &raw_filter, const size_t K, const uint32_t L, uint32_t *indices,
+    float *distances);
+
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filter_expression<uint64_t>(
+    const DataType &query, const std::string &raw_filter, const size_t K, const uint32_t L, uint64_t *indices,
+    float *distances);
+
 template DISKANN_DLLEXPORT size_t AbstractIndex::search_with_tags<float, int32_t>(const float *query, const uint64_t K,
                                                                                   const uint32_t L, int32_t *tags,
                                                                                   float *distances,
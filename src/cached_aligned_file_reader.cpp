@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <sys/stat.h>
+
+#include "cached_aligned_file_reader.h"
+#include "defaults.h"
+
+// bits of a cache key that hold the sector number, the rest hold the file id
+#define SECTOR_CACHE_SECTOR_BITS 40
+
+namespace
+{
+// what tells files apart in cache keys: device and inode where the file
+// system has them, else the path, plus size and modification time so that a
+// file rewritten in place is another file. the path alone if stat fails.
+std::string get_file_identity(const std::string &fname)
+{
+#ifdef _WINDOWS
+    struct _stat64 st;
+    if (_stat64(fname.c_str(), &st) != 0)
+        return "path:" + fname;
+    return "path:" + fname + ":" + std::to_string(st.st_size) + ":" + std::to_string(st.st_mtime);
+#else
+    struct stat st;
+    if (stat(fname.c_str(), &st) != 0)
+        return "path:" + fname;
+    return std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+           std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+#endif
+}
+
+// ids of the files open in any CachedAlignedFileReader of the process, so
+// that readers of the same file share its cached sectors. a file gets a new id
+// once no reader has it open, as it may have changed since, and the sectors
+// cached under the old id are never read again.
+class FileIds
+{
+  public:
+    uint64_t acquire(const std::string &identity)
+    {
+        std::lock_guard<std::mutex> lock(_mut);
+        auto iter = _open_files.find(identity);
+        if (iter == _open_files.end())
+            iter = _open_files.insert({identity, OpenFile{_next_id++, 0}}).first;
+        iter.value().num_readers++;
+        return iter->second.id;
+    }
+
+    void release(const std::string &identity)
+    {
+        std::lock_guard<std::mutex> lock(_mut);
+        auto iter = _open_files.find(identity);
+        if (iter != _open_files.end() && --iter.value().num_readers == 0)
+            _open_files.erase(iter);
+    }
+
+  private:
+    struct OpenFile
+    {
+        uint64_t id;
+        uint64_t num_readers;
+    };
+
+    std::mutex _mut;
+    tsl::robin_map<std::string, OpenFile> _open_files;
+    uint64_t _next_id = 1;
+};
+
+FileIds &file_ids()
+{
+    static FileIds ids;
+    return ids;
+}
+} // namespace
+
+CachedAlignedFileReader::CachedAlignedFileReader(std::shared_ptr<AlignedFileReader> reader,
+                                                 std::shared_ptr<diskann::NodeCache> sector_cache)
+    : _reader(reader), _sector_cache(sector_cache)
+{
+    if (_reader == nullptr)
+    {
+        throw diskann::ANNException("CachedAlignedFileReader needs a reader to wrap", -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
+    if (_sector_cache != nullptr && _sector_cache->get_record_len() != diskann::defaults::SECTOR_LEN)
+    {
+        throw diskann::ANNException("Sector cache records must be SECTOR_LEN bytes", -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
+}
+
+CachedAlignedFileReader::~CachedAlignedFileReader()
+{
+    release_file_id();
+}
+
+IOContext &CachedAlignedFileReader::get_ctx()
+{
+    return _reader->get_ctx();
+}
+
+void CachedAlignedFileReader::register_thread()
+{
+    _reader->register_thread();
+}
+
+void CachedAlignedFileReader::deregister_thread()
+{
+    _reader->deregister_thread();
+}
+
+void CachedAlignedFileReader::deregister_all_threads()
+{
+    _reader->deregister_all_threads();
+}
+
+IOContext CachedAlignedFileReader::create_ctx()
+{
+    return _reader->create_ctx();
+}
+
+void CachedAlignedFileReader::destroy_ctx(IOContext &ctx)
+{
+    clear_pending_reads(ctx);
+    _reader->destroy_ctx(ctx);
+}
+
+void CachedAlignedFileReader::open(const std::string &fname)
+{
+    release_file_id();
+    _reader->open(fname);
+    _file_identity = get_file_identity(fname);
+    _file_id = file_ids().acquire(_file_identity);
+}
+
+void CachedAlignedFileReader::close()
+{
+    _reader->close();
+    release_file_id();
+}
+
+void CachedAlignedFileReader::release_file_id()
+{
+    if (_file_id == 0)
+        return;
+    file_ids().release(_file_identity);
+    _file_id = 0;
+    _file_identity.clear();
+}
+
+void CachedAlignedFileReader::register_buffer(IOContext &ctx, void *buf, uint64_t len)
+{
+    _reader->register_buffer(ctx, buf, len);
+}
+
+CachedAlignedFileReader::PendingReads &CachedAlignedFileReader::pending_reads(IOContext &ctx)
+{
+    std::lock_guard<std::mutex> lock(_pending_mut);
+    return _pending[&ctx];
+}
+
+void CachedAlignedFileReader::clear_pending_reads(IOContext &ctx)
+{
+    std::lock_guard<std::mutex> lock(_pending_mut);
+    _pending.erase(&ctx);
+}
+
+bool CachedAlignedFileReader::read_from_cache(const AlignedRead &req)
+{
+    const uint64_t first_sector = req.offset / diskann::defaults::SECTOR_LEN;
+    const uint64_t num_sectors = req.len / diskann::defaults::SECTOR_LEN;
+    for (uint64_t i = 0; i < num_sectors; i++)
+    {
+        const uint64_t key = (_file_id << SECTOR_CACHE_SECTOR_BITS) | (first_sector + i);
+        if (!_sector_cache->get(key, (char *)req.buf + i * diskann::defaults::SECTOR_LEN))
+        {
+            _misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void CachedAlignedFileReader::insert_into_cache(const AlignedRead &req)
+{
+    const uint64_t first_sector = req.offset / diskann::defaults::SECTOR_LEN;
+    const uint64_t num_sectors = req.len / diskann::defaults::SECTOR_LEN;
+    for (uint64_t i = 0; i < num_sectors; i++)
+    {
+        const uint64_t key = (_file_id << SECTOR_CACHE_SECTOR_BITS) | (first_sector + i);
+        _sector_cache->insert(key, (const char *)req.buf + i * diskann::defaults::SECTOR_LEN);
+    }
+}
+
+void CachedAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async)
+{
+    // an async read may still be running when this returns, so there is
+    // nothing to offer to the cache yet
+    if (_sector_cache == nullptr || async)
+    {
+        _reader->read(read_reqs, ctx, async);
+        return;
+    }
+
+    static thread_local std::vector<AlignedRead> disk_reqs;
+    disk_reqs.clear();
+    for (auto &req : read_reqs)
+    {
+        if (!read_from_cache(req))
+            disk_reqs.push_back(req);
+    }
+    if (disk_reqs.empty())
+        return;
+
+    _reader->read(disk_reqs, ctx);
+    for (auto &req : disk_reqs)
+    {
+        insert_into_cache(req);
+    }
+}
+
+void CachedAlignedFileReader::submit_reads(std::vector<AlignedRead> &read_reqs, IOContext &ctx)
+{
+    if (_sector_cache == nullptr)
+    {
+        _reader->submit_reads(read_reqs, ctx);
+        return;
+    }
+
+    auto &pending = pending_reads(ctx);
+    static thread_local std::vector<AlignedRead> disk_reqs;
+    disk_reqs.clear();
+    for (auto &req : read_reqs)
+    {
+        if (read_from_cache(req))
+        {
+            pending.served.push_back(req.buf);
+        }
+        else
+        {
+            disk_reqs.push_back(req);
+            pending.in_flight[req.buf] = req;
+        }
+    }
+    if (disk_reqs.empty())
+        return;
+    try
+    {
+        _reader->submit_reads(disk_reqs, ctx);
+    }
+    catch (...)
+    {
+        // the caller drops the whole batch on a failed submit
+        clear_pending_reads(ctx);
+        throw;
+    }
+}
+
+uint64_t CachedAlignedFileReader::get_completed_reads(IOContext &ctx, uint64_t min_completions,
+                                                      std::vector<void *> &completed_bufs)
+{
+    if (_sector_cache == nullptr)
+        return _reader->get_completed_reads(ctx, min_completions, completed_bufs);
+
+    auto &pending = pending_reads(ctx);
+    uint64_t n_done = pending.served.size();
+    completed_bufs.insert(completed_bufs.end(), pending.served.begin(), pending.served.end());
+    pending.served.clear();
+
+    // only wait on the wrapped reader for what the cache could not serve
+    if (!pending.in_flight.empty())
+    {
+        const uint64_t first_new = completed_bufs.size();
+        try
+        {
+            n_done += _reader->get_completed_reads(ctx, min_completions > n_done ? min_completions - n_done : 0,
+                                                   completed_bufs);
+        }
+        catch (...)
+        {
+            clear_pending_reads(ctx);
+            throw;
+        }
+        for (uint64_t i = first_new; i < completed_bufs.size(); i++)
+        {
+            auto iter = pending.in_flight.find(completed_bufs[i]);
+            if (iter != pending.in_flight.end())
+            {
+                insert_into_cache(iter->second);
+                pending.in_flight.erase(iter);
+            }
+        }
+    }
+    if (pending.served.empty() && pending.in_flight.empty())
+        clear_pending_reads(ctx);
+    return n_done;
+}
+
+void CachedAlignedFileReader::drain_reads(IOContext &ctx)
+{
+    _reader->drain_reads(ctx);
+    clear_pending_reads(ctx);
+}
+
+uint64_t CachedAlignedFileReader::get_hits() const
+{
+    return _hits.load(std::memory_order_relaxed);
+}
+
+uint64_t CachedAlignedFileReader::get_misses() const
+{
+    return _misses.load(std::memory_order_relaxed);
+}
+
+void CachedAlignedFileReader::reset_stats()
+{
+    _hits = 0;
+    _misses = 0;
+}
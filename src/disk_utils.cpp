@@ -825,9 +825,82 @@ uint32_t optimize_beamwidth(std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> &p
     return best_bw;
 }
 
+std::vector<uint32_t> compute_locality_layout(const std::vector<std::vector<uint32_t>> &graph, uint32_t medoid,
+                                              uint64_t nnodes_per_sector)
+{
+    const uint64_t npts = graph.size();
+    std::vector<uint32_t> layout;
+    layout.reserve(npts);
+    std::vector<bool> placed(npts, false), queued(npts, false);
+    // nodes next to placed sectors, in the order they were reached
+    std::vector<uint32_t> seeds;
+    uint64_t next_seed = 0;
+    uint32_t next_unreached = 0;
+    if (npts > 0 && medoid < npts)
+    {
+        seeds.push_back(medoid);
+        queued[medoid] = true;
+    }
+
+    auto place = [&](uint32_t id) {
+        placed[id] = true;
+        layout.push_back(id);
+    };
+
+    while (layout.size() < npts)
+    {
+        uint32_t seed;
+        while (next_seed < seeds.size() && placed[seeds[next_seed]])
+            next_seed++;
+        if (next_seed < seeds.size())
+        {
+            seed = seeds[next_seed++];
+        }
+        else
+        {
+            while (placed[next_unreached])
+                next_unreached++;
+            seed = next_unreached;
+        }
+
+        // fill the rest of the current sector breadth-first from the seed,
+        // closest neighbours first as the graph keeps them in that order
+        const uint64_t sector_start = layout.size();
+        uint64_t room = nnodes_per_sector - (layout.size() % nnodes_per_sector);
+        place(seed);
+        room--;
+        for (uint64_t i = sector_start; i < layout.size() && room > 0; i++)
+        {
+            for (uint32_t nbr : graph[layout[i]])
+            {
+                if (room == 0)
+                    break;
+                if (!placed[nbr])
+                {
+                    place(nbr);
+                    room--;
+                }
+            }
+        }
+
+        for (uint64_t i = sector_start; i < layout.size(); i++)
+        {
+            for (uint32_t nbr : graph[layout[i]])
+            {
+                if (!placed[nbr] && !queued[nbr])
+                {
+                    queued[nbr] = true;
+                    seeds.push_back(nbr);
+                }
+            }
+        }
+    }
+    return layout;
+}
+
 template <typename T>
 void create_disk_layout(const std::string base_file, const std::string mem_index_file, const std::string output_file,
-                        const std::string reorder_data_file)
+                        const std::string reorder_data_file, const bool locality_layout)
 {
     uint32_t npts, ndims;
 
@@ -909,6 +982,42 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     diskann::cout << "max_node_len: " << max_node_len << "B" << std::endl;
     diskann::cout << "nnodes_per_sector: " << nnodes_per_sector << "B" << std::endl;
 
+    // with a locality layout the graph is loaded to compute the order, and
+    // nodes are then written in that order instead of streamed in id order
+    const std::string layout_file = output_file + "_layout_perm.bin";
+    std::vector<std::vector<uint32_t>> graph;
+    std::vector<uint32_t> layout;
+    std::ifstream coords_reader;
+    if (locality_layout && nnodes_per_sector == 0)
+    {
+        diskann::cout << "Nodes span multiple sectors, ignoring locality layout." << std::endl;
+    }
+    else if (locality_layout)
+    {
+        graph.resize(npts_64);
+        for (uint64_t i = 0; i < npts_64; i++)
+        {
+            uint32_t nnbrs;
+            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
+            graph[i].resize((std::min)(nnbrs, width_u32));
+            vamana_reader.read((char *)graph[i].data(), graph[i].size() * sizeof(uint32_t));
+            if (nnbrs > width_u32)
+            {
+                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
+            }
+        }
+        layout = compute_locality_layout(graph, (uint32_t)medoid, nnodes_per_sector);
+        diskann::save_bin<uint32_t>(layout_file, layout.data(), layout.size(), 1);
+        diskann::cout << "Locality layout written to " << layout_file << std::endl;
+        coords_reader.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        coords_reader.open(base_file, std::ios::binary);
+    }
+    if (layout.empty())
+    {
+        // a layout left by an earlier build would no longer match the index
+        std::remove(layout_file.c_str());
+    }
+
     // defaults::SECTOR_LEN buffer for each sector
     std::unique_ptr<char[]> sector_buf = std::make_unique<char[]>(defaults::SECTOR_LEN);
     std::unique_ptr<char[]> multisector_buf = std::make_unique<char[]>(ROUND_UP(max_node_len, defaults::SECTOR_LEN));
@@ -916,6 +1025,42 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     uint32_t &nnbrs = *(uint32_t *)(node_buf.get() + ndims_64 * sizeof(T));
     uint32_t *nhood_buf = (uint32_t *)(node_buf.get() + (ndims_64 * sizeof(T)) + sizeof(uint32_t));
 
+    // fills node_buf with the coords, nnbrs and nhood of the node at position
+    // pos of the layout
+    auto load_node = [&](uint64_t pos) {
+        memset(node_buf.get(), 0, max_node_len);
+        if (layout.empty())
+        {
+            // read cur node's nnbrs
+            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
+
+            // sanity checks on nnbrs
+            assert(nnbrs > 0);
+            assert(nnbrs <= width_u32);
+
+            // read node's nhood
+            vamana_reader.read((char *)nhood_buf, (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+            if (nnbrs > width_u32)
+            {
+                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
+            }
+
+            // write coords of node first
+            base_reader.read((char *)node_buf.get(), sizeof(T) * ndims_64);
+        }
+        else
+        {
+            const uint32_t id = layout[pos];
+            nnbrs = (uint32_t)graph[id].size();
+            memcpy(nhood_buf, graph[id].data(), nnbrs * sizeof(uint32_t));
+            coords_reader.seekg(2 * sizeof(uint32_t) + (uint64_t)id * ndims_64 * sizeof(T), coords_reader.beg);
+            coords_reader.read((char *)node_buf.get(), sizeof(T) * ndims_64);
+        }
+
+        // write nnbrs
+        nnbrs = (std::min)(nnbrs, width_u32);
+    };
+
     // number of sectors (1 for meta data)
     uint64_t n_sectors = nnodes_per_sector > 0 ? ROUND_UP(npts_64, nnodes_per_sector) / nnodes_per_sector
                                                : npts_64 * DIV_ROUND_UP(max_node_len, defaults::SECTOR_LEN);
@@ -948,7 +1093,6 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
 
     diskann_writer.write(sector_buf.get(), defaults::SECTOR_LEN);
 
-    std::unique_ptr<T[]> cur_node_coords = std::make_unique<T[]>(ndims_64);
     diskann::cout << "# sectors: " << n_sectors << std::endl;
     uint64_t cur_node_id = 0;
 
@@ -964,32 +1108,7 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
             for (uint64_t sector_node_id = 0; sector_node_id < nnodes_per_sector && cur_node_id < npts_64;
                  sector_node_id++)
             {
-                memset(node_buf.get(), 0, max_node_len);
-                // read cur node's nnbrs
-                vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
-
-                // sanity checks on nnbrs
-                assert(nnbrs > 0);
-                assert(nnbrs <= width_u32);
-
-                // read node's nhood
-                vamana_reader.read((char *)nhood_buf, (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
-                if (nnbrs > width_u32)
-                {
-                    vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
-                }
-
-                // write coords of node first
-                //  T *node_coords = data + ((uint64_t) ndims_64 * cur_node_id);
-                base_reader.read((char *)cur_node_coords.get(), sizeof(T) * ndims_64);
-                memcpy(node_buf.get(), cur_node_coords.get(), ndims_64 * sizeof(T));
-
-                // write nnbrs
-                *(uint32_t *)(node_buf.get() + ndims_64 * sizeof(T)) = (std::min)(nnbrs, width_u32);
-
-                // write nhood next
-                memcpy(node_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
-                       (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+                load_node(cur_node_id);
 
                 // get offset into sector_buf
                 char *sector_node_buf = sector_buf.get() + (sector_node_id * max_node_len);
@@ -1013,32 +1132,8 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
             }
             memset(multisector_buf.get(), 0, nsectors_per_node * defaults::SECTOR_LEN);
 
-            memset(node_buf.get(), 0, max_node_len);
-            // read cur node's nnbrs
-            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
-
-            // sanity checks on nnbrs
-            assert(nnbrs > 0);
-            assert(nnbrs <= width_u32);
-
-            // read node's nhood
-            vamana_reader.read((char *)nhood_buf, (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
-            if (nnbrs > width_u32)
-            {
-                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
-            }
-
-            // write coords of node first
-            //  T *node_coords = data + ((uint64_t) ndims_64 * cur_node_id);
-            base_reader.read((char *)cur_node_coords.get(), sizeof(T) * ndims_64);
-            memcpy(multisector_buf.get(), cur_node_coords.get(), ndims_64 * sizeof(T));
-
-            // write nnbrs
-            *(uint32_t *)(multisector_buf.get() + ndims_64 * sizeof(T)) = (std::min)(nnbrs, width_u32);
-
-            // write nhood next
-            memcpy(multisector_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
-                   (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+            load_node(i);
+            memcpy(multisector_buf.get(), node_buf.get(), max_node_len);
 
             // flush sector to disk
             diskann_writer.write(multisector_buf.get(), nsectors_per_node * defaults::SECTOR_LEN);
@@ -1093,7 +1188,7 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
     {
         param_list.push_back(cur_param);
     }
-    if (param_list.size() < 5 || param_list.size() > 9)
+    if (param_list.size() < 5 || param_list.size() > 11)
     {
         diskann::cout << "Correct usage of parameters is R (max degree)\n"
                          "L (indexing list size, better if >= R)\n"
@@ -1107,6 +1202,10 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
                          "build_PQ_byte (number of PQ bytes for inde build; set 0 to use "
                          "full precision vectors)\n"
                          "QD Quantized Dimension to overwrite the derived dim from B "
+                         "locality_layout (set true to place nodes close in the graph in the same "
+                         "disk sector: optional parameter)\n"
+                         "PQ_bits (bits per chunk of the in-memory PQ codes, 8 or 4: optional "
+                         "parameter)"
                       << std::endl;
         return -1;
     }
@@ -1149,6 +1248,39 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
         build_pq_bytes = atoi(param_list[7].c_str());
     }
 
+    bool locality_layout = false;
+    if (param_list.size() >= 10)
+    {
+        locality_layout = (1 == atoi(param_list[9].c_str()));
+    }
+
+    uint32_t num_pq_centers = NUM_PQ_CENTROIDS;
+    if (param_list.size() >= 11)
+    {
+        const uint32_t pq_bits = (uint32_t)atoi(param_list[10].c_str());
+        if (pq_bits != NUM_PQ_BITS && pq_bits != NUM_PQ_BITS_FAST_SCAN)
+        {
+            diskann::cout << "PQ_bits must be " << NUM_PQ_BITS << " or " << NUM_PQ_BITS_FAST_SCAN << std::endl;
+            return -1;
+        }
+        num_pq_centers = 1 << pq_bits;
+    }
+
+    // QD overrides the number of PQ chunks derived from the DRAM budget. Both
+    // counts are chunks, two to a byte with 4-bit codes, so an override past
+    // MAX_PQ_CHUNKS is rejected here, before any data is processed
+    uint32_t quantized_dim = 0;
+    if (param_list.size() >= 9)
+    {
+        quantized_dim = (uint32_t)atoi(param_list[8].c_str());
+        if (quantized_dim > MAX_PQ_CHUNKS)
+        {
+            diskann::cout << "QD must be at most " << MAX_PQ_CHUNKS << " PQ chunks, got " << param_list[8]
+                          << std::endl;
+            return -1;
+        }
+    }
+
     std::string base_file(dataFilePath);
     std::string data_file_to_use = base_file;
     std::string labels_file_original = label_file;
@@ -1261,24 +1393,29 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
                                         compareMetric, p_val, disk_pq_dims);
     }
     size_t num_pq_chunks = (size_t)(std::floor)(uint64_t(final_index_ram_limit / points_num));
+    // 4-bit codes fit two chunks in each byte of the budget, the doubled
+    // count is capped at MAX_PQ_CHUNKS below like the 8-bit one
+    if (num_pq_centers == NUM_PQ_CENTROIDS_FAST_SCAN)
+        num_pq_chunks *= 2;
 
     num_pq_chunks = num_pq_chunks <= 0 ? 1 : num_pq_chunks;
     num_pq_chunks = num_pq_chunks > dim ? dim : num_pq_chunks;
     num_pq_chunks = num_pq_chunks > MAX_PQ_CHUNKS ? MAX_PQ_CHUNKS : num_pq_chunks;
 
-    if (param_list.size() >= 9 && atoi(param_list[8].c_str()) <= MAX_PQ_CHUNKS && atoi(param_list[8].c_str()) > 0)
+    if (quantized_dim > 0)
     {
         std::cout << "Use quantized dimension (QD) to overwrite derived quantized "
                      "dimension from search_DRAM_budget (B)"
                   << std::endl;
-        num_pq_chunks = atoi(param_list[8].c_str());
+        num_pq_chunks = quantized_dim;
     }
 
-    diskann::cout << "Compressing " << dim << "-dimensional data into " << num_pq_chunks << " bytes per vector."
-                  << std::endl;
+    diskann::cout << "Compressing " << dim << "-dimensional data into " << num_pq_chunks << " chunks of "
+                  << (num_pq_centers == NUM_PQ_CENTROIDS_FAST_SCAN ? NUM_PQ_BITS_FAST_SCAN : NUM_PQ_BITS)
+                  << " bits per vector." << std::endl;
 
     generate_quantized_data<T>(data_file_to_use, pq_pivots_path, pq_compressed_vectors_path, compareMetric, p_val,
-                               num_pq_chunks, use_opq, codebook_prefix);
+                               num_pq_chunks, use_opq, codebook_prefix, num_pq_centers);
     diskann::cout << timer.elapsed_seconds_for_step("generating quantized data") << std::endl;
 
 // Gopal. Splitting diskann_dll into separate DLLs for search and build.
@@ -1297,15 +1434,17 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
     timer.reset();
     if (!use_disk_pq)
     {
-        diskann::create_disk_layout<T>(data_file_to_use.c_str(), mem_index_path, disk_index_path);
+        diskann::create_disk_layout<T>(data_file_to_use.c_str(), mem_index_path, disk_index_path, "",
+                                       locality_layout);
     }
     else
     {
         if (!reorder_data)
-            diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path);
+            diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path, "",
+                                                 locality_layout);
         else
             diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path,
-                                                 data_file_to_use.c_str());
+                                                 data_file_to_use.c_str(), locality_layout);
     }
     diskann::cout << timer.elapsed_seconds_for_step("generating disk layout") << std::endl;
 
@@ -1342,14 +1481,17 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
 template DISKANN_DLLEXPORT void create_disk_layout<int8_t>(const std::string base_file,
                                                            const std::string mem_index_file,
                                                            const std::string output_file,
-                                                           const std::string reorder_data_file);
+                                                           const std::string reorder_data_file,
+                                                           const bool locality_layout);
 template DISKANN_DLLEXPORT void create_disk_layout<uint8_t>(const std::string base_file,
                                                             const std::string mem_index_file,
                                                             const std::string output_file,
-                                                            const std::string reorder_data_file);
+                                                            const std::string reorder_data_file,
+                                                            const bool locality_layout);
 template DISKANN_DLLEXPORT void create_disk_layout<float>(const std::string base_file, const std::string mem_index_file,
                                                           const std::string output_file,
-                                                          const std::string reorder_data_file);
+                                                          const std::string reorder_data_file,
+                                                          const bool locality_layout);
 
 template DISKANN_DLLEXPORT int8_t *load_warmup<int8_t>(const std::string &cache_warmup_file, uint64_t &warmup_num,
                                                        uint64_t warmup_dim, uint64_t warmup_aligned_dim);
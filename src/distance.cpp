@@ -15,6 +15,7 @@
 #include <iostream>
 
 #include "distance.h"
+#include "distance_kernels.h"
 #include "utils.h"
 #include "logger.h"
 #include "ann_exception.h"
@@ -65,6 +66,14 @@ template <typename T> Distance<T>::~Distance()
 {
 }
 
+template <typename T>
+void Distance<T>::compare_batch(const T *query, const T *base, const size_t stride, const uint32_t *ids,
+                                const uint32_t count, const uint32_t length, float *distances) const
+{
+    compare_batch_prefetched(query, base, stride, ids, count, length, distances,
+                             [this](const T *a, const T *b, uint32_t len) { return this->compare(a, b, len); });
+}
+
 //
 // Cosine distance functions.
 //
@@ -599,12 +608,83 @@ void AVXNormalizedCosineDistanceFloat::normalize_and_copy(const float *query_vec
     }
 }
 
+//
+// Batched comparisons, see Distance::compare_batch.
+//
+void DistanceCosineInt8::compare_batch(const int8_t *query, const int8_t *base, const size_t stride,
+                                      const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                      float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void DistanceL2Int8::compare_batch(const int8_t *query, const int8_t *base, const size_t stride,
+                                  const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                  float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void DistanceL2UInt8::compare_batch(const uint8_t *query, const uint8_t *base, const size_t stride,
+                                   const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                   float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void DistanceCosineFloat::compare_batch(const float *query, const float *base, const size_t stride,
+                                       const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                       float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void DistanceL2Float::compare_batch(const float *query, const float *base, const size_t stride,
+                                   const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                   float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void AVXDistanceInnerProductFloat::compare_batch(const float *query, const float *base, const size_t stride,
+                                                const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+void AVXNormalizedCosineDistanceFloat::compare_batch(const float *query, const float *base, const size_t stride,
+                                                    const uint32_t *ids, const uint32_t count, const uint32_t length,
+                                                    float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+template <typename T>
+void KernelDistance<T>::compare_batch(const T *query, const T *base, const size_t stride, const uint32_t *ids,
+                                      const uint32_t count, const uint32_t length, float *distances) const
+{
+    compare_batch_with(*this, query, base, stride, ids, count, length, distances);
+}
+
+// true if the CPU has better kernels than the ones the build was compiled for
+static bool use_distance_kernels()
+{
+    return &get_distance_kernels() != &get_baseline_distance_kernels();
+}
+
 // Get the right distance function for the given metric.
 template <> diskann::Distance<float> *get_distance_function(diskann::Metric m)
 {
+    const DistanceKernels &kernels = get_distance_kernels();
     if (m == diskann::Metric::L2)
     {
-        if (Avx2SupportedCPU)
+        if (use_distance_kernels())
+        {
+            diskann::cout << "L2: Using " << kernels.name << " distance computation" << std::endl;
+            return new diskann::KernelDistance<float>(m, kernels.l2_float);
+        }
+        else if (Avx2SupportedCPU)
         {
             diskann::cout << "L2: Using AVX2 distance computation DistanceL2Float" << std::endl;
             return new diskann::DistanceL2Float();
@@ -622,11 +702,21 @@ template <> diskann::Distance<float> *get_distance_function(diskann::Metric m)
     }
     else if (m == diskann::Metric::COSINE)
     {
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Cosine: Using " << kernels.name << " implementation" << std::endl;
+            return new diskann::KernelDistance<float>(m, kernels.cosine_float);
+        }
         diskann::cout << "Cosine: Using either AVX or AVX2 implementation" << std::endl;
         return new diskann::DistanceCosineFloat();
     }
     else if (m == diskann::Metric::INNER_PRODUCT)
     {
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Inner product: Using " << kernels.name << " implementation" << std::endl;
+            return new diskann::KernelDistance<float>(m, kernels.inner_product_float);
+        }
         diskann::cout << "Inner product: Using AVX2 implementation "
                          "AVXDistanceInnerProductFloat"
                       << std::endl;
@@ -652,9 +742,15 @@ template <> diskann::Distance<float> *get_distance_function(diskann::Metric m)
 
 template <> diskann::Distance<int8_t> *get_distance_function(diskann::Metric m)
 {
+    const DistanceKernels &kernels = get_distance_kernels();
     if (m == diskann::Metric::L2)
     {
-        if (Avx2SupportedCPU)
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Using " << kernels.name << " distance computation for int8." << std::endl;
+            return new diskann::KernelDistance<int8_t>(m, kernels.l2_int8);
+        }
+        else if (Avx2SupportedCPU)
         {
             diskann::cout << "Using AVX2 distance computation DistanceL2Int8." << std::endl;
             return new diskann::DistanceL2Int8();
@@ -674,6 +770,11 @@ template <> diskann::Distance<int8_t> *get_distance_function(diskann::Metric m)
     }
     else if (m == diskann::Metric::COSINE)
     {
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Using " << kernels.name << " for Cosine similarity of int8." << std::endl;
+            return new diskann::KernelDistance<int8_t>(m, kernels.cosine_int8);
+        }
         diskann::cout << "Using either AVX or AVX2 for Cosine similarity "
                          "DistanceCosineInt8."
                       << std::endl;
@@ -690,8 +791,14 @@ template <> diskann::Distance<int8_t> *get_distance_function(diskann::Metric m)
 
 template <> diskann::Distance<uint8_t> *get_distance_function(diskann::Metric m)
 {
+    const DistanceKernels &kernels = get_distance_kernels();
     if (m == diskann::Metric::L2)
     {
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Using " << kernels.name << " distance computation for uint8." << std::endl;
+            return new diskann::KernelDistance<uint8_t>(m, kernels.l2_uint8);
+        }
 #ifdef _WINDOWS
         diskann::cout << "WARNING: AVX/AVX2 distance function not defined for Uint8. "
                          "Using "
@@ -703,6 +810,11 @@ template <> diskann::Distance<uint8_t> *get_distance_function(diskann::Metric m)
     }
     else if (m == diskann::Metric::COSINE)
     {
+        if (use_distance_kernels())
+        {
+            diskann::cout << "Using " << kernels.name << " for Cosine similarity of uint8." << std::endl;
+            return new diskann::KernelDistance<uint8_t>(m, kernels.cosine_uint8);
+        }
         diskann::cout << "AVX/AVX2 distance function not defined for Uint8. Using "
                          "slow version SlowDistanceCosineUint8() "
                          "Contact gopalsr@microsoft.com if you need AVX/AVX2 support."
@@ -718,6 +830,10 @@ template <> diskann::Distance<uint8_t> *get_distance_function(diskann::Metric m)
     }
 }
 
+template DISKANN_DLLEXPORT class Distance<float>;
+template DISKANN_DLLEXPORT class Distance<int8_t>;
+template DISKANN_DLLEXPORT class Distance<uint8_t>;
+
 template DISKANN_DLLEXPORT class DistanceInnerProduct<float>;
 template DISKANN_DLLEXPORT class DistanceInnerProduct<int8_t>;
 template DISKANN_DLLEXPORT class DistanceInnerProduct<uint8_t>;
@@ -730,4 +846,8 @@ template DISKANN_DLLEXPORT class SlowDistanceL2<float>;
 template DISKANN_DLLEXPORT class SlowDistanceL2<int8_t>;
 template DISKANN_DLLEXPORT class SlowDistanceL2<uint8_t>;
 
+template DISKANN_DLLEXPORT class KernelDistance<float>;
+template DISKANN_DLLEXPORT class KernelDistance<int8_t>;
+template DISKANN_DLLEXPORT class KernelDistance<uint8_t>;
+
 } // namespace diskann
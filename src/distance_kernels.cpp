@@ -0,0 +1,230 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cmath>
+
+#ifdef _WINDOWS
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include "utils.h"
+#include "distance.h"
+#include "distance_kernels.h"
+
+// The AVX-512 kernels are compiled for their instruction set whatever the
+// flags of the build, and only called on CPUs that have it. MSVC emits any
+// intrinsic without flags.
+#ifdef _WINDOWS
+#define DISKANN_TARGET_AVX512
+#define DISKANN_TARGET_AVX512_VNNI
+#else
+#define DISKANN_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl")))
+#define DISKANN_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+#endif
+
+namespace
+{
+// the implementations get_distance_function picks without AVX-512
+template <typename T, typename DistanceT> float baseline_kernel(const T *a, const T *b, uint32_t length)
+{
+    static const DistanceT distance;
+    return distance.compare(a, b, length);
+}
+
+float cosine_from_products(int64_t ab, int64_t aa, int64_t bb)
+{
+    return 1.0f - (float)(ab / (std::sqrt((double)aa) * std::sqrt((double)bb)));
+}
+
+//
+// AVX-512 float kernels: two accumulators over 32 floats per iteration, and
+// a masked load for the tail.
+//
+
+DISKANN_TARGET_AVX512 float l2_float_avx512(const float *a, const float *b, uint32_t length)
+{
+    __m512 sum0 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m512 diff0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        const __m512 diff1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+        sum0 = _mm512_fmadd_ps(diff0, diff0, sum0);
+        sum1 = _mm512_fmadd_ps(diff1, diff1, sum1);
+    }
+    for (; i < length; i += 16)
+    {
+        const __mmask16 mask = length - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (length - i)) - 1);
+        const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+        sum0 = _mm512_fmadd_ps(diff, diff, sum0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1));
+}
+
+DISKANN_TARGET_AVX512 float inner_product_float_avx512(const float *a, const float *b, uint32_t length)
+{
+    __m512 sum0 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum0);
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), sum1);
+    }
+    for (; i < length; i += 16)
+    {
+        const __mmask16 mask = length - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (length - i)) - 1);
+        sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum0);
+    }
+    return -_mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1));
+}
+
+DISKANN_TARGET_AVX512 float cosine_float_avx512(const float *a, const float *b, uint32_t length)
+{
+    __m512 ab = _mm512_setzero_ps(), aa = _mm512_setzero_ps(), bb = _mm512_setzero_ps();
+    for (uint32_t i = 0; i < length; i += 16)
+    {
+        const __mmask16 mask = length - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (length - i)) - 1);
+        const __m512 va = _mm512_maskz_loadu_ps(mask, a + i);
+        const __m512 vb = _mm512_maskz_loadu_ps(mask, b + i);
+        ab = _mm512_fmadd_ps(va, vb, ab);
+        aa = _mm512_fmadd_ps(va, va, aa);
+        bb = _mm512_fmadd_ps(vb, vb, bb);
+    }
+    const float magA = _mm512_reduce_add_ps(aa), magB = _mm512_reduce_add_ps(bb);
+    return 1.0f - _mm512_reduce_add_ps(ab) / (std::sqrt(magA) * std::sqrt(magB));
+}
+
+//
+// AVX-512 byte kernels. 32 bytes at a time are widened to 16 bits and
+// multiplied pairwise into 32-bit lanes, with vpmaddwd + vpaddd on
+// AVX-512BW or a single vpdpwssd on VNNI. The macro stamps out both sets,
+// since each needs its own target attribute.
+//
+
+#define DISKANN_BYTE_MASK(length, i)                                                                                   \
+    ((length) - (i) >= 32 ? (__mmask32)0xFFFFFFFF : (__mmask32)((1u << ((length) - (i))) - 1))
+
+#define DISKANN_AVX512_BYTE_KERNELS(TARGET, SUFFIX, DOT)                                                               \
+    TARGET float l2_int8_##SUFFIX(const int8_t *a, const int8_t *b, uint32_t length)                                   \
+    {                                                                                                                  \
+        __m512i sum = _mm512_setzero_si512();                                                                          \
+        for (uint32_t i = 0; i < length; i += 32)                                                                      \
+        {                                                                                                              \
+            const __mmask32 mask = DISKANN_BYTE_MASK(length, i);                                                       \
+            const __m512i va = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, a + i));                             \
+            const __m512i vb = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, b + i));                             \
+            const __m512i diff = _mm512_sub_epi16(va, vb);                                                             \
+            sum = DOT(sum, diff, diff);                                                                                \
+        }                                                                                                              \
+        return (float)_mm512_reduce_add_epi32(sum);                                                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    TARGET float l2_uint8_##SUFFIX(const uint8_t *a, const uint8_t *b, uint32_t length)                                \
+    {                                                                                                                  \
+        __m512i sum = _mm512_setzero_si512();                                                                          \
+        for (uint32_t i = 0; i < length; i += 32)                                                                      \
+        {                                                                                                              \
+            const __mmask32 mask = DISKANN_BYTE_MASK(length, i);                                                       \
+            const __m512i va = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, a + i));                             \
+            const __m512i vb = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, b + i));                             \
+            const __m512i diff = _mm512_sub_epi16(va, vb);                                                             \
+            sum = DOT(sum, diff, diff);                                                                                \
+        }                                                                                                              \
+        return (float)_mm512_reduce_add_epi32(sum);                                                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    TARGET float cosine_int8_##SUFFIX(const int8_t *a, const int8_t *b, uint32_t length)                               \
+    {                                                                                                                  \
+        __m512i ab = _mm512_setzero_si512(), aa = _mm512_setzero_si512(), bb = _mm512_setzero_si512();                 \
+        for (uint32_t i = 0; i < length; i += 32)                                                                      \
+        {                                                                                                              \
+            const __mmask32 mask = DISKANN_BYTE_MASK(length, i);                                                       \
+            const __m512i va = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, a + i));                             \
+            const __m512i vb = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, b + i));                             \
+            ab = DOT(ab, va, vb);                                                                                      \
+            aa = DOT(aa, va, va);                                                                                      \
+            bb = DOT(bb, vb, vb);                                                                                      \
+        }                                                                                                              \
+        return cosine_from_products(_mm512_reduce_add_epi32(ab), _mm512_reduce_add_epi32(aa),                          \
+                                    _mm512_reduce_add_epi32(bb));                                                      \
+    }                                                                                                                  \
+                                                                                                                       \
+    TARGET float cosine_uint8_##SUFFIX(const uint8_t *a, const uint8_t *b, uint32_t length)                            \
+    {                                                                                                                  \
+        __m512i ab = _mm512_setzero_si512(), aa = _mm512_setzero_si512(), bb = _mm512_setzero_si512();                 \
+        for (uint32_t i = 0; i < length; i += 32)                                                                      \
+        {                                                                                                              \
+            const __mmask32 mask = DISKANN_BYTE_MASK(length, i);                                                       \
+            const __m512i va = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, a + i));                             \
+            const __m512i vb = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, b + i));                             \
+            ab = DOT(ab, va, vb);                                                                                      \
+            aa = DOT(aa, va, va);                                                                                      \
+            bb = DOT(bb, vb, vb);                                                                                      \
+        }                                                                                                              \
+        return cosine_from_products(_mm512_reduce_add_epi32(ab), _mm512_reduce_add_epi32(aa),                          \
+                                    _mm512_reduce_add_epi32(bb));                                                      \
+    }
+
+#define DISKANN_DOT_MADD(sum, x, y) _mm512_add_epi32(sum, _mm512_madd_epi16(x, y))
+#define DISKANN_DOT_VNNI(sum, x, y) _mm512_dpwssd_epi32(sum, x, y)
+
+DISKANN_AVX512_BYTE_KERNELS(DISKANN_TARGET_AVX512, avx512, DISKANN_DOT_MADD)
+DISKANN_AVX512_BYTE_KERNELS(DISKANN_TARGET_AVX512_VNNI, avx512_vnni, DISKANN_DOT_VNNI)
+
+const diskann::DistanceKernels baseline_kernels = {"baseline",
+                                                    baseline_kernel<float, diskann::DistanceL2Float>,
+                                                    baseline_kernel<float, diskann::AVXDistanceInnerProductFloat>,
+                                                    baseline_kernel<float, diskann::DistanceCosineFloat>,
+                                                    baseline_kernel<int8_t, diskann::DistanceL2Int8>,
+                                                    baseline_kernel<int8_t, diskann::DistanceCosineInt8>,
+                                                    baseline_kernel<uint8_t, diskann::DistanceL2UInt8>,
+                                                    baseline_kernel<uint8_t, diskann::SlowDistanceCosineUInt8>};
+
+const diskann::DistanceKernels avx512_kernels = {"avx512",
+                                                  l2_float_avx512,
+                                                  inner_product_float_avx512,
+                                                  cosine_float_avx512,
+                                                  l2_int8_avx512,
+                                                  cosine_int8_avx512,
+                                                  l2_uint8_avx512,
+                                                  cosine_uint8_avx512};
+
+// the float kernels gain nothing from VNNI
+const diskann::DistanceKernels avx512_vnni_kernels = {"avx512_vnni",
+                                                       l2_float_avx512,
+                                                       inner_product_float_avx512,
+                                                       cosine_float_avx512,
+                                                       l2_int8_avx512_vnni,
+                                                       cosine_int8_avx512_vnni,
+                                                       l2_uint8_avx512_vnni,
+                                                       cosine_uint8_avx512_vnni};
+} // namespace
+
+namespace diskann
+{
+const DistanceKernels &get_baseline_distance_kernels()
+{
+    return baseline_kernels;
+}
+
+const DistanceKernels *get_avx512_distance_kernels()
+{
+    return Avx512SupportedCPU ? &avx512_kernels : nullptr;
+}
+
+const DistanceKernels *get_avx512_vnni_distance_kernels()
+{
+    return Avx512VnniSupportedCPU ? &avx512_vnni_kernels : nullptr;
+}
+
+const DistanceKernels &get_distance_kernels()
+{
+    static const DistanceKernels &kernels = Avx512VnniSupportedCPU ? avx512_vnni_kernels
+                                            : Avx512SupportedCPU   ? avx512_kernels
+                                                                   : baseline_kernels;
+    return kernels;
+}
+} // namespace diskann
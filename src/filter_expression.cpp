@@ -0,0 +1,236 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include "ann_exception.h"
+#include "filter_expression.h"
+
+namespace diskann
+{
+
+namespace
+{
+template <typename LabelT> void sort_and_unique(std::vector<LabelT> &labels)
+{
+    std::sort(labels.begin(), labels.end());
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+}
+
+// appends clause unless clauses has it already, which keeps ANDs of ORs of
+// the same labels from growing
+template <typename Clause> void add_clause(std::vector<Clause> &clauses, const Clause &clause)
+{
+    for (const auto &other : clauses)
+    {
+        if (other.labels == clause.labels && other.excluded_labels == clause.excluded_labels)
+            return;
+    }
+    clauses.push_back(clause);
+}
+
+// Recursive descent over the tokens of an expression, the parentheses and
+// the words between spaces and parentheses.
+template <typename LabelT> class FilterParser
+{
+  public:
+    FilterParser(const std::string &expression, const std::function<LabelT(const std::string &)> &convert_label)
+        : _expression(expression), _convert_label(convert_label)
+    {
+        std::string word;
+        for (const char c : expression)
+        {
+            if (c == '(' || c == ')' || std::isspace((unsigned char)c))
+            {
+                if (!word.empty())
+                    _tokens.push_back(word);
+                word.clear();
+                if (!std::isspace((unsigned char)c))
+                    _tokens.push_back(std::string(1, c));
+            }
+            else
+            {
+                word.push_back(c);
+            }
+        }
+        if (!word.empty())
+            _tokens.push_back(word);
+    }
+
+    FilterExpression<LabelT> parse()
+    {
+        auto expression = parse_or();
+        if (_pos != _tokens.size())
+            fail("unexpected \"" + _tokens[_pos] + "\"");
+        return expression;
+    }
+
+  private:
+    FilterExpression<LabelT> parse_or()
+    {
+        auto expression = parse_and();
+        while (accept("OR"))
+            expression = FilterExpression<LabelT>::disjunction(expression, parse_and());
+        return expression;
+    }
+
+    FilterExpression<LabelT> parse_and()
+    {
+        auto expression = parse_not();
+        while (accept("AND"))
+            expression = FilterExpression<LabelT>::conjunction(expression, parse_not());
+        return expression;
+    }
+
+    FilterExpression<LabelT> parse_not()
+    {
+        if (accept("NOT"))
+            return FilterExpression<LabelT>::negation(parse_not());
+        if (accept("("))
+        {
+            auto expression = parse_or();
+            if (!accept(")"))
+                fail("missing \")\"");
+            return expression;
+        }
+        if (_pos == _tokens.size())
+            fail("missing label at the end");
+        const std::string &token = _tokens[_pos];
+        if (token == ")" || token == "AND" || token == "OR")
+            fail("missing label before \"" + token + "\"");
+        _pos++;
+        return FilterExpression<LabelT>::label(_convert_label(token));
+    }
+
+    bool accept(const char *token)
+    {
+        if (_pos == _tokens.size() || _tokens[_pos] != token)
+            return false;
+        _pos++;
+        return true;
+    }
+
+    void fail(const std::string &message)
+    {
+        throw ANNException("Malformed filter expression \"" + _expression + "\": " + message, -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+
+    const std::string &_expression;
+    const std::function<LabelT(const std::string &)> &_convert_label;
+    std::vector<std::string> _tokens;
+    size_t _pos = 0;
+};
+} // namespace
+
+template <typename LabelT>
+FilterExpression<LabelT>::Matcher::Matcher(const FilterExpression<LabelT> &expression,
+                                           const LabelBitmapIndex<LabelT> &index, const bool use_universal_label,
+                                           const LabelT &universal_label)
+    : _use_universal_label(use_universal_label), _universal_label(index.matcher(universal_label))
+{
+    for (const auto &clause : expression._clauses)
+    {
+        for (const auto &label : clause.labels)
+            _labels.push_back(index.matcher(label));
+        const uint32_t labels_end = (uint32_t)_labels.size();
+        for (const auto &label : clause.excluded_labels)
+            _labels.push_back(index.matcher(label));
+        _clause_ends.emplace_back(labels_end, (uint32_t)_labels.size());
+    }
+}
+
+template <typename LabelT> FilterExpression<LabelT> FilterExpression<LabelT>::label(const LabelT &label)
+{
+    FilterExpression<LabelT> expression;
+    expression._clauses.emplace_back();
+    expression._clauses[0].labels.push_back(label);
+    return expression;
+}
+
+template <typename LabelT>
+FilterExpression<LabelT> FilterExpression<LabelT>::conjunction(const FilterExpression<LabelT> &left,
+                                                               const FilterExpression<LabelT> &right)
+{
+    // (a OR b) AND (c OR d) is (a AND c) OR (a AND d) OR (b AND c) OR (b AND d)
+    FilterExpression<LabelT> expression;
+    for (const auto &left_clause : left._clauses)
+    {
+        for (const auto &right_clause : right._clauses)
+        {
+            Clause clause = left_clause;
+            clause.labels.insert(clause.labels.end(), right_clause.labels.begin(), right_clause.labels.end());
+            clause.excluded_labels.insert(clause.excluded_labels.end(), right_clause.excluded_labels.begin(),
+                                          right_clause.excluded_labels.end());
+            sort_and_unique(clause.labels);
+            sort_and_unique(clause.excluded_labels);
+
+            // a clause that requires and excludes the same label matches
+            // nothing
+            std::vector<LabelT> contradictions;
+            std::set_intersection(clause.labels.begin(), clause.labels.end(), clause.excluded_labels.begin(),
+                                  clause.excluded_labels.end(), std::back_inserter(contradictions));
+            if (contradictions.empty())
+                add_clause(expression._clauses, clause);
+        }
+    }
+    if (expression._clauses.size() > MAX_CLAUSES)
+    {
+        throw ANNException("Filter expression has more than " + std::to_string(MAX_CLAUSES) +
+                               " clauses once expanded, simplify it.",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return expression;
+}
+
+template <typename LabelT>
+FilterExpression<LabelT> FilterExpression<LabelT>::disjunction(const FilterExpression<LabelT> &left,
+                                                               const FilterExpression<LabelT> &right)
+{
+    FilterExpression<LabelT> expression = left;
+    for (const auto &clause : right._clauses)
+        add_clause(expression._clauses, clause);
+    if (expression._clauses.size() > MAX_CLAUSES)
+    {
+        throw ANNException("Filter expression has more than " + std::to_string(MAX_CLAUSES) +
+                               " clauses once expanded, simplify it.",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return expression;
+}
+
+template <typename LabelT>
+FilterExpression<LabelT> FilterExpression<LabelT>::negation(const FilterExpression<LabelT> &expression)
+{
+    // NOT (c1 OR c2) is NOT c1 AND NOT c2, and NOT (a AND NOT b) is
+    // NOT a OR b. Starts from the clause without labels, which matches all.
+    FilterExpression<LabelT> negated;
+    negated._clauses.emplace_back();
+    for (const auto &clause : expression._clauses)
+    {
+        FilterExpression<LabelT> negated_clause;
+        for (const auto &label : clause.labels)
+        {
+            negated_clause._clauses.emplace_back();
+            negated_clause._clauses.back().excluded_labels.push_back(label);
+        }
+        for (const auto &label : clause.excluded_labels)
+            negated_clause._clauses.push_back(FilterExpression<LabelT>::label(label)._clauses[0]);
+        negated = conjunction(negated, negated_clause);
+    }
+    return negated;
+}
+
+template <typename LabelT>
+FilterExpression<LabelT> FilterExpression<LabelT>::parse(
+    const std::string &expression, const std::function<LabelT(const std::string &)> &convert_label)
+{
+    return FilterParser<LabelT>(expression, convert_label).parse();
+}
+
+template class FilterExpression<uint32_t>;
+template class FilterExpression<uint16_t>;
+
+} // namespace diskann
@@ -0,0 +1,419 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef DISKANN_USE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#include "huge_page_allocator.h"
+#include "utils.h"
+
+#define HUGE_PAGE_SIZE_2MB ((size_t)2 * 1024 * 1024)
+#define HUGE_PAGE_SIZE_1GB ((size_t)1024 * 1024 * 1024)
+// log2 of the page size, the way mmap wants it next to MAP_HUGETLB
+#define HUGE_PAGE_SHIFT_2MB 21
+#define HUGE_PAGE_SHIFT_1GB 30
+#define HUGE_PAGE_MAX_ALIGNMENT 4096
+
+namespace diskann
+{
+namespace
+{
+enum class PageKind
+{
+    REGULAR,
+    TRANSPARENT,
+    HUGE_2MB,
+    HUGE_1GB
+};
+
+struct Allocation
+{
+    size_t bytes;
+    // mapped and unmapped length, the caller sees [base, base + bytes)
+    size_t mapped_bytes;
+    PageKind kind;
+    NumaPolicy numa;
+    bool mapped;
+};
+
+// One bit per kind of fallback, each is only logged the first time
+enum FallbackWarning
+{
+    WARNED_1GB = 1,
+    WARNED_2MB = 2,
+    WARNED_TRANSPARENT = 4,
+    WARNED_NUMA = 8
+};
+
+struct AllocatorState
+{
+    std::mutex mutex;
+    HugePageConfig config;
+    HugePageStats stats;
+    std::unordered_map<void *, Allocation> allocations;
+    int warned = 0;
+};
+
+// node the allocations of this thread are bound to, -1 if none
+thread_local int thread_numa_binding = -1;
+
+AllocatorState &state()
+{
+    static AllocatorState allocator_state;
+    return allocator_state;
+}
+
+// returns true the first time it is called for a warning
+bool should_warn(AllocatorState &s, FallbackWarning warning)
+{
+    if (s.warned & warning)
+        return false;
+    s.warned |= warning;
+    return true;
+}
+
+size_t &bytes_of_kind(HugePageStats &stats, PageKind kind)
+{
+    switch (kind)
+    {
+    case PageKind::TRANSPARENT:
+        return stats.transparent_bytes;
+    case PageKind::HUGE_2MB:
+        return stats.huge_2mb_bytes;
+    case PageKind::HUGE_1GB:
+        return stats.huge_1gb_bytes;
+    default:
+        return stats.regular_bytes;
+    }
+}
+
+#ifndef _WINDOWS
+void *map_huge(size_t bytes, int page_shift)
+{
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    flags |= page_shift << MAP_HUGE_SHIFT;
+#else
+    if (page_shift != HUGE_PAGE_SHIFT_2MB)
+        return nullptr;
+#endif
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+    return nullptr;
+#endif
+}
+
+// a regular anonymous mapping starting at a multiple of alignment
+void *map_aligned(size_t bytes, size_t alignment)
+{
+    const size_t padded = bytes + alignment;
+    void *ptr = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+    char *start = (char *)ptr;
+    char *aligned = (char *)ROUND_UP((size_t)start, alignment);
+    if (aligned > start)
+        munmap(start, aligned - start);
+    char *end = aligned + bytes;
+    if (start + padded > end)
+        munmap(end, start + padded - end);
+    return aligned;
+}
+
+// Sets the NUMA policy of a fresh mapping, before any of its pages are
+// touched. Returns false if the policy could not be applied.
+bool apply_numa_policy(void *ptr, size_t bytes, const HugePageConfig &config)
+{
+#ifdef DISKANN_USE_NUMA
+    if (numa_available() < 0)
+        return false;
+    if (config.numa_policy == NumaPolicy::INTERLEAVE)
+    {
+        return mbind(ptr, bytes, MPOL_INTERLEAVE, numa_all_nodes_ptr->maskp, numa_all_nodes_ptr->size + 1, 0) == 0;
+    }
+    if (config.numa_node < 0 || config.numa_node > numa_max_node())
+        return false;
+    struct bitmask *nodes = numa_allocate_nodemask();
+    numa_bitmask_setbit(nodes, config.numa_node);
+    const bool bound = mbind(ptr, bytes, MPOL_BIND, nodes->maskp, nodes->size + 1, 0) == 0;
+    numa_free_nodemask(nodes);
+    return bound;
+#else
+    (void)ptr;
+    (void)bytes;
+    (void)config;
+    return false;
+#endif
+}
+#endif
+
+// Maps size bytes following config, falling back to smaller pages as needed.
+// Returns nullptr only if even regular pages cannot be mapped.
+void *map_pages(AllocatorState &s, const size_t size, const HugePageConfig &config, Allocation &allocation)
+{
+#ifndef _WINDOWS
+    allocation.mapped = true;
+    const HugePagePolicy policy = config.page_policy;
+    void *ptr = nullptr;
+
+    // 1GB pages are only worth it for allocations of at least a page
+    if (policy == HugePagePolicy::HUGE_1GB && size >= HUGE_PAGE_SIZE_1GB)
+    {
+        allocation.mapped_bytes = ROUND_UP(size, HUGE_PAGE_SIZE_1GB);
+        ptr = map_huge(allocation.mapped_bytes, HUGE_PAGE_SHIFT_1GB);
+        if (ptr != nullptr)
+        {
+            allocation.kind = PageKind::HUGE_1GB;
+            return ptr;
+        }
+        if (should_warn(s, WARNED_1GB))
+            diskann::cout << "No 1GB huge pages available, falling back to smaller pages" << std::endl;
+    }
+    if (policy == HugePagePolicy::HUGE_1GB || policy == HugePagePolicy::HUGE_2MB)
+    {
+        allocation.mapped_bytes = ROUND_UP(size, HUGE_PAGE_SIZE_2MB);
+        ptr = map_huge(allocation.mapped_bytes, HUGE_PAGE_SHIFT_2MB);
+        if (ptr != nullptr)
+        {
+            allocation.kind = PageKind::HUGE_2MB;
+            return ptr;
+        }
+        if (should_warn(s, WARNED_2MB))
+            diskann::cout << "No 2MB huge pages available, falling back to transparent huge pages" << std::endl;
+    }
+
+    if (policy != HugePagePolicy::NONE)
+    {
+        allocation.mapped_bytes = ROUND_UP(size, HUGE_PAGE_SIZE_2MB);
+        ptr = map_aligned(allocation.mapped_bytes, HUGE_PAGE_SIZE_2MB);
+        if (ptr == nullptr)
+            return nullptr;
+#ifdef MADV_HUGEPAGE
+        if (madvise(ptr, allocation.mapped_bytes, MADV_HUGEPAGE) == 0)
+        {
+            allocation.kind = PageKind::TRANSPARENT;
+            return ptr;
+        }
+#endif
+        if (should_warn(s, WARNED_TRANSPARENT))
+            diskann::cout << "Transparent huge pages not available, using regular pages" << std::endl;
+        allocation.kind = PageKind::REGULAR;
+        return ptr;
+    }
+
+    allocation.mapped_bytes = ROUND_UP(size, (size_t)sysconf(_SC_PAGESIZE));
+    allocation.kind = PageKind::REGULAR;
+    return map_aligned(allocation.mapped_bytes, HUGE_PAGE_MAX_ALIGNMENT);
+#else
+    (void)s;
+    (void)size;
+    (void)config;
+    (void)allocation;
+    return nullptr;
+#endif
+}
+
+} // namespace
+
+void set_huge_page_config(const HugePageConfig &config)
+{
+    AllocatorState &s = state();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.config = config;
+}
+
+HugePageConfig get_huge_page_config()
+{
+    AllocatorState &s = state();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    return s.config;
+}
+
+void set_thread_numa_binding(int numa_node)
+{
+    thread_numa_binding = numa_node;
+}
+
+HugePageConfig parse_huge_page_config(const std::string &huge_pages, const std::string &numa)
+{
+    HugePageConfig config;
+    if (huge_pages == "none")
+        config.page_policy = HugePagePolicy::NONE;
+    else if (huge_pages == "transparent")
+        config.page_policy = HugePagePolicy::TRANSPARENT;
+    else if (huge_pages == "2mb")
+        config.page_policy = HugePagePolicy::HUGE_2MB;
+    else if (huge_pages == "1gb")
+        config.page_policy = HugePagePolicy::HUGE_1GB;
+    else
+        throw diskann::ANNException("Unknown huge page policy " + huge_pages +
+                                        ", expected none, transparent, 2mb or 1gb.",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+
+    if (numa == "none")
+    {
+        config.numa_policy = NumaPolicy::NONE;
+    }
+    else if (numa == "interleave")
+    {
+        config.numa_policy = NumaPolicy::INTERLEAVE;
+    }
+    else
+    {
+        if (numa.empty() || numa.find_first_not_of("0123456789") != std::string::npos)
+            throw diskann::ANNException("Unknown NUMA policy " + numa +
+                                            ", expected none, interleave or the node number to bind to.",
+                                        -1, __FUNCSIG__, __FILE__, __LINE__);
+        config.numa_policy = NumaPolicy::BIND;
+        config.numa_node = std::stoi(numa);
+    }
+    return config;
+}
+
+void huge_page_alloc(void **ptr, size_t size, size_t align)
+{
+    *ptr = nullptr;
+    if (align > HUGE_PAGE_MAX_ALIGNMENT)
+    {
+        std::stringstream stream;
+        stream << "Alignment " << align << " requested from huge_page_alloc, at most " << HUGE_PAGE_MAX_ALIGNMENT
+               << " is supported.";
+        print_error_and_terminate(stream);
+    }
+
+    AllocatorState &s = state();
+    HugePageConfig config = get_huge_page_config();
+    if (thread_numa_binding >= 0)
+    {
+        config.numa_policy = NumaPolicy::BIND;
+        config.numa_node = thread_numa_binding;
+    }
+    const bool map = size >= HUGE_PAGE_MIN_ALLOCATION &&
+                     (config.page_policy != HugePagePolicy::NONE || config.numa_policy != NumaPolicy::NONE);
+    Allocation allocation{size, size, PageKind::REGULAR, NumaPolicy::NONE, false};
+    if (map)
+    {
+        std::lock_guard<std::mutex> guard(s.mutex);
+        *ptr = map_pages(s, size, config, allocation);
+    }
+    if (*ptr == nullptr)
+    {
+        // regular pages from the aligned allocator, as alloc_aligned gives
+        allocation = Allocation{size, size, PageKind::REGULAR, NumaPolicy::NONE, false};
+        alloc_aligned(ptr, size, align);
+        std::memset(*ptr, 0, size);
+    }
+#ifndef _WINDOWS
+    else if (config.numa_policy != NumaPolicy::NONE)
+    {
+        if (apply_numa_policy(*ptr, allocation.mapped_bytes, config))
+        {
+            allocation.numa = config.numa_policy;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(s.mutex);
+            if (should_warn(s, WARNED_NUMA))
+                diskann::cout << "NUMA policy could not be applied, using first touch placement" << std::endl;
+        }
+    }
+#endif
+
+    if (size < HUGE_PAGE_MIN_ALLOCATION)
+        return;
+
+    std::lock_guard<std::mutex> guard(s.mutex);
+    // 1GB pages are not tried below 1GB, 2MB pages are what was asked for there
+    PageKind wanted = PageKind::REGULAR;
+    if (config.page_policy == HugePagePolicy::HUGE_1GB && size >= HUGE_PAGE_SIZE_1GB)
+        wanted = PageKind::HUGE_1GB;
+    else if (config.page_policy == HugePagePolicy::HUGE_1GB || config.page_policy == HugePagePolicy::HUGE_2MB)
+        wanted = PageKind::HUGE_2MB;
+    else if (config.page_policy == HugePagePolicy::TRANSPARENT)
+        wanted = PageKind::TRANSPARENT;
+    const bool fell_back = allocation.kind != wanted || allocation.numa != config.numa_policy;
+    s.allocations.emplace(*ptr, allocation);
+    bytes_of_kind(s.stats, allocation.kind) += allocation.mapped_bytes;
+    if (allocation.numa == NumaPolicy::INTERLEAVE)
+        s.stats.numa_interleaved_bytes += allocation.mapped_bytes;
+    else if (allocation.numa == NumaPolicy::BIND)
+        s.stats.numa_bound_bytes += allocation.mapped_bytes;
+    s.stats.num_allocations++;
+    if (fell_back)
+        s.stats.num_fallbacks++;
+}
+
+void huge_page_free(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    AllocatorState &s = state();
+    Allocation allocation{};
+    {
+        std::lock_guard<std::mutex> guard(s.mutex);
+        auto iter = s.allocations.find(ptr);
+        if (iter == s.allocations.end())
+        {
+            // below HUGE_PAGE_MIN_ALLOCATION, straight from alloc_aligned
+            aligned_free(ptr);
+            return;
+        }
+        allocation = iter->second;
+        s.allocations.erase(iter);
+        bytes_of_kind(s.stats, allocation.kind) -= allocation.mapped_bytes;
+        if (allocation.numa == NumaPolicy::INTERLEAVE)
+            s.stats.numa_interleaved_bytes -= allocation.mapped_bytes;
+        else if (allocation.numa == NumaPolicy::BIND)
+            s.stats.numa_bound_bytes -= allocation.mapped_bytes;
+        s.stats.num_allocations--;
+    }
+
+#ifndef _WINDOWS
+    if (allocation.mapped)
+    {
+        munmap(ptr, allocation.mapped_bytes);
+        return;
+    }
+#endif
+    aligned_free(ptr);
+}
+
+HugePageStats get_huge_page_stats()
+{
+    AllocatorState &s = state();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    return s.stats;
+}
+
+void print_huge_page_stats()
+{
+    const HugePageStats stats = get_huge_page_stats();
+    const double mb = 1024.0 * 1024.0;
+    diskann::cout << "Large allocations: " << stats.num_allocations << ", 1GB pages: " << stats.huge_1gb_bytes / mb
+                  << "MB, 2MB pages: " << stats.huge_2mb_bytes / mb
+                  << "MB, transparent huge pages: " << stats.transparent_bytes / mb
+                  << "MB, regular pages: " << stats.regular_bytes / mb << "MB";
+    if (stats.numa_interleaved_bytes > 0 || stats.numa_bound_bytes > 0)
+    {
+        diskann::cout << ", NUMA interleaved: " << stats.numa_interleaved_bytes / mb
+                      << "MB, NUMA bound: " << stats.numa_bound_bytes / mb << "MB";
+    }
+    diskann::cout << ", fallbacks: " << stats.num_fallbacks << std::endl;
+}
+
+} // namespace diskann
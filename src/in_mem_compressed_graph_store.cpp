@@ -0,0 +1,291 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cmath>
+
+#include "in_mem_compressed_graph_store.h"
+#include "defaults.h"
+#include "utils.h"
+#include "streamvbyte/include/streamvbyte.h"
+
+namespace diskann
+{
+InMemCompressedGraphStore::InMemCompressedGraphStore(const size_t total_pts, const size_t reserve_graph_degree)
+    : AbstractGraphStore(total_pts, reserve_graph_degree),
+      _tail_capacity((size_t)std::ceil(defaults::COMPRESSED_GRAPH_TAIL_FRACTION * reserve_graph_degree))
+{
+    this->resize_graph(total_pts);
+}
+
+std::tuple<uint32_t, uint32_t, size_t> InMemCompressedGraphStore::load(const std::string &index_path_prefix,
+                                                                       const size_t num_points)
+{
+    return load_impl(index_path_prefix, num_points);
+}
+
+int InMemCompressedGraphStore::store(const std::string &index_path_prefix, const size_t num_points,
+                                     const size_t num_frozen_points, const uint32_t start)
+{
+    return save_graph(index_path_prefix, num_points, num_frozen_points, start);
+}
+
+std::vector<location_t> InMemCompressedGraphStore::get_neighbours(const location_t i) const
+{
+    std::vector<location_t> neighbours;
+    get_neighbours(i, neighbours);
+    return neighbours;
+}
+
+uint32_t InMemCompressedGraphStore::get_neighbours(const location_t i, std::vector<location_t> &out) const
+{
+    const uint32_t block_degree = _block_degrees[i];
+    const uint32_t tail_degree = _tail_degrees[i];
+    out.resize((size_t)block_degree + tail_degree);
+    if (block_degree > 0)
+    {
+        streamvbyte_delta_decode(_blocks[i].data(), out.data(), block_degree, 0);
+    }
+    if (tail_degree > 0)
+    {
+        std::memcpy(out.data() + block_degree, _tails.data() + i * _tail_capacity, tail_degree * sizeof(location_t));
+    }
+    return block_degree + tail_degree;
+}
+
+uint32_t InMemCompressedGraphStore::get_degree(const location_t i) const
+{
+    return _block_degrees[i] + _tail_degrees[i];
+}
+
+void InMemCompressedGraphStore::add_neighbour(const location_t i, location_t neighbour_id)
+{
+    if (_tail_capacity == 0)
+    {
+        // no append slots (e.g. a search-only store), fall back to re-encoding
+        thread_local std::vector<location_t> ids;
+        get_neighbours(i, ids);
+        ids.push_back(neighbour_id);
+        encode_block(i, ids);
+    }
+    else
+    {
+        if (_tail_degrees[i] == _tail_capacity)
+        {
+            merge_tail(i);
+        }
+        _tails[i * _tail_capacity + _tail_degrees[i]] = neighbour_id;
+        _tail_degrees[i]++;
+    }
+
+    const uint32_t degree = get_degree(i);
+    if (_max_observed_degree < degree)
+    {
+        _max_observed_degree = degree;
+    }
+}
+
+void InMemCompressedGraphStore::clear_neighbours(const location_t i)
+{
+    _blocks[i].clear();
+    _block_degrees[i] = 0;
+    _tail_degrees[i] = 0;
+}
+
+void InMemCompressedGraphStore::swap_neighbours(const location_t a, location_t b)
+{
+    _blocks[a].swap(_blocks[b]);
+    std::swap(_block_degrees[a], _block_degrees[b]);
+    std::swap_ranges(_tails.begin() + a * _tail_capacity, _tails.begin() + (a + 1) * _tail_capacity,
+                     _tails.begin() + b * _tail_capacity);
+    std::swap(_tail_degrees[a], _tail_degrees[b]);
+}
+
+void InMemCompressedGraphStore::set_neighbours(const location_t i, std::vector<location_t> &neighbours)
+{
+    // sort a copy, callers may still depend on the order of their pruned list
+    thread_local std::vector<location_t> ids;
+    ids.assign(neighbours.begin(), neighbours.end());
+    encode_block(i, ids);
+
+    if (_max_observed_degree < neighbours.size())
+    {
+        _max_observed_degree = (uint32_t)(neighbours.size());
+    }
+}
+
+void InMemCompressedGraphStore::encode_block(const location_t i, std::vector<location_t> &ids)
+{
+    thread_local std::vector<uint8_t> buf;
+    std::sort(ids.begin(), ids.end());
+    buf.resize(streamvbyte_max_compressedbytes((uint32_t)ids.size()));
+    size_t out_len = streamvbyte_delta_encode(ids.data(), (uint32_t)ids.size(), buf.data(), 0);
+    _blocks[i].assign(buf.begin(), buf.begin() + out_len);
+    _block_degrees[i] = (uint32_t)ids.size();
+    _tail_degrees[i] = 0;
+}
+
+void InMemCompressedGraphStore::merge_tail(const location_t i)
+{
+    thread_local std::vector<location_t> ids;
+    get_neighbours(i, ids);
+    encode_block(i, ids);
+}
+
+size_t InMemCompressedGraphStore::resize_graph(const size_t new_size)
+{
+    _blocks.resize(new_size);
+    _block_degrees.resize(new_size, 0);
+    _tails.resize(new_size * _tail_capacity);
+    _tail_degrees.resize(new_size, 0);
+
+    set_total_points(new_size);
+    return _blocks.size();
+}
+
+void InMemCompressedGraphStore::clear_graph()
+{
+    _blocks.clear();
+    _block_degrees.clear();
+    _tails.clear();
+    _tail_degrees.clear();
+}
+
+std::tuple<uint32_t, uint32_t, size_t> InMemCompressedGraphStore::load_impl(const std::string &filename,
+                                                                            size_t expected_num_points)
+{
+    size_t expected_file_size;
+    size_t file_frozen_pts;
+    uint32_t start;
+    size_t file_offset = 0; // will need this for single file format support
+
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(filename, std::ios::binary);
+    in.seekg(file_offset, in.beg);
+    in.read((char *)&expected_file_size, sizeof(size_t));
+    in.read((char *)&_max_observed_degree, sizeof(uint32_t));
+    in.read((char *)&start, sizeof(uint32_t));
+    in.read((char *)&file_frozen_pts, sizeof(size_t));
+    size_t vamana_metadata_size = sizeof(size_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(size_t);
+
+    diskann::cout << "From graph header, expected_file_size: " << expected_file_size
+                  << ", _max_observed_degree: " << _max_observed_degree << ", _start: " << start
+                  << ", file_frozen_pts: " << file_frozen_pts << std::endl;
+
+    diskann::cout << "Loading vamana graph " << filename << "..." << std::flush;
+
+    // If user provides more points than max_points
+    // resize the _graph to the larger size.
+    if (get_total_points() < expected_num_points)
+    {
+        diskann::cout << "resizing graph to " << expected_num_points << std::endl;
+        this->resize_graph(expected_num_points);
+    }
+
+    size_t bytes_read = vamana_metadata_size;
+    size_t cc = 0;
+    uint32_t nodes_read = 0;
+    std::vector<location_t> tmp;
+    tmp.reserve(_max_observed_degree);
+    while (bytes_read != expected_file_size)
+    {
+        uint32_t k;
+        in.read((char *)&k, sizeof(uint32_t));
+
+        if (k == 0)
+        {
+            diskann::cerr << "ERROR: Point found with no out-neighbours, point#" << nodes_read << std::endl;
+        }
+
+        cc += k;
+        ++nodes_read;
+        tmp.resize(k);
+        in.read((char *)tmp.data(), k * sizeof(uint32_t));
+        encode_block(nodes_read - 1, tmp);
+        bytes_read += sizeof(uint32_t) * ((size_t)k + 1);
+        if (nodes_read % 10000000 == 0)
+            diskann::cout << "." << std::flush;
+        if (k > _max_range_of_graph)
+        {
+            _max_range_of_graph = k;
+        }
+    }
+
+    diskann::cout << "done. Index has " << nodes_read << " nodes and " << cc << " out-edges, _start is set to " << start
+                  << std::endl;
+    return std::make_tuple(nodes_read, start, file_frozen_pts);
+}
+
+// Writes the same uncompressed format as the other graph stores, so a graph
+// built with one strategy can be loaded with any other.
+int InMemCompressedGraphStore::save_graph(const std::string &index_path_prefix, const size_t num_points,
+                                          const size_t num_frozen_points, const uint32_t start)
+{
+    std::ofstream out;
+    open_file_to_write(out, index_path_prefix);
+
+    size_t file_offset = 0;
+    out.seekp(file_offset, out.beg);
+    size_t index_size = 24;
+    uint32_t max_degree = 0;
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&_max_observed_degree, sizeof(uint32_t));
+    uint32_t ep_u32 = start;
+    out.write((char *)&ep_u32, sizeof(uint32_t));
+    out.write((char *)&num_frozen_points, sizeof(size_t));
+
+    // Note: num_points = _nd + _num_frozen_points
+    std::vector<location_t> neighbours;
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        uint32_t GK = get_neighbours(i, neighbours);
+        out.write((char *)&GK, sizeof(uint32_t));
+        out.write((char *)neighbours.data(), GK * sizeof(uint32_t));
+        max_degree = GK > max_degree ? GK : max_degree;
+        index_size += (size_t)(sizeof(uint32_t) * (GK + 1));
+    }
+    out.seekp(file_offset, out.beg);
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&max_degree, sizeof(uint32_t));
+    out.close();
+    return (int)index_size;
+}
+
+size_t InMemCompressedGraphStore::get_max_range_of_graph()
+{
+    return _max_range_of_graph;
+}
+
+uint32_t InMemCompressedGraphStore::get_max_observed_degree()
+{
+    return _max_observed_degree;
+}
+
+size_t InMemCompressedGraphStore::get_memory_in_bytes()
+{
+    size_t bytes = _blocks.capacity() * sizeof(std::vector<uint8_t>);
+    for (const auto &block : _blocks)
+    {
+        bytes += block.capacity();
+    }
+    bytes += (_block_degrees.capacity() + _tail_degrees.capacity()) * sizeof(uint32_t);
+    bytes += _tails.capacity() * sizeof(location_t);
+    return bytes;
+}
+
+void InMemCompressedGraphStore::release_build_memory()
+{
+    for (location_t i = 0; i < (location_t)_blocks.size(); i++)
+    {
+        if (_tail_degrees[i] > 0)
+        {
+            merge_tail(i);
+        }
+        _blocks[i].shrink_to_fit();
+    }
+    _tail_capacity = 0;
+    std::vector<location_t>().swap(_tails);
+}
+
+} // namespace diskann
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include "in_mem_data_store.h"
+#include "huge_page_allocator.h"
 
 #include "utils.h"
 
@@ -15,15 +16,14 @@ InMemDataStore<data_t>::InMemDataStore(const location_t num_points, const size_t
     : AbstractDataStore<data_t>(num_points, dim), _distance_fn(std::move(distance_fn))
 {
     _aligned_dim = ROUND_UP(dim, _distance_fn->get_required_alignment());
-    alloc_aligned(((void **)&_data), this->_capacity * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
-    std::memset(_data, 0, this->_capacity * _aligned_dim * sizeof(data_t));
+    huge_page_alloc(((void **)&_data), this->_capacity * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
 }
 
 template <typename data_t> InMemDataStore<data_t>::~InMemDataStore()
 {
     if (_data != nullptr)
     {
-        aligned_free(this->_data);
+        huge_page_free(this->_data);
     }
 }
 
@@ -55,7 +55,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(AlignedF
         stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
                << "but file has " << file_dim << " dimension." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -77,7 +78,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(const st
         std::stringstream stream;
         stream << "ERROR: data file " << filename << " does not exist." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
     diskann::get_bin_metadata(filename, file_num_points, file_dim);
@@ -88,7 +90,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(const st
         stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
                << "but file has " << file_dim << " dimension." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -185,10 +188,8 @@ template <typename data_t>
 void InMemDataStore<data_t>::get_distance(const data_t *query, const location_t *locations,
                                           const uint32_t location_count, float *distances) const
 {
-    for (location_t i = 0; i < location_count; i++)
-    {
-        distances[i] = _distance_fn->compare(query, _data + locations[i] * _aligned_dim, (uint32_t)this->_aligned_dim);
-    }
+    _distance_fn->compare_batch(query, _data, _aligned_dim, locations, location_count, (uint32_t)_aligned_dim,
+                                distances);
 }
 
 template <typename data_t>
@@ -211,15 +212,11 @@ template <typename data_t> location_t InMemDataStore<data_t>::expand(const locat
            << this->capacity() << ")" << std::endl;
         throw diskann::ANNException(ss.str(), -1);
     }
-#ifndef _WINDOWS
     data_t *new_data;
-    alloc_aligned((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
+    huge_page_alloc((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
     memcpy(new_data, _data, this->capacity() * _aligned_dim * sizeof(data_t));
-    aligned_free(_data);
+    huge_page_free(_data);
     _data = new_data;
-#else
-    realloc_aligned((void **)&_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
-#endif
     this->_capacity = new_size;
     return this->_capacity;
 }
@@ -237,15 +234,11 @@ template <typename data_t> location_t InMemDataStore<data_t>::shrink(const locat
            << this->capacity() << ")" << std::endl;
         throw diskann::ANNException(ss.str(), -1);
     }
-#ifndef _WINDOWS
     data_t *new_data;
-    alloc_aligned((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
+    huge_page_alloc((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
     memcpy(new_data, _data, new_size * _aligned_dim * sizeof(data_t));
-    aligned_free(_data);
+    huge_page_free(_data);
     _data = new_data;
-#else
-    realloc_aligned((void **)&_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
-#endif
     this->_capacity = new_size;
     return this->_capacity;
 }
@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+
+#include "huge_page_allocator.h"
+#include "in_mem_flat_graph_store.h"
+#include "utils.h"
+
+// Row stride is rounded up to this many bytes so rows never share a cache line
+#define FLAT_GRAPH_ROW_ALIGNMENT 64
+
+namespace diskann
+{
+InMemFlatGraphStore::InMemFlatGraphStore(const size_t total_pts, const size_t reserve_graph_degree)
+    : AbstractGraphStore(total_pts, reserve_graph_degree)
+{
+    reallocate(total_pts, reserve_graph_degree);
+}
+
+InMemFlatGraphStore::~InMemFlatGraphStore()
+{
+    huge_page_free(_graph);
+}
+
+std::tuple<uint32_t, uint32_t, size_t> InMemFlatGraphStore::load(const std::string &index_path_prefix,
+                                                                 const size_t num_points)
+{
+    return load_impl(index_path_prefix, num_points);
+}
+
+int InMemFlatGraphStore::store(const std::string &index_path_prefix, const size_t num_points,
+                               const size_t num_frozen_points, const uint32_t start)
+{
+    return save_graph(index_path_prefix, num_points, num_frozen_points, start);
+}
+
+std::vector<location_t> InMemFlatGraphStore::get_neighbours(const location_t i) const
+{
+    const uint32_t *r = row(i);
+    return std::vector<location_t>(r + 1, r + 1 + r[0]);
+}
+
+uint32_t InMemFlatGraphStore::get_neighbours(const location_t i, std::vector<location_t> &out) const
+{
+    const uint32_t *r = row(i);
+    out.assign(r + 1, r + 1 + r[0]);
+    return r[0];
+}
+
+NeighbourView InMemFlatGraphStore::get_neighbours_view(const location_t i, std::vector<location_t> &) const
+{
+    const uint32_t *r = row(i);
+    return NeighbourView{r + 1, r[0]};
+}
+
+uint32_t InMemFlatGraphStore::get_degree(const location_t i) const
+{
+    return row(i)[0];
+}
+
+void InMemFlatGraphStore::add_neighbour(const location_t i, location_t neighbour_id)
+{
+    uint32_t *r = row(i);
+    if (r[0] + 1 >= _stride)
+    {
+        std::stringstream stream;
+        stream << "Cannot add neighbour to point #" << i << ", degree " << r[0] << " is already at the capacity "
+               << _stride - 1 << " of the flat graph store." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    r[1 + r[0]] = neighbour_id;
+    r[0]++;
+
+    if (_max_observed_degree < r[0])
+    {
+        _max_observed_degree = r[0];
+    }
+}
+
+void InMemFlatGraphStore::clear_neighbours(const location_t i)
+{
+    row(i)[0] = 0;
+}
+
+void InMemFlatGraphStore::swap_neighbours(const location_t a, location_t b)
+{
+    std::swap_ranges(row(a), row(a) + _stride, row(b));
+}
+
+void InMemFlatGraphStore::set_neighbours(const location_t i, std::vector<location_t> &neighbours)
+{
+    if (neighbours.size() >= _stride)
+    {
+        std::stringstream stream;
+        stream << "Cannot set " << neighbours.size() << " neighbours for point #" << i
+               << ", the flat graph store holds at most " << _stride - 1 << " per point." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    uint32_t *r = row(i);
+    r[0] = (uint32_t)neighbours.size();
+    if (!neighbours.empty())
+    {
+        std::memcpy(r + 1, neighbours.data(), neighbours.size() * sizeof(location_t));
+    }
+
+    if (_max_observed_degree < neighbours.size())
+    {
+        _max_observed_degree = (uint32_t)(neighbours.size());
+    }
+}
+
+void InMemFlatGraphStore::reallocate(const size_t num_points, const size_t max_degree)
+{
+    const size_t new_stride =
+        ROUND_UP((max_degree + 1) * sizeof(uint32_t), FLAT_GRAPH_ROW_ALIGNMENT) / sizeof(uint32_t);
+
+    uint32_t *new_graph = nullptr;
+    if (num_points > 0)
+    {
+        huge_page_alloc((void **)&new_graph, num_points * new_stride * sizeof(uint32_t), FLAT_GRAPH_ROW_ALIGNMENT);
+    }
+
+    const size_t rows_to_copy = (std::min)(num_points, _num_rows);
+    const size_t words_to_copy = (std::min)(new_stride, _stride);
+    for (size_t i = 0; i < rows_to_copy; i++)
+    {
+        std::memcpy(new_graph + i * new_stride, _graph + i * _stride, words_to_copy * sizeof(uint32_t));
+    }
+
+    huge_page_free(_graph);
+    _graph = new_graph;
+    _num_rows = num_points;
+    _stride = new_stride;
+}
+
+size_t InMemFlatGraphStore::resize_graph(const size_t new_size)
+{
+    reallocate(new_size, _stride - 1);
+    set_total_points(new_size);
+    return _num_rows;
+}
+
+void InMemFlatGraphStore::clear_graph()
+{
+    if (_graph != nullptr)
+    {
+        std::memset(_graph, 0, _num_rows * _stride * sizeof(uint32_t));
+    }
+}
+
+std::tuple<uint32_t, uint32_t, size_t> InMemFlatGraphStore::load_impl(const std::string &filename,
+                                                                      size_t expected_num_points)
+{
+    size_t expected_file_size;
+    size_t file_frozen_pts;
+    uint32_t start;
+    size_t file_offset = 0; // will need this for single file format support
+
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(filename, std::ios::binary);
+    in.seekg(file_offset, in.beg);
+    in.read((char *)&expected_file_size, sizeof(size_t));
+    in.read((char *)&_max_observed_degree, sizeof(uint32_t));
+    in.read((char *)&start, sizeof(uint32_t));
+    in.read((char *)&file_frozen_pts, sizeof(size_t));
+    size_t vamana_metadata_size = sizeof(size_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(size_t);
+
+    diskann::cout << "From graph header, expected_file_size: " << expected_file_size
+                  << ", _max_observed_degree: " << _max_observed_degree << ", _start: " << start
+                  << ", file_frozen_pts: " << file_frozen_pts << std::endl;
+
+    diskann::cout << "Loading vamana graph " << filename << "..." << std::flush;
+
+    // If user provides more points than max_points, or the graph has a larger
+    // degree than was reserved, re-stride the array to fit.
+    if (get_total_points() < expected_num_points || _stride - 1 < _max_observed_degree)
+    {
+        size_t new_size = (std::max)(get_total_points(), expected_num_points);
+        diskann::cout << "resizing graph to " << new_size << " points with degree "
+                      << (std::max)(_stride - 1, (size_t)_max_observed_degree) << std::endl;
+        reallocate(new_size, (std::max)(_stride - 1, (size_t)_max_observed_degree));
+        set_total_points(new_size);
+    }
+
+    size_t bytes_read = vamana_metadata_size;
+    size_t cc = 0;
+    uint32_t nodes_read = 0;
+    while (bytes_read != expected_file_size)
+    {
+        uint32_t k;
+        in.read((char *)&k, sizeof(uint32_t));
+
+        if (k == 0)
+        {
+            diskann::cerr << "ERROR: Point found with no out-neighbours, point#" << nodes_read << std::endl;
+        }
+        if (k >= _stride)
+        {
+            std::stringstream stream;
+            stream << "Point #" << nodes_read << " has degree " << k << " larger than the header max degree "
+                   << _max_observed_degree << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+
+        uint32_t *r = row(nodes_read);
+        r[0] = k;
+        in.read((char *)(r + 1), k * sizeof(uint32_t));
+        cc += k;
+        ++nodes_read;
+        bytes_read += sizeof(uint32_t) * ((size_t)k + 1);
+        if (nodes_read % 10000000 == 0)
+            diskann::cout << "." << std::flush;
+        if (k > _max_range_of_graph)
+        {
+            _max_range_of_graph = k;
+        }
+    }
+
+    diskann::cout << "done. Index has " << nodes_read << " nodes and " << cc << " out-edges, _start is set to " << start
+                  << std::endl;
+    return std::make_tuple(nodes_read, start, file_frozen_pts);
+}
+
+int InMemFlatGraphStore::save_graph(const std::string &index_path_prefix, const size_t num_points,
+                                    const size_t num_frozen_points, const uint32_t start)
+{
+    std::ofstream out;
+    open_file_to_write(out, index_path_prefix);
+
+    size_t file_offset = 0;
+    out.seekp(file_offset, out.beg);
+    size_t index_size = 24;
+    uint32_t max_degree = 0;
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&_max_observed_degree, sizeof(uint32_t));
+    uint32_t ep_u32 = start;
+    out.write((char *)&ep_u32, sizeof(uint32_t));
+    out.write((char *)&num_frozen_points, sizeof(size_t));
+
+    // Note: num_points = _nd + _num_frozen_points
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        // each row already is <degree, ids...> as laid out on disk
+        const uint32_t *r = row(i);
+        uint32_t GK = r[0];
+        out.write((char *)r, (GK + 1) * sizeof(uint32_t));
+        max_degree = GK > max_degree ? GK : max_degree;
+        index_size += (size_t)(sizeof(uint32_t) * (GK + 1));
+    }
+    out.seekp(file_offset, out.beg);
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&max_degree, sizeof(uint32_t));
+    out.close();
+    return (int)index_size;
+}
+
+size_t InMemFlatGraphStore::get_max_range_of_graph()
+{
+    return _max_range_of_graph;
+}
+
+uint32_t InMemFlatGraphStore::get_max_observed_degree()
+{
+    return _max_observed_degree;
+}
+
+size_t InMemFlatGraphStore::get_memory_in_bytes()
+{
+    return _num_rows * _stride * sizeof(uint32_t);
+}
+
+} // namespace diskann
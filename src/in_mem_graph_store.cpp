@@ -44,6 +44,23 @@ std::vector<location_t> InMemGraphStore::get_neighbours(const location_t i) cons
     // return _graph.at(i);
 }
 
+uint32_t InMemGraphStore::get_neighbours(const location_t i, std::vector<location_t> &out) const
+{
+    const uint32_t degree = _degree_counts[i];
+    out.resize(degree);
+    if (degree > 0)
+    {
+        auto *in = const_cast<uint8_t *>(_graph2[i].data());
+        streamvbyte_decode(in, out.data(), degree);
+    }
+    return degree;
+}
+
+uint32_t InMemGraphStore::get_degree(const location_t i) const
+{
+    return _degree_counts[i];
+}
+
 void InMemGraphStore::add_neighbour(const location_t i, location_t neighbour_id)
 {
 
@@ -248,6 +265,7 @@ std::tuple<uint32_t, uint32_t, size_t> InMemGraphStore::load_impl(const std::str
         buf.resize(streamvbyte_max_compressedbytes(tmp.size()));
         size_t out_len = streamvbyte_encode(src, tmp.size(), buf.data());
         _graph2[nodes_read - 1].assign(buf.begin(), buf.begin() + out_len);
+        _degree_counts[nodes_read - 1] = k;
         bytes_read += sizeof(uint32_t) * ((size_t)k + 1);
         if (nodes_read % 10000000 == 0)
             diskann::cout << "." << std::flush;
@@ -279,13 +297,16 @@ int InMemGraphStore::save_graph(const std::string &index_path_prefix, const size
     out.write((char *)&num_frozen_points, sizeof(size_t));
 
     // Note: num_points = _nd + _num_frozen_points
+    // Lists are written decoded so that load_impl, and the other graph
+    // stores, can read the file back.
+    std::vector<location_t> neighbours;
     for (uint32_t i = 0; i < num_points; i++)
     {
-        uint32_t GK = (uint32_t)_graph2[i].size();
+        uint32_t GK = get_neighbours(i, neighbours);
         out.write((char *)&GK, sizeof(uint32_t));
-        out.write((char *)_graph2[i].data(), GK * sizeof(uint8_t));
-        max_degree = _degree_counts[i] > max_degree ? (uint32_t)_degree_counts[i] : max_degree;
-        index_size += (size_t)(sizeof(uint8_t) * GK + sizeof(uint32_t));
+        out.write((char *)neighbours.data(), GK * sizeof(uint32_t));
+        max_degree = GK > max_degree ? GK : max_degree;
+        index_size += (size_t)(sizeof(uint32_t) * (GK + 1));
     }
     out.seekp(file_offset, out.beg);
     out.write((char *)&index_size, sizeof(uint64_t));
@@ -304,4 +325,15 @@ uint32_t InMemGraphStore::get_max_observed_degree()
     return _max_observed_degree;
 }
 
+size_t InMemGraphStore::get_memory_in_bytes()
+{
+    size_t bytes = _graph2.capacity() * sizeof(std::vector<uint8_t>);
+    for (const auto &nbrs : _graph2)
+    {
+        bytes += nbrs.capacity();
+    }
+    bytes += _degree_counts.capacity() * sizeof(uint32_t);
+    return bytes;
+}
+
 } // namespace diskann
@@ -0,0 +1,703 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cmath>
+#include <limits>
+
+#include "huge_page_allocator.h"
+#include "in_mem_quantized_data_store.h"
+#include "utils.h"
+#ifdef USE_AVX2
+#include "simd_utils.h"
+#endif
+
+// points read per block when populating from a file
+#define QUANTIZED_STORE_READ_BLOCK 65536
+
+#ifdef USE_AVX2
+// every AVX2 CPU has F16C, but -mavx2 does not enable it
+#ifndef _WINDOWS
+#define DISKANN_TARGET_F16C __attribute__((target("f16c")))
+#else
+#define DISKANN_TARGET_F16C
+#endif
+#endif
+
+namespace
+{
+#ifndef USE_AVX2
+uint16_t float_to_half(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    const uint32_t float_exp = (x >> 23) & 0xff;
+    const int32_t exp = (int32_t)float_exp - 127 + 15;
+    uint32_t mant = x & 0x7fffff;
+
+    if (float_exp == 0xff)
+        return sign | 0x7c00 | (mant != 0 ? 0x200 : 0);
+    if (exp >= 31)
+        return sign | 0x7c00;
+    if (exp <= 0)
+    {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        const uint32_t shift = (uint32_t)(14 - exp);
+        uint32_t half = mant >> shift;
+        if ((mant >> (shift - 1)) & 1)
+            half++;
+        return sign | (uint16_t)half;
+    }
+    // a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = ((uint32_t)exp << 10) | (mant >> 13);
+    if (mant & 0x1000)
+        half++;
+    return sign | (uint16_t)half;
+}
+
+float half_to_float(uint16_t half)
+{
+    const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exp = (half >> 10) & 0x1f, mant = half & 0x3ff, x;
+    if (exp == 0)
+    {
+        if (mant == 0)
+        {
+            x = sign;
+        }
+        else
+        {
+            exp = 127 - 15 + 1;
+            while ((mant & 0x400) == 0)
+            {
+                mant <<= 1;
+                exp--;
+            }
+            x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+    }
+    else if (exp == 31)
+    {
+        x = sign | 0x7f800000 | (mant << 13);
+    }
+    else
+    {
+        x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    }
+    float value;
+    std::memcpy(&value, &x, sizeof(value));
+    return value;
+}
+#endif
+
+//
+// Asymmetric kernels, full-precision query against codes. All lengths are
+// multiples of 8. They return the squared L2 distance or the dot product.
+//
+#ifdef USE_AVX2
+inline __m256 load_int8_code(const uint8_t *code, const float *mins, const float *scales)
+{
+    const __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)code)));
+    return _mm256_fmadd_ps(c, _mm256_loadu_ps(scales), _mm256_loadu_ps(mins));
+}
+
+DISKANN_TARGET_F16C inline __m256 load_fp16_code(const uint8_t *code)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)code));
+}
+#endif
+
+float int8_l2(const float *query, const uint8_t *code, const float *mins, const float *scales, size_t length)
+{
+#ifdef USE_AVX2
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < length; i += 8)
+    {
+        const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(query + i), load_int8_code(code + i, mins + i, scales + i));
+        sum = _mm256_fmadd_ps(diff, diff, sum);
+    }
+    return diskann::_mm256_reduce_add_ps(sum);
+#else
+    float sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        const float diff = query[i] - (mins[i] + scales[i] * (float)code[i]);
+        sum += diff * diff;
+    }
+    return sum;
+#endif
+}
+
+float int8_dot(const float *query, const uint8_t *code, const float *mins, const float *scales, size_t length)
+{
+#ifdef USE_AVX2
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < length; i += 8)
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), load_int8_code(code + i, mins + i, scales + i), sum);
+    return diskann::_mm256_reduce_add_ps(sum);
+#else
+    float sum = 0;
+    for (size_t i = 0; i < length; i++)
+        sum += query[i] * (mins[i] + scales[i] * (float)code[i]);
+    return sum;
+#endif
+}
+
+#ifdef USE_AVX2
+DISKANN_TARGET_F16C
+#endif
+float fp16_l2(const float *query, const uint8_t *code, size_t length)
+{
+#ifdef USE_AVX2
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < length; i += 8)
+    {
+        const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(query + i), load_fp16_code(code + 2 * i));
+        sum = _mm256_fmadd_ps(diff, diff, sum);
+    }
+    return diskann::_mm256_reduce_add_ps(sum);
+#else
+    const uint16_t *halves = (const uint16_t *)code;
+    float sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        const float diff = query[i] - half_to_float(halves[i]);
+        sum += diff * diff;
+    }
+    return sum;
+#endif
+}
+
+#ifdef USE_AVX2
+DISKANN_TARGET_F16C
+#endif
+float fp16_dot(const float *query, const uint8_t *code, size_t length)
+{
+#ifdef USE_AVX2
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < length; i += 8)
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), load_fp16_code(code + 2 * i), sum);
+    return diskann::_mm256_reduce_add_ps(sum);
+#else
+    const uint16_t *halves = (const uint16_t *)code;
+    float sum = 0;
+    for (size_t i = 0; i < length; i++)
+        sum += query[i] * half_to_float(halves[i]);
+    return sum;
+#endif
+}
+
+#ifdef USE_AVX2
+DISKANN_TARGET_F16C
+#endif
+void fp16_encode(const float *vector, uint8_t *code, size_t length)
+{
+#ifdef USE_AVX2
+    for (size_t i = 0; i < length; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(code + 2 * i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(vector + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#else
+    uint16_t *halves = (uint16_t *)code;
+    for (size_t i = 0; i < length; i++)
+        halves[i] = float_to_half(vector[i]);
+#endif
+}
+
+#ifdef USE_AVX2
+DISKANN_TARGET_F16C
+#endif
+void fp16_decode(const uint8_t *code, float *vector, size_t length)
+{
+#ifdef USE_AVX2
+    for (size_t i = 0; i < length; i += 8)
+        _mm256_storeu_ps(vector + i, load_fp16_code(code + 2 * i));
+#else
+    const uint16_t *halves = (const uint16_t *)code;
+    for (size_t i = 0; i < length; i++)
+        vector[i] = half_to_float(halves[i]);
+#endif
+}
+} // namespace
+
+namespace diskann
+{
+
+InMemQuantizedDataStore::InMemQuantizedDataStore(const location_t capacity, const size_t dim,
+                                                 const ScalarQuantization quantization,
+                                                 std::unique_ptr<Distance<float>> distance_fn,
+                                                 const std::string &rerank_data_file)
+    : AbstractDataStore<float>(capacity, dim), _quantization(quantization), _distance_fn(std::move(distance_fn))
+{
+    _metric = _distance_fn->get_metric();
+    if (_metric != Metric::L2 && _metric != Metric::INNER_PRODUCT && _metric != Metric::COSINE)
+    {
+        throw ANNException("Quantized data store supports only L2, inner product and cosine metrics", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    _aligned_dim = ROUND_UP(dim, 8);
+    _code_len = _aligned_dim * (_quantization == ScalarQuantization::INT8 ? sizeof(uint8_t) : sizeof(uint16_t));
+    _mins.resize(_aligned_dim, 0);
+    _scales.resize(_aligned_dim, 0);
+
+    // the aligned allocator takes whole multiples of the alignment
+    huge_page_alloc((void **)&_codes, ROUND_UP(this->_capacity * _code_len, 64), 64);
+
+    if (!rerank_data_file.empty())
+        open_rerank_data(rerank_data_file);
+}
+
+InMemQuantizedDataStore::~InMemQuantizedDataStore()
+{
+    if (_codes != nullptr)
+        huge_page_free(_codes);
+}
+
+void InMemQuantizedDataStore::open_rerank_data(const std::string &rerank_data_file)
+{
+    if (!file_exists(rerank_data_file))
+    {
+        throw ANNException("Re-rank data file " + rerank_data_file + " does not exist", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+    size_t file_num_points, file_dim;
+    get_bin_metadata(rerank_data_file, file_num_points, file_dim);
+    if (file_dim != this->_dim)
+    {
+        std::stringstream stream;
+        stream << "Re-rank data file " << rerank_data_file << " has " << file_dim << " dimensions, expected "
+               << this->_dim << std::endl;
+        throw ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (get_file_size(rerank_data_file) < 2 * sizeof(uint32_t) + file_num_points * file_dim * sizeof(float))
+    {
+        throw ANNException("Re-rank data file " + rerank_data_file + " is truncated", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+
+    _rerank_mapper = std::make_unique<MemoryMapper>(rerank_data_file);
+    _rerank_data = (const float *)(_rerank_mapper->getBuf() + 2 * sizeof(uint32_t));
+    _rerank_num_points = file_num_points;
+    _rerank_distance_fn.reset(get_distance_function<float>(_metric));
+    diskann::cout << "Re-ranking against " << file_num_points << " full-precision vectors in " << rerank_data_file
+                  << std::endl;
+}
+
+size_t InMemQuantizedDataStore::get_aligned_dim() const
+{
+    return _aligned_dim;
+}
+
+size_t InMemQuantizedDataStore::get_alignment_factor() const
+{
+    return 8;
+}
+
+ScalarQuantization InMemQuantizedDataStore::get_quantization() const
+{
+    return _quantization;
+}
+
+Distance<float> *InMemQuantizedDataStore::get_dist_fn()
+{
+    return _distance_fn.get();
+}
+
+void InMemQuantizedDataStore::preprocess(const float *vector, float *target) const
+{
+    std::memcpy(target, vector, this->_dim * sizeof(float));
+    std::memset(target + this->_dim, 0, (_aligned_dim - this->_dim) * sizeof(float));
+    if (_distance_fn->preprocessing_required())
+        _distance_fn->preprocess_base_points(target, _aligned_dim, 1);
+}
+
+void InMemQuantizedDataStore::update_ranges(const float *vector, std::vector<float> &mins,
+                                            std::vector<float> &maxs) const
+{
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        mins[d] = std::min(mins[d], vector[d]);
+        maxs[d] = std::max(maxs[d], vector[d]);
+    }
+}
+
+void InMemQuantizedDataStore::set_ranges(const std::vector<float> &mins, const std::vector<float> &maxs)
+{
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        if (mins[d] > maxs[d])
+        {
+            // no points seen
+            _mins[d] = 0;
+            _scales[d] = 0;
+        }
+        else
+        {
+            _mins[d] = mins[d];
+            _scales[d] = (maxs[d] - mins[d]) / 255.0f;
+        }
+    }
+    _trained = true;
+}
+
+void InMemQuantizedDataStore::encode(const float *vector, uint8_t *code) const
+{
+    if (_quantization == ScalarQuantization::FP16)
+    {
+        fp16_encode(vector, code, _aligned_dim);
+        return;
+    }
+    for (size_t d = 0; d < _aligned_dim; d++)
+    {
+        if (_scales[d] == 0)
+        {
+            code[d] = 0;
+            continue;
+        }
+        const float level = std::round((vector[d] - _mins[d]) / _scales[d]);
+        code[d] = (uint8_t)std::min(255.0f, std::max(0.0f, level));
+    }
+}
+
+void InMemQuantizedDataStore::decode(const uint8_t *code, float *target) const
+{
+    if (_quantization == ScalarQuantization::FP16)
+    {
+        fp16_decode(code, target, _aligned_dim);
+        return;
+    }
+    for (size_t d = 0; d < _aligned_dim; d++)
+        target[d] = _mins[d] + _scales[d] * (float)code[d];
+}
+
+float InMemQuantizedDataStore::compare(const float *query, const uint8_t *code) const
+{
+    const bool int8 = _quantization == ScalarQuantization::INT8;
+    if (_metric == Metric::L2)
+    {
+        return int8 ? int8_l2(query, code, _mins.data(), _scales.data(), _aligned_dim)
+                    : fp16_l2(query, code, _aligned_dim);
+    }
+
+    const float dot = int8 ? int8_dot(query, code, _mins.data(), _scales.data(), _aligned_dim)
+                           : fp16_dot(query, code, _aligned_dim);
+    // cosine works on normalized vectors, as AVXNormalizedCosineDistanceFloat
+    return _metric == Metric::COSINE ? 1.0f - dot : -dot;
+}
+
+location_t InMemQuantizedDataStore::populate_from_file(const std::string &filename, const size_t offset)
+{
+    if (!file_exists(filename))
+    {
+        std::stringstream stream;
+        stream << "ERROR: data file " << filename << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    size_t file_num_points, file_dim;
+    std::ifstream reader(filename, std::ios::binary);
+    get_bin_metadata_impl(reader, file_num_points, file_dim, offset);
+    if (file_dim != this->_dim)
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
+               << "but file has " << file_dim << " dimension." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (file_num_points > this->capacity())
+        this->resize((location_t)file_num_points);
+
+    const size_t block_size = std::min((size_t)QUANTIZED_STORE_READ_BLOCK, std::max(file_num_points, (size_t)1));
+    std::vector<float> block(block_size * this->_dim);
+    std::vector<float> vector(_aligned_dim);
+    const size_t data_start = offset + 2 * sizeof(uint32_t);
+
+    // the INT8 ranges need a first pass over all of the points
+    if (_quantization == ScalarQuantization::INT8)
+    {
+        std::vector<float> mins(this->_dim, std::numeric_limits<float>::max());
+        std::vector<float> maxs(this->_dim, std::numeric_limits<float>::lowest());
+        reader.seekg(data_start, reader.beg);
+        for (size_t start = 0; start < file_num_points; start += block_size)
+        {
+            const size_t count = std::min(block_size, file_num_points - start);
+            reader.read((char *)block.data(), count * this->_dim * sizeof(float));
+            for (size_t i = 0; i < count; i++)
+            {
+                preprocess(block.data() + i * this->_dim, vector.data());
+                update_ranges(vector.data(), mins, maxs);
+            }
+        }
+        set_ranges(mins, maxs);
+    }
+
+    reader.seekg(data_start, reader.beg);
+    for (size_t start = 0; start < file_num_points; start += block_size)
+    {
+        const size_t count = std::min(block_size, file_num_points - start);
+        reader.read((char *)block.data(), count * this->_dim * sizeof(float));
+        for (size_t i = 0; i < count; i++)
+        {
+            preprocess(block.data() + i * this->_dim, vector.data());
+            encode(vector.data(), _codes + (start + i) * _code_len);
+        }
+    }
+    return (location_t)file_num_points;
+}
+
+location_t InMemQuantizedDataStore::load(const std::string &filename)
+{
+    return populate_from_file(filename, 0);
+}
+
+void InMemQuantizedDataStore::populate_data(const std::string &filename, const size_t offset)
+{
+    populate_from_file(filename, offset);
+}
+
+void InMemQuantizedDataStore::populate_data(const float *vectors, const location_t num_pts)
+{
+    if (num_pts > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Number of points " << num_pts << " is greater than the capacity of data store: " << this->capacity()
+           << ". Must invoke resize before calling populate_data()" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+
+    std::vector<float> vector(_aligned_dim);
+    if (_quantization == ScalarQuantization::INT8)
+    {
+        std::vector<float> mins(this->_dim, std::numeric_limits<float>::max());
+        std::vector<float> maxs(this->_dim, std::numeric_limits<float>::lowest());
+        for (location_t i = 0; i < num_pts; i++)
+        {
+            preprocess(vectors + i * this->_dim, vector.data());
+            update_ranges(vector.data(), mins, maxs);
+        }
+        set_ranges(mins, maxs);
+    }
+
+    for (location_t i = 0; i < num_pts; i++)
+    {
+        preprocess(vectors + i * this->_dim, vector.data());
+        encode(vector.data(), _codes + i * _code_len);
+    }
+}
+
+size_t InMemQuantizedDataStore::save(const std::string &filename, const location_t num_points)
+{
+    std::ofstream writer;
+    open_file_to_write(writer, filename);
+    const int npts_i32 = (int)num_points, ndims_i32 = (int)this->_dim;
+    writer.write((char *)&npts_i32, sizeof(int));
+    writer.write((char *)&ndims_i32, sizeof(int));
+
+    std::vector<float> vector(_aligned_dim);
+    for (location_t i = 0; i < num_points; i++)
+    {
+        decode(_codes + i * _code_len, vector.data());
+        writer.write((char *)vector.data(), this->_dim * sizeof(float));
+    }
+    writer.close();
+    return 2 * sizeof(uint32_t) + (size_t)num_points * this->_dim * sizeof(float);
+}
+
+void InMemQuantizedDataStore::extract_data_to_bin(const std::string &filename, const location_t num_pts)
+{
+    save(filename, num_pts);
+}
+
+void InMemQuantizedDataStore::get_vector(const location_t i, float *target) const
+{
+    std::vector<float> vector(_aligned_dim);
+    decode(_codes + i * _code_len, vector.data());
+    std::memcpy(target, vector.data(), this->_dim * sizeof(float));
+}
+
+void InMemQuantizedDataStore::set_vector(const location_t loc, const float *const vector)
+{
+    if (_quantization == ScalarQuantization::INT8 && !_trained)
+    {
+        throw ANNException("INT8 quantized data store must be populated or loaded before vectors are set", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+    }
+    std::vector<float> preprocessed(_aligned_dim);
+    preprocess(vector, preprocessed.data());
+    encode(preprocessed.data(), _codes + loc * _code_len);
+}
+
+bool InMemQuantizedDataStore::is_trained() const
+{
+    return _quantization != ScalarQuantization::INT8 || _trained;
+}
+
+void InMemQuantizedDataStore::prefetch_vector(const location_t loc)
+{
+    diskann::prefetch_vector((const char *)_codes + _code_len * (size_t)loc, _code_len);
+}
+
+float InMemQuantizedDataStore::get_distance(const float *query, const location_t loc) const
+{
+    return compare(query, _codes + _code_len * loc);
+}
+
+void InMemQuantizedDataStore::get_distance(const float *query, const location_t *locations,
+                                           const uint32_t location_count, float *distances) const
+{
+    for (uint32_t i = 0; i < location_count; i++)
+    {
+        if (i + 1 < location_count)
+            diskann::prefetch_vector((const char *)_codes + _code_len * (size_t)locations[i + 1], _code_len);
+        distances[i] = compare(query, _codes + _code_len * locations[i]);
+    }
+}
+
+float InMemQuantizedDataStore::get_distance(const location_t loc1, const location_t loc2) const
+{
+    static thread_local std::vector<float> vector;
+    vector.resize(_aligned_dim);
+    decode(_codes + _code_len * loc1, vector.data());
+    return compare(vector.data(), _codes + _code_len * loc2);
+}
+
+bool InMemQuantizedDataStore::get_full_precision_distance(const float *query, const location_t *locations,
+                                                          const uint32_t location_count, float *distances,
+                                                          float *vector_scratch) const
+{
+    if (_rerank_data == nullptr)
+        return false;
+
+    // the rows of the file are not aligned, and the AVX2 distances need them
+    // to be. only the first _dim entries of vector_scratch are written, its
+    // padding stays zero.
+    for (uint32_t i = 0; i < location_count; i++)
+    {
+        // points added after the file was written
+        if (locations[i] >= _rerank_num_points)
+        {
+            distances[i] = (std::numeric_limits<float>::max)();
+            continue;
+        }
+        std::memcpy(vector_scratch, _rerank_data + (size_t)locations[i] * this->_dim, this->_dim * sizeof(float));
+        distances[i] = _rerank_distance_fn->compare(query, vector_scratch, (uint32_t)_aligned_dim);
+    }
+    return true;
+}
+
+location_t InMemQuantizedDataStore::expand(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size < this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'expand' datastore when new capacity (" << new_size << ") < existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    uint8_t *new_codes;
+    huge_page_alloc((void **)&new_codes, ROUND_UP(new_size * _code_len, 64), 64);
+    memcpy(new_codes, _codes, this->capacity() * _code_len);
+    huge_page_free(_codes);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+location_t InMemQuantizedDataStore::shrink(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'shrink' datastore when new capacity (" << new_size << ") > existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    uint8_t *new_codes;
+    huge_page_alloc((void **)&new_codes, ROUND_UP(new_size * _code_len, 64), 64);
+    memcpy(new_codes, _codes, new_size * _code_len);
+    huge_page_free(_codes);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+void InMemQuantizedDataStore::move_vectors(const location_t old_location_start, const location_t new_location_start,
+                                           const location_t num_locations)
+{
+    if (num_locations == 0 || old_location_start == new_location_start)
+    {
+        return;
+    }
+
+    // The [start, end) interval which will contain obsolete points to be
+    // cleared, excluding any overlap with the new range.
+    uint32_t mem_clear_loc_start = old_location_start;
+    uint32_t mem_clear_loc_end_limit = old_location_start + num_locations;
+    if (new_location_start < old_location_start)
+    {
+        if (mem_clear_loc_start < new_location_start + num_locations)
+            mem_clear_loc_start = new_location_start + num_locations;
+    }
+    else
+    {
+        if (mem_clear_loc_end_limit > new_location_start)
+            mem_clear_loc_end_limit = new_location_start;
+    }
+
+    copy_vectors(old_location_start, new_location_start, num_locations);
+    memset(_codes + _code_len * mem_clear_loc_start, 0, _code_len * (mem_clear_loc_end_limit - mem_clear_loc_start));
+}
+
+void InMemQuantizedDataStore::copy_vectors(const location_t from_loc, const location_t to_loc,
+                                           const location_t num_points)
+{
+    assert(from_loc < this->_capacity);
+    assert(to_loc < this->_capacity);
+    assert(num_points < this->_capacity);
+    memmove(_codes + _code_len * to_loc, _codes + _code_len * from_loc, num_points * _code_len);
+}
+
+location_t InMemQuantizedDataStore::calculate_medoid() const
+{
+    std::vector<float> center(_aligned_dim, 0), vector(_aligned_dim);
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        decode(_codes + i * _code_len, vector.data());
+        for (size_t j = 0; j < _aligned_dim; j++)
+            center[j] += vector[j];
+    }
+    for (size_t j = 0; j < _aligned_dim; j++)
+        center[j] /= (float)this->capacity();
+
+    location_t min_idx = 0;
+    float min_dist = std::numeric_limits<float>::max();
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        decode(_codes + i * _code_len, vector.data());
+        float dist = 0;
+        for (size_t j = 0; j < _aligned_dim; j++)
+            dist += (center[j] - vector[j]) * (center[j] - vector[j]);
+        if (dist < min_dist)
+        {
+            min_idx = i;
+            min_dist = dist;
+        }
+    }
+    return min_idx;
+}
+
+} // namespace diskann
@@ -8,6 +8,8 @@
 #include "boost/dynamic_bitset.hpp"
 #include "index_factory.h"
 #include "memory_mapper.h"
+#include "packed_data_store.h"
+#include "packed_graph_store.h"
 #include "timer.h"
 #include "tsl/robin_map.h"
 #include "tsl/robin_set.h"
@@ -21,7 +23,6 @@
 #endif
 #include "index.h"
 
-#define MAX_POINTS_FOR_USING_BITSET 10000000
 
 namespace diskann
 {
@@ -33,9 +34,9 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
     : _dist_metric(index_config.metric), _dim(index_config.dimension), _max_points(index_config.max_points),
       _num_frozen_pts(index_config.num_frozen_pts), _dynamic_index(index_config.dynamic_index),
       _enable_tags(index_config.enable_tags), _indexingMaxC(DEFAULT_MAXC), _query_scratch(nullptr),
-      _pq_dist(index_config.pq_dist_build), _use_opq(index_config.use_opq),
-      _filtered_index(index_config.filtered_index), _num_pq_chunks(index_config.num_pq_chunks),
-      _delete_set(new tsl::robin_set<uint32_t>), _conc_consolidate(index_config.concurrent_consolidate)
+      _pq_dist(index_config.pq_dist_build || index_config.data_strategy == DataStoreStrategy::PQ),
+      _filtered_index(index_config.filtered_index), _delete_set(new tsl::robin_set<uint32_t>),
+      _conc_consolidate(index_config.concurrent_consolidate)
 {
     if (_dynamic_index && !_enable_tags)
     {
@@ -44,10 +45,6 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
 
     if (_pq_dist)
     {
-        if (_dynamic_index)
-            throw ANNException("ERROR: Dynamic Indexing not supported with PQ distance based "
-                               "index construction",
-                               -1, __FUNCSIG__, __FILE__, __LINE__);
         if (_dist_metric == diskann::Metric::INNER_PRODUCT)
             throw ANNException("ERROR: Inner product metrics not yet supported "
                                "with PQ distance "
@@ -71,18 +68,17 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
         _max_points = 1;
     }
     const size_t total_internal_points = _max_points + _num_frozen_pts;
-    if (_pq_dist)
+    if (index_config.pq_dist_build)
     {
-        if (_num_pq_chunks > _dim)
-            throw diskann::ANNException("ERROR: num_pq_chunks > dim", -1, __FUNCSIG__, __FILE__, __LINE__);
-        alloc_aligned(((void **)&_pq_data), total_internal_points * _num_pq_chunks * sizeof(char), 8 * sizeof(char));
-        std::memset(_pq_data, 0, total_internal_points * _num_pq_chunks * sizeof(char));
+        _pq_data_store = IndexFactory::construct_pq_datastore<T>(total_internal_points, _dim, _dist_metric,
+                                                                 index_config.num_pq_chunks, index_config.use_opq);
     }
 
     _start = (uint32_t)_max_points;
 
     _data_store = std::move(data_store);
     _graph_store = std::move(graph_store);
+    _packed_layout = index_config.graph_strategy == GraphStoreStrategy::PACKED;
 
     _locks = std::vector<non_recursive_mutex>(total_internal_points);
     if (_enable_tags)
@@ -166,11 +162,6 @@ template <typename T, typename TagT, typename LabelT> Index<T, TagT, LabelT>::~I
         LockGuard lg(lock);
     }
 
-    if (_opt_graph != nullptr)
-    {
-        delete[] _opt_graph;
-    }
-
     if (!_query_scratch.empty())
     {
         ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
@@ -188,6 +179,7 @@ void Index<T, TagT, LabelT>::initialize_query_scratch(uint32_t num_threads, uint
                                                 _data_store->get_alignment_factor(), _pq_dist);
         _query_scratch.push(scratch);
     }
+    _num_query_scratch += num_threads;
 }
 
 template <typename T, typename TagT, typename LabelT> size_t Index<T, TagT, LabelT>::save_tags(std::string tags_file)
@@ -234,6 +226,10 @@ template <typename T, typename TagT, typename LabelT> size_t Index<T, TagT, Labe
     // Note: at this point, either _nd == _max_points or any frozen points have
     // been temporarily moved to _nd, so _nd + _num_frozen_pts is the valid
     // location limit.
+    // The PQ codes are recomputed from the saved data on load, only their
+    // pivots are kept.
+    if (_pq_data_store != nullptr)
+        _pq_data_store->save_pivots(data_file + "_pq_pivots.bin");
     return _data_store->save(data_file, (location_t)(_nd + _num_frozen_pts));
 }
 
@@ -376,6 +372,15 @@ void Index<T, TagT, LabelT>::save(const char *filename, bool compact_before_save
         save_tags(tags_file);
         delete_file(delete_list_file);
         save_delete_list(delete_list_file);
+
+        // the regular files above keep the index loadable with any store,
+        // the packed file lets a packed index skip the repacking on load
+        if (_packed_nodes != nullptr)
+        {
+            std::string packed_file = std::string(filename) + ".packed";
+            delete_file(packed_file);
+            _packed_nodes->save(packed_file, _nd + _num_frozen_pts, _num_frozen_pts, _start);
+        }
     }
     else
     {
@@ -493,6 +498,8 @@ size_t Index<T, TagT, LabelT>::load_data(std::string filename)
     copy_aligned_data_from_file<T>(reader, _data, file_num_points, file_dim, _data_store->get_aligned_dim());
 #else
     _data_store->load(filename); // offset == 0.
+    if (_pq_data_store != nullptr)
+        _pq_data_store->load(filename);
 #endif
     return file_num_points;
 }
@@ -555,7 +562,9 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
         std::string tags_file = std::string(filename) + ".tags";
         std::string delete_set_file = std::string(filename) + ".del";
         std::string graph_file = std::string(filename);
-        data_file_num_pts = load_data(data_file);
+        std::string packed_file = std::string(filename) + ".packed";
+        const bool from_packed_file = _packed_layout && file_exists(packed_file);
+        data_file_num_pts = from_packed_file ? load_packed(packed_file) : load_data(data_file);
         if (file_exists(delete_set_file))
         {
             load_delete_set(delete_set_file);
@@ -564,7 +573,7 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
         {
             tags_file_num_pts = load_tags(tags_file);
         }
-        graph_num_pts = load_graph(graph_file, data_file_num_pts);
+        graph_num_pts = from_packed_file ? data_file_num_pts : load_graph(graph_file, data_file_num_pts);
 #endif
     }
     else
@@ -640,6 +649,14 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
     }
 
     reposition_frozen_point_to_end();
+    if (!_dynamic_index)
+    {
+        _graph_store->release_build_memory();
+    }
+    if (_packed_layout)
+    {
+        pack_layout();
+    }
     diskann::cout << "Num frozen points:" << _num_frozen_pts << " _nd: " << _nd << " _start: " << _start
                   << " size(_location_to_tag): " << _location_to_tag.size()
                   << " size(_tag_to_location):" << _tag_to_location.size() << " Max points: " << _max_points
@@ -677,6 +694,39 @@ size_t Index<T, TagT, LabelT>::get_graph_num_frozen_points(const std::string &gr
 }
 #endif
 
+#ifndef EXEC_ENV_OLS
+template <typename T, typename TagT, typename LabelT>
+size_t Index<T, TagT, LabelT>::load_packed(const std::string &filename)
+{
+    const PackedLayoutHeader header = PackedNodeStore::read_header(filename);
+    if (header.dim != _dim || header.element_size != sizeof(T))
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << _dim << " dimensions of " << sizeof(T) << " bytes, "
+               << "but packed file has " << header.dim << " dimensions of " << header.element_size << " bytes."
+               << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    // The rows are allocated at their final size right away, in place of the
+    // resize that load_data would do.
+    _empty_slots.clear();
+    _num_frozen_pts = header.num_frozen_points;
+    if (header.num_points > _max_points + _num_frozen_pts)
+    {
+        _max_points = header.num_points - _num_frozen_pts;
+    }
+    if (_locks.size() != _max_points + _num_frozen_pts)
+    {
+        _locks = std::vector<non_recursive_mutex>(_max_points + _num_frozen_pts);
+    }
+    _start = (uint32_t)header.start;
+    use_packed_nodes(PackedNodeStore::load(filename, _max_points + _num_frozen_pts));
+    return header.num_points;
+}
+#endif
+
 #ifdef EXEC_ENV_OLS
 template <typename T, typename TagT, typename LabelT>
 size_t Index<T, TagT, LabelT>::load_graph(AlignedFileReader &reader, size_t expected_num_points)
@@ -729,13 +779,6 @@ template <typename T, typename TagT, typename LabelT> int Index<T, TagT, LabelT>
 
 template <typename T, typename TagT, typename LabelT> uint32_t Index<T, TagT, LabelT>::calculate_entry_point()
 {
-    //  TODO: need to compute medoid with PQ data too, for now sample at random
-    if (_pq_dist)
-    {
-        size_t r = (size_t)rand() * (size_t)RAND_MAX + (size_t)rand();
-        return (uint32_t)(r % (size_t)_nd);
-    }
-
     // TODO: This function does not support multi-threaded calculation of medoid.
     // Must revisit if perf is a concern.
     return _data_store->calculate_medoid();
@@ -765,107 +808,125 @@ template <typename T, typename TagT, typename LabelT>
 bool Index<T, TagT, LabelT>::detect_common_filters(uint32_t point_id, bool search_invocation,
                                                    const std::vector<LabelT> &incoming_labels)
 {
-    auto &curr_node_labels = _location_to_labels[point_id];
-    std::vector<LabelT> common_filters;
-    std::set_intersection(incoming_labels.begin(), incoming_labels.end(), curr_node_labels.begin(),
-                          curr_node_labels.end(), std::back_inserter(common_filters));
-    if (common_filters.size() > 0)
-    {
-        // This is to reduce the repetitive calls. If common_filters size is > 0 ,
-        // we dont need to check further for universal label
-        return true;
-    }
-    if (_use_universal_label)
+    if (!_label_index.empty())
     {
-        if (!search_invocation)
+        // a point with one label is tested against its label, else against
+        // the bitmap of each incoming label
+        for (const auto &label : incoming_labels)
         {
-            if (std::find(incoming_labels.begin(), incoming_labels.end(), _universal_label) != incoming_labels.end() ||
-                std::find(curr_node_labels.begin(), curr_node_labels.end(), _universal_label) != curr_node_labels.end())
-                common_filters.push_back(_universal_label);
+            if (_label_index.has_label(point_id, label))
+                return true;
         }
+        if (!_use_universal_label)
+            return false;
+        if (!search_invocation &&
+            std::find(incoming_labels.begin(), incoming_labels.end(), _universal_label) != incoming_labels.end())
+            return true;
+        return _label_index.has_label(point_id, _universal_label);
+    }
+
+    // both label lists are sorted, look for a common label without
+    // collecting them
+    auto &curr_node_labels = _location_to_labels[point_id];
+    auto incoming = incoming_labels.begin();
+    auto curr = curr_node_labels.begin();
+    while (incoming != incoming_labels.end() && curr != curr_node_labels.end())
+    {
+        if (*incoming < *curr)
+            ++incoming;
+        else if (*curr < *incoming)
+            ++curr;
         else
-        {
-            if (std::find(curr_node_labels.begin(), curr_node_labels.end(), _universal_label) != curr_node_labels.end())
-                common_filters.push_back(_universal_label);
-        }
+            return true;
     }
-    return (common_filters.size() > 0);
+    if (_use_universal_label)
+    {
+        if (!search_invocation &&
+            std::find(incoming_labels.begin(), incoming_labels.end(), _universal_label) != incoming_labels.end())
+            return true;
+        return std::find(curr_node_labels.begin(), curr_node_labels.end(), _universal_label) !=
+               curr_node_labels.end();
+    }
+    return false;
+}
+
+template <typename T, typename TagT, typename LabelT>
+bool Index<T, TagT, LabelT>::matches_filter(uint32_t location, const FilterExpression<LabelT> &filter)
+{
+    if (!_label_index.empty())
+    {
+        auto has_label = [this, location](const LabelT &label) { return _label_index.has_label(location, label); };
+        return filter.matches(has_label, _use_universal_label && has_label(_universal_label));
+    }
+
+    auto &labels = _location_to_labels[location];
+    auto has_label = [&labels](const LabelT &label) {
+        return std::find(labels.begin(), labels.end(), label) != labels.end();
+    };
+    return filter.matches(has_label, _use_universal_label && has_label(_universal_label));
 }
 
 template <typename T, typename TagT, typename LabelT>
 std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     const T *query, const uint32_t Lsize, const std::vector<uint32_t> &init_ids, InMemQueryScratch<T> *scratch,
-    bool use_filter, const std::vector<LabelT> &filter_labels, bool search_invocation)
+    bool use_filter, const std::vector<LabelT> &filter_labels, bool search_invocation, std::vector<Neighbor> *dropped,
+    const FilterExpression<LabelT> *filter_expression)
 {
     std::vector<Neighbor> &expanded_nodes = scratch->pool();
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
     best_L_nodes.reserve(Lsize);
-    tsl::robin_set<uint32_t> &inserted_into_pool_rs = scratch->inserted_into_pool_rs();
-    boost::dynamic_bitset<> &inserted_into_pool_bs = scratch->inserted_into_pool_bs();
+    VisitedSet &inserted_into_pool = scratch->inserted_into_pool();
     std::vector<uint32_t> &id_scratch = scratch->id_scratch();
     std::vector<float> &dist_scratch = scratch->dist_scratch();
+    std::vector<uint32_t> &neighbours = scratch->neighbour_scratch();
     assert(id_scratch.size() == 0);
 
     T *aligned_query = scratch->aligned_query();
 
-    float *query_float = nullptr;
-    float *query_rotated = nullptr;
-    float *pq_dists = nullptr;
-    uint8_t *pq_coord_scratch = nullptr;
-    // Intialize PQ related scratch to use PQ based distances
-    if (_pq_dist)
-    {
-        // Get scratch spaces
-        PQScratch<T> *pq_query_scratch = scratch->pq_scratch();
-        query_float = pq_query_scratch->aligned_query_float;
-        query_rotated = pq_query_scratch->rotated_query;
-        pq_dists = pq_query_scratch->aligned_pqtable_dist_scratch;
-
-        // Copy query vector to float and then to "rotated" query
-        for (size_t d = 0; d < _dim; d++)
-        {
-            query_float[d] = (float)aligned_query[d];
-        }
-        pq_query_scratch->set(_dim, aligned_query);
-
-        // center the query and rotate if we have a rotation matrix
-        _pq_table.preprocess_query(query_rotated);
-        _pq_table.populate_chunk_distances(query_rotated, pq_dists);
-
-        pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
-    }
+    // Distances come from the PQ codes if there are separate ones, else from
+    // the data store, which may itself be a PQDataStore. Per-query state such
+    // as the PQ distance tables is prepared once, in the PQ scratch.
+    AbstractDataStore<T> *search_store = _pq_data_store != nullptr ? _pq_data_store.get() : _data_store.get();
+    PQScratch<T> *pq_query_scratch = scratch->pq_scratch();
+    search_store->preprocess_query(aligned_query, pq_query_scratch);
 
     if (expanded_nodes.size() > 0 || id_scratch.size() > 0)
     {
         throw ANNException("ERROR: Clear scratch space before passing.", -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    // Decide whether to use bitset or robin set to mark visited nodes
-    auto total_num_points = _max_points + _num_frozen_pts;
-    bool fast_iterate = total_num_points <= MAX_POINTS_FOR_USING_BITSET;
-
-    if (fast_iterate)
+    // Set up the visited set for the current size of the index, with the
+    // budget shared by all query scratches
+    const uint64_t total_num_points = _max_points + _num_frozen_pts;
+    if (!inserted_into_pool.covers(total_num_points))
     {
-        if (inserted_into_pool_bs.size() < total_num_points)
-        {
-            // hopefully using 2X will reduce the number of allocations.
-            auto resize_size =
-                2 * total_num_points > MAX_POINTS_FOR_USING_BITSET ? MAX_POINTS_FOR_USING_BITSET : 2 * total_num_points;
-            inserted_into_pool_bs.resize(resize_size);
-        }
+        inserted_into_pool.init(
+            VisitedSet::choose(total_num_points, _num_query_scratch, defaults::MAX_VISITED_SET_BYTES),
+            total_num_points, 20 * (uint64_t)Lsize);
     }
 
-    // Lambda to determine if a node has been visited
-    auto is_not_visited = [this, fast_iterate, &inserted_into_pool_bs, &inserted_into_pool_rs](const uint32_t id) {
-        return fast_iterate ? inserted_into_pool_bs[id] == 0
-                            : inserted_into_pool_rs.find(id) == inserted_into_pool_rs.end();
+    auto insert_candidate = [&best_L_nodes, dropped](const Neighbor &nbr) {
+        if (dropped != nullptr)
+            best_L_nodes.insert(nbr, *dropped);
+        else
+            best_L_nodes.insert(nbr);
     };
 
-    // Lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const std::vector<uint32_t> &ids,
-                                                            std::vector<float> &dists_out) {
-        diskann::aggregate_coords(ids, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
-        diskann::pq_dist_lookup(pq_coord_scratch, ids.size(), this->_num_pq_chunks, pq_dists, dists_out);
+    // a filter expression is tested with the bitmaps of its labels, looked up
+    // once, if the index has them
+    std::unique_ptr<typename FilterExpression<LabelT>::Matcher> expression_matcher;
+    if (use_filter && filter_expression != nullptr && !_label_index.empty())
+    {
+        expression_matcher.reset(new typename FilterExpression<LabelT>::Matcher(*filter_expression, _label_index,
+                                                                                  _use_universal_label,
+                                                                                  _universal_label));
+    }
+    auto passes_filter = [&](const uint32_t id) {
+        if (filter_expression == nullptr)
+            return detect_common_filters(id, search_invocation, filter_labels);
+        if (expression_matcher != nullptr)
+            return expression_matcher->matches(id);
+        return matches_filter(id, *filter_expression);
     };
 
     // Initialize the candidate pool with starting points
@@ -878,37 +939,27 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
                                         __LINE__);
         }
 
-        if (use_filter)
+        if (use_filter && filter_expression == nullptr)
         {
             if (!detect_common_filters(id, search_invocation, filter_labels))
                 continue;
         }
 
-        if (is_not_visited(id))
+        if (inserted_into_pool.insert(id))
         {
-            if (fast_iterate)
-            {
-                inserted_into_pool_bs[id] = 1;
-            }
-            else
-            {
-                inserted_into_pool_rs.insert(id);
-            }
-
-            float distance;
-            if (_pq_dist)
-            {
-                pq_dist_lookup(pq_coord_scratch, 1, this->_num_pq_chunks, pq_dists, &distance);
-            }
-            else
-            {
-                distance = _data_store->get_distance(aligned_query, id);
-            }
-            Neighbor nn = Neighbor(id, distance);
-            best_L_nodes.insert(nn);
+            id_scratch.push_back(id);
         }
     }
 
+    // Compute distances to the starting points in one batch
+    dist_scratch.resize(id_scratch.size());
+    search_store->get_distance(aligned_query, id_scratch.data(), (uint32_t)id_scratch.size(), dist_scratch.data(),
+                               pq_query_scratch);
+    for (size_t m = 0; m < id_scratch.size(); ++m)
+    {
+        insert_candidate(Neighbor(id_scratch[m], dist_scratch[m]));
+    }
+
     uint32_t hops = 0;
     uint32_t cmps = 0;
 
@@ -935,13 +986,14 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
             }
         }
 
-        // Find which of the nodes in des have not been visited before
+        // Find which of the nodes in des have not been visited before, and
+        // mark them visited
         id_scratch.clear();
         dist_scratch.clear();
         {
             if (_dynamic_index)
                 _locks[n].lock();
-            for (auto id : _graph_store->get_neighbours(n))
+            for (auto id : _graph_store->get_neighbours_view(n, neighbours))
             {
                 if(id >= _max_points + _num_frozen_pts)
                     diskann::cout << n << " " << id << " " << _max_points << " " << _num_frozen_pts << std::endl;
@@ -950,11 +1002,11 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
                 if (use_filter)
                 {
                     // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
-                    if (!detect_common_filters(id, search_invocation, filter_labels))
+                    if (!passes_filter(id))
                         continue;
                 }
 
-                if (is_not_visited(id))
+                if (inserted_into_pool.insert(id))
                 {
                     id_scratch.push_back(id);
                 }
@@ -963,52 +1015,63 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
                 _locks[n].unlock();
         }
 
-        // Mark nodes visited
-        for (auto id : id_scratch)
-        {
-            if (fast_iterate)
-            {
-                inserted_into_pool_bs[id] = 1;
-            }
-            else
-            {
-                inserted_into_pool_rs.insert(id);
-            }
-        }
-
         // Compute distances to unvisited nodes in the expansion
-        if (_pq_dist)
-        {
-            assert(dist_scratch.capacity() >= id_scratch.size());
-            compute_dists(id_scratch, dist_scratch);
-        }
-        else
-        {
-            assert(dist_scratch.size() == 0);
-            for (size_t m = 0; m < id_scratch.size(); ++m)
-            {
-                uint32_t id = id_scratch[m];
-
-                if (m + 1 < id_scratch.size())
-                {
-                    auto nextn = id_scratch[m + 1];
-                    _data_store->prefetch_vector(nextn);
-                }
-
-                dist_scratch.push_back(_data_store->get_distance(aligned_query, id));
-            }
-        }
+        assert(dist_scratch.size() == 0);
+        dist_scratch.resize(id_scratch.size());
+        search_store->get_distance(aligned_query, id_scratch.data(), (uint32_t)id_scratch.size(), dist_scratch.data(),
+                                   pq_query_scratch);
         cmps += (uint32_t)id_scratch.size();
 
         // Insert <id, dist> pairs into the pool of candidates
         for (size_t m = 0; m < id_scratch.size(); ++m)
         {
-            best_L_nodes.insert(Neighbor(id_scratch[m], dist_scratch[m]));
+            insert_candidate(Neighbor(id_scratch[m], dist_scratch[m]));
         }
     }
     return std::make_pair(hops, cmps);
 }
 
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::rerank_best_l_nodes(InMemQueryScratch<T> *scratch)
+{
+    NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
+    if (best_L_nodes.size() == 0)
+        return;
+    rerank_nodes(&best_L_nodes[0], best_L_nodes.size(), scratch);
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::rerank_nodes(Neighbor *nodes, size_t num_nodes, InMemQueryScratch<T> *scratch)
+{
+    std::vector<uint32_t> &ids = scratch->id_scratch();
+    std::vector<float> &dists = scratch->dist_scratch();
+    ids.clear();
+    for (size_t i = 0; i < num_nodes; i++)
+        ids.push_back(nodes[i].id);
+    dists.resize(ids.size());
+
+    if (_data_store->get_full_precision_distance(scratch->aligned_query(), ids.data(), (uint32_t)ids.size(),
+                                                 dists.data(), scratch->rerank_vector()))
+    {
+        std::vector<Neighbor> not_reranked;
+        size_t num_reranked = 0;
+        for (size_t i = 0; i < num_nodes; i++)
+        {
+            if (dists[i] == (std::numeric_limits<float>::max)())
+            {
+                not_reranked.push_back(nodes[i]);
+                continue;
+            }
+            nodes[num_reranked] = nodes[i];
+            nodes[num_reranked++].distance = dists[i];
+        }
+        std::sort(nodes, nodes + num_reranked);
+        std::copy(not_reranked.begin(), not_reranked.end(), nodes + num_reranked);
+    }
+    ids.clear();
+    dists.clear();
+}
+
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::search_for_point_and_prune(int location, uint32_t Lindex,
                                                         std::vector<uint32_t> &pruned_list,
@@ -1202,8 +1265,8 @@ void Index<T, TagT, LabelT>::prune_neighbors(const uint32_t location, std::vecto
         return;
     }
 
-    // If using _pq_build, over-write the PQ distances with actual distances
-    if (_pq_dist)
+    // If the pool has PQ distances, over-write them with actual distances
+    if (_pq_data_store != nullptr)
     {
         for (auto &ngh : pool)
             ngh.distance = _data_store->get_distance(ngh.id, location);
@@ -1247,7 +1310,8 @@ void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pru
         bool prune_needed = false;
         {
             LockGuard guard(_locks[des]);
-            auto des_pool = _graph_store->get_neighbours(des);
+            std::vector<uint32_t> &des_pool = scratch->neighbour_scratch();
+            _graph_store->get_neighbours(des, des_pool);
             if (std::find(des_pool.begin(), des_pool.end(), n) == des_pool.end())
             {
                 if (des_pool.size() < (uint64_t)(defaults::GRAPH_SLACK_FACTOR * range))
@@ -1374,7 +1438,7 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     for (int64_t node_ctr = 0; node_ctr < (int64_t)(visit_order.size()); node_ctr++)
     {
         auto node = visit_order[node_ctr];
-        if (_graph_store->get_neighbours((location_t)node).size() > _indexingRange)
+        if (_graph_store->get_degree((location_t)node) > _indexingRange)
         {
             ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
             auto scratch = manager.scratch_space();
@@ -1401,6 +1465,8 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     if (_nd > 0)
     {
         diskann::cout << "done. Link time: " << ((double)link_timer.elapsed() / (double)1000000) << "s" << std::endl;
+        diskann::cout << "Graph store memory: " << _graph_store->get_memory_in_bytes() / (1024.0 * 1024.0) << "MB"
+                      << std::endl;
     }
 }
 
@@ -1419,7 +1485,7 @@ void Index<T, TagT, LabelT>::prune_all_neighbors(const uint32_t max_degree, cons
     {
         if ((size_t)node < _nd || (size_t)node >= _max_points)
         {
-            if (_graph_store->get_neighbours((location_t)node).size() > range)
+            if (_graph_store->get_degree((location_t)node) > range)
             {
                 tsl::robin_set<uint32_t> dummy_visited(0);
                 std::vector<Neighbor> dummy_pool(0);
@@ -1451,11 +1517,11 @@ void Index<T, TagT, LabelT>::prune_all_neighbors(const uint32_t max_degree, cons
     {
         if (i < _nd || i >= _max_points)
         {
-            const std::vector<uint32_t> &pool = _graph_store->get_neighbours((location_t)i);
-            max = (std::max)(max, pool.size());
-            min = (std::min)(min, pool.size());
-            total += pool.size();
-            if (pool.size() < 2)
+            const size_t degree = _graph_store->get_degree((location_t)i);
+            max = (std::max)(max, degree);
+            min = (std::min)(min, degree);
+            total += degree;
+            if (degree < 2)
                 cnt++;
         }
     }
@@ -1469,6 +1535,16 @@ void Index<T, TagT, LabelT>::prune_all_neighbors(const uint32_t max_degree, cons
     }
 }
 
+template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::check_stores_trained() const
+{
+    if (!_data_store->is_trained() || (_pq_data_store != nullptr && !_pq_data_store->is_trained()))
+    {
+        throw ANNException("ERROR: The data store can not encode points before it is trained. Build the index from "
+                           "a data file, or load one with its PQ pivots, before adding points.",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
 // REFACTOR
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::set_start_points(const T *data, size_t data_count)
@@ -1480,12 +1556,15 @@ void Index<T, TagT, LabelT>::set_start_points(const T *data, size_t data_count)
 
     if (data_count != _num_frozen_pts * _dim)
         throw ANNException("Invalid number of points", -1, __FUNCSIG__, __FILE__, __LINE__);
+    check_stores_trained();
 
     //     memcpy(_data + _aligned_dim * _max_points, data, _aligned_dim *
     //     sizeof(T) * _num_frozen_pts);
     for (location_t i = 0; i < _num_frozen_pts; i++)
     {
         _data_store->set_vector((location_t)(i + _max_points), data + i * _dim);
+        if (_pq_data_store != nullptr)
+            _pq_data_store->set_vector((location_t)(i + _max_points), data + i * _dim);
     }
     _has_built = true;
     diskann::cout << "Index start points set: #" << _num_frozen_pts << std::endl;
@@ -1590,6 +1669,18 @@ void Index<T, TagT, LabelT>::build_with_data_populated(const std::vector<TagT> &
     diskann::cout << "Index built with degree: max:" << max << "  avg:" << (float)total / (float)(_nd + _num_frozen_pts)
                   << "  min:" << min << "  count(deg<2):" << cnt << std::endl;
 
+    if (!_dynamic_index)
+    {
+        // no inserts follow, so space kept to make them cheap can go
+        _graph_store->release_build_memory();
+        diskann::cout << "Graph store memory after build: "
+                      << _graph_store->get_memory_in_bytes() / (1024.0 * 1024.0) << "MB" << std::endl;
+    }
+
+    if (_packed_layout)
+    {
+        pack_layout();
+    }
     _has_built = true;
 }
 template <typename T, typename TagT, typename LabelT>
@@ -1617,8 +1708,7 @@ void Index<T, TagT, LabelT>::build(const T *data, const size_t num_points_to_loa
     }
     if (_pq_dist)
     {
-        throw ANNException("ERROR: DO not use this build interface with PQ distance", -1, __FUNCSIG__, __FILE__,
-                           __LINE__);
+        check_stores_trained();
     }
 
     std::unique_lock<std::shared_timed_mutex> ul(_update_lock);
@@ -1628,6 +1718,8 @@ void Index<T, TagT, LabelT>::build(const T *data, const size_t num_points_to_loa
         _nd = num_points_to_load;
 
         _data_store->populate_data(data, (location_t)num_points_to_load);
+        if (_pq_data_store != nullptr)
+            _pq_data_store->populate_data(data, (location_t)num_points_to_load);
     }
 
     build_with_data_populated(tags);
@@ -1666,8 +1758,6 @@ void Index<T, TagT, LabelT>::build(const char *filename, const size_t num_points
                << " points, but "
                << "index can support only " << _max_points << " points as specified in constructor." << std::endl;
 
-        if (_pq_dist)
-            aligned_free(_pq_data);
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -1677,8 +1767,6 @@ void Index<T, TagT, LabelT>::build(const char *filename, const size_t num_points
         stream << "ERROR: Driver requests loading " << num_points_to_load << " points and file has only "
                << file_num_points << " points." << std::endl;
 
-        if (_pq_dist)
-            aligned_free(_pq_data);
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -1689,33 +1777,11 @@ void Index<T, TagT, LabelT>::build(const char *filename, const size_t num_points
                << "but file has " << file_dim << " dimension." << std::endl;
         diskann::cerr << stream.str() << std::endl;
 
-        if (_pq_dist)
-            aligned_free(_pq_data);
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    if (_pq_dist)
-    {
-        double p_val = std::min(1.0, ((double)MAX_PQ_TRAINING_SET_SIZE / (double)file_num_points));
-
-        std::string suffix = _use_opq ? "_opq" : "_pq";
-        suffix += std::to_string(_num_pq_chunks);
-        auto pq_pivots_file = std::string(filename) + suffix + "_pivots.bin";
-        auto pq_compressed_file = std::string(filename) + suffix + "_compressed.bin";
-        generate_quantized_data<T>(std::string(filename), pq_pivots_file, pq_compressed_file, _dist_metric, p_val,
-                                   _num_pq_chunks, _use_opq);
-
-        copy_aligned_data_from_file<uint8_t>(pq_compressed_file.c_str(), _pq_data, file_num_points, _num_pq_chunks,
-                                             _num_pq_chunks);
-#ifdef EXEC_ENV_OLS
-        throw ANNException("load_pq_centroid_bin should not be called when "
-                           "EXEC_ENV_OLS is defined.",
-                           -1, __FUNCSIG__, __FILE__, __LINE__);
-#else
-        _pq_table.load_pq_centroid_bin(pq_pivots_file.c_str(), _num_pq_chunks);
-#endif
-    }
-
+    if (_pq_data_store != nullptr)
+        _pq_data_store->populate_data(filename, 0U);
     _data_store->populate_data(filename, 0U);
     diskann::cout << "Using only first " << num_points_to_load << " from file.. " << std::endl;
 
@@ -1835,6 +1901,13 @@ LabelT Index<T, TagT, LabelT>::get_converted_label(const std::string &raw_label)
     throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
 }
 
+template <typename T, typename TagT, typename LabelT>
+FilterExpression<LabelT> Index<T, TagT, LabelT>::get_converted_filter(const std::string &raw_filter)
+{
+    return FilterExpression<LabelT>::parse(
+        raw_filter, [this](const std::string &raw_label) { return get_converted_label(raw_label); });
+}
+
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::parse_label_file(const std::string &label_file, size_t &num_points)
 {
@@ -1880,6 +1953,17 @@ void Index<T, TagT, LabelT>::parse_label_file(const std::string &label_file, siz
     }
     num_points = (size_t)line_cnt;
     diskann::cout << "Identified " << _labels.size() << " distinct label(s)" << std::endl;
+
+    if (!_dynamic_index)
+    {
+        _label_index.reset(_location_to_labels.size());
+        for (uint32_t i = 0; i < _location_to_labels.size(); i++)
+        {
+            _label_index.add_point(i, _location_to_labels[i].data(), (uint32_t)_location_to_labels[i].size());
+        }
+        _label_index.shrink_to_fit();
+        diskann::cout << "Label index takes " << _label_index.memory_bytes() / (1024 * 1024) << "MB" << std::endl;
+    }
 }
 
 template <typename T, typename TagT, typename LabelT>
@@ -2025,6 +2109,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search(const T *query, con
 
     auto retval =
         iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, false, unused_filter_label, true);
+    rerank_best_l_nodes(scratch);
 
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
 
@@ -2082,6 +2167,30 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::_search_with_filters(const
     }
 }
 
+template <typename T, typename TagT, typename LabelT>
+std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::_search_with_filter_expression(const DataType &query,
+                                                                                     const std::string &raw_filter,
+                                                                                     const size_t K, const uint32_t L,
+                                                                                     std::any &indices,
+                                                                                     float *distances)
+{
+    auto filter = this->get_converted_filter(raw_filter);
+    if (typeid(uint64_t *) == indices.type())
+    {
+        auto ptr = std::any_cast<uint64_t *>(indices);
+        return this->search_with_filters(std::any_cast<T *>(query), filter, K, L, ptr, distances);
+    }
+    else if (typeid(uint32_t *) == indices.type())
+    {
+        auto ptr = std::any_cast<uint32_t *>(indices);
+        return this->search_with_filters(std::any_cast<T *>(query), filter, K, L, ptr, distances);
+    }
+    else
+    {
+        throw ANNException("Error: Id type can only be uint64_t or uint32_t.", -1);
+    }
+}
+
 template <typename T, typename TagT, typename LabelT>
 template <typename IdType>
 std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_filters(const T *query, const LabelT &filter_label,
@@ -2129,6 +2238,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_filters(const
 
     _data_store->get_dist_fn()->preprocess_query(query, _data_store->get_dims(), scratch->aligned_query());
     auto retval = iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, true, filter_vec, true);
+    rerank_best_l_nodes(scratch);
 
     auto best_L_nodes = scratch->best_l_nodes();
 
@@ -2179,6 +2289,117 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_filters(const
     return retval;
 }
 
+template <typename T, typename TagT, typename LabelT>
+template <typename IdType>
+std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_filters(const T *query,
+                                                                          const FilterExpression<LabelT> &filter,
+                                                                          const size_t K, const uint32_t L,
+                                                                          IdType *indices, float *distances)
+{
+    if (K > (uint64_t)L)
+    {
+        throw ANNException("Set L to a value of at least K", -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
+    auto scratch = manager.scratch_space();
+
+    if (L > scratch->get_L())
+    {
+        diskann::cout << "Attempting to expand query scratch_space. Was created "
+                      << "with Lsize: " << scratch->get_L() << " but search L is: " << L << std::endl;
+        scratch->resize_for_new_L(L);
+        diskann::cout << "Resize completed. New scratch->L is " << scratch->get_L() << std::endl;
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(_update_lock);
+    std::shared_lock<std::shared_timed_mutex> tl(_tag_lock, std::defer_lock);
+    if (_dynamic_index)
+        tl.lock();
+
+    // the start point of every label a clause requires, which may not match
+    // the whole clause, and the start points of the index for a clause that
+    // only excludes labels
+    std::vector<uint32_t> init_ids;
+    bool with_index_init_ids = false;
+    for (const auto &clause : filter.clauses())
+    {
+        if (clause.labels.empty() && !with_index_init_ids)
+        {
+            const auto index_init_ids = get_init_ids();
+            init_ids.insert(init_ids.end(), index_init_ids.begin(), index_init_ids.end());
+            with_index_init_ids = true;
+        }
+        for (const auto &label : clause.labels)
+        {
+            const auto start_id = _label_to_start_id.find(label);
+            if (start_id != _label_to_start_id.end())
+                init_ids.push_back(start_id->second);
+        }
+    }
+    if (_dynamic_index)
+        tl.unlock();
+
+    if (init_ids.empty())
+    {
+        throw diskann::ANNException("No filtered medoid found for any clause of the filter.", -1, __FUNCSIG__,
+                                    __FILE__, __LINE__);
+    }
+
+    const std::vector<LabelT> unused_filter_label;
+    _data_store->get_dist_fn()->preprocess_query(query, _data_store->get_dims(), scratch->aligned_query());
+    auto retval = iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, true, unused_filter_label,
+                                         true, nullptr, &filter);
+    rerank_best_l_nodes(scratch);
+
+    auto best_L_nodes = scratch->best_l_nodes();
+
+    size_t pos = 0;
+    for (size_t i = 0; i < best_L_nodes.size(); ++i)
+    {
+        // start points that do not match filter are visited but not returned
+        if (best_L_nodes[i].id < _max_points && matches_filter(best_L_nodes[i].id, filter))
+        {
+            if (_enable_tags)
+            {
+                TagT tag;
+                if (_location_to_tag.try_get(best_L_nodes[i].id, tag))
+                {
+                    indices[pos] = (IdType)tag;
+                }
+                else
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                indices[pos] = (IdType)best_L_nodes[i].id;
+            }
+
+            if (distances != nullptr)
+            {
+#ifdef EXEC_ENV_OLS
+                // DLVS expects negative distances
+                distances[pos] = best_L_nodes[i].distance;
+#else
+                distances[pos] = _dist_metric == diskann::Metric::INNER_PRODUCT ? -1 * best_L_nodes[i].distance
+                                                                                : best_L_nodes[i].distance;
+#endif
+            }
+            pos++;
+        }
+        if (pos == K)
+            break;
+    }
+    if (pos < K)
+    {
+        diskann::cerr << "Found fewer than K elements for query" << std::endl;
+    }
+
+    return retval;
+}
+
 template <typename T, typename TagT, typename LabelT>
 size_t Index<T, TagT, LabelT>::_search_with_tags(const DataType &query, const uint64_t K, const uint32_t L,
                                                  const TagType &tags, float *distances, DataVector &res_vectors)
@@ -2226,6 +2447,7 @@ size_t Index<T, TagT, LabelT>::search_with_tags(const T *query, const uint64_t K
     // scratch->aligned_query());
     _data_store->get_dist_fn()->preprocess_query(query, _data_store->get_dims(), scratch->aligned_query());
     iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, false, unused_filter_label, true);
+    rerank_best_l_nodes(scratch);
 
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
     assert(best_L_nodes.size() <= L);
@@ -2265,6 +2487,158 @@ size_t Index<T, TagT, LabelT>::search_with_tags(const T *query, const uint64_t K
     return pos;
 }
 
+template <typename T, typename TagT, typename LabelT>
+uint32_t Index<T, TagT, LabelT>::_range_search(const DataType &query, const float range, const uint32_t min_l_search,
+                                               const uint32_t max_l_search, std::any &indices,
+                                               std::vector<float> &distances)
+{
+    try
+    {
+        auto typed_query = std::any_cast<const T *>(query);
+        if (typeid(std::vector<uint32_t> *) == indices.type())
+        {
+            auto ptr = std::any_cast<std::vector<uint32_t> *>(indices);
+            return this->range_search(typed_query, range, min_l_search, max_l_search, *ptr, distances);
+        }
+        else if (typeid(std::vector<uint64_t> *) == indices.type())
+        {
+            auto ptr = std::any_cast<std::vector<uint64_t> *>(indices);
+            return this->range_search(typed_query, range, min_l_search, max_l_search, *ptr, distances);
+        }
+        else
+        {
+            throw ANNException("Error: Id type can only be uint64_t or uint32_t.", -1);
+        }
+    }
+    catch (const std::bad_any_cast &e)
+    {
+        throw ANNException("Error: bad any cast while performing _range_search() " + std::string(e.what()), -1);
+    }
+}
+
+template <typename T, typename TagT, typename LabelT>
+template <typename IdType>
+uint32_t Index<T, TagT, LabelT>::range_search(const T *query, const float range, const uint32_t min_l_search,
+                                              const uint32_t max_l_search, std::vector<IdType> &indices,
+                                              std::vector<float> &distances, std::vector<TagT> *tags)
+{
+    if (min_l_search == 0 || min_l_search > max_l_search)
+    {
+        throw ANNException("Set min_l_search to a value between 1 and max_l_search", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+    if (tags != nullptr && !_enable_tags)
+    {
+        throw ANNException("Tags asked from range_search on an index without tags", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+
+    ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
+    auto scratch = manager.scratch_space();
+
+    const std::vector<uint32_t> init_ids = get_init_ids();
+    const std::vector<LabelT> unused_filter_label;
+
+    std::shared_lock<std::shared_timed_mutex> lock(_update_lock);
+
+    _data_store->get_dist_fn()->preprocess_query(query, _data_store->get_dims(), scratch->aligned_query());
+
+    // inner products are negated inside the index, so that smaller is closer
+    const float max_distance = _dist_metric == diskann::Metric::INNER_PRODUCT ? -range : range;
+
+    NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
+    std::vector<Neighbor> &dropped = scratch->dropped_candidates();
+    std::vector<Neighbor> candidates;
+
+    uint32_t L = min_l_search;
+    uint32_t num_in_range = 0;
+    while (true)
+    {
+        // unlike search, L changes on every query, so the scratch grows quietly
+        scratch->resize_for_new_L(L);
+        if (L == min_l_search)
+        {
+            iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, false, unused_filter_label, true,
+                                   &dropped);
+        }
+        else
+        {
+            // the start points are in the visited set already, the search goes
+            // on from the candidates of the smaller L and the ones that fell out
+            const std::vector<uint32_t> no_init_ids;
+            best_L_nodes.grow(L, dropped);
+            scratch->id_scratch().clear();
+            scratch->dist_scratch().clear();
+            iterate_to_fixed_point(scratch->aligned_query(), L, no_init_ids, scratch, false, unused_filter_label,
+                                   true, &dropped);
+        }
+
+        // the list keeps the distances the index searches with for the next
+        // round, a copy is reranked like Index::search does
+        candidates.clear();
+        for (size_t i = 0; i < best_L_nodes.size(); i++)
+            candidates.push_back(best_L_nodes[i]);
+        rerank_nodes(candidates.data(), candidates.size(), scratch);
+
+        // the candidates a store could not rerank follow the reranked ones,
+        // sorted by their search distances, so both runs are checked whole
+        num_in_range = 0;
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (candidates[i].distance <= max_distance && candidates[i].id < _max_points)
+                num_in_range++;
+        }
+
+        // Fewer than L/2 points in range means the search has gone past the
+        // edge of the ball, a larger L would only add points outside of it
+        if (num_in_range < L / 2 || L >= max_l_search)
+            break;
+        L = std::min(2 * L, max_l_search);
+    }
+
+    // deleted points lose their tag, so a dynamic index, which always has
+    // tags, skips them like search_with_tags even if no tags are asked for
+    std::shared_lock<std::shared_timed_mutex> tl(_tag_lock, std::defer_lock);
+    if (tags != nullptr || _dynamic_index)
+        tl.lock();
+    if (tags != nullptr)
+        tags->resize(num_in_range);
+    indices.resize(num_in_range);
+    distances.resize(num_in_range);
+
+    uint32_t pos = 0;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        const Neighbor &node = candidates[i];
+        if (node.distance > max_distance || node.id >= _max_points)
+            continue;
+        if (tags != nullptr)
+        {
+            TagT tag;
+            if (!_location_to_tag.try_get(node.id, tag))
+                continue;
+            (*tags)[pos] = tag;
+        }
+        else if (_dynamic_index && !_location_to_tag.contains(node.id))
+        {
+            continue;
+        }
+
+        // safe because Index uses uint32_t ids internally
+        // and IDType will be uint32_t or uint64_t
+        indices[pos] = (IdType)node.id;
+        distances[pos] = _dist_metric == diskann::Metric::INNER_PRODUCT ? -1 * node.distance : node.distance;
+        pos++;
+    }
+
+    // shrinking keeps the allocation
+    indices.resize(pos);
+    distances.resize(pos);
+    if (tags != nullptr)
+        tags->resize(pos);
+    return pos;
+}
+
 template <typename T, typename TagT, typename LabelT> size_t Index<T, TagT, LabelT>::get_num_points()
 {
     std::shared_lock<std::shared_timed_mutex> tl(_tag_lock);
@@ -2294,17 +2668,9 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     }
     size_t res = calculate_entry_point();
 
-    if (_pq_dist)
-    {
-        // copy the PQ data corresponding to the point returned by
-        // calculate_entry_point
-        memcpy(_pq_data + _max_points * _num_pq_chunks, _pq_data + res * _num_pq_chunks,
-               _num_pq_chunks * DIV_ROUND_UP(NUM_PQ_BITS, 8));
-    }
-    else
-    {
-        _data_store->copy_vectors((location_t)res, (location_t)_max_points, 1);
-    }
+    _data_store->copy_vectors((location_t)res, (location_t)_max_points, 1);
+    if (_pq_data_store != nullptr)
+        _pq_data_store->copy_vectors((location_t)res, (location_t)_max_points, 1);
     _frozen_pts_used++;
 }
 
@@ -2349,13 +2715,16 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
     // If this condition were not true, deadlock could result
     assert(old_delete_set.find((uint32_t)loc) == old_delete_set.end());
 
-    std::vector<uint32_t> adj_list;
+    std::vector<uint32_t> &adj_list = scratch->neighbour_scratch();
+    // id_scratch is not used by process_delete otherwise, so it holds the
+    // decoded neighbours of each deleted neighbour
+    std::vector<uint32_t> &ngh_list = scratch->id_scratch();
     {
         // Acquire and release lock[loc] before acquiring locks for neighbors
         std::unique_lock<non_recursive_mutex> adj_list_lock;
         if (_conc_consolidate)
             adj_list_lock = std::unique_lock<non_recursive_mutex>(_locks[loc]);
-        adj_list = _graph_store->get_neighbours((location_t)loc);
+        _graph_store->get_neighbours((location_t)loc, adj_list);
     }
 
     bool modify = false;
@@ -2372,7 +2741,8 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
             std::unique_lock<non_recursive_mutex> ngh_lock;
             if (_conc_consolidate)
                 ngh_lock = std::unique_lock<non_recursive_mutex>(_locks[ngh]);
-            for (auto j : _graph_store->get_neighbours((location_t)ngh))
+            _graph_store->get_neighbours((location_t)ngh, ngh_list);
+            for (auto j : ngh_list)
                 if (j != loc && old_delete_set.find(j) == old_delete_set.end())
                     expanded_nodes_set.insert(j);
         }
@@ -2616,6 +2986,8 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
                 }
 
                 _data_store->copy_vectors(old, new_location[old], 1);
+                if (_pq_data_store != nullptr)
+                    _pq_data_store->copy_vectors(old, new_location[old], 1);
             }
         }
         else
@@ -2800,6 +3172,8 @@ void Index<T, TagT, LabelT>::reposition_points(uint32_t old_location_start, uint
         }
     }
     _data_store->move_vectors(old_location_start, new_location_start, num_locations);
+    if (_pq_data_store != nullptr)
+        _pq_data_store->move_vectors(old_location_start, new_location_start, num_locations);
 }
 
 template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::reposition_frozen_point_to_end()
@@ -2835,6 +3209,8 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     assert(_empty_slots.size() == 0); // should not resize if there are empty slots.
 
     _data_store->resize((location_t)new_internal_points);
+    if (_pq_data_store != nullptr)
+        _pq_data_store->resize((location_t)new_internal_points);
     _graph_store->resize_graph(new_internal_points);
     _locks = std::vector<non_recursive_mutex>(new_internal_points);
 
@@ -2909,6 +3285,7 @@ int Index<T, TagT, LabelT>::insert_point(const T *point, const TagT tag, const s
                                     "from the user.",
                                     -1, __FUNCSIG__, __FILE__, __LINE__);
     }
+    check_stores_trained();
 
     std::shared_lock<std::shared_timed_mutex> shared_ul(_update_lock);
     std::unique_lock<std::shared_timed_mutex> tl(_tag_lock);
@@ -2945,6 +3322,8 @@ int Index<T, TagT, LabelT>::insert_point(const T *point, const TagT tag, const s
                 _label_to_start_id[label] = (uint32_t)fz_location;
                 _location_to_labels[fz_location] = {label};
                 _data_store->set_vector((location_t)fz_location, point);
+                if (_pq_data_store != nullptr)
+                    _pq_data_store->set_vector((location_t)fz_location, point);
                 _frozen_pts_used++;
             }
         }
@@ -3006,6 +3385,8 @@ int Index<T, TagT, LabelT>::insert_point(const T *point, const TagT tag, const s
     tl.unlock();
 
     _data_store->set_vector(location, point); // update datastore
+    if (_pq_data_store != nullptr)
+        _pq_data_store->set_vector(location, point); // encodes the point on the fly
 
     // Find and add appropriate graph edges
     ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
@@ -3222,55 +3603,67 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     delete[] bfs_sets;
 }
 
-// REFACTOR: This should be an OptimizedDataStore class, dummy impl here for
-// compiling sake template <typename T, typename TagT, typename LabelT> void
-// Index<T, TagT, LabelT>::optimize_index_layout()
-//{ // use after build or load
-//}
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::use_packed_nodes(std::shared_ptr<PackedNodeStore> nodes)
+{
+    // FAST_L2 only ever meant L2 over the old optimized layout
+    const Metric metric = _dist_metric == diskann::Metric::FAST_L2 ? diskann::Metric::L2 : _dist_metric;
+    _data_store = std::make_unique<PackedDataStore<T>>(nodes, IndexFactory::construct_distance<T>(metric));
+    _graph_store = std::make_unique<PackedGraphStore>(nodes);
+    _packed_nodes = std::move(nodes);
+}
 
-// REFACTOR: This should be an OptimizedDataStore class
-template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::optimize_index_layout()
-{ // use after build or load
+template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::pack_layout()
+{
+    if (_packed_nodes != nullptr)
+    {
+        return;
+    }
     if (_dynamic_index)
     {
-        throw diskann::ANNException("Optimize_index_layout not implemented for dyanmic indices", -1, __FUNCSIG__,
-                                    __FILE__, __LINE__);
+        throw diskann::ANNException("The packed layout is read-only and not supported for dynamic indices", -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (_pq_dist)
+    {
+        throw diskann::ANNException("The packed layout holds full-precision vectors, it does not support PQ "
+                                    "distances",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    float *cur_vec = new float[_data_store->get_aligned_dim()];
-    std::memset(cur_vec, 0, _data_store->get_aligned_dim() * sizeof(float));
-    _data_len = (_data_store->get_aligned_dim() + 1) * sizeof(float);
-    _neighbor_len = (_graph_store->get_max_observed_degree() + 1) * sizeof(uint32_t);
-    _node_size = _data_len + _neighbor_len;
-    _opt_graph = new char[_node_size * _nd];
-    DistanceFastL2<T> *dist_fast = (DistanceFastL2<T> *)_data_store->get_dist_fn();
-    for (uint32_t i = 0; i < _nd; i++)
+    diskann::Timer timer;
+    const size_t num_locations = _max_points + _num_frozen_pts;
+    uint32_t max_degree = 0;
+    for (size_t i = 0; i < num_locations; i++)
     {
-        char *cur_node_offset = _opt_graph + i * _node_size;
-        _data_store->get_vector(i, (T *)cur_vec);
-        float cur_norm = dist_fast->norm((T *)cur_vec, (uint32_t)_data_store->get_aligned_dim());
-        std::memcpy(cur_node_offset, &cur_norm, sizeof(float));
-        std::memcpy(cur_node_offset + sizeof(float), cur_vec, _data_len - sizeof(float));
+        max_degree = (std::max)(max_degree, _graph_store->get_degree((location_t)i));
+    }
 
-        cur_node_offset += _data_len;
-        uint32_t k = (uint32_t)_graph_store->get_neighbours(i).size();
-        std::memcpy(cur_node_offset, &k, sizeof(uint32_t));
-        std::memcpy(cur_node_offset + sizeof(uint32_t), _graph_store->get_neighbours(i).data(), k * sizeof(uint32_t));
-        // std::vector<uint32_t>().swap(_graph_store->get_neighbours(i));
-        _graph_store->clear_neighbours(i);
+    auto nodes = std::make_shared<PackedNodeStore>(num_locations, _dim, sizeof(T),
+                                                   _data_store->get_aligned_dim() * sizeof(T), max_degree);
+#pragma omp parallel
+    {
+        std::vector<location_t> neighbours;
+#pragma omp for schedule(dynamic, 2048)
+        for (int64_t i = 0; i < (int64_t)num_locations; i++)
+        {
+            // the stored vectors are already preprocessed for the metric
+            _data_store->get_vector((location_t)i, (T *)nodes->vector((location_t)i));
+            uint32_t *adjacency = nodes->adjacency((location_t)i);
+            adjacency[0] = _graph_store->get_neighbours((location_t)i, neighbours);
+            std::memcpy(adjacency + 1, neighbours.data(), adjacency[0] * sizeof(location_t));
+        }
     }
-    _graph_store->clear_graph();
-    _graph_store->resize_graph(0);
-    delete[] cur_vec;
+    use_packed_nodes(nodes);
+    diskann::cout << "Packed " << num_locations << " points into rows of " << nodes->row_size() << " bytes in "
+                  << timer.elapsed() / 1000000.0 << "s." << std::endl;
 }
 
-//  REFACTOR: once optimized layout becomes its own Data+Graph store, we should
-//  just invoke regular search
-// template <typename T, typename TagT, typename LabelT>
-// void Index<T, TagT, LabelT>::search_with_optimized_layout(const T *query,
-// size_t K, size_t L, uint32_t *indices)
-//{
-//}
+template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::optimize_index_layout()
+{ // use after build or load
+    std::unique_lock<std::shared_timed_mutex> ul(_update_lock);
+    pack_layout();
+}
 
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::_search_with_optimized_layout(const DataType &query, size_t K, size_t L, uint32_t *indices)
@@ -3295,84 +3688,7 @@ void Index<T, TagT, LabelT>::_search_with_optimized_layout(const DataType &query
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::search_with_optimized_layout(const T *query, size_t K, size_t L, uint32_t *indices)
 {
-    DistanceFastL2<T> *dist_fast = (DistanceFastL2<T> *)_data_store->get_dist_fn();
-
-    NeighborPriorityQueue retset(L);
-    std::vector<uint32_t> init_ids(L);
-
-    boost::dynamic_bitset<> flags{_nd, 0};
-    uint32_t tmp_l = 0;
-    uint32_t *neighbors = (uint32_t *)(_opt_graph + _node_size * _start + _data_len);
-    uint32_t MaxM_ep = *neighbors;
-    neighbors++;
-
-    for (; tmp_l < L && tmp_l < MaxM_ep; tmp_l++)
-    {
-        init_ids[tmp_l] = neighbors[tmp_l];
-        flags[init_ids[tmp_l]] = true;
-    }
-
-    while (tmp_l < L)
-    {
-        uint32_t id = rand() % _nd;
-        if (flags[id])
-            continue;
-        flags[id] = true;
-        init_ids[tmp_l] = id;
-        tmp_l++;
-    }
-
-    for (uint32_t i = 0; i < init_ids.size(); i++)
-    {
-        uint32_t id = init_ids[i];
-        if (id >= _nd)
-            continue;
-        _mm_prefetch(_opt_graph + _node_size * id, _MM_HINT_T0);
-    }
-    L = 0;
-    for (uint32_t i = 0; i < init_ids.size(); i++)
-    {
-        uint32_t id = init_ids[i];
-        if (id >= _nd)
-            continue;
-        T *x = (T *)(_opt_graph + _node_size * id);
-        float norm_x = *x;
-        x++;
-        float dist = dist_fast->compare(x, query, norm_x, (uint32_t)_data_store->get_aligned_dim());
-        retset.insert(Neighbor(id, dist));
-        flags[id] = true;
-        L++;
-    }
-
-    while (retset.has_unexpanded_node())
-    {
-        auto nbr = retset.closest_unexpanded();
-        auto n = nbr.id;
-        _mm_prefetch(_opt_graph + _node_size * n + _data_len, _MM_HINT_T0);
-        neighbors = (uint32_t *)(_opt_graph + _node_size * n + _data_len);
-        uint32_t MaxM = *neighbors;
-        neighbors++;
-        for (uint32_t m = 0; m < MaxM; ++m)
-            _mm_prefetch(_opt_graph + _node_size * neighbors[m], _MM_HINT_T0);
-        for (uint32_t m = 0; m < MaxM; ++m)
-        {
-            uint32_t id = neighbors[m];
-            if (flags[id])
-                continue;
-            flags[id] = 1;
-            T *data = (T *)(_opt_graph + _node_size * id);
-            float norm = *data;
-            data++;
-            float dist = dist_fast->compare(query, data, norm, (uint32_t)_data_store->get_aligned_dim());
-            Neighbor nn(id, dist);
-            retset.insert(nn);
-        }
-    }
-
-    for (size_t i = 0; i < K; i++)
-    {
-        indices[i] = retset[i].id;
-    }
+    search(query, K, (uint32_t)L, indices);
 }
 
 /*  Internals of the library */
@@ -3532,4 +3848,152 @@ template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t,
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint16_t>::search_with_filters<
     uint32_t>(const int8_t *query, const uint16_t &filter_label, const size_t K, const uint32_t L, uint32_t *indices,
               float *distances);
+
+// filter expression search, for the same tag and label types as search_with_filters
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint32_t>::search_with_filters<
+    uint64_t>(const float *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint32_t>::search_with_filters<
+    uint32_t>(const float *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint32_t>::search_with_filters<
+    uint64_t>(const uint8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint32_t>::search_with_filters<
+    uint32_t>(const uint8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint32_t>::search_with_filters<
+    uint64_t>(const int8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint32_t>::search_with_filters<
+    uint32_t>(const int8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint32_t>::search_with_filters<
+    uint64_t>(const float *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint32_t>::search_with_filters<
+    uint32_t>(const float *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint32_t>::search_with_filters<
+    uint64_t>(const uint8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint32_t>::search_with_filters<
+    uint32_t>(const uint8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint32_t>::search_with_filters<
+    uint64_t>(const int8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint32_t>::search_with_filters<
+    uint32_t>(const int8_t *query, const FilterExpression<uint32_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint16_t>::search_with_filters<
+    uint64_t>(const float *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint16_t>::search_with_filters<
+    uint32_t>(const float *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint16_t>::search_with_filters<
+    uint64_t>(const uint8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint16_t>::search_with_filters<
+    uint32_t>(const uint8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint16_t>::search_with_filters<
+    uint64_t>(const int8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint16_t>::search_with_filters<
+    uint32_t>(const int8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint16_t>::search_with_filters<
+    uint64_t>(const float *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint16_t>::search_with_filters<
+    uint32_t>(const float *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint16_t>::search_with_filters<
+    uint64_t>(const uint8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint16_t>::search_with_filters<
+    uint32_t>(const uint8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint16_t>::search_with_filters<
+    uint64_t>(const int8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint64_t *indices, float *distances);
+template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint16_t>::search_with_filters<
+    uint32_t>(const int8_t *query, const FilterExpression<uint16_t> &filter, const size_t K, const uint32_t L,
+              uint32_t *indices, float *distances);
+
+// range search, for the same tag and label types as search
+template DISKANN_DLLEXPORT uint32_t Index<float, uint64_t, uint32_t>::range_search<uint64_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint64_t, uint32_t>::range_search<uint32_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint64_t, uint32_t>::range_search<uint64_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint64_t, uint32_t>::range_search<uint32_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint64_t, uint32_t>::range_search<uint64_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint64_t, uint32_t>::range_search<uint32_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint32_t, uint32_t>::range_search<uint64_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint32_t, uint32_t>::range_search<uint32_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint32_t, uint32_t>::range_search<uint64_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint32_t, uint32_t>::range_search<uint32_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint32_t, uint32_t>::range_search<uint64_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint32_t, uint32_t>::range_search<uint32_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint64_t, uint16_t>::range_search<uint64_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint64_t, uint16_t>::range_search<uint32_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint64_t, uint16_t>::range_search<uint64_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint64_t, uint16_t>::range_search<uint32_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint64_t, uint16_t>::range_search<uint64_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint64_t, uint16_t>::range_search<uint32_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint32_t, uint16_t>::range_search<uint64_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<float, uint32_t, uint16_t>::range_search<uint32_t>(
+    const float *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint32_t, uint16_t>::range_search<uint64_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<uint8_t, uint32_t, uint16_t>::range_search<uint32_t>(
+    const uint8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint32_t, uint16_t>::range_search<uint64_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t Index<int8_t, uint32_t, uint16_t>::range_search<uint32_t>(
+    const int8_t *query, const float range, const uint32_t min_l_search, const uint32_t max_l_search,
+    std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
 } // namespace diskann
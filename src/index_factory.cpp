@@ -1,7 +1,35 @@
 #include "index_factory.h"
+#include "in_mem_quantized_data_store.h"
 
 namespace diskann
 {
+namespace
+{
+// quantized data stores hold float vectors only
+template <typename T>
+std::unique_ptr<AbstractDataStore<T>> construct_quantized_datastore(const ScalarQuantization quantization,
+                                                                    const size_t num_points, const size_t dimension,
+                                                                    const Metric m,
+                                                                    const std::string &rerank_data_file)
+{
+    throw ANNException("ERROR: Quantized data stores support only float data.", -1, __FUNCSIG__, __FILE__, __LINE__);
+}
+
+template <>
+std::unique_ptr<AbstractDataStore<float>> construct_quantized_datastore(const ScalarQuantization quantization,
+                                                                        const size_t num_points,
+                                                                        const size_t dimension, const Metric m,
+                                                                        const std::string &rerank_data_file)
+{
+    std::unique_ptr<Distance<float>> distance;
+    if (m == diskann::Metric::COSINE)
+        distance.reset(new AVXNormalizedCosineDistanceFloat());
+    else
+        distance.reset(get_distance_function<float>(m));
+    return std::make_unique<InMemQuantizedDataStore>((location_t)num_points, dimension, quantization,
+                                                     std::move(distance), rerank_data_file);
+}
+} // namespace
 
 IndexFactory::IndexFactory(const IndexConfig &config) : _config(std::make_unique<IndexConfig>(config))
 {
@@ -20,12 +48,8 @@ void IndexFactory::check_config()
         throw ANNException("ERROR: Dynamic Indexing must have tags enabled.", -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    if (_config->pq_dist_build)
+    if (_config->pq_dist_build || _config->data_strategy == DataStoreStrategy::PQ)
     {
-        if (_config->dynamic_index)
-            throw ANNException("ERROR: Dynamic Indexing not supported with PQ distance based "
-                               "index construction",
-                               -1, __FUNCSIG__, __FILE__, __LINE__);
         if (_config->metric == diskann::Metric::INNER_PRODUCT)
             throw ANNException("ERROR: Inner product metrics not yet supported "
                                "with PQ distance "
@@ -40,6 +64,36 @@ void IndexFactory::check_config()
                            -1);
     }
 
+    if (_config->data_strategy != DataStoreStrategy::MEMORY)
+    {
+        if (_config->data_type != "float" && _config->data_strategy != DataStoreStrategy::PQ)
+            throw ANNException("ERROR: Quantized data stores support only float data.", -1);
+        if (_config->pq_dist_build)
+            throw ANNException("ERROR: Quantized data stores can not be combined with PQ distance based index "
+                               "construction",
+                               -1);
+    }
+
+    if (_config->graph_strategy == GraphStoreStrategy::PACKED)
+    {
+        if (_config->dynamic_index)
+            throw ANNException("ERROR: The packed layout is read-only and not supported for dynamic indices.", -1);
+        if (_config->data_strategy != DataStoreStrategy::MEMORY || _config->pq_dist_build)
+            throw ANNException("ERROR: The packed layout holds full-precision vectors, it needs the memory data "
+                               "store and no PQ distance based index construction.",
+                               -1);
+    }
+
+    if (!_config->rerank_data_file.empty())
+    {
+        if (_config->data_strategy != DataStoreStrategy::QUANTIZED_INT8 &&
+            _config->data_strategy != DataStoreStrategy::QUANTIZED_FP16)
+            throw ANNException("ERROR: Re-ranking applies only to scalar quantized data stores.", -1);
+        // locations of a dynamic index move, they stop matching rows of the file
+        if (_config->dynamic_index)
+            throw ANNException("ERROR: Re-ranking is not supported for dynamic indices.", -1);
+    }
+
     if (_config->tag_type != "int32" && _config->tag_type != "uint32" && _config->tag_type != "int64" &&
         _config->tag_type != "uint64")
     {
@@ -49,32 +103,49 @@ void IndexFactory::check_config()
     }
 }
 
+template <typename T> std::unique_ptr<Distance<T>> IndexFactory::construct_distance(const Metric m)
+{
+    std::unique_ptr<Distance<T>> distance;
+    if (m == diskann::Metric::COSINE && std::is_same<T, float>::value)
+        distance.reset((Distance<T> *)new AVXNormalizedCosineDistanceFloat());
+    else
+        distance.reset((Distance<T> *)get_distance_function<T>(m));
+    return distance;
+}
+
 template <typename T>
 std::unique_ptr<AbstractDataStore<T>> IndexFactory::construct_datastore(const DataStoreStrategy strategy,
                                                                         const size_t num_points, const size_t dimension,
-                                                                        const Metric m)
+                                                                        const Metric m,
+                                                                        const std::string &rerank_data_file)
 {
-    std::unique_ptr<Distance<T>> distance;
     switch (strategy)
     {
     case DataStoreStrategy::MEMORY:
-        if (m == diskann::Metric::COSINE && std::is_same<T, float>::value)
-        {
-            distance.reset((Distance<T> *)new AVXNormalizedCosineDistanceFloat());
-            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance));
-        }
-        else
-        {
-            distance.reset((Distance<T> *)get_distance_function<T>(m));
-            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance));
-        }
-        break;
+        return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension,
+                                                            construct_distance<T>(m));
+    case DataStoreStrategy::QUANTIZED_INT8:
+        return construct_quantized_datastore<T>(ScalarQuantization::INT8, num_points, dimension, m, rerank_data_file);
+    case DataStoreStrategy::QUANTIZED_FP16:
+        return construct_quantized_datastore<T>(ScalarQuantization::FP16, num_points, dimension, m, rerank_data_file);
+    case DataStoreStrategy::PQ:
+        throw ANNException("ERROR: PQ data stores need their number of chunks, use construct_pq_datastore.", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
     default:
         break;
     }
     return nullptr;
 }
 
+template <typename T>
+std::unique_ptr<PQDataStore<T>> IndexFactory::construct_pq_datastore(const size_t num_points, const size_t dimension,
+                                                                     const Metric m, const size_t num_pq_chunks,
+                                                                     const bool use_opq)
+{
+    return std::make_unique<PQDataStore<T>>((location_t)num_points, dimension, num_pq_chunks, use_opq,
+                                            construct_distance<T>(m));
+}
+
 std::unique_ptr<AbstractGraphStore> IndexFactory::construct_graphstore(const GraphStoreStrategy strategy,
                                                                        const size_t size,
                                                                        const size_t reserve_graph_degree)
@@ -82,7 +153,12 @@ std::unique_ptr<AbstractGraphStore> IndexFactory::construct_graphstore(const Gra
     switch (strategy)
     {
     case GraphStoreStrategy::MEMORY:
+    case GraphStoreStrategy::PACKED:
         return std::make_unique<InMemGraphStore>(size, reserve_graph_degree);
+    case GraphStoreStrategy::COMPRESSED:
+        return std::make_unique<InMemCompressedGraphStore>(size, reserve_graph_degree);
+    case GraphStoreStrategy::FLAT:
+        return std::make_unique<InMemFlatGraphStore>(size, reserve_graph_degree);
     default:
         throw ANNException("Error : Current GraphStoreStratagy is not supported.", -1);
     }
@@ -96,7 +172,13 @@ std::unique_ptr<AbstractIndex> IndexFactory::create_instance()
     size_t max_reserve_degree =
         (size_t)(defaults::GRAPH_SLACK_FACTOR * 1.05 *
                  (_config->index_write_params == nullptr ? 0 : _config->index_write_params->max_degree));
-    auto data_store = construct_datastore<data_type>(_config->data_strategy, num_points, dim, _config->metric);
+    std::unique_ptr<AbstractDataStore<data_type>> data_store;
+    if (_config->data_strategy == DataStoreStrategy::PQ)
+        data_store = construct_pq_datastore<data_type>(num_points, dim, _config->metric, _config->num_pq_chunks,
+                                                       _config->use_opq);
+    else
+        data_store = construct_datastore<data_type>(_config->data_strategy, num_points, dim, _config->metric,
+                                                    _config->rerank_data_file);
     auto graph_store = construct_graphstore(_config->graph_strategy, num_points, max_reserve_degree);
     return std::make_unique<diskann::Index<data_type, tag_type, label_type>>(*_config, std::move(data_store),
                                                                              std::move(graph_store));
@@ -159,11 +241,22 @@ std::unique_ptr<AbstractIndex> IndexFactory::create_instance(const std::string &
         throw ANNException("Error: unsupported label_type please choose from [uint/ushort]", -1);
 }
 
+template DISKANN_DLLEXPORT std::unique_ptr<Distance<uint8_t>> IndexFactory::construct_distance(Metric m);
+template DISKANN_DLLEXPORT std::unique_ptr<Distance<int8_t>> IndexFactory::construct_distance(Metric m);
+template DISKANN_DLLEXPORT std::unique_ptr<Distance<float>> IndexFactory::construct_distance(Metric m);
+
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<uint8_t>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, const std::string &rerank_data_file);
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<int8_t>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, const std::string &rerank_data_file);
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<float>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, const std::string &rerank_data_file);
+
+template DISKANN_DLLEXPORT std::unique_ptr<PQDataStore<uint8_t>> IndexFactory::construct_pq_datastore(
+    size_t num_points, size_t dimension, Metric m, size_t num_pq_chunks, bool use_opq);
+template DISKANN_DLLEXPORT std::unique_ptr<PQDataStore<int8_t>> IndexFactory::construct_pq_datastore(
+    size_t num_points, size_t dimension, Metric m, size_t num_pq_chunks, bool use_opq);
+template DISKANN_DLLEXPORT std::unique_ptr<PQDataStore<float>> IndexFactory::construct_pq_datastore(
+    size_t num_points, size_t dimension, Metric m, size_t num_pq_chunks, bool use_opq);
 
 } // namespace diskann
@@ -0,0 +1,450 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#if !defined(_WINDOWS) && defined(DISKANN_USE_IO_URING)
+
+#include "io_uring_aligned_file_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <liburing.h>
+#include <string>
+#include "ann_exception.h"
+#include "logger.h"
+#include "utils.h"
+
+// submission queue entries per ring, also the cap on reads in flight
+#define IO_URING_QUEUE_DEPTH 256
+// how long an idle SQPOLL thread keeps polling before it goes to sleep
+#define IO_URING_SQPOLL_IDLE_MS 2000
+
+struct IoUringAlignedFileReader::Ring
+{
+    struct io_uring ring;
+
+    // fd to put in requests, 0 once the file is registered as a fixed file
+    int fd = -1;
+    bool file_registered = false;
+    // open() the fd above belongs to, see IoUringAlignedFileReader::to_ring
+    uint64_t file_generation = 0;
+
+    // range registered with register_buffer, read with READ_FIXED
+    char *fixed_buf = nullptr;
+    uint64_t fixed_len = 0;
+
+    // reads queued and not yet reaped, by slot. a completion carries the
+    // slot of its read, plus one, as user data.
+    struct Request
+    {
+        void *buf;
+        uint64_t len;
+        bool async;
+    };
+    std::vector<Request> requests;
+    std::vector<uint32_t> free_requests;
+
+    // submit_reads requests queued and not yet reaped
+    uint64_t n_async_in_flight = 0;
+    // completions of submit_reads not yet returned by get_completed_reads,
+    // and the first error among them
+    std::vector<void *> async_completed;
+    std::string async_error;
+
+    // queues a read of req, async for submit_reads. returns false if the
+    // submission queue is full.
+    bool prep(const AlignedRead &req, bool async)
+    {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        if (sqe == nullptr)
+            return false;
+
+        if (free_requests.empty())
+        {
+            free_requests.push_back((uint32_t)requests.size());
+            requests.emplace_back();
+        }
+        const uint32_t slot = free_requests.back();
+        free_requests.pop_back();
+        requests[slot] = {req.buf, req.len, async};
+        if (async)
+            n_async_in_flight++;
+
+        char *buf = (char *)req.buf;
+        if (fixed_buf != nullptr && buf >= fixed_buf && buf + req.len <= fixed_buf + fixed_len)
+            io_uring_prep_read_fixed(sqe, fd, buf, (unsigned)req.len, req.offset, 0);
+        else
+            io_uring_prep_read(sqe, fd, buf, (unsigned)req.len, req.offset);
+
+        if (file_registered)
+            io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+        io_uring_sqe_set_data(sqe, (void *)(uintptr_t)(slot + 1));
+        return true;
+    }
+
+    // submits queued reads and waits for at least wait_nr completions
+    void submit_and_wait(unsigned wait_nr)
+    {
+        int ret;
+        do
+        {
+            ret = io_uring_submit_and_wait(&ring, wait_nr);
+        } while (ret == -EINTR || ret == -EAGAIN);
+
+        if (ret < 0)
+        {
+            std::stringstream stream;
+            stream << "io_uring_submit_and_wait() failed; returned " << ret << ", errno=" << -ret << "="
+                   << ::strerror(-ret);
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+    }
+
+    // consumes every available completion without blocking. returns the number
+    // of blocking reads completed, failed or not, and keeps why the first
+    // failed one did in sync_error. completed submit_reads requests are queued
+    // in async_completed, or their failure kept in async_error.
+    uint64_t reap(std::string &sync_error)
+    {
+        uint64_t n_sync = 0;
+        unsigned head, n_seen = 0;
+        struct io_uring_cqe *cqe;
+        io_uring_for_each_cqe(&ring, head, cqe)
+        {
+            n_seen++;
+            const uint32_t slot = (uint32_t)((uintptr_t)io_uring_cqe_get_data(cqe) - 1);
+            const Request request = requests[slot];
+            free_requests.push_back(slot);
+            if (request.async)
+                n_async_in_flight--;
+            else
+                n_sync++;
+            // a short read, e.g. past the end of the file, is a failure too
+            if (cqe->res != (int64_t)request.len)
+            {
+                std::string &error = request.async ? async_error : sync_error;
+                if (error.empty())
+                {
+                    std::stringstream stream;
+                    stream << "io_uring read of " << request.len << " bytes failed; returned " << cqe->res;
+                    if (cqe->res < 0)
+                        stream << ", errno=" << -cqe->res << "=" << ::strerror(-cqe->res);
+                    error = stream.str();
+                }
+                continue;
+            }
+            if (request.async)
+                async_completed.push_back(request.buf);
+        }
+        io_uring_cq_advance(&ring, n_seen);
+        return n_sync;
+    }
+
+    // waits until n_sync more blocking reads complete, failed or not, so that
+    // none is left writing into the buffers of a read that gave up. queued
+    // reads the kernel has not taken yet are submitted again. does not throw.
+    void wait_for_sync(uint64_t n_sync)
+    {
+        std::string ignored;
+        try
+        {
+            while (n_sync > 0)
+            {
+                submit_and_wait(1);
+                n_sync -= std::min(n_sync, reap(ignored));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            diskann::cerr << "io_uring failed while waiting for the reads of a failed read: " << e.what() << std::endl;
+        }
+    }
+};
+
+IoUringAlignedFileReader::IoUringAlignedFileReader(bool use_sqpoll) : _use_sqpoll(use_sqpoll)
+{
+    this->file_desc = -1;
+}
+
+IoUringAlignedFileReader::~IoUringAlignedFileReader()
+{
+    deregister_all_threads();
+    if (this->file_desc != -1)
+    {
+        std::cerr << "close() not called" << std::endl;
+        ::close(this->file_desc);
+    }
+}
+
+IoUringAlignedFileReader::Ring *IoUringAlignedFileReader::to_ring(io_context_t &ctx)
+{
+    assert(ctx != this->bad_ctx);
+    Ring *ring = reinterpret_cast<Ring *>(ctx);
+    // (re)register the file lazily from the thread using the ring, so open()
+    // does not need to know about the rings that exist
+    if (ring->file_generation != _file_generation.load(std::memory_order_acquire))
+    {
+        register_file(ring);
+    }
+    return ring;
+}
+
+void IoUringAlignedFileReader::register_file(Ring *ring)
+{
+    if (ring->file_registered)
+    {
+        io_uring_unregister_files(&ring->ring);
+        ring->file_registered = false;
+    }
+    ring->file_generation = _file_generation.load(std::memory_order_acquire);
+
+    int ret = io_uring_register_files(&ring->ring, &this->file_desc, 1);
+    if (ret < 0)
+    {
+        diskann::cerr << "io_uring_register_files() failed; returned " << ret << ", errno=" << -ret << ":"
+                      << ::strerror(-ret) << ", using the plain file descriptor" << std::endl;
+        ring->fd = this->file_desc;
+    }
+    else
+    {
+        ring->fd = 0;
+        ring->file_registered = true;
+    }
+}
+
+io_context_t IoUringAlignedFileReader::create_ctx()
+{
+    Ring *ring = new Ring();
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int wq_fd = _sqpoll_wq_fd.load();
+    if (_use_sqpoll)
+    {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = IO_URING_SQPOLL_IDLE_MS;
+        // share one poller thread between all rings of this reader
+        if (wq_fd != -1)
+        {
+            params.flags |= IORING_SETUP_ATTACH_WQ;
+            params.wq_fd = wq_fd;
+        }
+    }
+
+    int ret = io_uring_queue_init_params(IO_URING_QUEUE_DEPTH, &ring->ring, &params);
+    if (ret < 0 && _use_sqpoll)
+    {
+        // SQPOLL needs a 5.11+ kernel for unprivileged users
+        diskann::cerr << "io_uring SQPOLL setup failed; returned " << ret << ", errno=" << -ret << ":"
+                      << ::strerror(-ret) << ", falling back to syscall submission" << std::endl;
+        std::memset(&params, 0, sizeof(params));
+        ret = io_uring_queue_init_params(IO_URING_QUEUE_DEPTH, &ring->ring, &params);
+    }
+    if (ret < 0)
+    {
+        delete ring;
+        std::stringstream stream;
+        stream << "io_uring_queue_init() failed; returned " << ret << ", errno=" << -ret << ":" << ::strerror(-ret);
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    if (params.flags & IORING_SETUP_SQPOLL)
+    {
+        // first SQPOLL ring becomes the one later rings attach to
+        wq_fd = -1;
+        _sqpoll_wq_fd.compare_exchange_strong(wq_fd, ring->ring.ring_fd);
+    }
+    return reinterpret_cast<io_context_t>(ring);
+}
+
+void IoUringAlignedFileReader::destroy_ctx(io_context_t &ctx)
+{
+    Ring *ring = reinterpret_cast<Ring *>(ctx);
+    int wq_fd = ring->ring.ring_fd;
+    _sqpoll_wq_fd.compare_exchange_strong(wq_fd, -1);
+    // also drops the registered file and buffers
+    io_uring_queue_exit(&ring->ring);
+    delete ring;
+    ctx = this->bad_ctx;
+}
+
+io_context_t &IoUringAlignedFileReader::get_ctx()
+{
+    io_context_t *ctx = _thread_ctxs.find();
+    if (ctx == nullptr)
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    return *ctx;
+}
+
+void IoUringAlignedFileReader::register_thread()
+{
+    io_context_t *ctx = _thread_ctxs.register_thread();
+    if (ctx != nullptr)
+    {
+        diskann::cout << "allocating io_uring ctx: " << *ctx << " to thread-id:" << std::this_thread::get_id()
+                      << std::endl;
+    }
+}
+
+void IoUringAlignedFileReader::deregister_thread()
+{
+    _thread_ctxs.deregister_thread();
+}
+
+void IoUringAlignedFileReader::deregister_all_threads()
+{
+    _thread_ctxs.deregister_all_threads();
+}
+
+void IoUringAlignedFileReader::open(const std::string &fname)
+{
+    int flags = O_DIRECT | O_RDONLY | O_LARGEFILE;
+    this->file_desc = ::open(fname.c_str(), flags);
+    if (this->file_desc == -1)
+    {
+        std::stringstream stream;
+        stream << "Failed to open " << fname << ", errno=" << errno << ":" << ::strerror(errno);
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _file_generation++;
+    std::cerr << "Opened file : " << fname << std::endl;
+}
+
+void IoUringAlignedFileReader::close()
+{
+    // rings that registered the file keep it open until they are destroyed or
+    // see the next open()
+    if (this->file_desc != -1)
+    {
+        ::close(this->file_desc);
+        this->file_desc = -1;
+    }
+}
+
+void IoUringAlignedFileReader::register_buffer(io_context_t &ctx, void *buf, uint64_t len)
+{
+    Ring *ring = reinterpret_cast<Ring *>(ctx);
+    if (ring->fixed_buf != nullptr)
+    {
+        io_uring_unregister_buffers(&ring->ring);
+        ring->fixed_buf = nullptr;
+        ring->fixed_len = 0;
+    }
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    int ret = io_uring_register_buffers(&ring->ring, &iov, 1);
+    if (ret < 0)
+    {
+        // most likely RLIMIT_MEMLOCK, reads into buf still work unregistered
+        diskann::cerr << "io_uring_register_buffers() failed; returned " << ret << ", errno=" << -ret << ":"
+                      << ::strerror(-ret) << ", reading into unregistered buffers" << std::endl;
+        return;
+    }
+    ring->fixed_buf = (char *)buf;
+    ring->fixed_len = len;
+}
+
+void IoUringAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_context_t &ctx, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    assert(this->file_desc != -1);
+    Ring *ring = to_ring(ctx);
+
+    // once a read fails no more are queued, but the queued ones are waited
+    // for, as they write into the caller's buffers
+    uint64_t n_prepped = 0, n_done = 0;
+    std::string error;
+    try
+    {
+        while (n_done < n_prepped || (error.empty() && n_done < read_reqs.size()))
+        {
+            while (error.empty() && n_prepped < read_reqs.size() && n_prepped - n_done < IO_URING_QUEUE_DEPTH &&
+                   ring->prep(read_reqs[n_prepped], false))
+            {
+                n_prepped++;
+            }
+            ring->submit_and_wait(1);
+            n_done += ring->reap(error);
+        }
+    }
+    catch (const diskann::ANNException &)
+    {
+        // the reads that made it are writing into the caller's buffers, and
+        // their completions must not show up in the next batch
+        ring->wait_for_sync(n_prepped - n_done);
+        throw;
+    }
+    if (!error.empty())
+    {
+        throw diskann::ANNException(error, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
+void IoUringAlignedFileReader::submit_reads(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    Ring *ring = to_ring(ctx);
+    for (auto &req : read_reqs)
+    {
+        while (!ring->prep(req, true))
+        {
+            ring->submit_and_wait(0);
+        }
+    }
+    ring->submit_and_wait(0);
+}
+
+uint64_t IoUringAlignedFileReader::get_completed_reads(io_context_t &ctx, uint64_t min_completions,
+                                                       std::vector<void *> &completed_bufs)
+{
+    Ring *ring = to_ring(ctx);
+    // no blocking read is in flight outside of read
+    std::string sync_error;
+    ring->reap(sync_error);
+    while (ring->async_error.empty() && ring->n_async_in_flight > 0 && ring->async_completed.size() < min_completions)
+    {
+        ring->submit_and_wait((unsigned)(min_completions - ring->async_completed.size()));
+        ring->reap(sync_error);
+    }
+
+    if (!ring->async_error.empty())
+    {
+        std::string error;
+        error.swap(ring->async_error);
+        throw diskann::ANNException(error, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    const uint64_t n_done = ring->async_completed.size();
+    completed_bufs.insert(completed_bufs.end(), ring->async_completed.begin(), ring->async_completed.end());
+    ring->async_completed.clear();
+    return n_done;
+}
+
+void IoUringAlignedFileReader::drain_reads(io_context_t &ctx)
+{
+    Ring *ring = to_ring(ctx);
+    std::string ignored;
+    try
+    {
+        while (ring->n_async_in_flight > 0)
+        {
+            ring->submit_and_wait(1);
+            ring->reap(ignored);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        diskann::cerr << "io_uring failed while draining reads: " << e.what() << std::endl;
+    }
+    ring->async_completed.clear();
+    ring->async_error.clear();
+}
+
+#endif
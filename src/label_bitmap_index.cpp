@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "label_bitmap_index.h"
+
+namespace diskann
+{
+
+void RoaringBitmap::add(const uint32_t id)
+{
+    const uint16_t key = (uint16_t)(id >> 16);
+    const uint16_t low = (uint16_t)(id & 0xFFFF);
+
+    // ids added in increasing order always land in the last chunk
+    size_t pos;
+    if (!_keys.empty() && _keys.back() == key)
+    {
+        pos = _keys.size() - 1;
+    }
+    else
+    {
+        pos = std::lower_bound(_keys.begin(), _keys.end(), key) - _keys.begin();
+        if (pos == _keys.size() || _keys[pos] != key)
+        {
+            _keys.insert(_keys.begin() + pos, key);
+            _chunks.insert(_chunks.begin() + pos, Chunk());
+        }
+    }
+
+    Chunk &chunk = _chunks[pos];
+    if (!chunk.bits.empty())
+    {
+        uint64_t &word = chunk.bits[low >> 6];
+        const uint64_t bit = (uint64_t)1 << (low & 63);
+        if ((word & bit) == 0)
+        {
+            word |= bit;
+            chunk.cardinality++;
+        }
+        return;
+    }
+
+    auto it = chunk.array.end();
+    if (!chunk.array.empty() && chunk.array.back() >= low)
+    {
+        it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+        if (*it == low)
+            return;
+    }
+    chunk.array.insert(it, low);
+    chunk.cardinality++;
+
+    if (chunk.array.size() > MAX_ARRAY_SIZE)
+    {
+        chunk.bits.assign((1 << 16) / 64, 0);
+        for (auto x : chunk.array)
+            chunk.bits[x >> 6] |= (uint64_t)1 << (x & 63);
+        std::vector<uint16_t>().swap(chunk.array);
+    }
+}
+
+uint64_t RoaringBitmap::cardinality() const
+{
+    uint64_t total = 0;
+    for (const auto &chunk : _chunks)
+        total += chunk.cardinality;
+    return total;
+}
+
+uint64_t RoaringBitmap::memory_bytes() const
+{
+    uint64_t total = sizeof(RoaringBitmap) + _keys.capacity() * sizeof(uint16_t) + _chunks.capacity() * sizeof(Chunk);
+    for (const auto &chunk : _chunks)
+        total += chunk.array.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+    return total;
+}
+
+void RoaringBitmap::shrink_to_fit()
+{
+    _keys.shrink_to_fit();
+    _chunks.shrink_to_fit();
+    for (auto &chunk : _chunks)
+        chunk.array.shrink_to_fit();
+}
+
+template <typename LabelT> void LabelBitmapIndex<LabelT>::reset(const uint64_t num_points)
+{
+    _single_labels.assign(num_points, MULTIPLE_LABELS);
+    _label_to_bitmap.clear();
+    _bitmaps.clear();
+    _label_counts.clear();
+}
+
+template <typename LabelT>
+void LabelBitmapIndex<LabelT>::add_point(const uint32_t point, const LabelT *labels, const uint32_t num_labels)
+{
+    if (num_labels == 1 && labels[0] != MULTIPLE_LABELS)
+        _single_labels[point] = labels[0];
+
+    for (uint32_t i = 0; i < num_labels; i++)
+    {
+        auto it = _label_to_bitmap.find(labels[i]);
+        if (it == _label_to_bitmap.end())
+        {
+            it = _label_to_bitmap.insert({labels[i], (uint32_t)_bitmaps.size()}).first;
+            _bitmaps.emplace_back();
+            _label_counts.push_back(0);
+        }
+        _label_counts[it->second]++;
+        if (_single_labels[point] == MULTIPLE_LABELS)
+            _bitmaps[it->second].add(point);
+    }
+}
+
+template <typename LabelT> void LabelBitmapIndex<LabelT>::shrink_to_fit()
+{
+    _bitmaps.shrink_to_fit();
+    _label_counts.shrink_to_fit();
+    for (auto &bitmap : _bitmaps)
+        bitmap.shrink_to_fit();
+}
+
+template <typename LabelT>
+const RoaringBitmap *LabelBitmapIndex<LabelT>::multi_label_points(const LabelT &label) const
+{
+    const auto it = _label_to_bitmap.find(label);
+    return it == _label_to_bitmap.end() ? nullptr : &_bitmaps[it->second];
+}
+
+template <typename LabelT>
+void LabelBitmapIndex<LabelT>::get_label_counts(std::vector<LabelT> &labels, std::vector<uint64_t> &counts) const
+{
+    labels.clear();
+    counts.clear();
+    for (const auto &label_and_bitmap : _label_to_bitmap)
+    {
+        labels.push_back(label_and_bitmap.first);
+        counts.push_back(_label_counts[label_and_bitmap.second]);
+    }
+}
+
+template <typename LabelT> size_t LabelBitmapIndex<LabelT>::num_labels() const
+{
+    return _bitmaps.size();
+}
+
+template <typename LabelT> uint64_t LabelBitmapIndex<LabelT>::memory_bytes() const
+{
+    uint64_t total = _single_labels.capacity() * sizeof(LabelT) +
+                     _label_to_bitmap.bucket_count() * (sizeof(LabelT) + sizeof(uint32_t)) +
+                     _label_counts.capacity() * sizeof(uint64_t);
+    for (const auto &bitmap : _bitmaps)
+        total += bitmap.memory_bytes();
+    return total;
+}
+
+template class LabelBitmapIndex<uint32_t>;
+template class LabelBitmapIndex<uint16_t>;
+
+} // namespace diskann
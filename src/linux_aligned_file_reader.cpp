@@ -3,9 +3,12 @@
 
 #include "linux_aligned_file_reader.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <memory>
+#include <string>
 #include "tsl/robin_map.h"
 #include "utils.h"
 #define MAX_EVENTS 1024
@@ -15,7 +18,97 @@ namespace
 typedef struct io_event io_event_t;
 typedef struct iocb iocb_t;
 
-void execute_io(io_context_t ctx, int fd, std::vector<AlignedRead> &read_reqs, uint64_t n_retries = 0)
+// State of an IOContext of LinuxAlignedFileReader, which is an opaque handle
+// to it.
+struct AioContext
+{
+    io_context_t aio = 0;
+
+    // iocbs of the submit_reads requests in flight. io_event::obj points back
+    // to them, so a slot is only reused once its completion is reaped.
+    std::vector<iocb_t> async_cbs;
+    std::vector<uint32_t> free_async_cbs;
+
+    // completions of submit_reads that were reaped by a blocking read, and
+    // the first error among them
+    std::vector<void *> async_completed;
+    std::string async_error;
+
+    // iocbs of a submit_reads batch that failed part way. their reads are in
+    // flight, but the caller has dropped the batch, so they complete quietly.
+    std::vector<uint8_t> abandoned_cbs;
+    uint64_t num_abandoned = 0;
+
+    AioContext() : async_cbs(MAX_EVENTS), free_async_cbs(MAX_EVENTS), abandoned_cbs(MAX_EVENTS, 0)
+    {
+        for (uint32_t i = 0; i < MAX_EVENTS; i++)
+            free_async_cbs[i] = MAX_EVENTS - 1 - i;
+    }
+
+    uint64_t num_async_in_flight() const
+    {
+        return async_cbs.size() - free_async_cbs.size();
+    }
+
+    // if evt completes a submit_reads request, frees its iocb and queues its
+    // buf, or records why it failed, and returns true
+    bool complete_async(const io_event_t &evt)
+    {
+        if (evt.obj < async_cbs.data() || evt.obj >= async_cbs.data() + async_cbs.size())
+            return false;
+        const uint32_t slot = (uint32_t)(evt.obj - async_cbs.data());
+        free_async_cbs.push_back(slot);
+        if (abandoned_cbs[slot])
+        {
+            abandoned_cbs[slot] = 0;
+            num_abandoned--;
+            return true;
+        }
+        // a short read, e.g. past the end of the file, is a failure too
+        if ((int64_t)evt.res != (int64_t)evt.obj->u.c.nbytes)
+        {
+            if (async_error.empty())
+            {
+                std::stringstream stream;
+                stream << "async read of " << evt.obj->u.c.nbytes << " bytes into " << evt.data
+                       << " failed; returned " << (int64_t)evt.res;
+                async_error = stream.str();
+            }
+            return true;
+        }
+        async_completed.push_back(evt.data);
+        return true;
+    }
+};
+
+AioContext *to_aio(io_context_t ctx)
+{
+    return reinterpret_cast<AioContext *>(ctx);
+}
+
+// reaps completions until no abandoned read is in flight. other submit_reads
+// requests that complete meanwhile are queued as usual. does not throw.
+void wait_for_abandoned(AioContext *ctx)
+{
+    thread_local std::vector<io_event_t> evts(MAX_EVENTS);
+    while (ctx->num_abandoned > 0)
+    {
+        int64_t ret = io_getevents(ctx->aio, 1, MAX_EVENTS, evts.data(), nullptr);
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0)
+        {
+            diskann::cerr << "io_getevents() failed while waiting for the reads of a failed submit; returned " << ret
+                          << ", errno=" << -ret << "=" << ::strerror((int)-ret) << std::endl;
+            break;
+        }
+        for (int64_t i = 0; i < ret; i++)
+            ctx->complete_async(evts[i]);
+    }
+}
+
+void execute_io(AioContext *ctx, int fd, std::vector<AlignedRead> &read_reqs,
+                uint64_t n_retries = 0)
 {
 #ifdef DEBUG
     for (auto &req : read_reqs)
@@ -28,14 +121,19 @@ void execute_io(io_context_t ctx, int fd, std::vector<AlignedRead> &read_reqs, u
     }
 #endif
 
+    // per-thread buffers, reused across batches instead of allocated per call
+    thread_local std::vector<iocb_t *> cbs;
+    thread_local std::vector<io_event_t> evts;
+    thread_local std::vector<struct iocb> cb;
+
     // break-up requests into chunks of size MAX_EVENTS each
     uint64_t n_iters = ROUND_UP(read_reqs.size(), MAX_EVENTS) / MAX_EVENTS;
     for (uint64_t iter = 0; iter < n_iters; iter++)
     {
         uint64_t n_ops = std::min((uint64_t)read_reqs.size() - (iter * MAX_EVENTS), (uint64_t)MAX_EVENTS);
-        std::vector<iocb_t *> cbs(n_ops, nullptr);
-        std::vector<io_event_t> evts(n_ops);
-        std::vector<struct iocb> cb(n_ops);
+        cbs.resize(n_ops);
+        evts.resize(MAX_EVENTS);
+        cb.resize(n_ops);
         for (uint64_t j = 0; j < n_ops; j++)
         {
             io_prep_pread(cb.data() + j, fd, read_reqs[j + iter * MAX_EVENTS].buf, read_reqs[j + iter * MAX_EVENTS].len,
@@ -50,35 +148,74 @@ void execute_io(io_context_t ctx, int fd, std::vector<AlignedRead> &read_reqs, u
             cbs[i] = cb.data() + i;
         }
 
-        uint64_t n_tries = 0;
-        while (n_tries <= n_retries)
-        {
-            // issue reads
-            int64_t ret = io_submit(ctx, (int64_t)n_ops, cbs.data());
-            // if requests didn't get accepted
-            if (ret != (int64_t)n_ops)
-            {
-                std::cerr << "io_submit() failed; returned " << ret << ", expected=" << n_ops << ", ernno=" << errno
-                          << "=" << ::strerror(-ret) << ", try #" << n_tries + 1;
-                std::cout << "ctx: " << ctx << "\n";
-                exit(-1);
-            }
-            else
+        // waits on io_getevents until n_wait reads of the batch are back, and
+        // returns why the first failed one did. reads of submit_reads still in
+        // flight on ctx may complete in between, they are set aside for
+        // get_completed_reads.
+        auto wait_for = [&](uint64_t n_wait) {
+            uint64_t n_completed = 0;
+            std::string error;
+            while (n_completed < n_wait)
             {
-                // wait on io_getevents
-                ret = io_getevents(ctx, (int64_t)n_ops, (int64_t)n_ops, evts.data(), nullptr);
-                // if requests didn't complete
-                if (ret != (int64_t)n_ops)
+                int64_t ret = io_getevents(ctx->aio, 1, MAX_EVENTS, evts.data(), nullptr);
+                if (ret == -EINTR)
+                {
+                    continue;
+                }
+                if (ret < 0)
                 {
-                    std::cerr << "io_getevents() failed; returned " << ret << ", expected=" << n_ops
-                              << ", ernno=" << errno << "=" << ::strerror(-ret) << ", try #" << n_tries + 1;
-                    exit(-1);
+                    std::stringstream stream;
+                    stream << "io_getevents() failed; returned " << ret << ", expected=" << n_wait - n_completed
+                           << ", errno=" << -ret << "=" << ::strerror((int)-ret);
+                    throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
                 }
-                else
+                for (int64_t i = 0; i < ret; i++)
                 {
-                    break;
+                    if (ctx->complete_async(evts[i]))
+                        continue;
+                    n_completed++;
+                    const AlignedRead &req = read_reqs[iter * MAX_EVENTS + (evts[i].obj - cb.data())];
+                    if ((int64_t)evts[i].res != (int64_t)req.len && error.empty())
+                    {
+                        const int64_t res = (int64_t)evts[i].res;
+                        std::stringstream stream;
+                        stream << "read of " << req.len << " bytes at offset " << req.offset << " failed; returned "
+                               << res;
+                        if (res < 0)
+                            stream << ", errno=" << -res << "=" << ::strerror((int)-res);
+                        error = stream.str();
+                    }
                 }
             }
+            return error;
+        };
+
+        // issue reads, io_submit may accept only part of the batch
+        uint64_t n_submitted = 0, n_tries = 0;
+        while (n_submitted < n_ops)
+        {
+            int64_t ret = io_submit(ctx->aio, (int64_t)(n_ops - n_submitted), cbs.data() + n_submitted);
+            if (ret < 0 && (ret == -EAGAIN || ret == -EINTR) && n_tries++ < n_retries)
+            {
+                continue;
+            }
+            if (ret <= 0)
+            {
+                std::stringstream stream;
+                stream << "io_submit() failed; returned " << ret << ", expected=" << n_ops - n_submitted
+                       << ", errno=" << -ret << "=" << ::strerror((int)-ret) << ", ctx: " << ctx->aio;
+                // the accepted reads are writing into the caller's buffers,
+                // and their completions must not show up in the next batch
+                wait_for(n_submitted);
+                throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+            }
+            n_submitted += ret;
+        }
+
+        const std::string error = wait_for(n_ops);
+        if (!error.empty())
+        {
+            throw diskann::ANNException(error, -1, __FUNCSIG__, __FILE__, __LINE__);
         }
         // disabled since req.buf could be an offset into another buf
         /*
@@ -98,6 +235,7 @@ LinuxAlignedFileReader::LinuxAlignedFileReader()
 
 LinuxAlignedFileReader::~LinuxAlignedFileReader()
 {
+    deregister_all_threads();
     int64_t ret;
     // check to make sure file_desc is closed
     ret = ::fcntl(this->file_desc, F_GETFD);
@@ -118,78 +256,57 @@ LinuxAlignedFileReader::~LinuxAlignedFileReader()
     }
 }
 
+io_context_t LinuxAlignedFileReader::create_ctx()
+{
+    std::unique_ptr<AioContext> ctx(new AioContext());
+    int ret = io_setup(MAX_EVENTS, &ctx->aio);
+    if (ret != 0)
+    {
+        std::stringstream stream;
+        stream << "io_setup() failed; returned " << ret << ", errno=" << -ret << ":" << ::strerror(-ret)
+               << ". Consider raising /proc/sys/fs/aio-max-nr";
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return reinterpret_cast<io_context_t>(ctx.release());
+}
+
+void LinuxAlignedFileReader::destroy_ctx(io_context_t &ctx)
+{
+    AioContext *aio_ctx = to_aio(ctx);
+    // waits for the reads still in flight
+    io_destroy(aio_ctx->aio);
+    delete aio_ctx;
+    ctx = this->bad_ctx;
+}
+
 io_context_t &LinuxAlignedFileReader::get_ctx()
 {
-    std::unique_lock<std::mutex> lk(ctx_mut);
-    // perform checks only in DEBUG mode
-    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    io_context_t *ctx = _thread_ctxs.find();
+    if (ctx == nullptr)
     {
         std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
         return this->bad_ctx;
     }
-    else
-    {
-        return ctx_map[std::this_thread::get_id()];
-    }
+    return *ctx;
 }
 
 void LinuxAlignedFileReader::register_thread()
 {
-    auto my_id = std::this_thread::get_id();
-    std::unique_lock<std::mutex> lk(ctx_mut);
-    if (ctx_map.find(my_id) != ctx_map.end())
-    {
-        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
-        return;
-    }
-    io_context_t ctx = 0;
-    int ret = io_setup(MAX_EVENTS, &ctx);
-    if (ret != 0)
-    {
-        lk.unlock();
-        assert(errno != EAGAIN);
-        assert(errno != ENOMEM);
-        std::cerr << "io_setup() failed; returned " << ret << ", errno=" << errno << ":" << ::strerror(errno)
-                  << std::endl;
-    }
-    else
+    io_context_t *ctx = _thread_ctxs.register_thread();
+    if (ctx != nullptr)
     {
-        diskann::cout << "allocating ctx: " << ctx << " to thread-id:" << my_id << std::endl;
-        ctx_map[my_id] = ctx;
+        diskann::cout << "allocating ctx: " << *ctx << " to thread-id:" << std::this_thread::get_id() << std::endl;
     }
-    lk.unlock();
 }
 
 void LinuxAlignedFileReader::deregister_thread()
 {
-    auto my_id = std::this_thread::get_id();
-    std::unique_lock<std::mutex> lk(ctx_mut);
-    assert(ctx_map.find(my_id) != ctx_map.end());
-
-    lk.unlock();
-    io_context_t ctx = this->get_ctx();
-    io_destroy(ctx);
-    //  assert(ret == 0);
-    lk.lock();
-    ctx_map.erase(my_id);
-    std::cerr << "returned ctx from thread-id:" << my_id << std::endl;
-    lk.unlock();
+    _thread_ctxs.deregister_thread();
 }
 
 void LinuxAlignedFileReader::deregister_all_threads()
 {
-    std::unique_lock<std::mutex> lk(ctx_mut);
-    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
-    {
-        io_context_t ctx = x.value();
-        io_destroy(ctx);
-        //  assert(ret == 0);
-        //  lk.lock();
-        //  ctx_map.erase(my_id);
-        //  std::cerr << "returned ctx from thread-id:" << my_id << std::endl;
-    }
-    ctx_map.clear();
-    //  lk.unlock();
+    _thread_ctxs.deregister_all_threads();
 }
 
 void LinuxAlignedFileReader::open(const std::string &fname)
@@ -220,5 +337,116 @@ void LinuxAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_contex
         diskann::cout << "Async currently not supported in linux." << std::endl;
     }
     assert(this->file_desc != -1);
-    execute_io(ctx, this->file_desc, read_reqs);
+    execute_io(to_aio(ctx), this->file_desc, read_reqs);
+}
+
+void LinuxAlignedFileReader::submit_reads(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    AioContext *aio_ctx = to_aio(ctx);
+    if (read_reqs.size() > aio_ctx->free_async_cbs.size())
+    {
+        std::stringstream stream;
+        stream << "submit_reads() of " << read_reqs.size() << " reads with " << aio_ctx->num_async_in_flight()
+               << " in flight, at most " << MAX_EVENTS << " can be";
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    // the request's buf comes back in io_event::data
+    thread_local std::vector<iocb_t *> cb_ptrs;
+    cb_ptrs.resize(read_reqs.size());
+    for (uint64_t j = 0; j < read_reqs.size(); j++)
+    {
+        iocb_t *cb = aio_ctx->async_cbs.data() + aio_ctx->free_async_cbs.back();
+        aio_ctx->free_async_cbs.pop_back();
+        io_prep_pread(cb, this->file_desc, read_reqs[j].buf, read_reqs[j].len, read_reqs[j].offset);
+        cb->data = read_reqs[j].buf;
+        cb_ptrs[j] = cb;
+    }
+
+    uint64_t n_submitted = 0;
+    while (n_submitted < read_reqs.size())
+    {
+        int64_t ret = io_submit(aio_ctx->aio, (int64_t)(read_reqs.size() - n_submitted), cb_ptrs.data() + n_submitted);
+        if (ret <= 0)
+        {
+            // the requests that did not make it are not in flight
+            for (uint64_t j = n_submitted; j < read_reqs.size(); j++)
+                aio_ctx->free_async_cbs.push_back((uint32_t)(cb_ptrs[j] - aio_ctx->async_cbs.data()));
+            // those that did are writing into the caller's buffers, wait for
+            // them and drop their completions with the batch
+            for (uint64_t j = 0; j < n_submitted; j++)
+                aio_ctx->abandoned_cbs[cb_ptrs[j] - aio_ctx->async_cbs.data()] = 1;
+            aio_ctx->num_abandoned += n_submitted;
+            wait_for_abandoned(aio_ctx);
+
+            std::stringstream stream;
+            stream << "io_submit() failed; returned " << ret << ", expected=" << read_reqs.size() - n_submitted
+                   << ", errno=" << -ret << "=" << ::strerror((int)-ret);
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        n_submitted += ret;
+    }
+}
+
+uint64_t LinuxAlignedFileReader::get_completed_reads(io_context_t &ctx, uint64_t min_completions,
+                                                     std::vector<void *> &completed_bufs)
+{
+    AioContext *aio_ctx = to_aio(ctx);
+    thread_local std::vector<io_event_t> evts(MAX_EVENTS);
+    // takes the reads that are done already, then blocks for the rest of
+    // min_completions
+    struct timespec no_wait = {0, 0};
+    bool polled = false;
+    while (aio_ctx->async_error.empty() && aio_ctx->num_async_in_flight() > 0 &&
+           (!polled || aio_ctx->async_completed.size() < min_completions))
+    {
+        const bool block = aio_ctx->async_completed.size() < min_completions;
+        int64_t ret = io_getevents(aio_ctx->aio, block ? 1 : 0, MAX_EVENTS, evts.data(), block ? nullptr : &no_wait);
+        if (ret == -EINTR)
+            continue;
+        polled = true;
+        if (ret < 0)
+        {
+            std::stringstream stream;
+            stream << "io_getevents() failed; returned " << ret << ", expected at least " << min_completions
+                   << ", errno=" << -ret << "=" << ::strerror((int)-ret);
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        for (int64_t i = 0; i < ret; i++)
+            aio_ctx->complete_async(evts[i]);
+    }
+
+    if (!aio_ctx->async_error.empty())
+    {
+        std::string error;
+        error.swap(aio_ctx->async_error);
+        throw diskann::ANNException(error, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    const uint64_t n_done = aio_ctx->async_completed.size();
+    completed_bufs.insert(completed_bufs.end(), aio_ctx->async_completed.begin(), aio_ctx->async_completed.end());
+    aio_ctx->async_completed.clear();
+    return n_done;
+}
+
+void LinuxAlignedFileReader::drain_reads(io_context_t &ctx)
+{
+    AioContext *aio_ctx = to_aio(ctx);
+    thread_local std::vector<io_event_t> evts(MAX_EVENTS);
+    while (aio_ctx->num_async_in_flight() > 0)
+    {
+        int64_t ret = io_getevents(aio_ctx->aio, 1, MAX_EVENTS, evts.data(), nullptr);
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0)
+        {
+            diskann::cerr << "io_getevents() failed while draining reads; returned " << ret << ", errno=" << -ret
+                          << "=" << ::strerror((int)-ret) << std::endl;
+            break;
+        }
+        for (int64_t i = 0; i < ret; i++)
+            aio_ctx->complete_async(evts[i]);
+    }
+    aio_ctx->async_completed.clear();
+    aio_ctx->async_error.clear();
 }
@@ -0,0 +1,262 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstring>
+
+#include "huge_page_allocator.h"
+#include "node_cache.h"
+#include "utils.h"
+
+// upper bound on the number of independently locked shards
+#define NODE_CACHE_MAX_SHARDS 64
+// shards are only split off while each keeps at least this many records
+#define NODE_CACHE_MIN_SHARD_CAPACITY 256
+// rows of the count-min frequency sketch
+#define NODE_CACHE_SKETCH_DEPTH 4
+// counters per sketch row for every cached record
+#define NODE_CACHE_SKETCH_WIDTH_FACTOR 4
+// sketch counters saturate here, TinyLFU only needs to tell warm from hot
+#define NODE_CACHE_SKETCH_MAX_COUNT 15
+// the sketch is aged after this many accesses per cached record
+#define NODE_CACHE_SKETCH_SAMPLE_FACTOR 10
+// approximate RAM per record besides the record itself: slot id, CLOCK bit,
+// hash map entry and sketch counters
+#define NODE_CACHE_ENTRY_OVERHEAD 48
+
+namespace
+{
+inline uint64_t mix_hash(uint64_t x)
+{
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+} // namespace
+
+namespace diskann
+{
+
+struct NodeCache::Shard
+{
+    std::mutex mut;
+
+    // id -> slot, and the id, CLOCK reference bit and record of every slot
+    tsl::robin_map<uint64_t, uint32_t> slot_of;
+    std::vector<uint64_t> ids;
+    std::vector<uint8_t> referenced;
+    char *records = nullptr;
+    uint64_t record_len = 0;
+    uint32_t capacity = 0;
+    uint32_t size = 0;
+    uint32_t hand = 0;
+
+    // count-min sketch of recent access frequencies
+    std::vector<uint8_t> sketch;
+    uint64_t sketch_mask = 0;
+    uint64_t num_accesses = 0;
+    uint64_t sample_size = 0;
+
+    std::atomic<uint64_t> hits{0}, misses{0}, admitted{0}, rejected{0}, evicted{0};
+
+    Shard(uint32_t capacity, uint64_t record_len) : record_len(record_len), capacity(capacity)
+    {
+        ids.resize(capacity);
+        referenced.resize(capacity, 0);
+        slot_of.reserve(capacity);
+        // the aligned allocator takes whole multiples of the alignment
+        huge_page_alloc((void **)&records, ROUND_UP(std::max<uint64_t>(capacity * record_len, 1), 64), 64);
+
+        // a few counters per record keep collisions with one-off ids rare
+        uint64_t width = 16;
+        while (width < (uint64_t)NODE_CACHE_SKETCH_WIDTH_FACTOR * capacity)
+            width <<= 1;
+        sketch.resize(NODE_CACHE_SKETCH_DEPTH * width, 0);
+        sketch_mask = width - 1;
+        sample_size = (uint64_t)NODE_CACHE_SKETCH_SAMPLE_FACTOR * std::max<uint32_t>(capacity, 1);
+    }
+
+    ~Shard()
+    {
+        huge_page_free(records);
+    }
+
+    inline uint8_t *counter(uint64_t hash, uint32_t row)
+    {
+        const uint64_t h1 = hash & 0xffffffffULL, h2 = hash >> 32;
+        return sketch.data() + row * (sketch_mask + 1) + ((h1 + row * h2) & sketch_mask);
+    }
+
+    uint32_t frequency(uint64_t hash)
+    {
+        uint32_t freq = NODE_CACHE_SKETCH_MAX_COUNT;
+        for (uint32_t row = 0; row < NODE_CACHE_SKETCH_DEPTH; row++)
+            freq = std::min<uint32_t>(freq, *counter(hash, row));
+        return freq;
+    }
+
+    // conservative update: only the counters at the current minimum grow
+    void record_access(uint64_t hash)
+    {
+        const uint32_t freq = frequency(hash);
+        if (freq < NODE_CACHE_SKETCH_MAX_COUNT)
+        {
+            for (uint32_t row = 0; row < NODE_CACHE_SKETCH_DEPTH; row++)
+            {
+                uint8_t *c = counter(hash, row);
+                if (*c == freq)
+                    (*c)++;
+            }
+        }
+
+        if (++num_accesses >= sample_size)
+        {
+            // age the sketch so that old popularity fades out
+            for (auto &c : sketch)
+                c >>= 1;
+            num_accesses /= 2;
+        }
+    }
+
+    inline char *record(uint32_t slot)
+    {
+        return records + slot * record_len;
+    }
+};
+
+NodeCache::NodeCache(uint64_t ram_budget_bytes, uint64_t record_len) : _record_len(record_len)
+{
+    uint64_t capacity = ram_budget_bytes / (record_len + NODE_CACHE_ENTRY_OVERHEAD);
+    if (capacity == 0)
+        return;
+
+    const uint64_t num_shards =
+        std::max<uint64_t>(1, std::min<uint64_t>(NODE_CACHE_MAX_SHARDS, capacity / NODE_CACHE_MIN_SHARD_CAPACITY));
+    const uint32_t shard_capacity = (uint32_t)(capacity / num_shards);
+    for (uint64_t i = 0; i < num_shards; i++)
+    {
+        _shards.emplace_back(new Shard(shard_capacity, record_len));
+    }
+    _capacity = num_shards * shard_capacity;
+}
+
+NodeCache::~NodeCache()
+{
+}
+
+NodeCache::Shard &NodeCache::shard_of(uint64_t id) const
+{
+    return *_shards[mix_hash(id) % _shards.size()];
+}
+
+bool NodeCache::get(uint64_t id, char *out)
+{
+    if (_shards.empty())
+        return false;
+
+    Shard &shard = shard_of(id);
+    std::lock_guard<std::mutex> lock(shard.mut);
+    shard.record_access(mix_hash(~id));
+
+    auto iter = shard.slot_of.find(id);
+    if (iter == shard.slot_of.end())
+    {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    shard.referenced[iter->second] = 1;
+    std::memcpy(out, shard.record(iter->second), _record_len);
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool NodeCache::insert(uint64_t id, const char *record)
+{
+    if (_shards.empty())
+        return false;
+
+    Shard &shard = shard_of(id);
+    std::lock_guard<std::mutex> lock(shard.mut);
+    if (shard.slot_of.find(id) != shard.slot_of.end())
+    {
+        // another query read the same node concurrently
+        return false;
+    }
+
+    uint32_t slot;
+    if (shard.size < shard.capacity)
+    {
+        slot = shard.size++;
+    }
+    else
+    {
+        // CLOCK: give every referenced record a second chance
+        while (shard.referenced[shard.hand])
+        {
+            shard.referenced[shard.hand] = 0;
+            shard.hand = (shard.hand + 1) % shard.capacity;
+        }
+
+        // TinyLFU admission: only replace the victim with a more popular node
+        slot = shard.hand;
+        const uint64_t victim = shard.ids[slot];
+        if (shard.frequency(mix_hash(~id)) <= shard.frequency(mix_hash(~victim)))
+        {
+            shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        shard.slot_of.erase(victim);
+        shard.hand = (shard.hand + 1) % shard.capacity;
+        shard.evicted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.ids[slot] = id;
+    shard.referenced[slot] = 0;
+    std::memcpy(shard.record(slot), record, _record_len);
+    shard.slot_of[id] = slot;
+    shard.admitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+NodeCacheStats NodeCache::get_stats() const
+{
+    NodeCacheStats stats;
+    for (auto &shard : _shards)
+    {
+        stats.hits += shard->hits.load(std::memory_order_relaxed);
+        stats.misses += shard->misses.load(std::memory_order_relaxed);
+        stats.admitted += shard->admitted.load(std::memory_order_relaxed);
+        stats.rejected += shard->rejected.load(std::memory_order_relaxed);
+        stats.evicted += shard->evicted.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(shard->mut);
+        stats.num_cached += shard->size;
+    }
+    stats.capacity = _capacity;
+    return stats;
+}
+
+void NodeCache::reset_stats()
+{
+    for (auto &shard : _shards)
+    {
+        shard->hits = 0;
+        shard->misses = 0;
+        shard->admitted = 0;
+        shard->rejected = 0;
+        shard->evicted = 0;
+    }
+}
+
+uint64_t NodeCache::get_capacity() const
+{
+    return _capacity;
+}
+
+uint64_t NodeCache::get_record_len() const
+{
+    return _record_len;
+}
+
+} // namespace diskann
@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <omp.h>
+
+#ifdef DISKANN_USE_NUMA
+#include <numa.h>
+#endif
+
+#include "numa_replicas.h"
+#include "logger.h"
+
+namespace diskann
+{
+namespace
+{
+// node the calling thread was pinned to by a NumaThreadScheduler, -1 if none
+thread_local int scheduled_numa_node = -1;
+} // namespace
+
+uint32_t get_num_numa_nodes()
+{
+#ifdef DISKANN_USE_NUMA
+    if (numa_available() < 0)
+        return 1;
+    return (uint32_t)(numa_max_node() + 1);
+#else
+    return 1;
+#endif
+}
+
+bool pin_thread_to_numa_node(uint32_t numa_node)
+{
+#ifdef DISKANN_USE_NUMA
+    if (numa_available() < 0 || (int)numa_node > numa_max_node())
+        return false;
+    return numa_run_on_node((int)numa_node) == 0;
+#else
+    (void)numa_node;
+    return false;
+#endif
+}
+
+NumaThreadScheduler::NumaThreadScheduler(const uint32_t num_nodes) : _num_nodes(num_nodes == 0 ? 1 : num_nodes)
+{
+    if (_num_nodes > get_num_numa_nodes())
+    {
+        diskann::cout << "Asked for " << _num_nodes << " NUMA replicas on a machine with " << get_num_numa_nodes()
+                      << " NUMA nodes, threads of the extra replicas will not be pinned" << std::endl;
+    }
+}
+
+uint32_t NumaThreadScheduler::node_of_current_thread()
+{
+    if (scheduled_numa_node < 0)
+    {
+        const uint32_t node = _next_node.fetch_add(1) % _num_nodes;
+        pin_thread_to_numa_node(node);
+        scheduled_numa_node = (int)node;
+    }
+    return (uint32_t)scheduled_numa_node % _num_nodes;
+}
+
+void NumaThreadScheduler::pin_omp_threads(const uint32_t num_threads)
+{
+    if (_num_nodes == 1 || num_threads == 0)
+        return;
+
+#pragma omp parallel num_threads(num_threads)
+    {
+        const uint32_t node = (uint32_t)omp_get_thread_num() * _num_nodes / num_threads;
+        pin_thread_to_numa_node(node);
+        scheduled_numa_node = (int)node;
+    }
+}
+
+} // namespace diskann
@@ -0,0 +1,272 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "packed_data_store.h"
+#include "utils.h"
+
+// Number of vectors read from a data file at a time
+#define PACKED_STORE_READ_BLOCK 65536
+
+namespace diskann
+{
+
+template <typename data_t>
+PackedDataStore<data_t>::PackedDataStore(std::shared_ptr<PackedNodeStore> nodes,
+                                         std::unique_ptr<Distance<data_t>> distance_fn)
+    : AbstractDataStore<data_t>((location_t)nodes->capacity(), nodes->dim()), _nodes(std::move(nodes)),
+      _distance_fn(std::move(distance_fn))
+{
+    if (_nodes->element_size() != sizeof(data_t))
+    {
+        std::stringstream stream;
+        stream << "Packed rows hold elements of " << _nodes->element_size() << " bytes, the data store needs "
+               << sizeof(data_t) << "." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _aligned_dim = _nodes->vector_bytes() / sizeof(data_t);
+    _stride = _nodes->row_size() / sizeof(data_t);
+}
+
+template <typename data_t> size_t PackedDataStore<data_t>::get_aligned_dim() const
+{
+    return _aligned_dim;
+}
+
+template <typename data_t> size_t PackedDataStore<data_t>::get_alignment_factor() const
+{
+    return _distance_fn->get_required_alignment();
+}
+
+template <typename data_t> location_t PackedDataStore<data_t>::load(const std::string &filename)
+{
+    return populate_from_file(filename, 0);
+}
+
+template <typename data_t>
+location_t PackedDataStore<data_t>::populate_from_file(const std::string &filename, const size_t offset)
+{
+    if (!file_exists(filename))
+    {
+        std::stringstream stream;
+        stream << "ERROR: data file " << filename << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    size_t file_num_points, file_dim;
+    std::ifstream reader(filename, std::ios::binary);
+    get_bin_metadata_impl(reader, file_num_points, file_dim, offset);
+    if (file_dim != this->_dim)
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
+               << "but file has " << file_dim << " dimension." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (file_num_points > this->capacity())
+        this->resize((location_t)file_num_points);
+
+    const size_t block_size = std::min((size_t)PACKED_STORE_READ_BLOCK, std::max(file_num_points, (size_t)1));
+    std::vector<data_t> block(block_size * this->_dim);
+    reader.seekg(offset + 2 * sizeof(uint32_t), reader.beg);
+    for (size_t start = 0; start < file_num_points; start += block_size)
+    {
+        const size_t count = std::min(block_size, file_num_points - start);
+        reader.read((char *)block.data(), count * this->_dim * sizeof(data_t));
+        for (size_t i = 0; i < count; i++)
+            set_vector((location_t)(start + i), block.data() + i * this->_dim);
+    }
+    return (location_t)file_num_points;
+}
+
+template <typename data_t>
+size_t PackedDataStore<data_t>::save(const std::string &filename, const location_t num_points)
+{
+    std::ofstream writer;
+    open_file_to_write(writer, filename);
+    const int npts_i32 = (int)num_points, ndims_i32 = (int)this->_dim;
+    writer.write((char *)&npts_i32, sizeof(int));
+    writer.write((char *)&ndims_i32, sizeof(int));
+    for (location_t i = 0; i < num_points; i++)
+        writer.write((char *)vector(i), this->_dim * sizeof(data_t));
+    writer.close();
+    return 2 * sizeof(uint32_t) + (size_t)num_points * this->_dim * sizeof(data_t);
+}
+
+template <typename data_t> void PackedDataStore<data_t>::populate_data(const data_t *vectors, const location_t num_pts)
+{
+    if (num_pts > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Number of points " << num_pts << " is greater than the capacity of data store: " << this->capacity()
+           << ", which is fixed for a packed layout." << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    for (location_t i = 0; i < num_pts; i++)
+        set_vector(i, vectors + (size_t)i * this->_dim);
+}
+
+template <typename data_t> void PackedDataStore<data_t>::populate_data(const std::string &filename, const size_t offset)
+{
+    populate_from_file(filename, offset);
+}
+
+template <typename data_t>
+void PackedDataStore<data_t>::extract_data_to_bin(const std::string &filename, const location_t num_pts)
+{
+    save(filename, num_pts);
+}
+
+template <typename data_t> void PackedDataStore<data_t>::get_vector(const location_t i, data_t *target) const
+{
+    std::memcpy(target, vector(i), this->_dim * sizeof(data_t));
+}
+
+template <typename data_t> void PackedDataStore<data_t>::set_vector(const location_t loc, const data_t *const vector)
+{
+    data_t *target = this->vector(loc);
+    std::memset(target, 0, _aligned_dim * sizeof(data_t));
+    std::memcpy(target, vector, this->_dim * sizeof(data_t));
+    if (_distance_fn->preprocessing_required())
+    {
+        _distance_fn->preprocess_base_points(target, _aligned_dim, 1);
+    }
+}
+
+template <typename data_t> void PackedDataStore<data_t>::prefetch_vector(const location_t loc)
+{
+    diskann::prefetch_vector((const char *)vector(loc), _nodes->row_size());
+}
+
+template <typename data_t>
+void PackedDataStore<data_t>::move_vectors(const location_t old_location_start, const location_t new_location_start,
+                                           const location_t num_locations)
+{
+    if (num_locations == 0 || old_location_start == new_location_start)
+    {
+        return;
+    }
+
+    // The [start, end) interval which will contain obsolete points to be
+    // cleared, as in InMemDataStore::move_vectors.
+    uint32_t mem_clear_loc_start = old_location_start;
+    uint32_t mem_clear_loc_end_limit = old_location_start + num_locations;
+    if (new_location_start < old_location_start)
+    {
+        if (mem_clear_loc_start < new_location_start + num_locations)
+            mem_clear_loc_start = new_location_start + num_locations;
+    }
+    else
+    {
+        if (mem_clear_loc_end_limit > new_location_start)
+            mem_clear_loc_end_limit = new_location_start;
+    }
+
+    copy_vectors(old_location_start, new_location_start, num_locations);
+    for (location_t loc = mem_clear_loc_start; loc < mem_clear_loc_end_limit; loc++)
+        std::memset(vector(loc), 0, _aligned_dim * sizeof(data_t));
+}
+
+template <typename data_t>
+void PackedDataStore<data_t>::copy_vectors(const location_t from_loc, const location_t to_loc,
+                                           const location_t num_points)
+{
+    assert(from_loc < this->_capacity);
+    assert(to_loc < this->_capacity);
+    assert(num_points < this->_capacity);
+    // rows are interleaved with the graph, so copy vector by vector in the
+    // order that keeps overlapping ranges intact
+    if (to_loc < from_loc)
+    {
+        for (location_t i = 0; i < num_points; i++)
+            std::memcpy(vector(to_loc + i), vector(from_loc + i), _aligned_dim * sizeof(data_t));
+    }
+    else if (to_loc > from_loc)
+    {
+        for (location_t i = num_points; i > 0; i--)
+            std::memcpy(vector(to_loc + i - 1), vector(from_loc + i - 1), _aligned_dim * sizeof(data_t));
+    }
+}
+
+template <typename data_t>
+float PackedDataStore<data_t>::get_distance(const data_t *query, const location_t loc) const
+{
+    return _distance_fn->compare(query, vector(loc), (uint32_t)_aligned_dim);
+}
+
+template <typename data_t>
+float PackedDataStore<data_t>::get_distance(const location_t loc1, const location_t loc2) const
+{
+    return _distance_fn->compare(vector(loc1), vector(loc2), (uint32_t)_aligned_dim);
+}
+
+template <typename data_t>
+void PackedDataStore<data_t>::get_distance(const data_t *query, const location_t *locations,
+                                           const uint32_t location_count, float *distances) const
+{
+    _distance_fn->compare_batch(query, vector(0), _stride, locations, location_count, (uint32_t)_aligned_dim,
+                                distances);
+}
+
+template <typename data_t> location_t PackedDataStore<data_t>::calculate_medoid() const
+{
+    std::vector<float> center(_aligned_dim, 0);
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        const data_t *cur_vec = vector(i);
+        for (size_t j = 0; j < _aligned_dim; j++)
+            center[j] += (float)cur_vec[j];
+    }
+    for (size_t j = 0; j < _aligned_dim; j++)
+        center[j] /= (float)this->capacity();
+
+    location_t min_idx = 0;
+    float min_dist = std::numeric_limits<float>::max();
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        const data_t *cur_vec = vector(i);
+        float dist = 0;
+        for (size_t j = 0; j < _aligned_dim; j++)
+            dist += (center[j] - (float)cur_vec[j]) * (center[j] - (float)cur_vec[j]);
+        if (dist < min_dist)
+        {
+            min_idx = i;
+            min_dist = dist;
+        }
+    }
+    return min_idx;
+}
+
+template <typename data_t> Distance<data_t> *PackedDataStore<data_t>::get_dist_fn()
+{
+    return _distance_fn.get();
+}
+
+template <typename data_t> location_t PackedDataStore<data_t>::expand(const location_t new_size)
+{
+    if (new_size <= this->capacity())
+    {
+        return this->capacity();
+    }
+    std::stringstream ss;
+    ss << "Cannot expand a packed data store beyond its capacity " << this->capacity() << " to " << new_size
+       << ", the packed layout is read-only." << std::endl;
+    throw diskann::ANNException(ss.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+}
+
+template <typename data_t> location_t PackedDataStore<data_t>::shrink(const location_t new_size)
+{
+    // the rows are shared with the graph store, keep them all
+    return this->capacity();
+}
+
+template DISKANN_DLLEXPORT class PackedDataStore<float>;
+template DISKANN_DLLEXPORT class PackedDataStore<int8_t>;
+template DISKANN_DLLEXPORT class PackedDataStore<uint8_t>;
+
+} // namespace diskann
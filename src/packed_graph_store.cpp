@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+
+#include "packed_graph_store.h"
+#include "utils.h"
+
+namespace diskann
+{
+PackedGraphStore::PackedGraphStore(std::shared_ptr<PackedNodeStore> nodes)
+    : AbstractGraphStore(nodes->capacity(), nodes->max_degree()), _nodes(std::move(nodes))
+{
+    // the rows may already be filled, e.g. by PackedNodeStore::load
+    for (size_t i = 0; i < _nodes->capacity(); i++)
+    {
+        _max_observed_degree = (std::max)(_max_observed_degree, _nodes->adjacency((location_t)i)[0]);
+    }
+}
+
+std::tuple<uint32_t, uint32_t, size_t> PackedGraphStore::load(const std::string &index_path_prefix,
+                                                              const size_t num_points)
+{
+    size_t expected_file_size;
+    size_t file_frozen_pts;
+    uint32_t start, file_max_degree;
+
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(index_path_prefix, std::ios::binary);
+    in.read((char *)&expected_file_size, sizeof(size_t));
+    in.read((char *)&file_max_degree, sizeof(uint32_t));
+    in.read((char *)&start, sizeof(uint32_t));
+    in.read((char *)&file_frozen_pts, sizeof(size_t));
+    size_t vamana_metadata_size = sizeof(size_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(size_t);
+
+    diskann::cout << "Loading vamana graph " << index_path_prefix << " into the packed layout..." << std::flush;
+    if (num_points > _nodes->capacity() || file_max_degree > _nodes->max_degree())
+    {
+        std::stringstream stream;
+        stream << "Graph of " << num_points << " points with max degree " << file_max_degree
+               << " does not fit a packed layout of " << _nodes->capacity() << " points with max degree "
+               << _nodes->max_degree() << "." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    size_t bytes_read = vamana_metadata_size;
+    size_t cc = 0;
+    uint32_t nodes_read = 0;
+    while (bytes_read != expected_file_size)
+    {
+        uint32_t k;
+        in.read((char *)&k, sizeof(uint32_t));
+        if (nodes_read >= _nodes->capacity())
+        {
+            throw diskann::ANNException("Graph file has more points than the packed layout holds.", -1,
+                                        __FUNCSIG__, __FILE__, __LINE__);
+        }
+        check_degree(nodes_read, k);
+
+        uint32_t *adjacency = _nodes->adjacency(nodes_read);
+        adjacency[0] = k;
+        in.read((char *)(adjacency + 1), k * sizeof(uint32_t));
+        cc += k;
+        ++nodes_read;
+        bytes_read += sizeof(uint32_t) * ((size_t)k + 1);
+        _max_observed_degree = (std::max)(_max_observed_degree, k);
+    }
+
+    diskann::cout << "done. Index has " << nodes_read << " nodes and " << cc << " out-edges, _start is set to " << start
+                  << std::endl;
+    return std::make_tuple(nodes_read, start, file_frozen_pts);
+}
+
+int PackedGraphStore::store(const std::string &index_path_prefix, const size_t num_points,
+                            const size_t num_frozen_points, const uint32_t start)
+{
+    std::ofstream out;
+    open_file_to_write(out, index_path_prefix);
+
+    size_t file_offset = 0;
+    out.seekp(file_offset, out.beg);
+    size_t index_size = 24;
+    uint32_t max_degree = 0;
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&_max_observed_degree, sizeof(uint32_t));
+    uint32_t ep_u32 = start;
+    out.write((char *)&ep_u32, sizeof(uint32_t));
+    out.write((char *)&num_frozen_points, sizeof(size_t));
+
+    // Note: num_points = _nd + _num_frozen_points
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        // <degree, ids...> as laid out on disk
+        const uint32_t *adjacency = _nodes->adjacency(i);
+        uint32_t GK = adjacency[0];
+        out.write((char *)adjacency, (GK + 1) * sizeof(uint32_t));
+        max_degree = GK > max_degree ? GK : max_degree;
+        index_size += (size_t)(sizeof(uint32_t) * (GK + 1));
+    }
+    out.seekp(file_offset, out.beg);
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&max_degree, sizeof(uint32_t));
+    out.close();
+    return (int)index_size;
+}
+
+std::vector<location_t> PackedGraphStore::get_neighbours(const location_t i) const
+{
+    const uint32_t *adjacency = _nodes->adjacency(i);
+    return std::vector<location_t>(adjacency + 1, adjacency + 1 + adjacency[0]);
+}
+
+uint32_t PackedGraphStore::get_neighbours(const location_t i, std::vector<location_t> &out) const
+{
+    const uint32_t *adjacency = _nodes->adjacency(i);
+    out.assign(adjacency + 1, adjacency + 1 + adjacency[0]);
+    return adjacency[0];
+}
+
+NeighbourView PackedGraphStore::get_neighbours_view(const location_t i, std::vector<location_t> &) const
+{
+    const uint32_t *adjacency = _nodes->adjacency(i);
+    return NeighbourView{adjacency + 1, adjacency[0]};
+}
+
+uint32_t PackedGraphStore::get_degree(const location_t i) const
+{
+    return _nodes->adjacency(i)[0];
+}
+
+void PackedGraphStore::check_degree(const location_t i, const size_t degree) const
+{
+    if (degree > _nodes->max_degree())
+    {
+        std::stringstream stream;
+        stream << "Cannot give point #" << i << " " << degree << " neighbours, the packed layout holds at most "
+               << _nodes->max_degree() << " per point." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
+void PackedGraphStore::add_neighbour(const location_t i, location_t neighbour_id)
+{
+    uint32_t *adjacency = _nodes->adjacency(i);
+    check_degree(i, (size_t)adjacency[0] + 1);
+    adjacency[1 + adjacency[0]] = neighbour_id;
+    adjacency[0]++;
+    _max_observed_degree = (std::max)(_max_observed_degree, adjacency[0]);
+}
+
+void PackedGraphStore::clear_neighbours(const location_t i)
+{
+    _nodes->adjacency(i)[0] = 0;
+}
+
+void PackedGraphStore::swap_neighbours(const location_t a, location_t b)
+{
+    std::swap_ranges(_nodes->adjacency(a), _nodes->adjacency(a) + _nodes->max_degree() + 1, _nodes->adjacency(b));
+}
+
+void PackedGraphStore::set_neighbours(const location_t i, std::vector<location_t> &neighbours)
+{
+    check_degree(i, neighbours.size());
+    uint32_t *adjacency = _nodes->adjacency(i);
+    adjacency[0] = (uint32_t)neighbours.size();
+    if (!neighbours.empty())
+    {
+        std::memcpy(adjacency + 1, neighbours.data(), neighbours.size() * sizeof(location_t));
+    }
+    _max_observed_degree = (std::max)(_max_observed_degree, adjacency[0]);
+}
+
+size_t PackedGraphStore::resize_graph(const size_t new_size)
+{
+    if (new_size > _nodes->capacity())
+    {
+        std::stringstream stream;
+        stream << "Cannot resize a packed graph store of " << _nodes->capacity() << " points to " << new_size
+               << ", the packed layout is read-only." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return _nodes->capacity();
+}
+
+void PackedGraphStore::clear_graph()
+{
+    for (size_t i = 0; i < _nodes->capacity(); i++)
+    {
+        _nodes->adjacency((location_t)i)[0] = 0;
+    }
+}
+
+size_t PackedGraphStore::get_max_range_of_graph()
+{
+    return _nodes->max_degree();
+}
+
+uint32_t PackedGraphStore::get_max_observed_degree()
+{
+    return _max_observed_degree;
+}
+
+size_t PackedGraphStore::get_memory_in_bytes()
+{
+    // the adjacency part of the rows; the vectors account for the rest
+    return _nodes->capacity() * (_nodes->row_size() - _nodes->vector_bytes());
+}
+
+} // namespace diskann
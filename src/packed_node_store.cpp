@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+
+#include "huge_page_allocator.h"
+#include "packed_node_store.h"
+#include "utils.h"
+
+// Rows are rounded up to this many bytes so they never share a cache line
+#define PACKED_ROW_ALIGNMENT 64
+
+namespace diskann
+{
+PackedNodeStore::PackedNodeStore(const size_t capacity, const size_t dim, const size_t element_size,
+                                 const size_t vector_bytes, const size_t max_degree)
+    : _capacity(capacity), _dim(dim), _element_size(element_size), _vector_bytes(vector_bytes),
+      _max_degree(max_degree)
+{
+    if (vector_bytes % sizeof(uint32_t) != 0 || vector_bytes < dim * element_size)
+    {
+        std::stringstream stream;
+        stream << "Packed rows need room for " << dim << " elements of " << element_size
+               << " bytes in a multiple of 4 bytes, got " << vector_bytes << " bytes." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _row_size = ROUND_UP(vector_bytes + (max_degree + 1) * sizeof(uint32_t), PACKED_ROW_ALIGNMENT);
+    allocate();
+}
+
+PackedNodeStore::~PackedNodeStore()
+{
+    huge_page_free(_rows);
+}
+
+void PackedNodeStore::allocate()
+{
+    _allocated_bytes = (std::max)(_capacity, (size_t)1) * _row_size;
+    huge_page_alloc((void **)&_rows, _allocated_bytes, PACKED_ROW_ALIGNMENT);
+}
+
+PackedLayoutHeader PackedNodeStore::read_header(const std::string &filename)
+{
+    if (!file_exists(filename))
+    {
+        std::stringstream stream;
+        stream << "ERROR: packed index file " << filename << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    PackedLayoutHeader header;
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(filename, std::ios::binary);
+    in.read((char *)&header, sizeof(PackedLayoutHeader));
+    return header;
+}
+
+std::shared_ptr<PackedNodeStore> PackedNodeStore::load(const std::string &filename, const size_t capacity)
+{
+    const PackedLayoutHeader header = read_header(filename);
+    if (header.num_points > capacity)
+    {
+        std::stringstream stream;
+        stream << "ERROR: packed index file " << filename << " has " << header.num_points
+               << " points, more than the requested capacity " << capacity << "." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    auto store = std::make_shared<PackedNodeStore>(capacity, header.dim, header.element_size, header.vector_bytes,
+                                                   header.max_degree);
+    if (store->row_size() != header.row_size)
+    {
+        std::stringstream stream;
+        stream << "ERROR: packed index file " << filename << " has rows of " << header.row_size
+               << " bytes, expected " << store->row_size() << "." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    diskann::cout << "Loading packed index " << filename << " with " << header.num_points << " points of "
+                  << header.row_size << " bytes..." << std::flush;
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(filename, std::ios::binary);
+    in.seekg(sizeof(PackedLayoutHeader), in.beg);
+    in.read(store->_rows, header.num_points * header.row_size);
+    diskann::cout << "done." << std::endl;
+    return store;
+}
+
+size_t PackedNodeStore::save(const std::string &filename, const size_t num_points, const size_t num_frozen_points,
+                             const uint32_t start) const
+{
+    PackedLayoutHeader header;
+    header.num_points = num_points;
+    header.num_frozen_points = num_frozen_points;
+    header.start = start;
+    header.dim = _dim;
+    header.element_size = _element_size;
+    header.vector_bytes = _vector_bytes;
+    header.max_degree = _max_degree;
+    header.row_size = _row_size;
+
+    std::ofstream out;
+    open_file_to_write(out, filename);
+    out.write((char *)&header, sizeof(PackedLayoutHeader));
+    out.write(_rows, num_points * _row_size);
+    out.close();
+    return sizeof(PackedLayoutHeader) + num_points * _row_size;
+}
+
+} // namespace diskann
@@ -2,8 +2,10 @@
 // Licensed under the MIT license.
 
 #include "mkl.h"
+#include <immintrin.h>
 
 #include "pq.h"
+#include "huge_page_allocator.h"
 #include "partition.h"
 #include "math_utils.h"
 #include "tsl/robin_map.h"
@@ -23,7 +25,7 @@ FixedChunkPQTable::~FixedChunkPQTable()
     if (tables != nullptr)
         delete[] tables;
     if (tables_tr != nullptr)
-        delete[] tables_tr;
+        huge_page_free(tables_tr);
     if (chunk_offsets != nullptr)
         delete[] chunk_offsets;
     if (centroid != nullptr)
@@ -87,14 +89,15 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     diskann::load_bin<float>(pq_table_file, tables, nr, nc, file_offset_data[0]);
 #endif
 
-    if ((nr != NUM_PQ_CENTROIDS))
+    if (nr != NUM_PQ_CENTROIDS && nr != NUM_PQ_CENTROIDS_FAST_SCAN)
     {
         diskann::cout << "Error reading pq_pivots file " << pq_table_file << ". file_num_centers  = " << nr
-                      << " but expecting " << NUM_PQ_CENTROIDS << " centers";
+                      << " but expecting " << NUM_PQ_CENTROIDS << " or " << NUM_PQ_CENTROIDS_FAST_SCAN << " centers";
         throw diskann::ANNException("Error reading pq_pivots file at pivots data.", -1, __FUNCSIG__, __FILE__,
                                     __LINE__);
     }
 
+    this->num_centers = nr;
     this->ndims = nc;
 
 #ifdef EXEC_ENV_OLS
@@ -130,7 +133,7 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     }
 
     this->n_chunks = nr - 1;
-    diskann::cout << "Loaded PQ Pivots: #ctrs: " << NUM_PQ_CENTROIDS << ", #dims: " << this->ndims
+    diskann::cout << "Loaded PQ Pivots: #ctrs: " << this->num_centers << ", #dims: " << this->ndims
                   << ", #chunks: " << this->n_chunks << std::endl;
 
 #ifdef EXEC_ENV_OLS
@@ -150,13 +153,13 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
         use_rotation = true;
     }
 
-    // alloc and compute transpose
-    tables_tr = new float[256 * this->ndims];
-    for (size_t i = 0; i < 256; i++)
+    // alloc and compute transpose, every query reads all of it
+    huge_page_alloc((void **)&tables_tr, this->num_centers * this->ndims * sizeof(float), sizeof(float));
+    for (size_t i = 0; i < this->num_centers; i++)
     {
         for (size_t j = 0; j < this->ndims; j++)
         {
-            tables_tr[j * 256 + i] = tables[i * this->ndims + j];
+            tables_tr[j * this->num_centers + i] = tables[i * this->ndims + j];
         }
     }
 }
@@ -166,7 +169,17 @@ uint32_t FixedChunkPQTable::get_num_chunks()
     return static_cast<uint32_t>(n_chunks);
 }
 
-void FixedChunkPQTable::preprocess_query(float *query_vec)
+uint32_t FixedChunkPQTable::get_num_centers()
+{
+    return static_cast<uint32_t>(num_centers);
+}
+
+uint64_t FixedChunkPQTable::get_code_len()
+{
+    return num_centers == NUM_PQ_CENTROIDS_FAST_SCAN ? DIV_ROUND_UP(n_chunks, 2) : n_chunks;
+}
+
+void FixedChunkPQTable::preprocess_query(float *query_vec) const
 {
     for (uint32_t d = 0; d < ndims; d++)
     {
@@ -187,24 +200,65 @@ void FixedChunkPQTable::preprocess_query(float *query_vec)
 }
 
 // assumes pre-processed query
-void FixedChunkPQTable::populate_chunk_distances(const float *query_vec, float *dist_vec)
+void FixedChunkPQTable::populate_chunk_distances(const float *query_vec, float *dist_vec) const
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double diff = centers_dim_vec[idx] - (query_vec[j]);
                 chunk_dists[idx] += (float)(diff * diff);
             }
         }
     }
+    if (num_centers == NUM_PQ_CENTROIDS_FAST_SCAN)
+        quantize_fast_scan_tables(dist_vec);
+}
+
+// The uint8 tables follow the float ones: 16 entries per chunk, padded to an
+// even number of chunks, then the scale and bias that map a sum of entries
+// back to a distance. Every chunk is shifted by its minimum and all of them
+// share one scale, small enough that the sum over all chunks fits in uint16.
+void FixedChunkPQTable::quantize_fast_scan_tables(float *dist_vec) const
+{
+    const uint64_t n_padded_chunks = 2 * DIV_ROUND_UP(n_chunks, 2);
+    uint8_t *luts = (uint8_t *)(dist_vec + NUM_PQ_CENTROIDS_FAST_SCAN * n_chunks);
+    float *scale_bias = (float *)(luts + NUM_PQ_CENTROIDS_FAST_SCAN * n_padded_chunks);
+
+    float bias = 0, max_range = 0;
+    std::vector<float> chunk_mins(n_chunks);
+    for (size_t chunk = 0; chunk < n_chunks; chunk++)
+    {
+        const float *chunk_dists = dist_vec + NUM_PQ_CENTROIDS_FAST_SCAN * chunk;
+        const float min_dist = *std::min_element(chunk_dists, chunk_dists + NUM_PQ_CENTROIDS_FAST_SCAN);
+        const float max_dist = *std::max_element(chunk_dists, chunk_dists + NUM_PQ_CENTROIDS_FAST_SCAN);
+        chunk_mins[chunk] = min_dist;
+        bias += min_dist;
+        max_range = (std::max)(max_range, max_dist - min_dist);
+    }
+
+    const float max_entry = (float)(std::min)((uint64_t)255, (uint64_t)65535 / n_padded_chunks);
+    const float scale = max_range > 0 ? max_range / max_entry : 1.0f;
+    for (size_t chunk = 0; chunk < n_chunks; chunk++)
+    {
+        const float *chunk_dists = dist_vec + NUM_PQ_CENTROIDS_FAST_SCAN * chunk;
+        for (size_t idx = 0; idx < NUM_PQ_CENTROIDS_FAST_SCAN; idx++)
+        {
+            const float entry = std::round((chunk_dists[idx] - chunk_mins[chunk]) / scale);
+            luts[NUM_PQ_CENTROIDS_FAST_SCAN * chunk + idx] = (uint8_t)(std::min)(entry, max_entry);
+        }
+    }
+    memset(luts + NUM_PQ_CENTROIDS_FAST_SCAN * n_chunks, 0,
+           NUM_PQ_CENTROIDS_FAST_SCAN * (n_padded_chunks - n_chunks));
+    scale_bias[0] = scale;
+    scale_bias[1] = bias;
 }
 
 float FixedChunkPQTable::l2_distance(const float *query_vec, uint8_t *base_vec)
@@ -214,7 +268,7 @@ float FixedChunkPQTable::l2_distance(const float *query_vec, uint8_t *base_vec)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] - (query_vec[j]);
             res += diff * diff;
         }
@@ -229,7 +283,7 @@ float FixedChunkPQTable::inner_product(const float *query_vec, uint8_t *base_vec
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] * query_vec[j]; // assumes centroid is 0 to
                                                                           // prevent translation errors
             res += diff;
@@ -239,31 +293,94 @@ float FixedChunkPQTable::inner_product(const float *query_vec, uint8_t *base_vec
                  // conversion)
 }
 
-// assumes no rotation is involved
-void FixedChunkPQTable::inflate_vector(uint8_t *base_vec, float *out_vec)
+void FixedChunkPQTable::inflate_vector(const uint8_t *base_vec, float *out_vec) const
 {
+    std::vector<float> rotated(use_rotation ? ndims : 0);
+    float *centered = use_rotation ? rotated.data() : out_vec;
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            out_vec[j] = centers_dim_vec[base_vec[chunk]] + centroid[j];
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            centered[j] = centers_dim_vec[base_vec[chunk]];
         }
     }
+    // preprocess_query multiplies by rotmat_tr, which is orthonormal, so its
+    // transpose undoes the rotation
+    if (use_rotation)
+    {
+        for (uint64_t d1 = 0; d1 < ndims; d1++)
+        {
+            float sum = 0;
+            for (uint64_t d = 0; d < ndims; d++)
+            {
+                sum += rotated[d] * rotmat_tr[d1 * ndims + d];
+            }
+            out_vec[d1] = sum;
+        }
+    }
+    for (uint64_t j = 0; j < ndims; j++)
+    {
+        out_vec[j] += centroid[j];
+    }
+}
+
+void FixedChunkPQTable::compress_vector(const float *vec, uint8_t *out_code) const
+{
+    std::vector<float> processed(vec, vec + ndims);
+    preprocess_query(processed.data());
+    for (size_t chunk = 0; chunk < n_chunks; chunk++)
+    {
+        uint32_t best_center = 0;
+        float best_dist = std::numeric_limits<float>::max();
+        for (uint32_t idx = 0; idx < num_centers; idx++)
+        {
+            float dist = 0;
+            for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
+            {
+                float diff = tables[idx * ndims + j] - processed[j];
+                dist += diff * diff;
+            }
+            if (dist < best_dist)
+            {
+                best_dist = dist;
+                best_center = idx;
+            }
+        }
+        out_code[chunk] = (uint8_t)best_center;
+    }
+}
+
+float FixedChunkPQTable::symmetric_l2_distance(const uint8_t *code_a, const uint8_t *code_b) const
+{
+    float res = 0;
+    for (size_t chunk = 0; chunk < n_chunks; chunk++)
+    {
+        if (code_a[chunk] == code_b[chunk])
+            continue;
+        const float *center_a = tables + code_a[chunk] * ndims;
+        const float *center_b = tables + code_b[chunk] * ndims;
+        for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
+        {
+            float diff = center_a[j] - center_b[j];
+            res += diff * diff;
+        }
+    }
+    return res;
 }
 
 void FixedChunkPQTable::populate_chunk_inner_products(const float *query_vec, float *dist_vec)
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double prod = centers_dim_vec[idx] * query_vec[j]; // assumes that we are not
                                                                    // shifting the vectors to
@@ -278,34 +395,14 @@ void FixedChunkPQTable::populate_chunk_inner_products(const float *query_vec, fl
 
 void aggregate_coords(const std::vector<uint32_t> &ids, const uint8_t *all_coords, const size_t ndims, uint8_t *out)
 {
-    for (size_t i = 0; i < ids.size(); i++)
-    {
-        memcpy(out + i * ndims, all_coords + ids[i] * ndims, ndims * sizeof(uint8_t));
-    }
+    aggregate_coords(ids.data(), ids.size(), all_coords, ndims, out);
 }
 
 void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_nchunks, const float *pq_dists,
                     std::vector<float> &dists_out)
 {
-    //_mm_prefetch((char*) dists_out, _MM_HINT_T0);
-    _mm_prefetch((char *)pq_ids, _MM_HINT_T0);
-    _mm_prefetch((char *)(pq_ids + 64), _MM_HINT_T0);
-    _mm_prefetch((char *)(pq_ids + 128), _MM_HINT_T0);
-    dists_out.clear();
-    dists_out.resize(n_pts, 0);
-    for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
-    {
-        const float *chunk_dists = pq_dists + 256 * chunk;
-        if (chunk < pq_nchunks - 1)
-        {
-            _mm_prefetch((char *)(chunk_dists + 256), _MM_HINT_T0);
-        }
-        for (size_t idx = 0; idx < n_pts; idx++)
-        {
-            uint8_t pq_centerid = pq_ids[pq_nchunks * idx + chunk];
-            dists_out[idx] += chunk_dists[pq_centerid];
-        }
-    }
+    dists_out.resize(n_pts);
+    pq_dist_lookup(pq_ids, n_pts, pq_nchunks, pq_dists, dists_out.data());
 }
 
 // Need to replace calls to these functions with calls to vector& based
@@ -313,9 +410,18 @@ void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_n
 void aggregate_coords(const uint32_t *ids, const size_t n_ids, const uint8_t *all_coords, const size_t ndims,
                       uint8_t *out)
 {
+    if (n_ids == 0)
+        return;
+    const uint64_t block_len = ndims * PQ_TRANSPOSED_BLOCK;
+    memset(out + (DIV_ROUND_UP(n_ids, PQ_TRANSPOSED_BLOCK) - 1) * block_len, 0, block_len);
     for (size_t i = 0; i < n_ids; i++)
     {
-        memcpy(out + i * ndims, all_coords + ids[i] * ndims, ndims * sizeof(uint8_t));
+        const uint8_t *code = all_coords + ids[i] * ndims;
+        uint8_t *block = out + (i / PQ_TRANSPOSED_BLOCK) * block_len + (i % PQ_TRANSPOSED_BLOCK);
+        for (size_t chunk = 0; chunk < ndims; chunk++)
+        {
+            block[chunk * PQ_TRANSPOSED_BLOCK] = code[chunk];
+        }
     }
 }
 
@@ -326,18 +432,131 @@ void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_n
     _mm_prefetch((char *)pq_ids, _MM_HINT_T0);
     _mm_prefetch((char *)(pq_ids + 64), _MM_HINT_T0);
     _mm_prefetch((char *)(pq_ids + 128), _MM_HINT_T0);
-    memset(dists_out, 0, n_pts * sizeof(float));
-    for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
+    float sums[PQ_TRANSPOSED_BLOCK];
+    for (size_t start = 0; start < n_pts; start += PQ_TRANSPOSED_BLOCK)
+    {
+        const uint8_t *block = pq_ids + (start / PQ_TRANSPOSED_BLOCK) * pq_nchunks * PQ_TRANSPOSED_BLOCK;
+#ifdef USE_AVX2
+        __m256 low_sums = _mm256_setzero_ps();
+        __m256 high_sums = _mm256_setzero_ps();
+        for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
+        {
+            const float *chunk_dists = pq_dists + 256 * chunk;
+            if (chunk < pq_nchunks - 1)
+            {
+                _mm_prefetch((char *)(chunk_dists + 256), _MM_HINT_T0);
+            }
+            const __m128i codes = _mm_loadu_si128((const __m128i *)(block + chunk * PQ_TRANSPOSED_BLOCK));
+            const __m256i low_codes = _mm256_cvtepu8_epi32(codes);
+            const __m256i high_codes = _mm256_cvtepu8_epi32(_mm_srli_si128(codes, 8));
+            low_sums = _mm256_add_ps(low_sums, _mm256_i32gather_ps(chunk_dists, low_codes, sizeof(float)));
+            high_sums = _mm256_add_ps(high_sums, _mm256_i32gather_ps(chunk_dists, high_codes, sizeof(float)));
+        }
+        _mm256_storeu_ps(sums, low_sums);
+        _mm256_storeu_ps(sums + PQ_TRANSPOSED_BLOCK / 2, high_sums);
+#else
+        memset(sums, 0, sizeof(sums));
+        for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
+        {
+            const float *chunk_dists = pq_dists + 256 * chunk;
+            if (chunk < pq_nchunks - 1)
+            {
+                _mm_prefetch((char *)(chunk_dists + 256), _MM_HINT_T0);
+            }
+            const uint8_t *codes = block + chunk * PQ_TRANSPOSED_BLOCK;
+            for (size_t i = 0; i < PQ_TRANSPOSED_BLOCK; i++)
+            {
+                sums[i] += chunk_dists[codes[i]];
+            }
+        }
+#endif
+        const size_t block_pts = (std::min)((size_t)PQ_TRANSPOSED_BLOCK, n_pts - start);
+        memcpy(dists_out + start, sums, block_pts * sizeof(float));
+    }
+}
+
+void aggregate_coords_fast_scan(const uint32_t *ids, const uint64_t n_ids, const uint8_t *all_coords,
+                                const uint64_t n_chunks, uint8_t *out)
+{
+    if (n_ids == 0)
+        return;
+    const uint64_t code_len = DIV_ROUND_UP(n_chunks, 2);
+    const uint64_t block_len = code_len * PQ_FAST_SCAN_BLOCK;
+    // the points past n_ids in the last block are scanned too
+    memset(out + (DIV_ROUND_UP(n_ids, PQ_FAST_SCAN_BLOCK) - 1) * block_len, 0, block_len);
+    for (size_t i = 0; i < n_ids; i++)
     {
-        const float *chunk_dists = pq_dists + 256 * chunk;
-        if (chunk < pq_nchunks - 1)
+        const uint8_t *code = all_coords + ids[i] * code_len;
+        uint8_t *block = out + (i / PQ_FAST_SCAN_BLOCK) * block_len + (i % PQ_FAST_SCAN_BLOCK);
+        for (size_t j = 0; j < code_len; j++)
+        {
+            block[j * PQ_FAST_SCAN_BLOCK] = code[j];
+        }
+    }
+}
+
+void pq_dist_lookup_fast_scan(const uint8_t *pq_blocks, const size_t n_pts, const size_t pq_nchunks,
+                              const float *pq_dists, float *dists_out)
+{
+    // tables as laid out by FixedChunkPQTable::quantize_fast_scan_tables
+    const uint64_t code_len = DIV_ROUND_UP(pq_nchunks, 2);
+    const uint8_t *luts = (const uint8_t *)(pq_dists + NUM_PQ_CENTROIDS_FAST_SCAN * pq_nchunks);
+    const float *scale_bias = (const float *)(luts + 2 * NUM_PQ_CENTROIDS_FAST_SCAN * code_len);
+    const float scale = scale_bias[0], bias = scale_bias[1];
+
+    uint16_t sums[PQ_FAST_SCAN_BLOCK];
+    for (size_t start = 0; start < n_pts; start += PQ_FAST_SCAN_BLOCK)
+    {
+        const uint8_t *block = pq_blocks + (start / PQ_FAST_SCAN_BLOCK) * code_len * PQ_FAST_SCAN_BLOCK;
+#ifdef USE_AVX2
+        // each code byte selects from the tables of two chunks with pshufb.
+        // The uint8 results are summed in uint16 lanes, the even points in
+        // the low byte of a lane and the odd ones in the high byte.
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+        const __m256i low_byte_mask = _mm256_set1_epi16(0x00ff);
+        __m256i even_sums = _mm256_setzero_si256();
+        __m256i odd_sums = _mm256_setzero_si256();
+        for (size_t j = 0; j < code_len; j++)
+        {
+            const __m256i codes = _mm256_loadu_si256((const __m256i *)(block + j * PQ_FAST_SCAN_BLOCK));
+            const __m256i low_codes = _mm256_and_si256(codes, nibble_mask);
+            const __m256i high_codes = _mm256_and_si256(_mm256_srli_epi16(codes, 4), nibble_mask);
+            const uint8_t *pair_luts = luts + 2 * NUM_PQ_CENTROIDS_FAST_SCAN * j;
+            const __m256i low_lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)pair_luts));
+            const __m256i high_lut = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)(pair_luts + NUM_PQ_CENTROIDS_FAST_SCAN)));
+            const __m256i low_dists = _mm256_shuffle_epi8(low_lut, low_codes);
+            const __m256i high_dists = _mm256_shuffle_epi8(high_lut, high_codes);
+
+            even_sums = _mm256_add_epi16(even_sums, _mm256_and_si256(low_dists, low_byte_mask));
+            even_sums = _mm256_add_epi16(even_sums, _mm256_and_si256(high_dists, low_byte_mask));
+            odd_sums = _mm256_add_epi16(odd_sums, _mm256_srli_epi16(low_dists, 8));
+            odd_sums = _mm256_add_epi16(odd_sums, _mm256_srli_epi16(high_dists, 8));
+        }
+        uint16_t even[PQ_FAST_SCAN_BLOCK / 2], odd[PQ_FAST_SCAN_BLOCK / 2];
+        _mm256_storeu_si256((__m256i *)even, even_sums);
+        _mm256_storeu_si256((__m256i *)odd, odd_sums);
+        for (size_t i = 0; i < PQ_FAST_SCAN_BLOCK / 2; i++)
         {
-            _mm_prefetch((char *)(chunk_dists + 256), _MM_HINT_T0);
+            sums[2 * i] = even[i];
+            sums[2 * i + 1] = odd[i];
         }
-        for (size_t idx = 0; idx < n_pts; idx++)
+#else
+        memset(sums, 0, sizeof(sums));
+        for (size_t j = 0; j < code_len; j++)
+        {
+            const uint8_t *pair_luts = luts + 2 * NUM_PQ_CENTROIDS_FAST_SCAN * j;
+            for (size_t i = 0; i < PQ_FAST_SCAN_BLOCK; i++)
+            {
+                const uint8_t code = block[j * PQ_FAST_SCAN_BLOCK + i];
+                sums[i] += pair_luts[code & 0x0f] + pair_luts[NUM_PQ_CENTROIDS_FAST_SCAN + (code >> 4)];
+            }
+        }
+#endif
+        const size_t block_pts = (std::min)((size_t)PQ_FAST_SCAN_BLOCK, n_pts - start);
+        for (size_t i = 0; i < block_pts; i++)
         {
-            uint8_t pq_centerid = pq_ids[pq_nchunks * idx + chunk];
-            dists_out[idx] += chunk_dists[pq_centerid];
+            dists_out[start + i] = bias + scale * sums[i];
         }
     }
 }
@@ -802,10 +1021,11 @@ int generate_pq_data_from_pivots(const std::string &data_file, uint32_t num_cent
     }
 
     std::ofstream compressed_file_writer(pq_compressed_vectors_path, std::ios::binary);
-    uint32_t num_pq_chunks_u32 = num_pq_chunks;
+    const bool pack_codes = num_centers == NUM_PQ_CENTROIDS_FAST_SCAN;
+    uint32_t code_len_u32 = pack_codes ? (uint32_t)DIV_ROUND_UP(num_pq_chunks, 2) : num_pq_chunks;
 
     compressed_file_writer.write((char *)&num_points, sizeof(uint32_t));
-    compressed_file_writer.write((char *)&num_pq_chunks_u32, sizeof(uint32_t));
+    compressed_file_writer.write((char *)&code_len_u32, sizeof(uint32_t));
 
     size_t block_size = num_points <= BLOCK_SIZE ? num_points : BLOCK_SIZE;
 
@@ -909,6 +1129,20 @@ int generate_pq_data_from_pivots(const std::string &data_file, uint32_t num_cent
             compressed_file_writer.write((char *)(block_compressed_base.get()),
                                          cur_blk_size * num_pq_chunks * sizeof(uint32_t));
         }
+        else if (pack_codes)
+        {
+            std::unique_ptr<uint8_t[]> pVec = std::make_unique<uint8_t[]>(cur_blk_size * code_len_u32);
+            std::memset(pVec.get(), 0, cur_blk_size * code_len_u32);
+            for (size_t j = 0; j < cur_blk_size; j++)
+            {
+                for (size_t i = 0; i < num_pq_chunks; i++)
+                {
+                    pVec[j * code_len_u32 + i / 2] |=
+                        (uint8_t)(block_compressed_base[j * num_pq_chunks + i] << (4 * (i % 2)));
+                }
+            }
+            compressed_file_writer.write((char *)(pVec.get()), cur_blk_size * code_len_u32 * sizeof(uint8_t));
+        }
         else
         {
             std::unique_ptr<uint8_t[]> pVec = std::make_unique<uint8_t[]>(cur_blk_size * num_pq_chunks);
@@ -965,7 +1199,7 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, diskann::Metric compareMetric,
                              const double p_val, const size_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix)
+                             const std::string &codebook_prefix, const uint32_t num_pq_centers)
 {
     size_t train_size, train_dim;
     float *train_data;
@@ -983,12 +1217,12 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
 
         if (!use_opq)
         {
-            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, num_pq_centers, (uint32_t)num_pq_chunks,
                                NUM_KMEANS_REPS_PQ, pq_pivots_path, make_zero_mean);
         }
         else
         {
-            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, num_pq_centers, (uint32_t)num_pq_chunks,
                                 pq_pivots_path, make_zero_mean);
         }
         delete[] train_data;
@@ -997,7 +1231,7 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
     {
         diskann::cout << "Skip Training with predefined pivots in: " << pq_pivots_path << std::endl;
     }
-    generate_pq_data_from_pivots<T>(data_file_to_use, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks, pq_pivots_path,
+    generate_pq_data_from_pivots<T>(data_file_to_use, num_pq_centers, (uint32_t)num_pq_chunks, pq_pivots_path,
                                     pq_compressed_vectors_path, use_opq);
 }
 
@@ -1041,19 +1275,22 @@ template DISKANN_DLLEXPORT void generate_quantized_data<int8_t>(const std::strin
                                                                 const std::string &pq_compressed_vectors_path,
                                                                 diskann::Metric compareMetric, const double p_val,
                                                                 const size_t num_pq_chunks, const bool use_opq,
-                                                                const std::string &codebook_prefix);
+                                                                const std::string &codebook_prefix,
+                                                                const uint32_t num_pq_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<uint8_t>(const std::string &data_file_to_use,
                                                                  const std::string &pq_pivots_path,
                                                                  const std::string &pq_compressed_vectors_path,
                                                                  diskann::Metric compareMetric, const double p_val,
                                                                  const size_t num_pq_chunks, const bool use_opq,
-                                                                 const std::string &codebook_prefix);
+                                                                 const std::string &codebook_prefix,
+                                                                 const uint32_t num_pq_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<float>(const std::string &data_file_to_use,
                                                                const std::string &pq_pivots_path,
                                                                const std::string &pq_compressed_vectors_path,
                                                                diskann::Metric compareMetric, const double p_val,
                                                                const size_t num_pq_chunks, const bool use_opq,
-                                                               const std::string &codebook_prefix);
+                                                               const std::string &codebook_prefix,
+                                                               const uint32_t num_pq_centers);
 } // namespace diskann
@@ -0,0 +1,546 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "huge_page_allocator.h"
+#include "pq_data_store.h"
+#include "defaults.h"
+#include "utils.h"
+
+// points read per block when populating from a file
+#define PQ_STORE_READ_BLOCK 65536
+
+namespace
+{
+template <typename data_t> data_t from_float(const float value)
+{
+    if (std::is_floating_point<data_t>::value)
+        return (data_t)value;
+    const float rounded = std::round(value);
+    return (data_t)std::min((float)std::numeric_limits<data_t>::max(),
+                            std::max((float)std::numeric_limits<data_t>::lowest(), rounded));
+}
+
+float l2(const float *a, const float *b, const size_t dim)
+{
+    float sum = 0;
+    for (size_t d = 0; d < dim; d++)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+} // namespace
+
+namespace diskann
+{
+
+template <typename data_t>
+PQDataStore<data_t>::PQDataStore(const location_t capacity, const size_t dim, const size_t num_pq_chunks,
+                                 const bool use_opq, std::unique_ptr<Distance<data_t>> distance_fn)
+    : AbstractDataStore<data_t>(capacity, dim), _num_chunks(num_pq_chunks), _use_opq(use_opq),
+      _distance_fn(std::move(distance_fn))
+{
+    _metric = _distance_fn->get_metric();
+    if (_metric != Metric::L2 && _metric != Metric::COSINE)
+    {
+        throw ANNException("PQ data store supports only L2 and cosine metrics", -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (_num_chunks > dim || _num_chunks > MAX_PQ_CHUNKS)
+    {
+        std::stringstream stream;
+        stream << "ERROR: num_pq_chunks must be at most min(dim, " << MAX_PQ_CHUNKS << "), got " << _num_chunks
+               << " for " << dim << " dimensions." << std::endl;
+        throw ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _normalize = _metric == Metric::COSINE && std::is_floating_point<data_t>::value;
+
+    _aligned_dim = ROUND_UP(dim, _distance_fn->get_required_alignment());
+    if (_num_chunks > 0)
+        allocate_codes();
+}
+
+template <typename data_t> PQDataStore<data_t>::~PQDataStore()
+{
+    if (_codes != nullptr)
+        huge_page_free(_codes);
+}
+
+template <typename data_t> void PQDataStore<data_t>::allocate_codes()
+{
+    // the aligned allocator takes whole multiples of the alignment
+    huge_page_alloc((void **)&_codes, ROUND_UP(this->_capacity * _num_chunks, 8), 8);
+}
+
+template <typename data_t> size_t PQDataStore<data_t>::get_aligned_dim() const
+{
+    return _aligned_dim;
+}
+
+template <typename data_t> size_t PQDataStore<data_t>::get_alignment_factor() const
+{
+    return _distance_fn->get_required_alignment();
+}
+
+template <typename data_t> size_t PQDataStore<data_t>::get_num_chunks() const
+{
+    return _num_chunks;
+}
+
+template <typename data_t> Distance<data_t> *PQDataStore<data_t>::get_dist_fn()
+{
+    return _distance_fn.get();
+}
+
+template <typename data_t> void PQDataStore<data_t>::check_trained() const
+{
+    if (!_trained)
+    {
+        throw ANNException("ERROR: PQ data store has no pivots. Populate it from a data file or load it before "
+                           "adding vectors.",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
+template <typename data_t> void PQDataStore<data_t>::preprocess(const data_t *vector, float *target) const
+{
+    for (size_t d = 0; d < this->_dim; d++)
+        target[d] = (float)vector[d];
+    if (_normalize)
+    {
+        float norm = 0;
+        for (size_t d = 0; d < this->_dim; d++)
+            norm += target[d] * target[d];
+        norm = std::sqrt(norm);
+        if (norm > 0)
+        {
+            for (size_t d = 0; d < this->_dim; d++)
+                target[d] /= norm;
+        }
+    }
+}
+
+template <typename data_t> void PQDataStore<data_t>::encode(const data_t *vector, uint8_t *code) const
+{
+    std::vector<float> processed(this->_dim);
+    preprocess(vector, processed.data());
+    _pq_table->compress_vector(processed.data(), code);
+}
+
+template <typename data_t> void PQDataStore<data_t>::load_pivots(const std::string &pivots_file)
+{
+#ifdef EXEC_ENV_OLS
+    throw ANNException("load_pq_centroid_bin should not be called when "
+                       "EXEC_ENV_OLS is defined.",
+                       -1, __FUNCSIG__, __FILE__, __LINE__);
+#else
+    auto pq_table = std::make_unique<FixedChunkPQTable>();
+    pq_table->load_pq_centroid_bin(pivots_file.c_str(), _num_chunks);
+    if (pq_table->get_num_centers() != NUM_PQ_CENTROIDS)
+    {
+        throw ANNException("ERROR: PQ data store needs pivots with " + std::to_string(NUM_PQ_CENTROIDS) +
+                               " centers, " + pivots_file + " has " + std::to_string(pq_table->get_num_centers()),
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _pq_table = std::move(pq_table);
+    if (_num_chunks == 0)
+    {
+        _num_chunks = _pq_table->get_num_chunks();
+        allocate_codes();
+    }
+    _pivots_file = pivots_file;
+    _trained = true;
+#endif
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::train(const std::string &filename, const size_t offset, const size_t num_points)
+{
+    if (_num_chunks == 0)
+    {
+        throw ANNException("ERROR: PQ data store needs num_pq_chunks to train pivots for " + filename, -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+    }
+    std::string suffix = _use_opq ? "_opq" : "_pq";
+    suffix += std::to_string(_num_chunks);
+    const std::string pivots_file = filename + suffix + "_pivots.bin";
+
+    const double p_val = std::min(1.0, ((double)MAX_PQ_TRAINING_SET_SIZE / (double)num_points));
+    std::mt19937 generator(std::random_device{}());
+    std::uniform_real_distribution<float> distribution(0, 1);
+
+    std::ifstream reader(filename, std::ios::binary);
+    reader.seekg(offset + 2 * sizeof(uint32_t), reader.beg);
+    const size_t block_size = std::min((size_t)PQ_STORE_READ_BLOCK, num_points);
+    std::vector<data_t> block(block_size * this->_dim);
+    std::vector<float> train_data;
+    size_t num_train = 0;
+    for (size_t start = 0; start < num_points; start += block_size)
+    {
+        const size_t count = std::min(block_size, num_points - start);
+        reader.read((char *)block.data(), count * this->_dim * sizeof(data_t));
+        for (size_t i = 0; i < count; i++)
+        {
+            if (distribution(generator) >= p_val)
+                continue;
+            train_data.resize((num_train + 1) * this->_dim);
+            preprocess(block.data() + i * this->_dim, train_data.data() + num_train * this->_dim);
+            num_train++;
+        }
+    }
+    diskann::cout << "Training PQ data store with " << num_train << " samples." << std::endl;
+
+    // OPQ is trained without centering, as generate_quantized_data does
+    if (!_use_opq)
+    {
+        generate_pq_pivots(train_data.data(), num_train, (uint32_t)this->_dim, NUM_PQ_CENTROIDS,
+                           (uint32_t)_num_chunks, NUM_KMEANS_REPS_PQ, pivots_file, true);
+    }
+    else
+    {
+        generate_opq_pivots(train_data.data(), num_train, (uint32_t)this->_dim, NUM_PQ_CENTROIDS,
+                            (uint32_t)_num_chunks, pivots_file, false);
+    }
+    load_pivots(pivots_file);
+}
+
+template <typename data_t>
+location_t PQDataStore<data_t>::populate_from_file(const std::string &filename, const size_t offset)
+{
+    if (!file_exists(filename))
+    {
+        std::stringstream stream;
+        stream << "ERROR: data file " << filename << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    size_t file_num_points, file_dim;
+    std::ifstream reader(filename, std::ios::binary);
+    get_bin_metadata_impl(reader, file_num_points, file_dim, offset);
+    if (file_dim != this->_dim)
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
+               << "but file has " << file_dim << " dimension." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (file_num_points == 0)
+        return 0;
+    if (file_num_points > this->capacity())
+        this->resize((location_t)file_num_points);
+
+    if (!_trained)
+        train(filename, offset, file_num_points);
+
+    const size_t block_size = std::min((size_t)PQ_STORE_READ_BLOCK, file_num_points);
+    std::vector<data_t> block(block_size * this->_dim);
+    reader.seekg(offset + 2 * sizeof(uint32_t), reader.beg);
+    for (size_t start = 0; start < file_num_points; start += block_size)
+    {
+        const size_t count = std::min(block_size, file_num_points - start);
+        reader.read((char *)block.data(), count * this->_dim * sizeof(data_t));
+#pragma omp parallel for schedule(static, 1024)
+        for (int64_t i = 0; i < (int64_t)count; i++)
+        {
+            encode(block.data() + i * this->_dim, _codes + (start + i) * _num_chunks);
+        }
+    }
+    return (location_t)file_num_points;
+}
+
+template <typename data_t> location_t PQDataStore<data_t>::load(const std::string &filename)
+{
+    const std::string pivots_file = filename + "_pq_pivots.bin";
+    if (file_exists(pivots_file))
+        load_pivots(pivots_file);
+    return populate_from_file(filename, 0);
+}
+
+template <typename data_t> void PQDataStore<data_t>::populate_data(const std::string &filename, const size_t offset)
+{
+    populate_from_file(filename, offset);
+}
+
+template <typename data_t> void PQDataStore<data_t>::populate_data(const data_t *vectors, const location_t num_pts)
+{
+    check_trained();
+    if (num_pts > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Number of points " << num_pts << " is greater than the capacity of data store: " << this->capacity()
+           << ". Must invoke resize before calling populate_data()" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+
+#pragma omp parallel for schedule(static, 1024)
+    for (int64_t i = 0; i < (int64_t)num_pts; i++)
+    {
+        encode(vectors + i * this->_dim, _codes + i * _num_chunks);
+    }
+}
+
+template <typename data_t> size_t PQDataStore<data_t>::save(const std::string &filename, const location_t num_points)
+{
+    std::ofstream writer;
+    open_file_to_write(writer, filename);
+    const int npts_i32 = (int)num_points, ndims_i32 = (int)this->_dim;
+    writer.write((char *)&npts_i32, sizeof(int));
+    writer.write((char *)&ndims_i32, sizeof(int));
+
+    std::vector<data_t> vector(this->_dim);
+    for (location_t i = 0; i < num_points; i++)
+    {
+        get_vector(i, vector.data());
+        writer.write((char *)vector.data(), this->_dim * sizeof(data_t));
+    }
+    writer.close();
+
+    if (_trained)
+        save_pivots(filename + "_pq_pivots.bin");
+    return 2 * sizeof(uint32_t) + (size_t)num_points * this->_dim * sizeof(data_t);
+}
+
+template <typename data_t> void PQDataStore<data_t>::save_pivots(const std::string &pivots_file) const
+{
+    check_trained();
+    if (pivots_file == _pivots_file)
+        return;
+    copy_file(_pivots_file, pivots_file);
+
+    // load_pq_centroid_bin picks up a rotation matrix next to the pivots
+    const std::string rotation_file = _pivots_file + "_rotation_matrix.bin";
+    const std::string target_rotation_file = pivots_file + "_rotation_matrix.bin";
+    if (file_exists(rotation_file))
+        copy_file(rotation_file, target_rotation_file);
+    else if (file_exists(target_rotation_file))
+        std::remove(target_rotation_file.c_str());
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::extract_data_to_bin(const std::string &filename, const location_t num_pts)
+{
+    save(filename, num_pts);
+}
+
+template <typename data_t> void PQDataStore<data_t>::get_vector(const location_t i, data_t *target) const
+{
+    check_trained();
+    std::vector<float> vector(this->_dim);
+    _pq_table->inflate_vector(_codes + i * _num_chunks, vector.data());
+    for (size_t d = 0; d < this->_dim; d++)
+        target[d] = from_float<data_t>(vector[d]);
+}
+
+template <typename data_t> void PQDataStore<data_t>::set_vector(const location_t loc, const data_t *const vector)
+{
+    check_trained();
+    encode(vector, _codes + loc * _num_chunks);
+}
+
+template <typename data_t> bool PQDataStore<data_t>::is_trained() const
+{
+    return _trained;
+}
+
+template <typename data_t> void PQDataStore<data_t>::prefetch_vector(const location_t loc)
+{
+    diskann::prefetch_vector((const char *)(_codes + loc * _num_chunks), _num_chunks);
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::move_vectors(const location_t old_location_start, const location_t new_location_start,
+                                       const location_t num_locations)
+{
+    if (num_locations == 0 || old_location_start == new_location_start)
+    {
+        return;
+    }
+
+    // The [start, end) interval which will contain obsolete points to be
+    // cleared, without the part overlapping the new range.
+    uint32_t mem_clear_loc_start = old_location_start;
+    uint32_t mem_clear_loc_end_limit = old_location_start + num_locations;
+    if (new_location_start < old_location_start)
+    {
+        if (mem_clear_loc_start < new_location_start + num_locations)
+            mem_clear_loc_start = new_location_start + num_locations;
+    }
+    else
+    {
+        if (mem_clear_loc_end_limit > new_location_start)
+            mem_clear_loc_end_limit = new_location_start;
+    }
+
+    copy_vectors(old_location_start, new_location_start, num_locations);
+    memset(_codes + _num_chunks * mem_clear_loc_start, 0,
+           _num_chunks * (mem_clear_loc_end_limit - mem_clear_loc_start));
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::copy_vectors(const location_t from_loc, const location_t to_loc, const location_t num_points)
+{
+    assert(from_loc < this->_capacity);
+    assert(to_loc < this->_capacity);
+    assert(num_points < this->_capacity);
+    memmove(_codes + _num_chunks * to_loc, _codes + _num_chunks * from_loc, num_points * _num_chunks);
+}
+
+template <typename data_t> float PQDataStore<data_t>::get_distance(const data_t *query, const location_t loc) const
+{
+    float distance;
+    get_distance(query, &loc, 1, &distance);
+    return distance;
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::get_distance(const data_t *query, const location_t *locations,
+                                       const uint32_t location_count, float *distances) const
+{
+    // without the tables of a scratch, compare against the decoded vectors
+    check_trained();
+    std::vector<float> query_float(this->_dim), vector(this->_dim);
+    for (size_t d = 0; d < this->_dim; d++)
+        query_float[d] = (float)query[d];
+    for (uint32_t i = 0; i < location_count; i++)
+    {
+        _pq_table->inflate_vector(_codes + locations[i] * _num_chunks, vector.data());
+        distances[i] = l2(query_float.data(), vector.data(), this->_dim);
+        if (_normalize)
+            distances[i] *= 0.5f;
+    }
+}
+
+template <typename data_t>
+float PQDataStore<data_t>::get_distance(const location_t loc1, const location_t loc2) const
+{
+    check_trained();
+    const float distance = _pq_table->symmetric_l2_distance(_codes + loc1 * _num_chunks, _codes + loc2 * _num_chunks);
+    return _normalize ? 0.5f * distance : distance;
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::preprocess_query(const data_t *aligned_query, PQScratch<data_t> *scratch) const
+{
+    check_trained();
+    if (scratch == nullptr)
+    {
+        throw ANNException("ERROR: PQ data store needs a PQ scratch to preprocess queries.", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+    // center the query and rotate if we have a rotation matrix
+    scratch->set(this->_dim, aligned_query);
+    _pq_table->preprocess_query(scratch->rotated_query);
+    _pq_table->populate_chunk_distances(scratch->rotated_query, scratch->aligned_pqtable_dist_scratch);
+}
+
+template <typename data_t>
+void PQDataStore<data_t>::get_distance(const data_t *aligned_query, const location_t *locations,
+                                       const uint32_t location_count, float *distances,
+                                       PQScratch<data_t> *scratch) const
+{
+    // the coordinate scratch holds the codes of up to MAX_GRAPH_DEGREE points
+    for (uint32_t start = 0; start < location_count; start += (uint32_t)defaults::MAX_GRAPH_DEGREE)
+    {
+        const uint32_t count = std::min(location_count - start, (uint32_t)defaults::MAX_GRAPH_DEGREE);
+        aggregate_coords(locations + start, count, _codes, _num_chunks, scratch->aligned_pq_coord_scratch);
+        pq_dist_lookup(scratch->aligned_pq_coord_scratch, count, _num_chunks, scratch->aligned_pqtable_dist_scratch,
+                       distances + start);
+    }
+    if (_normalize)
+    {
+        for (uint32_t i = 0; i < location_count; i++)
+            distances[i] *= 0.5f;
+    }
+}
+
+template <typename data_t> location_t PQDataStore<data_t>::calculate_medoid() const
+{
+    check_trained();
+    std::vector<float> center(this->_dim, 0), vector(this->_dim);
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        _pq_table->inflate_vector(_codes + i * _num_chunks, vector.data());
+        for (size_t d = 0; d < this->_dim; d++)
+            center[d] += vector[d];
+    }
+    for (size_t d = 0; d < this->_dim; d++)
+        center[d] /= (float)this->capacity();
+
+    location_t min_idx = 0;
+    float min_dist = std::numeric_limits<float>::max();
+    for (location_t i = 0; i < this->capacity(); i++)
+    {
+        _pq_table->inflate_vector(_codes + i * _num_chunks, vector.data());
+        const float dist = l2(center.data(), vector.data(), this->_dim);
+        if (dist < min_dist)
+        {
+            min_idx = i;
+            min_dist = dist;
+        }
+    }
+    return min_idx;
+}
+
+template <typename data_t> location_t PQDataStore<data_t>::expand(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size < this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'expand' datastore when new capacity (" << new_size << ") < existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    if (_codes == nullptr)
+    {
+        // the codes are allocated once the pivots give the number of chunks
+        this->_capacity = new_size;
+        return this->_capacity;
+    }
+    uint8_t *new_codes;
+    huge_page_alloc((void **)&new_codes, ROUND_UP(new_size * _num_chunks, 8), 8);
+    memcpy(new_codes, _codes, this->capacity() * _num_chunks);
+    huge_page_free(_codes);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+template <typename data_t> location_t PQDataStore<data_t>::shrink(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'shrink' datastore when new capacity (" << new_size << ") > existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    if (_codes == nullptr)
+    {
+        this->_capacity = new_size;
+        return this->_capacity;
+    }
+    uint8_t *new_codes;
+    huge_page_alloc((void **)&new_codes, ROUND_UP(new_size * _num_chunks, 8), 8);
+    memcpy(new_codes, _codes, new_size * _num_chunks);
+    huge_page_free(_codes);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+template DISKANN_DLLEXPORT class PQDataStore<float>;
+template DISKANN_DLLEXPORT class PQDataStore<int8_t>;
+template DISKANN_DLLEXPORT class PQDataStore<uint8_t>;
+
+} // namespace diskann
@@ -2,9 +2,12 @@
 // Licensed under the MIT license.
 
 #include "common_includes.h"
+#include <exception>
+#include <numeric>
 
 #include "timer.h"
 #include "pq_flash_index.h"
+#include "huge_page_allocator.h"
 #include "cosine_similarity.h"
 
 #ifdef _WINDOWS
@@ -56,7 +59,7 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
 #ifndef EXEC_ENV_OLS
     if (data != nullptr)
     {
-        delete[] data;
+        huge_page_free(data);
     }
 #endif
 
@@ -65,42 +68,36 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
     // delete backing bufs for nhood and coord cache
     if (_nhood_cache_buf != nullptr)
     {
-        delete[] _nhood_cache_buf;
-        diskann::aligned_free(_coord_cache_buf);
+        huge_page_free(_nhood_cache_buf);
+        huge_page_free(_coord_cache_buf);
     }
 
     if (_load_flag)
     {
         diskann::cout << "Clearing scratch" << std::endl;
-        ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
-        manager.destroy();
+        this->resize_thread_data(0);
         this->reader->deregister_all_threads();
         reader->close();
     }
-    if (_pts_to_label_offsets != nullptr)
-    {
-        delete[] _pts_to_label_offsets;
-    }
-    if (_pts_to_label_counts != nullptr)
-    {
-        delete[] _pts_to_label_counts;
-    }
-    if (_pts_to_labels != nullptr)
-    {
-        delete[] _pts_to_labels;
-    }
+}
+
+template <typename T, typename LabelT> inline uint64_t PQFlashIndex<T, LabelT>::get_node_location(uint64_t node_id)
+{
+    return _node_locations.empty() ? node_id : _node_locations[node_id];
 }
 
 template <typename T, typename LabelT> inline uint64_t PQFlashIndex<T, LabelT>::get_node_sector(uint64_t node_id)
 {
-    return 1 + (_nnodes_per_sector > 0 ? node_id / _nnodes_per_sector
-                                       : node_id * DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN));
+    const uint64_t location = get_node_location(node_id);
+    return 1 + (_nnodes_per_sector > 0 ? location / _nnodes_per_sector
+                                       : location * DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN));
 }
 
 template <typename T, typename LabelT>
 inline char *PQFlashIndex<T, LabelT>::offset_to_node(char *sector_buf, uint64_t node_id)
 {
-    return sector_buf + (_nnodes_per_sector == 0 ? 0 : (node_id % _nnodes_per_sector) * _max_node_len);
+    return sector_buf +
+           (_nnodes_per_sector == 0 ? 0 : (get_node_location(node_id) % _nnodes_per_sector) * _max_node_len);
 }
 
 template <typename T, typename LabelT> inline uint32_t *PQFlashIndex<T, LabelT>::offset_to_node_nhood(char *node_buf)
@@ -113,23 +110,116 @@ template <typename T, typename LabelT> inline T *PQFlashIndex<T, LabelT>::offset
     return (T *)(node_buf);
 }
 
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::compute_pq_dists(const uint32_t *ids, const uint64_t n_ids, const float *pq_dists,
+                                               uint8_t *pq_coord_scratch, float *dists_out)
+{
+    if (_pq_fast_scan)
+    {
+        diskann::aggregate_coords_fast_scan(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
+        diskann::pq_dist_lookup_fast_scan(pq_coord_scratch, n_ids, this->_n_chunks, pq_dists, dists_out);
+    }
+    else
+    {
+        diskann::aggregate_coords(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
+        diskann::pq_dist_lookup(pq_coord_scratch, n_ids, this->_n_chunks, pq_dists, dists_out);
+    }
+}
+
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::setup_thread_data(uint64_t nthreads, uint64_t visited_reserve)
 {
     diskann::cout << "Setting up thread-specific contexts for nthreads: " << nthreads << std::endl;
-// omp parallel for to generate unique thread IDs
+    _visited_reserve = visited_reserve;
+    _visited_set_type = choose_visited_set_type(this->_max_nthreads + nthreads);
+    // each SSDThreadData owns its IO context, so queries never look contexts
+    // up by thread id. omp parallel for to generate unique thread IDs for
+    // readers that can only create thread-bound contexts.
+    std::exception_ptr setup_error = nullptr;
 #pragma omp parallel for num_threads((int)nthreads)
     for (int64_t thread = 0; thread < (int64_t)nthreads; thread++)
     {
 #pragma omp critical
         {
-            SSDThreadData<T> *data = new SSDThreadData<T>(this->_aligned_dim, visited_reserve);
-            this->reader->register_thread();
-            data->ctx = this->reader->get_ctx();
-            this->_thread_data.push(data);
+            try
+            {
+                SSDThreadData<T> *data = new_thread_data(visited_reserve);
+                this->_thread_data.push(data);
+                this->_max_nthreads++;
+            }
+            catch (...)
+            {
+                if (setup_error == nullptr)
+                    setup_error = std::current_exception();
+            }
         }
     }
+    this->_thread_data.push_notify_all();
     _load_flag = true;
+    if (setup_error != nullptr)
+    {
+        std::rethrow_exception(setup_error);
+    }
+}
+
+template <typename T, typename LabelT>
+VisitedSetType PQFlashIndex<T, LabelT>::choose_visited_set_type(uint64_t num_sets)
+{
+    if (_visited_set_type_fixed)
+        return _visited_set_type;
+    return VisitedSet::choose(_num_points, num_sets, defaults::MAX_VISITED_SET_BYTES, true);
+}
+
+template <typename T, typename LabelT>
+SSDThreadData<T> *PQFlashIndex<T, LabelT>::new_thread_data(uint64_t visited_reserve)
+{
+    std::unique_ptr<SSDThreadData<T>> data(new SSDThreadData<T>(this->_aligned_dim, visited_reserve));
+    data->scratch.visited.init(_visited_set_type, _num_points, visited_reserve);
+    data->ctx = this->reader->create_ctx();
+    // destroys the context if register_buffer throws
+    struct CtxReleaser
+    {
+        AlignedFileReader &reader;
+        IOContext &ctx;
+        bool owned;
+        ~CtxReleaser()
+        {
+            if (owned)
+                reader.destroy_ctx(ctx);
+        }
+    } releaser{*this->reader, data->ctx, true};
+    this->reader->register_buffer(data->ctx, data->scratch.sector_scratch,
+                                  defaults::MAX_N_SECTOR_READS * defaults::SECTOR_LEN);
+    releaser.owned = false;
+    return data.release();
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::release_thread_data(SSDThreadData<T> *data)
+{
+    this->reader->destroy_ctx(data->ctx);
+    delete data;
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::resize_thread_data(uint64_t nthreads)
+{
+    if (nthreads > this->_max_nthreads)
+    {
+        this->setup_thread_data(nthreads - this->_max_nthreads, _visited_reserve);
+        return;
+    }
+
+    // wait for queries to hand back the thread data we are dropping
+    while (this->_max_nthreads > nthreads)
+    {
+        SSDThreadData<T> *data = this->_thread_data.pop();
+        while (data == nullptr)
+        {
+            this->_thread_data.wait_for_push_notify();
+            data = this->_thread_data.pop();
+        }
+        release_thread_data(data);
+        this->_max_nthreads--;
+    }
 }
 
 template <typename T, typename LabelT>
@@ -207,13 +297,12 @@ template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_
     IOContext &ctx = this_thread_data->ctx;
 
     // Allocate space for neighborhood cache
-    _nhood_cache_buf = new uint32_t[num_cached_nodes * (_max_degree + 1)];
-    memset(_nhood_cache_buf, 0, num_cached_nodes * (_max_degree + 1));
+    huge_page_alloc((void **)&_nhood_cache_buf, num_cached_nodes * (_max_degree + 1) * sizeof(uint32_t),
+                    sizeof(uint32_t));
 
     // Allocate space for coordinate cache
     size_t coord_cache_buf_len = num_cached_nodes * _aligned_dim;
-    diskann::alloc_aligned((void **)&_coord_cache_buf, coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
-    memset(_coord_cache_buf, 0, coord_cache_buf_len * sizeof(T));
+    huge_page_alloc((void **)&_coord_cache_buf, coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
 
     size_t BLOCK_SIZE = 8;
     size_t num_blocks = DIV_ROUND_UP(num_cached_nodes, BLOCK_SIZE);
@@ -547,7 +636,13 @@ void PQFlashIndex<T, LabelT>::generate_random_labels(std::vector<LabelT> &labels
     labels.clear();
     labels.resize(num_labels);
 
-    uint64_t num_total_labels = _pts_to_label_offsets[_num_points - 1] + _pts_to_label_counts[_num_points - 1];
+    // a label is drawn as often as points have it, like drawing a random
+    // entry of the label lists of all points
+    std::vector<LabelT> all_labels;
+    std::vector<uint64_t> label_counts;
+    _label_index.get_label_counts(all_labels, label_counts);
+    std::partial_sum(label_counts.begin(), label_counts.end(), label_counts.begin());
+    uint64_t num_total_labels = label_counts.empty() ? 0 : label_counts.back();
     std::mt19937 gen(rd());
     if (num_total_labels == 0)
     {
@@ -562,7 +657,8 @@ void PQFlashIndex<T, LabelT>::generate_random_labels(std::vector<LabelT> &labels
     for (int64_t i = 0; i < num_labels; i++)
     {
         uint64_t rnd_loc = dis(gen);
-        labels[i] = (LabelT)_pts_to_labels[rnd_loc];
+        labels[i] = all_labels[std::upper_bound(label_counts.begin(), label_counts.end(), rnd_loc) -
+                               label_counts.begin()];
     }
 }
 
@@ -602,6 +698,13 @@ LabelT PQFlashIndex<T, LabelT>::get_converted_label(const std::string &filter_la
     throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
 }
 
+template <typename T, typename LabelT>
+FilterExpression<LabelT> PQFlashIndex<T, LabelT>::get_converted_filter(const std::string &raw_filter)
+{
+    return FilterExpression<LabelT>::parse(
+        raw_filter, [this](const std::string &raw_label) { return get_converted_label(raw_label); });
+}
+
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::reset_stream_for_reading(std::basic_istream<char> &infile)
 {
@@ -653,23 +756,6 @@ void PQFlashIndex<T, LabelT>::get_label_file_metadata(const std::string &fileCon
                   << std::endl;
 }
 
-template <typename T, typename LabelT>
-inline bool PQFlashIndex<T, LabelT>::point_has_label(uint32_t point_id, LabelT label_id)
-{
-    uint32_t start_vec = _pts_to_label_offsets[point_id];
-    uint32_t num_lbls = _pts_to_label_counts[point_id];
-    bool ret_val = false;
-    for (uint32_t i = 0; i < num_lbls; i++)
-    {
-        if (_pts_to_labels[start_vec + i] == label_id)
-        {
-            ret_val = true;
-            break;
-        }
-    }
-    return ret_val;
-}
-
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::parse_label_file(std::basic_istream<char> &infile, size_t &num_points_labels)
 {
@@ -688,10 +774,8 @@ void PQFlashIndex<T, LabelT>::parse_label_file(std::basic_istream<char> &infile,
     uint32_t num_total_labels;
     get_label_file_metadata(buffer, num_pts_in_label_file, num_total_labels);
 
-    _pts_to_label_offsets = new uint32_t[num_pts_in_label_file];
-    _pts_to_label_counts = new uint32_t[num_pts_in_label_file];
-    _pts_to_labels = new LabelT[num_total_labels];
-    uint32_t labels_seen_so_far = 0;
+    _label_index.reset(num_pts_in_label_file);
+    std::vector<LabelT> cur_pt_labels;
 
     std::string label_str;
     size_t cur_pos = 0;
@@ -704,9 +788,7 @@ void PQFlashIndex<T, LabelT>::parse_label_file(std::basic_istream<char> &infile,
             break;
         }
 
-        _pts_to_label_offsets[line_cnt] = labels_seen_so_far;
-        uint32_t &num_lbls_in_cur_pt = _pts_to_label_counts[line_cnt];
-        num_lbls_in_cur_pt = 0;
+        cur_pt_labels.clear();
 
         size_t lbl_pos = cur_pos;
         size_t next_lbl_pos = 0;
@@ -730,8 +812,7 @@ void PQFlashIndex<T, LabelT>::parse_label_file(std::basic_istream<char> &infile,
             }
 
             LabelT token_as_num = (LabelT)std::stoul(label_str);
-            _pts_to_labels[labels_seen_so_far++] = (LabelT)token_as_num;
-            num_lbls_in_cur_pt++;
+            cur_pt_labels.push_back(token_as_num);
 
             // move to next label
             lbl_pos = next_lbl_pos + 1;
@@ -740,16 +821,23 @@ void PQFlashIndex<T, LabelT>::parse_label_file(std::basic_istream<char> &infile,
         // move to next line
         cur_pos = next_pos + 1;
 
-        if (num_lbls_in_cur_pt == 0)
+        if (cur_pt_labels.empty())
         {
             diskann::cout << "No label found for point " << line_cnt << std::endl;
             exit(-1);
         }
+        _label_index.add_point(line_cnt, cur_pt_labels.data(), (uint32_t)cur_pt_labels.size());
 
         line_cnt++;
     }
+    _label_index.shrink_to_fit();
 
     num_points_labels = line_cnt;
+    // label lists would take an offset and a count per point and a LabelT per label
+    diskann::cout << "Label index of " << _label_index.num_labels() << " labels takes "
+                  << _label_index.memory_bytes() / (1024 * 1024) << "MB, label lists would take "
+                  << (2 * sizeof(uint32_t) * num_pts_in_label_file + sizeof(LabelT) * num_total_labels) / (1024 * 1024)
+                  << "MB" << std::endl;
     reset_stream_for_reading(infile);
 }
 
@@ -812,11 +900,13 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 
     this->_disk_index_file = _disk_index_file;
 
-    if (pq_file_num_centroids != 256)
+    if (pq_file_num_centroids != NUM_PQ_CENTROIDS && pq_file_num_centroids != NUM_PQ_CENTROIDS_FAST_SCAN)
     {
-        diskann::cout << "Error. Number of PQ centroids is not 256. Exiting." << std::endl;
+        diskann::cout << "Error. Number of PQ centroids is not " << NUM_PQ_CENTROIDS << " or "
+                      << NUM_PQ_CENTROIDS_FAST_SCAN << ". Exiting." << std::endl;
         return -1;
     }
+    this->_pq_fast_scan = pq_file_num_centroids == NUM_PQ_CENTROIDS_FAST_SCAN;
 
     this->_data_dim = pq_file_dim;
     // will change later if we use PQ on disk or if we are using
@@ -828,7 +918,21 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 #ifdef EXEC_ENV_OLS
     diskann::load_bin<uint8_t>(files, pq_compressed_vectors, this->data, npts_u64, nchunks_u64);
 #else
-    diskann::load_bin<uint8_t>(pq_compressed_vectors, this->data, npts_u64, nchunks_u64);
+    // the codes of every candidate are read at random, keep them on huge pages
+    diskann::get_bin_metadata(pq_compressed_vectors, npts_u64, nchunks_u64);
+    huge_page_alloc((void **)&this->data, npts_u64 * nchunks_u64, 1);
+    try
+    {
+        std::ifstream codes_reader;
+        codes_reader.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        codes_reader.open(pq_compressed_vectors, std::ios::binary);
+        codes_reader.seekg(2 * sizeof(uint32_t), codes_reader.beg);
+        codes_reader.read((char *)this->data, npts_u64 * nchunks_u64);
+    }
+    catch (std::system_error &e)
+    {
+        throw FileException(pq_compressed_vectors, e, __FUNCSIG__, __FILE__, __LINE__);
+    }
 #endif
 
     this->_num_points = npts_u64;
@@ -972,11 +1076,26 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
         }
     }
 
+    // the compressed vectors of 4-bit PQ hold two chunks per byte, so the
+    // number of chunks comes from the pivots file
+    const size_t num_table_chunks = _pq_fast_scan ? 0 : nchunks_u64;
 #ifdef EXEC_ENV_OLS
-    _pq_table.load_pq_centroid_bin(files, pq_table_bin.c_str(), nchunks_u64);
+    _pq_table.load_pq_centroid_bin(files, pq_table_bin.c_str(), num_table_chunks);
 #else
-    _pq_table.load_pq_centroid_bin(pq_table_bin.c_str(), nchunks_u64);
+    _pq_table.load_pq_centroid_bin(pq_table_bin.c_str(), num_table_chunks);
 #endif
+    if (_pq_fast_scan)
+    {
+        this->_n_chunks = _pq_table.get_num_chunks();
+        if (_pq_table.get_code_len() != nchunks_u64)
+        {
+            std::stringstream stream;
+            stream << "Error loading index. 4-bit PQ with " << _n_chunks << " chunks needs "
+                   << _pq_table.get_code_len() << " bytes per point, but " << pq_compressed_vectors << " has "
+                   << nchunks_u64 << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+    }
 
     diskann::cout << "Loaded PQ centroids and in-memory compressed vectors. #points: " << _num_points
                   << " #dim: " << _data_dim << " #aligned_dim: " << _aligned_dim << " #chunks: " << _n_chunks
@@ -1023,7 +1142,6 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
     // 'standard' aligned file reader approach.
     reader->open(_disk_index_file);
     this->setup_thread_data(num_threads);
-    this->_max_nthreads = num_threads;
 
     char *bytes = getHeaderBytes();
     ContentBuf buf(bytes, HEADER_SIZE);
@@ -1102,12 +1220,51 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
     index_metadata.close();
 #endif
 
+    // create_disk_layout may have placed the nodes in a locality order
+    std::string layout_file = _disk_index_file + "_layout_perm.bin";
+    std::unique_ptr<uint32_t[]> layout;
+    size_t layout_npts = 0, layout_dim = 0;
+#ifdef EXEC_ENV_OLS
+    if (files.fileExists(layout_file))
+        diskann::load_bin<uint32_t>(files, layout_file, layout, layout_npts, layout_dim);
+#else
+    if (file_exists(layout_file))
+        diskann::load_bin<uint32_t>(layout_file, layout, layout_npts, layout_dim);
+#endif
+    _node_locations.clear();
+    if (layout != nullptr)
+    {
+        if (layout_npts != _num_points || layout_dim != 1)
+        {
+            std::stringstream stream;
+            stream << "Error loading layout file " << layout_file << ". Expected " << _num_points
+                   << " x 1 uint32_t, found " << layout_npts << " x " << layout_dim << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        // every id must have exactly one position, or reads land on the
+        // wrong node
+        _node_locations.assign(_num_points, std::numeric_limits<uint32_t>::max());
+        for (uint32_t pos = 0; pos < _num_points; pos++)
+        {
+            if (layout[pos] >= _num_points || _node_locations[layout[pos]] != std::numeric_limits<uint32_t>::max())
+            {
+                std::stringstream stream;
+                stream << "Error loading layout file " << layout_file << ". Position " << pos << " holds "
+                       << (layout[pos] >= _num_points ? "out of range" : "duplicate") << " id " << layout[pos]
+                       << ", expected a permutation of [0, " << _num_points << ")" << std::endl;
+                _node_locations.clear();
+                throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+            }
+            _node_locations[layout[pos]] = pos;
+        }
+        diskann::cout << "Nodes are placed on disk in the order of " << layout_file << std::endl;
+    }
+
 #ifndef EXEC_ENV_OLS
     // open AlignedFileReader handle to index_file
     std::string index_fname(_disk_index_file);
     reader->open(index_fname);
     this->setup_thread_data(num_threads);
-    this->_max_nthreads = num_threads;
 
 #endif
 
@@ -1264,19 +1421,27 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
                                                  uint64_t *indices, float *distances, const uint64_t beam_width,
-                                                 const bool use_filter, const LabelT &filter_label,
-                                                 const uint32_t io_limit, const bool use_reorder_data,
+                                                 const FilterExpression<LabelT> &filter, const bool use_reorder_data,
                                                  QueryStats *stats)
 {
+    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, filter,
+                       std::numeric_limits<uint32_t>::max(), use_reorder_data, stats);
+}
 
-    uint64_t num_sector_per_nodes = DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
-    if (beam_width > num_sector_per_nodes * defaults::MAX_N_SECTOR_READS)
-        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
-                           __LINE__);
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const FilterExpression<LabelT> &filter, const uint32_t io_limit,
+                                                 const bool use_reorder_data, QueryStats *stats)
+{
+    beam_search(query1, k_search, l_search, indices, distances, beam_width, &filter, io_limit, use_reorder_data,
+                stats);
+}
 
-    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
-    auto data = manager.scratch_space();
-    IOContext &ctx = data->ctx;
+template <typename T, typename LabelT>
+float PQFlashIndex<T, LabelT>::init_beam_search(const T *query1, SSDThreadData<T> *data, const uint64_t l_search,
+                                                const FilterExpression<LabelT> *filter)
+{
     auto query_scratch = &(data->scratch);
     auto pq_query_scratch = query_scratch->_pq_scratch;
 
@@ -1318,16 +1483,6 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
         pq_query_scratch->set(this->_data_dim, aligned_query_T);
     }
 
-    // pointers to buffers for data
-    T *data_buf = query_scratch->coord_scratch;
-    _mm_prefetch((char *)data_buf, _MM_HINT_T1);
-
-    // sector scratch
-    char *sector_scratch = query_scratch->sector_scratch;
-    uint64_t &sector_scratch_idx = query_scratch->sector_idx;
-    const uint64_t num_sectors_per_node =
-        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
-
     // query <-> PQ chunk centers distances
     _pq_table.preprocess_query(query_rotated); // center the query and rotate if
                                                // we have a rotation matrix
@@ -1341,20 +1496,18 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     // lambda to batch compute query<-> node distances in PQ space
     auto compute_dists = [this, pq_coord_scratch, pq_dists](const uint32_t *ids, const uint64_t n_ids,
                                                             float *dists_out) {
-        diskann::aggregate_coords(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
-        diskann::pq_dist_lookup(pq_coord_scratch, n_ids, this->_n_chunks, pq_dists, dists_out);
+        compute_pq_dists(ids, n_ids, pq_dists, pq_coord_scratch, dists_out);
     };
-    Timer query_timer, io_timer, cpu_timer;
 
-    tsl::robin_set<uint64_t> &visited = query_scratch->visited;
+    VisitedSet &visited = query_scratch->visited;
     NeighborPriorityQueue &retset = query_scratch->retset;
     retset.reserve(l_search);
-    std::vector<Neighbor> &full_retset = query_scratch->full_retset;
 
-    uint32_t best_medoid = 0;
-    float best_dist = (std::numeric_limits<float>::max)();
-    if (!use_filter)
+    std::vector<uint32_t> start_ids;
+    if (filter == nullptr)
     {
+        uint32_t best_medoid = 0;
+        float best_dist = (std::numeric_limits<float>::max)();
         for (uint64_t cur_m = 0; cur_m < _num_medoids; cur_m++)
         {
             float cur_expanded_dist =
@@ -1365,34 +1518,120 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                 best_dist = cur_expanded_dist;
             }
         }
+        start_ids.push_back(best_medoid);
     }
     else
     {
-        if (_filter_to_medoid_ids.find(filter_label) != _filter_to_medoid_ids.end())
+        // the closest medoid of the labels each clause requires, or of the
+        // index for a clause that only excludes labels. for filtered index, we
+        // dont store global centroid data as for unfiltered index, so we use
+        // PQ distance as approximation to decide the closest medoid.
+        for (const auto &clause : filter->clauses())
         {
-            const auto &medoid_ids = _filter_to_medoid_ids[filter_label];
-            for (uint64_t cur_m = 0; cur_m < medoid_ids.size(); cur_m++)
+            std::vector<uint32_t> medoid_ids;
+            if (clause.labels.empty())
+                medoid_ids.assign(_medoids, _medoids + _num_medoids);
+            for (const auto &label : clause.labels)
+            {
+                const auto label_medoids = _filter_to_medoid_ids.find(label);
+                if (label_medoids != _filter_to_medoid_ids.end())
+                    medoid_ids.insert(medoid_ids.end(), label_medoids->second.begin(), label_medoids->second.end());
+            }
+            if (medoid_ids.empty())
+                continue;
+
+            uint32_t best_medoid = 0;
+            float best_dist = (std::numeric_limits<float>::max)();
+            for (const auto medoid_id : medoid_ids)
             {
-                // for filtered index, we dont store global centroid data as for unfiltered index, so we use PQ distance
-                // as approximation to decide closest medoid matching the query filter.
-                compute_dists(&medoid_ids[cur_m], 1, dist_scratch);
-                float cur_expanded_dist = dist_scratch[0];
-                if (cur_expanded_dist < best_dist)
+                compute_dists(&medoid_id, 1, dist_scratch);
+                if (dist_scratch[0] < best_dist)
                 {
-                    best_medoid = medoid_ids[cur_m];
-                    best_dist = cur_expanded_dist;
+                    best_medoid = medoid_id;
+                    best_dist = dist_scratch[0];
                 }
             }
+            start_ids.push_back(best_medoid);
         }
-        else
+        if (start_ids.empty())
         {
             throw ANNException("Cannot find medoid for specified filter.", -1, __FUNCSIG__, __FILE__, __LINE__);
         }
     }
 
-    compute_dists(&best_medoid, 1, dist_scratch);
-    retset.insert(Neighbor(best_medoid, dist_scratch[0]));
-    visited.insert(best_medoid);
+    for (const auto start_id : start_ids)
+    {
+        if (visited.insert(start_id))
+        {
+            compute_dists(&start_id, 1, dist_scratch);
+            retset.insert(Neighbor(start_id, dist_scratch[0]));
+        }
+    }
+
+    return query_norm;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::expand_beam_search(SSDThreadData<T> *data, const uint64_t beam_width,
+                                                 const FilterExpression<LabelT> *filter, const uint32_t io_limit,
+                                                 const bool keep_dropped, QueryStats *stats)
+{
+    uint64_t num_sector_per_nodes = DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    if (beam_width > num_sector_per_nodes * defaults::MAX_N_SECTOR_READS)
+        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+
+    IOContext &ctx = data->ctx;
+    auto query_scratch = &(data->scratch);
+    auto pq_query_scratch = query_scratch->_pq_scratch;
+    T *aligned_query_T = query_scratch->aligned_query_T;
+    float *query_float = pq_query_scratch->aligned_query_float;
+
+    // pointers to buffers for data
+    T *data_buf = query_scratch->coord_scratch;
+    _mm_prefetch((char *)data_buf, _MM_HINT_T1);
+
+    // sector scratch
+    char *sector_scratch = query_scratch->sector_scratch;
+    uint64_t &sector_scratch_idx = query_scratch->sector_idx;
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+
+    // query <-> PQ chunk centers distances, from init_beam_search
+    float *pq_dists = pq_query_scratch->aligned_pqtable_dist_scratch;
+
+    // query <-> neighbor list
+    float *dist_scratch = pq_query_scratch->aligned_dist_scratch;
+    uint8_t *pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
+
+    // lambda to batch compute query<-> node distances in PQ space
+    auto compute_dists = [this, pq_coord_scratch, pq_dists](const uint32_t *ids, const uint64_t n_ids,
+                                                            float *dists_out) {
+        compute_pq_dists(ids, n_ids, pq_dists, pq_coord_scratch, dists_out);
+    };
+    Timer io_timer, cpu_timer;
+
+    // the search keeps the dynamic cache it starts with if the budget changes
+    const auto dynamic_cache = std::atomic_load(&_dynamic_cache);
+
+    VisitedSet &visited = query_scratch->visited;
+    NeighborPriorityQueue &retset = query_scratch->retset;
+    std::vector<Neighbor> &full_retset = query_scratch->full_retset;
+
+    // the bitmaps of the filter labels are looked up once per search
+    const bool use_filter = filter != nullptr;
+    const FilterExpression<LabelT> no_filter;
+    const typename FilterExpression<LabelT>::Matcher filter_matcher(use_filter ? *filter : no_filter, _label_index,
+                                                                    _use_universal_label, _universal_filter_label);
+
+    // a resumable search keeps the candidates that fall out of the full
+    // retset, so that a later call with a larger retset can expand them
+    auto insert_candidate = [&](const Neighbor &nn) {
+        if (keep_dropped)
+            retset.insert(nn, query_scratch->dropped_candidates);
+        else
+            retset.insert(nn);
+    };
 
     uint32_t cmps = 0;
     uint32_t hops = 0;
@@ -1407,55 +1646,192 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     frontier_read_reqs.reserve(2 * beam_width);
     std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>> cached_nhoods;
     cached_nhoods.reserve(2 * beam_width);
+    // nodes found in the dynamic cache, copied into sector scratch
+    std::vector<std::pair<uint32_t, char *>> dynamic_cached_nhoods;
+    dynamic_cached_nhoods.reserve(2 * beam_width);
+
+    // lambda to expand a node whose nhood and coords are in the in-memory cache
+    auto expand_cached_nhood = [&](const std::pair<uint32_t, std::pair<uint32_t, uint32_t *>> &cached_nhood) {
+        auto global_cache_iter = _coord_cache.find(cached_nhood.first);
+        T *node_fp_coords_copy = global_cache_iter->second;
+        float cur_expanded_dist;
+        if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist = _dist_cmp->compare(aligned_query_T, node_fp_coords_copy, (uint32_t)_aligned_dim);
+        }
+        else
+        {
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords_copy);
+            else
+                cur_expanded_dist = _disk_pq_table.l2_distance( // disk_pq does not support OPQ yet
+                    query_float, (uint8_t *)node_fp_coords_copy);
+        }
+        full_retset.push_back(Neighbor((uint32_t)cached_nhood.first, cur_expanded_dist));
+
+        uint64_t nnbrs = cached_nhood.second.first;
+        uint32_t *node_nbrs = cached_nhood.second.second;
 
-    while (retset.has_unexpanded_node() && num_ios < io_limit)
-    {
-        // clear iteration state
-        frontier.clear();
-        frontier_nhoods.clear();
-        frontier_read_reqs.clear();
-        cached_nhoods.clear();
-        sector_scratch_idx = 0;
-        // find new beam
-        uint32_t num_seen = 0;
-        while (retset.has_unexpanded_node() && frontier.size() < beam_width && num_seen < beam_width)
-        {
-            auto nbr = retset.closest_unexpanded();
-            num_seen++;
-            auto iter = _nhood_cache.find(nbr.id);
-            if (iter != _nhood_cache.end())
+        // compute node_nbrs <-> query dists in PQ space
+        cpu_timer.reset();
+        compute_dists(node_nbrs, nnbrs, dist_scratch);
+        if (stats != nullptr)
+        {
+            stats->n_cmps += (uint32_t)nnbrs;
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+
+        // process prefetched nhood
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t id = node_nbrs[m];
+            if (visited.insert(id))
             {
-                cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
-                if (stats != nullptr)
-                {
-                    stats->n_cache_hits++;
-                }
+                if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
+                    continue;
+
+                if (use_filter && !filter_matcher.matches(id))
+                    continue;
+                cmps++;
+                float dist = dist_scratch[m];
+                Neighbor nn(id, dist);
+                insert_candidate(nn);
             }
+        }
+    };
+
+    // lambda to expand a node from the sectors read into its frontier buffer
+    auto expand_frontier_nhood = [&](const std::pair<uint32_t, char *> &frontier_nhood) {
+        char *node_disk_buf = offset_to_node(frontier_nhood.second, frontier_nhood.first);
+        uint32_t *node_buf = offset_to_node_nhood(node_disk_buf);
+        uint64_t nnbrs = (uint64_t)(*node_buf);
+        T *node_fp_coords = offset_to_node_coords(node_disk_buf);
+        memcpy(data_buf, node_fp_coords, _disk_bytes_per_point);
+        float cur_expanded_dist;
+        if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist = _dist_cmp->compare(aligned_query_T, data_buf, (uint32_t)_aligned_dim);
+        }
+        else
+        {
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)data_buf);
             else
+                cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)data_buf);
+        }
+        full_retset.push_back(Neighbor(frontier_nhood.first, cur_expanded_dist));
+        uint32_t *node_nbrs = (node_buf + 1);
+        // compute node_nbrs <-> query dist in PQ space
+        cpu_timer.reset();
+        compute_dists(node_nbrs, nnbrs, dist_scratch);
+        if (stats != nullptr)
+        {
+            stats->n_cmps += (uint32_t)nnbrs;
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+
+        cpu_timer.reset();
+        // process prefetch-ed nhood
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t id = node_nbrs[m];
+            if (visited.insert(id))
             {
-                frontier.push_back(nbr.id);
+                if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
+                    continue;
+
+                if (use_filter && !filter_matcher.matches(id))
+                    continue;
+                cmps++;
+                float dist = dist_scratch[m];
+                if (stats != nullptr)
+                {
+                    stats->n_cmps++;
+                }
+
+                Neighbor nn(id, dist);
+                insert_candidate(nn);
             }
-            if (this->_count_visited_nodes)
+        }
+
+        if (stats != nullptr)
+        {
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+    };
+
+    if (_use_pipelined_search)
+    {
+        // Pipelined search: keep up to beam_width node reads in flight. Each
+        // read is expanded as soon as it completes, and the closest unexpanded
+        // candidates are submitted right away to refill the pipeline, so PQ
+        // distance computation overlaps with the reads still outstanding.
+        const uint64_t slot_len = num_sectors_per_node * defaults::SECTOR_LEN;
+        const uint64_t num_slots = defaults::MAX_N_SECTOR_READS / num_sectors_per_node;
+        const uint64_t max_in_flight = (std::min)(beam_width, num_slots);
+        std::vector<uint32_t> slot_ids(num_slots);
+        std::vector<uint64_t> free_slots(num_slots);
+        std::iota(free_slots.begin(), free_slots.end(), 0);
+        std::vector<void *> completed_bufs;
+        completed_bufs.reserve(max_in_flight);
+        std::vector<uint64_t> dynamic_cached_slots;
+        dynamic_cached_slots.reserve(max_in_flight);
+        uint64_t num_in_flight = 0;
+
+        // reads still in flight when the search stops early, e.g. on a failed
+        // read, would complete into the slots of the next query on this
+        // scratch, so they are waited for on every exit path
+        struct ReadDrainer
+        {
+            AlignedFileReader &reader;
+            IOContext &ctx;
+            bool drained;
+            ~ReadDrainer()
             {
-                reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                if (!drained)
+                    reader.drain_reads(ctx);
             }
-        }
+        } drainer{*reader, ctx, false};
 
-        // read nhoods of frontier ids
-        if (!frontier.empty())
+        while (true)
         {
-            if (stats != nullptr)
-                stats->n_hops++;
-            for (uint64_t i = 0; i < frontier.size(); i++)
+            frontier_read_reqs.clear();
+            cached_nhoods.clear();
+            dynamic_cached_slots.clear();
+            while (num_in_flight + frontier_read_reqs.size() + dynamic_cached_slots.size() < max_in_flight &&
+                   retset.has_unexpanded_node() && num_ios < io_limit)
             {
-                auto id = frontier[i];
-                std::pair<uint32_t, char *> fnhood;
-                fnhood.first = id;
-                fnhood.second = sector_scratch + num_sectors_per_node * sector_scratch_idx * defaults::SECTOR_LEN;
-                sector_scratch_idx++;
-                frontier_nhoods.push_back(fnhood);
-                frontier_read_reqs.emplace_back(get_node_sector((size_t)id) * defaults::SECTOR_LEN,
-                                                num_sectors_per_node * defaults::SECTOR_LEN, fnhood.second);
+                auto nbr = retset.closest_unexpanded();
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+                auto iter = _nhood_cache.find(nbr.id);
+                if (iter != _nhood_cache.end())
+                {
+                    cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
+                    if (stats != nullptr)
+                    {
+                        stats->n_cache_hits++;
+                    }
+                    continue;
+                }
+
+                uint64_t slot = free_slots.back();
+                free_slots.pop_back();
+                slot_ids[slot] = nbr.id;
+                if (dynamic_cache != nullptr &&
+                    dynamic_cache->get(nbr.id, offset_to_node(sector_scratch + slot * slot_len, nbr.id)))
+                {
+                    dynamic_cached_slots.push_back(slot);
+                    if (stats != nullptr)
+                    {
+                        stats->n_cache_hits++;
+                    }
+                    continue;
+                }
+                frontier_read_reqs.emplace_back(get_node_sector((size_t)nbr.id) * defaults::SECTOR_LEN, slot_len,
+                                                sector_scratch + slot * slot_len);
                 if (stats != nullptr)
                 {
                     stats->n_4k++;
@@ -1463,145 +1839,253 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                 }
                 num_ios++;
             }
-            io_timer.reset();
-#ifdef USE_BING_INFRA
-            reader->read(frontier_read_reqs, ctx,
-                         true); // asynhronous reader for Bing.
-#else
-            reader->read(frontier_read_reqs, ctx); // synchronous IO linux
-#endif
-            if (stats != nullptr)
+
+            if (!frontier_read_reqs.empty())
             {
-                stats->io_us += (float)io_timer.elapsed();
+                reader->submit_reads(frontier_read_reqs, ctx);
+                num_in_flight += frontier_read_reqs.size();
             }
-        }
 
-        // process cached nhoods
-        for (auto &cached_nhood : cached_nhoods)
-        {
-            auto global_cache_iter = _coord_cache.find(cached_nhood.first);
-            T *node_fp_coords_copy = global_cache_iter->second;
-            float cur_expanded_dist;
-            if (!_use_disk_index_pq)
+            for (auto &cached_nhood : cached_nhoods)
             {
-                cur_expanded_dist = _dist_cmp->compare(aligned_query_T, node_fp_coords_copy, (uint32_t)_aligned_dim);
+                expand_cached_nhood(cached_nhood);
             }
-            else
+            for (uint64_t slot : dynamic_cached_slots)
             {
-                if (metric == diskann::Metric::INNER_PRODUCT)
-                    cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords_copy);
-                else
-                    cur_expanded_dist = _disk_pq_table.l2_distance( // disk_pq does not support OPQ yet
-                        query_float, (uint8_t *)node_fp_coords_copy);
+                expand_frontier_nhood(std::make_pair(slot_ids[slot], sector_scratch + slot * slot_len));
+                free_slots.push_back(slot);
             }
-            full_retset.push_back(Neighbor((uint32_t)cached_nhood.first, cur_expanded_dist));
+            // cached nodes may have added closer candidates, issue those first
+            if (!cached_nhoods.empty() || !dynamic_cached_slots.empty())
+                continue;
 
-            uint64_t nnbrs = cached_nhood.second.first;
-            uint32_t *node_nbrs = cached_nhood.second.second;
+            if (num_in_flight == 0)
+            {
+                drainer.drained = true;
+                break;
+            }
 
-            // compute node_nbrs <-> query dists in PQ space
-            cpu_timer.reset();
-            compute_dists(node_nbrs, nnbrs, dist_scratch);
+            completed_bufs.clear();
+            io_timer.reset();
+            reader->get_completed_reads(ctx, 1, completed_bufs);
             if (stats != nullptr)
             {
-                stats->n_cmps += (uint32_t)nnbrs;
-                stats->cpu_us += (float)cpu_timer.elapsed();
+                stats->io_us += (float)io_timer.elapsed();
             }
+            num_in_flight -= completed_bufs.size();
 
-            // process prefetched nhood
-            for (uint64_t m = 0; m < nnbrs; ++m)
+            for (void *buf : completed_bufs)
             {
-                uint32_t id = node_nbrs[m];
-                if (visited.insert(id).second)
+                uint64_t slot = ((char *)buf - sector_scratch) / slot_len;
+                expand_frontier_nhood(std::make_pair(slot_ids[slot], (char *)buf));
+                if (dynamic_cache != nullptr)
                 {
-                    if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
-                        continue;
-
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
-                        continue;
-                    cmps++;
-                    float dist = dist_scratch[m];
-                    Neighbor nn(id, dist);
-                    retset.insert(nn);
+                    dynamic_cache->insert(slot_ids[slot], offset_to_node((char *)buf, slot_ids[slot]));
                 }
+                free_slots.push_back(slot);
             }
+            // a hop is one wait for reads, however many complete in it
+            hops++;
+            if (stats != nullptr)
+                stats->n_hops++;
         }
-#ifdef USE_BING_INFRA
-        // process each frontier nhood - compute distances to unvisited nodes
-        int completedIndex = -1;
-        long requestCount = static_cast<long>(frontier_read_reqs.size());
-        // If we issued read requests and if a read is complete or there are
-        // reads in wait state, then enter the while loop.
-        while (requestCount > 0 && getNextCompletedRequest(ctx, requestCount, completedIndex))
-        {
-            assert(completedIndex >= 0);
-            auto &frontier_nhood = frontier_nhoods[completedIndex];
-            (*ctx.m_pRequestsStatus)[completedIndex] = IOContext::PROCESS_COMPLETE;
-#else
-        for (auto &frontier_nhood : frontier_nhoods)
+    }
+    else
+    {
+        while (retset.has_unexpanded_node() && num_ios < io_limit)
         {
-#endif
-            char *node_disk_buf = offset_to_node(frontier_nhood.second, frontier_nhood.first);
-            uint32_t *node_buf = offset_to_node_nhood(node_disk_buf);
-            uint64_t nnbrs = (uint64_t)(*node_buf);
-            T *node_fp_coords = offset_to_node_coords(node_disk_buf);
-            memcpy(data_buf, node_fp_coords, _disk_bytes_per_point);
-            float cur_expanded_dist;
-            if (!_use_disk_index_pq)
+            // clear iteration state
+            frontier.clear();
+            frontier_nhoods.clear();
+            frontier_read_reqs.clear();
+            cached_nhoods.clear();
+            dynamic_cached_nhoods.clear();
+            sector_scratch_idx = 0;
+            // find new beam
+            uint32_t num_seen = 0;
+            while (retset.has_unexpanded_node() && frontier.size() < beam_width && num_seen < beam_width)
             {
-                cur_expanded_dist = _dist_cmp->compare(aligned_query_T, data_buf, (uint32_t)_aligned_dim);
-            }
-            else
-            {
-                if (metric == diskann::Metric::INNER_PRODUCT)
-                    cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)data_buf);
+                auto nbr = retset.closest_unexpanded();
+                num_seen++;
+                auto iter = _nhood_cache.find(nbr.id);
+                if (iter != _nhood_cache.end())
+                {
+                    cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
+                    if (stats != nullptr)
+                    {
+                        stats->n_cache_hits++;
+                    }
+                }
                 else
-                    cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)data_buf);
-            }
-            full_retset.push_back(Neighbor(frontier_nhood.first, cur_expanded_dist));
-            uint32_t *node_nbrs = (node_buf + 1);
-            // compute node_nbrs <-> query dist in PQ space
-            cpu_timer.reset();
-            compute_dists(node_nbrs, nnbrs, dist_scratch);
-            if (stats != nullptr)
-            {
-                stats->n_cmps += (uint32_t)nnbrs;
-                stats->cpu_us += (float)cpu_timer.elapsed();
+                {
+                    // a dynamic cache hit copies the node into the next sector
+                    // buffer, where it is expanded like a node read from disk
+                    char *sector_buf =
+                        sector_scratch + num_sectors_per_node * sector_scratch_idx * defaults::SECTOR_LEN;
+                    if (dynamic_cache != nullptr && dynamic_cache->get(nbr.id, offset_to_node(sector_buf, nbr.id)))
+                    {
+                        dynamic_cached_nhoods.push_back(std::make_pair(nbr.id, sector_buf));
+                        sector_scratch_idx++;
+                        if (stats != nullptr)
+                        {
+                            stats->n_cache_hits++;
+                        }
+                    }
+                    else
+                    {
+                        frontier.push_back(nbr.id);
+                    }
+                }
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
             }
 
-            cpu_timer.reset();
-            // process prefetch-ed nhood
-            for (uint64_t m = 0; m < nnbrs; ++m)
+            // read nhoods of frontier ids
+            if (!frontier.empty())
             {
-                uint32_t id = node_nbrs[m];
-                if (visited.insert(id).second)
+                if (stats != nullptr)
+                    stats->n_hops++;
+                for (uint64_t i = 0; i < frontier.size(); i++)
                 {
-                    if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
+                    auto id = frontier[i];
+                    const uint64_t offset = get_node_sector((size_t)id) * defaults::SECTOR_LEN;
+                    std::pair<uint32_t, char *> fnhood;
+                    fnhood.first = id;
+
+#ifndef USE_BING_INFRA // completions there are matched to frontier_nhoods by index
+                    // nodes sharing a sector, as a locality layout tries to
+                    // arrange for neighbours, are expanded from one read
+                    auto same_sector = std::find_if(frontier_read_reqs.begin(), frontier_read_reqs.end(),
+                                                    [offset](const AlignedRead &req) { return req.offset == offset; });
+                    if (same_sector != frontier_read_reqs.end())
+                    {
+                        fnhood.second = (char *)same_sector->buf;
+                        frontier_nhoods.push_back(fnhood);
                         continue;
+                    }
+#endif
 
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
-                        continue;
-                    cmps++;
-                    float dist = dist_scratch[m];
+                    fnhood.second = sector_scratch + num_sectors_per_node * sector_scratch_idx * defaults::SECTOR_LEN;
+                    sector_scratch_idx++;
+                    frontier_nhoods.push_back(fnhood);
+                    frontier_read_reqs.emplace_back(offset, num_sectors_per_node * defaults::SECTOR_LEN, fnhood.second);
                     if (stats != nullptr)
                     {
-                        stats->n_cmps++;
+                        stats->n_4k++;
+                        stats->n_ios++;
                     }
-
-                    Neighbor nn(id, dist);
-                    retset.insert(nn);
+                    num_ios++;
+                }
+                io_timer.reset();
+#ifdef USE_BING_INFRA
+                reader->read(frontier_read_reqs, ctx,
+                             true); // asynhronous reader for Bing.
+#else
+                reader->read(frontier_read_reqs, ctx); // synchronous IO linux
+#endif
+                if (stats != nullptr)
+                {
+                    stats->io_us += (float)io_timer.elapsed();
                 }
             }
 
-            if (stats != nullptr)
+            // process cached nhoods
+            for (auto &cached_nhood : cached_nhoods)
             {
-                stats->cpu_us += (float)cpu_timer.elapsed();
+                expand_cached_nhood(cached_nhood);
             }
+            for (auto &dynamic_cached_nhood : dynamic_cached_nhoods)
+            {
+                expand_frontier_nhood(dynamic_cached_nhood);
+            }
+#ifdef USE_BING_INFRA
+            // process each frontier nhood - compute distances to unvisited nodes
+            int completedIndex = -1;
+            long requestCount = static_cast<long>(frontier_read_reqs.size());
+            // If we issued read requests and if a read is complete or there are
+            // reads in wait state, then enter the while loop.
+            while (requestCount > 0 && getNextCompletedRequest(ctx, requestCount, completedIndex))
+            {
+                assert(completedIndex >= 0);
+                auto &frontier_nhood = frontier_nhoods[completedIndex];
+                (*ctx.m_pRequestsStatus)[completedIndex] = IOContext::PROCESS_COMPLETE;
+#else
+            for (auto &frontier_nhood : frontier_nhoods)
+            {
+#endif
+                expand_frontier_nhood(frontier_nhood);
+                if (dynamic_cache != nullptr)
+                {
+                    dynamic_cache->insert(frontier_nhood.first,
+                                          offset_to_node(frontier_nhood.second, frontier_nhood.first));
+                }
+            }
+
+            hops++;
         }
+    }
+}
+
+template <typename T, typename LabelT>
+float PQFlashIndex<T, LabelT>::to_output_distance(const float distance, const float query_norm)
+{
+    if (metric != diskann::Metric::INNER_PRODUCT)
+        return distance;
+
+    // flip the sign to convert min to max, and rescale to revert back to
+    // original norms (cancelling the effect of base and query pre-processing)
+    float output = -distance;
+    if (_max_base_norm != 0)
+        output *= (_max_base_norm * query_norm);
+    return output;
+}
 
-        hops++;
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const bool use_filter, const LabelT &filter_label,
+                                                 const uint32_t io_limit, const bool use_reorder_data,
+                                                 QueryStats *stats)
+{
+    if (!use_filter)
+    {
+        beam_search(query1, k_search, l_search, indices, distances, beam_width, nullptr, io_limit, use_reorder_data,
+                    stats);
+        return;
+    }
+    const auto filter = FilterExpression<LabelT>::label(filter_label);
+    beam_search(query1, k_search, l_search, indices, distances, beam_width, &filter, io_limit, use_reorder_data,
+                stats);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                          uint64_t *indices, float *distances, const uint64_t beam_width,
+                                          const FilterExpression<LabelT> *filter, const uint32_t io_limit,
+                                          const bool use_reorder_data, QueryStats *stats)
+{
+    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
+    auto data = manager.scratch_space();
+    IOContext &ctx = data->ctx;
+    auto query_scratch = &(data->scratch);
+    T *aligned_query_T = query_scratch->aligned_query_T;
+    char *sector_scratch = query_scratch->sector_scratch;
+    std::vector<Neighbor> &full_retset = query_scratch->full_retset;
+    Timer query_timer, io_timer;
+
+    const float query_norm = init_beam_search(query1, data, l_search, filter);
+    expand_beam_search(data, beam_width, filter, io_limit, false, stats);
+
+    // the medoids the search started from may not match the filter
+    if (filter != nullptr)
+    {
+        const typename FilterExpression<LabelT>::Matcher filter_matcher(*filter, _label_index, _use_universal_label,
+                                                                        _universal_filter_label);
+        full_retset.erase(std::remove_if(full_retset.begin(), full_retset.end(),
+                                         [&](const Neighbor &nbr) { return !filter_matcher.matches(nbr.id); }),
+                          full_retset.end());
     }
 
     // re-sort by distance
@@ -1660,6 +2144,13 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     // copy k_search values
     for (uint64_t i = 0; i < k_search; i++)
     {
+        if (i >= full_retset.size())
+        {
+            indices[i] = std::numeric_limits<uint64_t>::max();
+            if (distances != nullptr)
+                distances[i] = std::numeric_limits<float>::max();
+            continue;
+        }
         indices[i] = full_retset[i].id;
         auto key = (uint32_t)indices[i];
         if (_dummy_pts.find(key) != _dummy_pts.end())
@@ -1669,16 +2160,7 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
 
         if (distances != nullptr)
         {
-            distances[i] = full_retset[i].distance;
-            if (metric == diskann::Metric::INNER_PRODUCT)
-            {
-                // flip the sign to convert min to max
-                distances[i] = (-distances[i]);
-                // rescale to revert back to original norms (cancelling the
-                // effect of base and query pre-processing)
-                if (_max_base_norm != 0)
-                    distances[i] *= (_max_base_norm * query_norm);
-            }
+            distances[i] = to_output_distance(full_retset[i].distance, query_norm);
         }
     }
 
@@ -1692,50 +2174,485 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     }
 }
 
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::batch_search(const T *queries, const uint64_t num_queries,
+                                           const uint64_t query_aligned_dim, const uint64_t k_search,
+                                           const uint64_t l_search, uint64_t *indices, float *distances,
+                                           const uint64_t beam_width, const bool use_reorder_data, QueryStats *stats)
+{
+    if (num_queries == 0)
+        return;
+    if (use_reorder_data && !(this->_reorder_data_exists))
+    {
+        throw ANNException("Requested use of reordering data which does not exist in index file", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+
+    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
+    auto data = manager.scratch_space();
+    IOContext &ctx = data->ctx;
+    auto query_scratch = &(data->scratch);
+    auto pq_query_scratch = query_scratch->_pq_scratch;
+
+    Timer query_timer, io_timer;
+
+    // the PQ coordinate and distance scratch, and the node coords buffer, are
+    // shared by the batch. each query keeps its own aligned copy, float copy
+    // and PQ distance table.
+    T *data_buf = query_scratch->coord_scratch;
+    float *dist_scratch = pq_query_scratch->aligned_dist_scratch;
+    uint8_t *pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
+    const uint64_t pq_table_len = NUM_PQ_CENTROIDS * _n_chunks;
+    const auto dynamic_cache = std::atomic_load(&_dynamic_cache);
+
+    T *queries_T = nullptr;
+    float *queries_float = nullptr, *queries_pq_dists = nullptr;
+    alloc_aligned((void **)&queries_T, num_queries * _aligned_dim * sizeof(T), 8 * sizeof(T));
+    alloc_aligned((void **)&queries_float, num_queries * _aligned_dim * sizeof(float), 8 * sizeof(float));
+    alloc_aligned((void **)&queries_pq_dists, num_queries * pq_table_len * sizeof(float), 256);
+    std::unique_ptr<T[], AlignedFreeDeleter> queries_T_holder(queries_T);
+    std::unique_ptr<float[], AlignedFreeDeleter> queries_float_holder(queries_float);
+    std::unique_ptr<float[], AlignedFreeDeleter> queries_pq_dists_holder(queries_pq_dists);
+    memset(queries_T, 0, num_queries * _aligned_dim * sizeof(T));
+    memset(queries_float, 0, num_queries * _aligned_dim * sizeof(float));
+
+    // the sectors read in one hop, or for re-ranking, by the whole batch
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    const uint64_t node_buf_len = num_sectors_per_node * defaults::SECTOR_LEN;
+    uint64_t max_sectors = num_queries * beam_width * num_sectors_per_node;
+    if (use_reorder_data)
+        max_sectors = (std::max)(max_sectors, num_queries * k_search * FULL_PRECISION_REORDER_MULTIPLIER);
+    char *batch_sectors = nullptr;
+    alloc_aligned((void **)&batch_sectors, max_sectors * defaults::SECTOR_LEN, defaults::SECTOR_LEN);
+    std::unique_ptr<char[], AlignedFreeDeleter> batch_sectors_holder(batch_sectors);
+
+    struct BatchQuery
+    {
+        NeighborPriorityQueue retset;
+        std::vector<Neighbor> full_retset;
+        float query_norm = 0;
+    };
+    std::vector<BatchQuery> batch(num_queries);
+
+    // the visited sets of the batch are kept in the scratch between batches,
+    // of the type the index picks for that many sets
+    std::vector<VisitedSet> &batch_visited = query_scratch->batch_visited;
+    const VisitedSetType visited_type = choose_visited_set_type(this->_max_nthreads * num_queries);
+    if (batch_visited.size() < num_queries)
+        batch_visited.resize(num_queries);
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        if (batch_visited[q].type() == visited_type && batch_visited[q].covers(_num_points))
+            batch_visited[q].clear();
+        else
+            batch_visited[q].init(visited_type, _num_points, _visited_reserve);
+    }
+
+    // each query is prepared and seeded in the scratch as cached_beam_search
+    // does, then its part of the scratch is copied out for the batch
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        batch[q].query_norm = init_beam_search(queries + q * query_aligned_dim, data, l_search, nullptr);
+        memcpy(queries_T + q * _aligned_dim, query_scratch->aligned_query_T, this->_data_dim * sizeof(T));
+        memcpy(queries_float + q * _aligned_dim, pq_query_scratch->aligned_query_float,
+               this->_data_dim * sizeof(float));
+        memcpy(queries_pq_dists + q * pq_table_len, pq_query_scratch->aligned_pqtable_dist_scratch,
+               pq_table_len * sizeof(float));
+
+        auto &seeds = query_scratch->retset;
+        batch[q].retset.reserve(l_search);
+        for (size_t i = 0; i < seeds.size(); i++)
+        {
+            batch[q].retset.insert(seeds[i]);
+            batch_visited[q].insert(seeds[i].id);
+        }
+    }
+
+    // full precision distance from query q to a node's coords
+    auto full_dist = [&](uint64_t q, T *node_coords) {
+        if (!_use_disk_index_pq)
+            return _dist_cmp->compare(queries_T + q * _aligned_dim, node_coords, (uint32_t)_aligned_dim);
+        if (metric == diskann::Metric::INNER_PRODUCT)
+            return _disk_pq_table.inner_product(queries_float + q * _aligned_dim, (uint8_t *)node_coords);
+        return _disk_pq_table.l2_distance(queries_float + q * _aligned_dim, (uint8_t *)node_coords);
+    };
+
+    // issues reqs in groups the IO context can take at once
+    std::vector<AlignedRead> read_reqs, read_group;
+    auto read_all = [&]() {
+        for (uint64_t start = 0; start < read_reqs.size(); start += defaults::MAX_N_SECTOR_READS)
+        {
+            uint64_t end = (std::min)((uint64_t)read_reqs.size(), start + defaults::MAX_N_SECTOR_READS);
+            read_group.assign(read_reqs.begin() + start, read_reqs.begin() + end);
+            reader->read(read_group, ctx);
+        }
+    };
+
+    // nodes needed by the batch in the current hop. buf is null for nodes in
+    // the static cache, and shared by nodes in the same sector. requests
+    // pairs an index into hop_nodes with a query.
+    struct HopNode
+    {
+        uint32_t id;
+        char *buf;
+        bool from_disk;
+    };
+    std::vector<HopNode> hop_nodes;
+    tsl::robin_map<uint32_t, uint32_t> hop_node_idx;
+    tsl::robin_map<uint64_t, char *> hop_sector_bufs;
+    std::vector<std::pair<uint32_t, uint32_t>> requests;
+    std::vector<uint32_t> active_queries(num_queries);
+    std::iota(active_queries.begin(), active_queries.end(), 0);
+
+    while (!active_queries.empty())
+    {
+        hop_nodes.clear();
+        hop_node_idx.clear();
+        hop_sector_bufs.clear();
+        requests.clear();
+        read_reqs.clear();
+        uint64_t num_bufs = 0;
+
+        // find the beam of every query, reading each node only once
+        uint64_t num_active = 0;
+        for (uint32_t q : active_queries)
+        {
+            auto &retset = batch[q].retset;
+            if (!retset.has_unexpanded_node())
+                continue;
+            active_queries[num_active++] = q;
+
+            uint32_t num_seen = 0, num_frontier = 0;
+            while (retset.has_unexpanded_node() && num_frontier < beam_width && num_seen < beam_width)
+            {
+                auto nbr = retset.closest_unexpanded();
+                num_seen++;
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+
+                auto iter = hop_node_idx.find(nbr.id);
+                if (iter != hop_node_idx.end())
+                {
+                    // already wanted by another query in this hop
+                    if (hop_nodes[iter->second].from_disk)
+                        num_frontier++;
+                    else if (stats != nullptr)
+                        stats[q].n_cache_hits++;
+                    requests.emplace_back(iter->second, q);
+                    continue;
+                }
+
+                HopNode node{nbr.id, nullptr, false};
+                if (_nhood_cache.find(nbr.id) == _nhood_cache.end())
+                {
+                    const uint64_t sector = get_node_sector((size_t)nbr.id);
+                    auto sector_iter = hop_sector_bufs.find(sector);
+                    if (sector_iter != hop_sector_bufs.end())
+                    {
+                        // shares a sector with a node read in this hop
+                        node.buf = sector_iter->second;
+                        node.from_disk = true;
+                        num_frontier++;
+                    }
+                    else
+                    {
+                        node.buf = batch_sectors + num_bufs * node_buf_len;
+                        num_bufs++;
+                        if (dynamic_cache == nullptr || !dynamic_cache->get(nbr.id, offset_to_node(node.buf, nbr.id)))
+                        {
+                            node.from_disk = true;
+                            num_frontier++;
+                            hop_sector_bufs[sector] = node.buf;
+                            read_reqs.emplace_back(sector * defaults::SECTOR_LEN, node_buf_len, node.buf);
+                            if (stats != nullptr)
+                            {
+                                stats[q].n_4k++;
+                                stats[q].n_ios++;
+                            }
+                        }
+                    }
+                }
+                if (!node.from_disk && stats != nullptr)
+                    stats[q].n_cache_hits++;
+
+                hop_node_idx[nbr.id] = (uint32_t)hop_nodes.size();
+                requests.emplace_back((uint32_t)hop_nodes.size(), q);
+                hop_nodes.push_back(node);
+            }
+            if (stats != nullptr && num_frontier > 0)
+                stats[q].n_hops++;
+        }
+        active_queries.resize(num_active);
+        if (requests.empty())
+            break;
+
+        io_timer.reset();
+        read_all();
+        if (stats != nullptr)
+        {
+            float io_us = (float)io_timer.elapsed();
+            for (uint32_t q : active_queries)
+                stats[q].io_us += io_us;
+        }
+
+        // expand every node for all the queries that asked for it, gathering
+        // the PQ codes of its neighbours once
+        std::sort(requests.begin(), requests.end());
+        for (uint64_t start = 0, end = 0; start < requests.size(); start = end)
+        {
+            const HopNode &node = hop_nodes[requests[start].first];
+            for (end = start; end < requests.size() && requests[end].first == requests[start].first; end++)
+                ;
+
+            T *node_coords;
+            uint64_t nnbrs;
+            uint32_t *node_nbrs;
+            if (node.buf == nullptr)
+            {
+                auto &cached_nhood = _nhood_cache.find(node.id)->second;
+                node_coords = _coord_cache.find(node.id)->second;
+                nnbrs = cached_nhood.first;
+                node_nbrs = cached_nhood.second;
+            }
+            else
+            {
+                char *node_disk_buf = offset_to_node(node.buf, node.id);
+                uint32_t *node_buf = offset_to_node_nhood(node_disk_buf);
+                nnbrs = (uint64_t)(*node_buf);
+                node_nbrs = node_buf + 1;
+                memcpy(data_buf, offset_to_node_coords(node_disk_buf), _disk_bytes_per_point);
+                node_coords = data_buf;
+                if (node.from_disk && dynamic_cache != nullptr)
+                    dynamic_cache->insert(node.id, node_disk_buf);
+            }
+            if (_pq_fast_scan)
+                diskann::aggregate_coords_fast_scan(node_nbrs, nnbrs, this->data, this->_n_chunks, pq_coord_scratch);
+            else
+                diskann::aggregate_coords(node_nbrs, nnbrs, this->data, this->_n_chunks, pq_coord_scratch);
+
+            for (uint64_t r = start; r < end; r++)
+            {
+                const uint32_t q = requests[r].second;
+                auto &query = batch[q];
+                query.full_retset.push_back(Neighbor(node.id, full_dist(q, node_coords)));
+                if (_pq_fast_scan)
+                    diskann::pq_dist_lookup_fast_scan(pq_coord_scratch, nnbrs, this->_n_chunks,
+                                                      queries_pq_dists + q * pq_table_len, dist_scratch);
+                else
+                    diskann::pq_dist_lookup(pq_coord_scratch, nnbrs, this->_n_chunks,
+                                            queries_pq_dists + q * pq_table_len, dist_scratch);
+                if (stats != nullptr)
+                    stats[q].n_cmps += (uint32_t)nnbrs;
+
+                for (uint64_t m = 0; m < nnbrs; ++m)
+                {
+                    uint32_t id = node_nbrs[m];
+                    if (batch_visited[q].insert(id))
+                    {
+                        if (_dummy_pts.find(id) != _dummy_pts.end())
+                            continue;
+                        query.retset.insert(Neighbor(id, dist_scratch[m]));
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto &query : batch)
+        std::sort(query.full_retset.begin(), query.full_retset.end());
+
+    if (use_reorder_data)
+    {
+        // read the full precision vectors of the best candidates of every
+        // query, each sector once
+        tsl::robin_map<uint64_t, char *> sector_bufs;
+        read_reqs.clear();
+        for (uint64_t q = 0; q < num_queries; q++)
+        {
+            auto &full_retset = batch[q].full_retset;
+            if (full_retset.size() > k_search * FULL_PRECISION_REORDER_MULTIPLIER)
+                full_retset.erase(full_retset.begin() + k_search * FULL_PRECISION_REORDER_MULTIPLIER,
+                                  full_retset.end());
+            for (auto &nbr : full_retset)
+            {
+                uint64_t sector = VECTOR_SECTOR_NO(nbr.id);
+                if (sector_bufs.find(sector) != sector_bufs.end())
+                    continue;
+                char *buf = batch_sectors + sector_bufs.size() * defaults::SECTOR_LEN;
+                sector_bufs[sector] = buf;
+                read_reqs.emplace_back(sector * defaults::SECTOR_LEN, defaults::SECTOR_LEN, buf);
+                if (stats != nullptr)
+                {
+                    stats[q].n_4k++;
+                    stats[q].n_ios++;
+                }
+            }
+        }
+
+        io_timer.reset();
+        read_all();
+        if (stats != nullptr)
+        {
+            float io_us = (float)io_timer.elapsed();
+            for (uint64_t q = 0; q < num_queries; q++)
+                stats[q].io_us += io_us;
+        }
+
+        for (uint64_t q = 0; q < num_queries; q++)
+        {
+            auto &full_retset = batch[q].full_retset;
+            for (auto &nbr : full_retset)
+            {
+                auto location = sector_bufs[VECTOR_SECTOR_NO(nbr.id)] + VECTOR_SECTOR_OFFSET(nbr.id);
+                nbr.distance =
+                    _dist_cmp->compare(queries_T + q * _aligned_dim, (T *)location, (uint32_t)this->_data_dim);
+            }
+            std::sort(full_retset.begin(), full_retset.end());
+        }
+    }
+
+    // copy k_search values of every query
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        auto &full_retset = batch[q].full_retset;
+        for (uint64_t i = 0; i < k_search; i++)
+        {
+            if (i >= full_retset.size())
+            {
+                indices[q * k_search + i] = std::numeric_limits<uint64_t>::max();
+                if (distances != nullptr)
+                    distances[q * k_search + i] = std::numeric_limits<float>::max();
+                continue;
+            }
+            uint64_t &id = indices[q * k_search + i];
+            id = full_retset[i].id;
+            if (_dummy_pts.find((uint32_t)id) != _dummy_pts.end())
+            {
+                id = _dummy_to_real_map[(uint32_t)id];
+            }
+
+            if (distances != nullptr)
+                distances[q * k_search + i] = to_output_distance(full_retset[i].distance, batch[q].query_norm);
+        }
+    }
+
+    if (stats != nullptr)
+    {
+        float total_us = (float)query_timer.elapsed();
+        for (uint64_t q = 0; q < num_queries; q++)
+            stats[q].total_us = total_us;
+    }
+}
+
 // range search returns results of all neighbors within distance of range.
-// indices and distances need to be pre-allocated of size l_search and the
-// return value is the number of matching hits.
+// indices and distances are resized to the number of matching hits, which is
+// also the return value.
 template <typename T, typename LabelT>
 uint32_t PQFlashIndex<T, LabelT>::range_search(const T *query1, const double range, const uint64_t min_l_search,
                                                const uint64_t max_l_search, std::vector<uint64_t> &indices,
                                                std::vector<float> &distances, const uint64_t min_beam_width,
                                                QueryStats *stats)
 {
-    uint32_t res_count = 0;
+    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
+    auto data = manager.scratch_space();
+    auto query_scratch = &(data->scratch);
+    NeighborPriorityQueue &retset = query_scratch->retset;
+    std::vector<Neighbor> &full_retset = query_scratch->full_retset;
+    std::vector<Neighbor> &dropped = query_scratch->dropped_candidates;
+    Timer query_timer;
 
-    bool stop_flag = false;
+    uint64_t l_search = min_l_search; // starting size of the candidate list
+    const float query_norm = init_beam_search(query1, data, l_search, nullptr);
 
-    uint32_t l_search = (uint32_t)min_l_search; // starting size of the candidate list
-    while (!stop_flag)
+    // Each round doubles L while the results fill at least half of the
+    // candidate list. Instead of searching again from the medoid, the next
+    // round grows the retset of the last one and puts back the candidates that
+    // fell out of it, so no node is read or PQ distance computed twice.
+    uint32_t res_count = 0;
+    while (true)
     {
-        indices.resize(l_search);
-        distances.resize(l_search);
         uint64_t cur_bw = min_beam_width > (l_search / 5) ? min_beam_width : l_search / 5;
         cur_bw = (cur_bw > 100) ? 100 : cur_bw;
-        for (auto &x : distances)
-            x = std::numeric_limits<float>::max();
-        this->cached_beam_search(query1, l_search, l_search, indices.data(), distances.data(), cur_bw, false, stats);
-        for (uint32_t i = 0; i < l_search; i++)
+        expand_beam_search(data, cur_bw, nullptr, std::numeric_limits<uint32_t>::max(), true, stats);
+
+        // the expanded nodes have full precision distances
+        std::sort(full_retset.begin(), full_retset.end());
+        res_count = 0;
+        while (res_count < full_retset.size() &&
+               to_output_distance(full_retset[res_count].distance, query_norm) <= (float)range)
         {
-            if (distances[i] > (float)range)
-            {
-                res_count = i;
-                break;
-            }
-            else if (i == l_search - 1)
-                res_count = l_search;
+            res_count++;
         }
-        if (res_count < (uint32_t)(l_search / 2.0))
-            stop_flag = true;
+
+        if (res_count < (uint32_t)(l_search / 2.0) || l_search * 2 > max_l_search)
+            break;
         l_search = l_search * 2;
-        if (l_search > max_l_search)
-            stop_flag = true;
+
+        retset.grow(l_search, dropped);
     }
+
     indices.resize(res_count);
     distances.resize(res_count);
+    for (uint32_t i = 0; i < res_count; i++)
+    {
+        indices[i] = full_retset[i].id;
+        auto key = (uint32_t)indices[i];
+        if (_dummy_pts.find(key) != _dummy_pts.end())
+        {
+            indices[i] = _dummy_to_real_map[key];
+        }
+        distances[i] = to_output_distance(full_retset[i].distance, query_norm);
+    }
+
+    if (stats != nullptr)
+    {
+        stats->total_us = (float)query_timer.elapsed();
+    }
     return res_count;
 }
 
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_dynamic_cache_budget(uint64_t ram_budget_bytes)
+{
+    if (ram_budget_bytes == 0)
+    {
+        std::atomic_store(&_dynamic_cache, std::shared_ptr<NodeCache>());
+        return;
+    }
+    auto dynamic_cache = std::make_shared<NodeCache>(ram_budget_bytes, _max_node_len);
+    diskann::cout << "Dynamic node cache holds up to " << dynamic_cache->get_capacity() << " nodes in "
+                  << ram_budget_bytes / (1024 * 1024) << "MB" << std::endl;
+    std::atomic_store(&_dynamic_cache, std::move(dynamic_cache));
+}
+
+template <typename T, typename LabelT> NodeCacheStats PQFlashIndex<T, LabelT>::get_dynamic_cache_stats()
+{
+    auto dynamic_cache = std::atomic_load(&_dynamic_cache);
+    return dynamic_cache != nullptr ? dynamic_cache->get_stats() : NodeCacheStats();
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_pipelined_search(bool use_pipelined_search)
+{
+    _use_pipelined_search = use_pipelined_search;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_visited_set_type(VisitedSetType visited_set_type)
+{
+    _visited_set_type = visited_set_type;
+    _visited_set_type_fixed = true;
+    const uint64_t nthreads = this->_max_nthreads;
+    if (nthreads > 0)
+    {
+        this->resize_thread_data(0);
+        this->setup_thread_data(nthreads, _visited_reserve);
+    }
+}
+
 template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::get_data_dim()
 {
     return _data_dim;
@@ -1767,8 +2684,9 @@ template <typename T, typename LabelT> char *PQFlashIndex<T, LabelT>::getHeaderB
 template <typename T, typename LabelT>
 std::vector<std::uint8_t> PQFlashIndex<T, LabelT>::get_pq_vector(std::uint64_t vid)
 {
-    std::uint8_t *pqVec = &this->data[vid * this->_n_chunks];
-    return std::vector<std::uint8_t>(pqVec, pqVec + this->_n_chunks);
+    const uint64_t code_len = _pq_table.get_code_len();
+    std::uint8_t *pqVec = &this->data[vid * code_len];
+    return std::vector<std::uint8_t>(pqVec, pqVec + code_len);
 }
 
 template <typename T, typename LabelT> std::uint64_t PQFlashIndex<T, LabelT>::get_num_points()
@@ -95,27 +95,42 @@ void BaseSearch::lookup_tags(const unsigned K, const unsigned *indices, std::str
 
 template <typename T>
 InMemorySearch<T>::InMemorySearch(const std::string &baseFile, const std::string &indexFile,
-                                  const std::string &tagsFile, Metric m, uint32_t num_threads, uint32_t search_l)
+                                  const std::string &tagsFile, Metric m, uint32_t num_threads, uint32_t search_l,
+                                  bool numa_replicas)
     : BaseSearch(tagsFile)
 {
     size_t dimensions, total_points = 0;
     diskann::get_bin_metadata(baseFile, total_points, dimensions);
-    auto search_params = diskann::IndexSearchParams(search_l, num_threads);
-    _index = std::unique_ptr<diskann::Index<T>>(
-        new diskann::Index<T>(m, dimensions, total_points, nullptr, search_params, 0, false));
-
-    _index->load(indexFile.c_str(), num_threads, search_l);
+    auto load = [&](uint32_t) {
+        auto search_params = std::make_shared<diskann::IndexSearchParams>(search_l, num_threads);
+        auto index = std::unique_ptr<diskann::Index<T>>(
+            new diskann::Index<T>(m, dimensions, total_points, nullptr, search_params, 0, false));
+        index->load(indexFile.c_str(), num_threads, search_l);
+        return index;
+    };
+    _index = std::unique_ptr<diskann::NumaReplicatedIndex<diskann::Index<T>>>(
+        new diskann::NumaReplicatedIndex<diskann::Index<T>>(numa_replicas ? diskann::get_num_numa_nodes() : 1, load));
 }
 
 template <typename T>
 SearchResult InMemorySearch<T>::search(const T *query, const unsigned int dimensions, const unsigned int K,
-                                       const unsigned int Ls)
+                                       const unsigned int Ls, const std::string &filter)
 {
     unsigned int *indices = new unsigned int[K];
     float *distances = new float[K];
 
     auto startTime = std::chrono::high_resolution_clock::now();
-    _index->search(query, K, Ls, indices, distances);
+    if (filter.empty())
+    {
+        _index->local().search(query, K, Ls, indices, distances);
+    }
+    else
+    {
+        std::fill(indices, indices + K, std::numeric_limits<unsigned int>::max());
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        auto &index = _index->local();
+        index.search_with_filters(query, index.get_converted_filter(filter), K, Ls, indices, distances);
+    }
     auto duration =
         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime)
             .count();
@@ -140,7 +155,8 @@ template <typename T> InMemorySearch<T>::~InMemorySearch()
 
 template <typename T>
 PQFlashSearch<T>::PQFlashSearch(const std::string &indexPrefix, const unsigned num_nodes_to_cache,
-                                const unsigned num_threads, const std::string &tagsFile, Metric m)
+                                const unsigned num_threads, const std::string &tagsFile, Metric m,
+                                std::shared_ptr<NodeCache> sector_cache)
     : BaseSearch(tagsFile)
 {
 #ifdef _WINDOWS
@@ -153,6 +169,11 @@ PQFlashSearch<T>::PQFlashSearch(const std::string &indexPrefix, const unsigned n
     auto ptr = new LinuxAlignedFileReader();
     reader.reset(ptr);
 #endif
+    if (sector_cache != nullptr)
+    {
+        _cached_reader.reset(new CachedAlignedFileReader(reader, sector_cache));
+        reader = _cached_reader;
+    }
 
     std::string index_prefix_path(indexPrefix);
     std::string disk_index_file = index_prefix_path + "_disk.index";
@@ -176,19 +197,24 @@ PQFlashSearch<T>::PQFlashSearch(const std::string &indexPrefix, const unsigned n
 
 template <typename T>
 SearchResult PQFlashSearch<T>::search(const T *query, const unsigned int dimensions, const unsigned int K,
-                                      const unsigned int Ls)
+                                      const unsigned int Ls, const std::string &filter)
 {
     uint64_t *indices_u64 = new uint64_t[K];
     unsigned *indices = new unsigned[K];
     float *distances = new float[K];
 
     auto startTime = std::chrono::high_resolution_clock::now();
-    _index->cached_beam_search(query, K, Ls, indices_u64, distances, DEFAULT_W);
+    if (filter.empty())
+        _index->cached_beam_search(query, K, Ls, indices_u64, distances, DEFAULT_W);
+    else
+        _index->cached_beam_search(query, K, Ls, indices_u64, distances, DEFAULT_W,
+                                   _index->get_converted_filter(filter));
     auto duration =
         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime)
             .count();
     for (unsigned k = 0; k < K; ++k)
-        indices[k] = indices_u64[k];
+        indices[k] = indices_u64[k] == std::numeric_limits<uint64_t>::max() ? std::numeric_limits<unsigned>::max()
+                                                                            : (unsigned)indices_u64[k];
 
     std::string *tags = nullptr;
     if (_tags_enabled)
@@ -203,6 +229,16 @@ SearchResult PQFlashSearch<T>::search(const T *query, const unsigned int dimensi
     return result;
 }
 
+template <typename T> uint64_t PQFlashSearch<T>::get_sector_cache_hits() const
+{
+    return _cached_reader != nullptr ? _cached_reader->get_hits() : 0;
+}
+
+template <typename T> uint64_t PQFlashSearch<T>::get_sector_cache_misses() const
+{
+    return _cached_reader != nullptr ? _cached_reader->get_misses() : 0;
+}
+
 template <typename T> PQFlashSearch<T>::~PQFlashSearch()
 {
 }
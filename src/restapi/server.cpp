@@ -120,13 +120,14 @@ template <class T> void Server::handle_post(web::http::http_request message)
                 T *queryVector = nullptr;
                 unsigned int dimensions = 0;
                 unsigned int Ls;
-                parseJson(body, K, queryId, queryVector, dimensions, Ls);
+                std::string filter;
+                parseJson(body, K, queryId, queryVector, dimensions, Ls, filter);
 
                 auto startTime = std::chrono::high_resolution_clock::now();
                 std::vector<diskann::SearchResult> results;
 
                 for (auto &searcher : _multi_searcher)
-                    results.push_back(searcher->search(queryVector, dimensions, (unsigned int)K, Ls));
+                    results.push_back(searcher->search(queryVector, dimensions, (unsigned int)K, Ls, filter));
                 diskann::SearchResult result = aggregate_results(K, results);
                 diskann::aligned_free(queryVector);
                 web::json::value response = prepareResponse(queryId, K);
@@ -182,7 +183,7 @@ web::json::value Server::prepareResponse(const int64_t &queryId, const int k)
 
 template <class T>
 void Server::parseJson(const utility::string_t &body, unsigned int &k, int64_t &queryId, T *&queryVector,
-                       unsigned int &dimensions, unsigned &Ls)
+                       unsigned int &dimensions, unsigned &Ls, std::string &filter)
 {
     std::cout << body << std::endl;
     web::json::value val = web::json::value::parse(body);
@@ -190,6 +191,7 @@ void Server::parseJson(const utility::string_t &body, unsigned int &k, int64_t &
     queryId = val.has_field(QUERY_ID_KEY) ? val.at(QUERY_ID_KEY).as_number().to_int64() : -1;
     Ls = val.has_field(L_KEY) ? val.at(L_KEY).as_number().to_uint32() : DEFAULT_L;
     k = val.at(K_KEY).as_integer();
+    filter = val.has_field(FILTER_KEY) ? utility::conversions::to_utf8string(val.at(FILTER_KEY).as_string()) : "";
 
     if (k <= 0 || k > Ls)
     {
@@ -2,7 +2,6 @@
 // Licensed under the MIT license.
 
 #include <vector>
-#include <boost/dynamic_bitset.hpp>
 
 #include "scratch.h"
 
@@ -26,6 +25,8 @@ InMemQueryScratch<T>::InMemQueryScratch(uint32_t search_l, uint32_t indexing_l,
 
     alloc_aligned(((void **)&_aligned_query), aligned_dim * sizeof(T), alignment_factor * sizeof(T));
     memset(_aligned_query, 0, aligned_dim * sizeof(T));
+    alloc_aligned(((void **)&_rerank_vector), aligned_dim * sizeof(T), alignment_factor * sizeof(T));
+    memset(_rerank_vector, 0, aligned_dim * sizeof(T));
 
     if (init_pq_scratch)
         _pq_scratch = new PQScratch<T>(defaults::MAX_GRAPH_DEGREE, aligned_dim);
@@ -33,9 +34,9 @@ InMemQueryScratch<T>::InMemQueryScratch(uint32_t search_l, uint32_t indexing_l,
         _pq_scratch = nullptr;
 
     _occlude_factor.reserve(maxc);
-    _inserted_into_pool_bs = new boost::dynamic_bitset<>();
     _id_scratch.reserve((size_t)std::ceil(1.5 * defaults::GRAPH_SLACK_FACTOR * _R));
     _dist_scratch.reserve((size_t)std::ceil(1.5 * defaults::GRAPH_SLACK_FACTOR * _R));
+    _neighbour_scratch.reserve((size_t)std::ceil(1.5 * defaults::GRAPH_SLACK_FACTOR * _R));
 
     resize_for_new_L(std::max(search_l, indexing_l));
 }
@@ -46,15 +47,16 @@ template <typename T> void InMemQueryScratch<T>::clear()
     _best_l_nodes.clear();
     _occlude_factor.clear();
 
-    _inserted_into_pool_rs.clear();
-    _inserted_into_pool_bs->reset();
+    _inserted_into_pool.clear();
 
     _id_scratch.clear();
     _dist_scratch.clear();
+    _neighbour_scratch.clear();
 
     _expanded_nodes_set.clear();
     _expanded_nghrs_vec.clear();
     _occlude_list_output.clear();
+    _dropped_candidates.clear();
 }
 
 template <typename T> void InMemQueryScratch<T>::resize_for_new_L(uint32_t new_l)
@@ -64,8 +66,6 @@ template <typename T> void InMemQueryScratch<T>::resize_for_new_L(uint32_t new_l
         _L = new_l;
         _pool.reserve(3 * _L + _R);
         _best_l_nodes.reserve(_L);
-
-        _inserted_into_pool_rs.reserve(20 * _L);
     }
 }
 
@@ -75,9 +75,9 @@ template <typename T> InMemQueryScratch<T>::~InMemQueryScratch()
     {
         aligned_free(_aligned_query);
     }
+    aligned_free(_rerank_vector);
 
     delete _pq_scratch;
-    delete _inserted_into_pool_bs;
 }
 
 //
@@ -89,6 +89,7 @@ template <typename T> void SSDQueryScratch<T>::reset()
     visited.clear();
     retset.clear();
     full_retset.clear();
+    dropped_candidates.clear();
 }
 
 template <typename T> SSDQueryScratch<T>::SSDQueryScratch(size_t aligned_dim, size_t visited_reserve)
@@ -105,7 +106,7 @@ template <typename T> SSDQueryScratch<T>::SSDQueryScratch(size_t aligned_dim, si
     memset(coord_scratch, 0, coord_alloc_size);
     memset(aligned_query_T, 0, aligned_dim * sizeof(T));
 
-    visited.reserve(visited_reserve);
+    visited.init(VisitedSetType::HASH_SET, 0, visited_reserve);
     full_retset.reserve(visited_reserve);
 }
 
@@ -115,7 +116,7 @@ template <typename T> SSDQueryScratch<T>::~SSDQueryScratch()
     diskann::aligned_free((void *)sector_scratch);
     diskann::aligned_free((void *)aligned_query_T);
 
-    delete[] _pq_scratch;
+    delete _pq_scratch;
 }
 
 template <typename T>
@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <limits>
+
+#include "search_iterator.h"
+#include "timer.h"
+
+namespace diskann
+{
+
+//
+// Search iterator over an in-memory index
+//
+
+template <typename T, typename TagT, typename LabelT>
+IndexSearchIterator<T, TagT, LabelT>::IndexSearchIterator(Index<T, TagT, LabelT> &index, const uint32_t L)
+    : _index(index), _initial_L(L)
+{
+    if (L == 0)
+    {
+        throw ANNException("Set L of a search iterator to a value of at least 1", -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    // sized like the query scratch set up by Index::load, the range of the
+    // graph is known only for a loaded index
+    const uint32_t max_degree = std::max((uint32_t)index._graph_store->get_max_range_of_graph(),
+                                         index._graph_store->get_max_observed_degree());
+    _scratch.reset(new InMemQueryScratch<T>(L, L, max_degree, index._indexingMaxC, index._dim,
+                                            index._data_store->get_aligned_dim(),
+                                            index._data_store->get_alignment_factor(), index._pq_dist));
+}
+
+template <typename T, typename TagT, typename LabelT> IndexSearchIterator<T, TagT, LabelT>::~IndexSearchIterator()
+{
+}
+
+template <typename T, typename TagT, typename LabelT> void IndexSearchIterator<T, TagT, LabelT>::start(const T *query)
+{
+    _scratch->clear();
+    _returned.clear();
+    _L = 0;
+    _started = true;
+    _index._data_store->get_dist_fn()->preprocess_query(query, _index._data_store->get_dims(),
+                                                        _scratch->aligned_query());
+}
+
+template <typename T, typename TagT, typename LabelT>
+void IndexSearchIterator<T, TagT, LabelT>::search_to(const uint32_t L)
+{
+    const std::vector<LabelT> unused_filter_label;
+    NeighborPriorityQueue &best_L_nodes = _scratch->best_l_nodes();
+    std::vector<Neighbor> &dropped = _scratch->dropped_candidates();
+
+    _scratch->resize_for_new_L(L);
+    if (_L == 0)
+    {
+        _index.iterate_to_fixed_point(_scratch->aligned_query(), L, _index.get_init_ids(), _scratch.get(), false,
+                                      unused_filter_label, true, &dropped);
+    }
+    else
+    {
+        // the start points are in the visited set already, the search goes on
+        // from the candidates of the last page and the ones that fell out
+        const std::vector<uint32_t> no_init_ids;
+        best_L_nodes.grow(L, dropped);
+        _scratch->id_scratch().clear();
+        _scratch->dist_scratch().clear();
+        _index.iterate_to_fixed_point(_scratch->aligned_query(), L, no_init_ids, _scratch.get(), false,
+                                      unused_filter_label, true, &dropped);
+    }
+    _L = L;
+}
+
+template <typename T, typename TagT, typename LabelT>
+template <typename IdType>
+uint32_t IndexSearchIterator<T, TagT, LabelT>::next(const uint32_t k, std::vector<IdType> &indices,
+                                                    std::vector<float> &distances, std::vector<TagT> *tags)
+{
+    if (!_started)
+    {
+        throw ANNException("Start a query on the search iterator before asking for results", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+    if (tags != nullptr && !_index._enable_tags)
+    {
+        throw ANNException("Tags asked from a search iterator on an index without tags", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+
+    indices.clear();
+    distances.clear();
+    if (tags != nullptr)
+        tags->clear();
+    if (k == 0)
+        return 0;
+
+    std::shared_lock<std::shared_timed_mutex> lock(_index._update_lock);
+    std::shared_lock<std::shared_timed_mutex> tl(_index._tag_lock, std::defer_lock);
+    if (tags != nullptr)
+        tl.lock();
+
+    NeighborPriorityQueue &best_L_nodes = _scratch->best_l_nodes();
+    const uint64_t max_L = std::numeric_limits<uint32_t>::max();
+    uint32_t L = (uint32_t)std::min(std::max((uint64_t)_initial_L, _returned.size() + k), max_L);
+    while (true)
+    {
+        if (L > _L)
+            search_to(L);
+
+        // frozen points, deleted points and the results of earlier pages take
+        // places in the candidate list, so it may hold fewer than k new ones
+        _page.clear();
+        for (size_t i = 0; i < best_L_nodes.size(); i++)
+        {
+            const Neighbor &node = best_L_nodes[i];
+            if (node.id >= _index._max_points || _returned.find(node.id) != _returned.end())
+                continue;
+            TagT tag;
+            if (tags != nullptr && !_index._location_to_tag.try_get(node.id, tag))
+                continue;
+            _page.push_back(node);
+        }
+
+        // a list that is not full has every point the search can reach
+        if (_page.size() >= k || best_L_nodes.size() < best_L_nodes.capacity() || L == max_L)
+            break;
+        L = (uint32_t)std::min((uint64_t)L + (k - _page.size()), max_L);
+    }
+
+    // the candidates are ordered by the distances the index searches with,
+    // rerank them like Index::search does before taking the closest k
+    _index.rerank_nodes(_page.data(), _page.size(), _scratch.get());
+
+    const uint32_t num_results = (uint32_t)std::min((size_t)k, _page.size());
+    indices.resize(num_results);
+    distances.resize(num_results);
+    if (tags != nullptr)
+        tags->resize(num_results);
+    for (uint32_t i = 0; i < num_results; i++)
+    {
+        const Neighbor &node = _page[i];
+        if (tags != nullptr)
+            _index._location_to_tag.try_get(node.id, (*tags)[i]);
+        // safe because Index uses uint32_t ids internally
+        // and IDType will be uint32_t or uint64_t
+        indices[i] = (IdType)node.id;
+        distances[i] = _index._dist_metric == diskann::Metric::INNER_PRODUCT ? -1 * node.distance : node.distance;
+        _returned.insert(node.id);
+    }
+    return num_results;
+}
+
+template <typename T, typename TagT, typename LabelT>
+uint64_t IndexSearchIterator<T, TagT, LabelT>::num_returned() const
+{
+    return _returned.size();
+}
+
+//
+// Search iterator over an SSD index
+//
+
+template <typename T, typename LabelT>
+PQFlashSearchIterator<T, LabelT>::PQFlashSearchIterator(PQFlashIndex<T, LabelT> &index, const uint64_t L,
+                                                        const uint64_t beam_width)
+    : _index(index), _initial_L(L), _beam_width(beam_width)
+{
+    if (L == 0 || beam_width == 0)
+    {
+        throw ANNException("Set L and beam width of a search iterator to values of at least 1", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+    _data = _index.new_thread_data(4096);
+}
+
+template <typename T, typename LabelT> PQFlashSearchIterator<T, LabelT>::~PQFlashSearchIterator()
+{
+    _index.release_thread_data(_data);
+}
+
+template <typename T, typename LabelT> void PQFlashSearchIterator<T, LabelT>::start(const T *query)
+{
+    _query_norm = _index.init_beam_search(query, _data, _initial_L, nullptr);
+    _returned.clear();
+    _L = 0;
+    _started = true;
+}
+
+template <typename T, typename LabelT>
+uint32_t PQFlashSearchIterator<T, LabelT>::next(const uint32_t k, std::vector<uint64_t> &indices,
+                                                std::vector<float> &distances, QueryStats *stats)
+{
+    if (!_started)
+    {
+        throw ANNException("Start a query on the search iterator before asking for results", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    }
+
+    indices.clear();
+    distances.clear();
+    if (k == 0)
+        return 0;
+
+    Timer query_timer;
+    NeighborPriorityQueue &retset = _data->scratch.retset;
+    std::vector<Neighbor> &full_retset = _data->scratch.full_retset;
+    std::vector<Neighbor> &dropped = _data->scratch.dropped_candidates;
+
+    uint64_t L = std::max(_initial_L, (uint64_t)_returned.size() + k);
+    while (true)
+    {
+        if (L > _L)
+        {
+            retset.grow(L, dropped);
+            _index.expand_beam_search(_data, _beam_width, nullptr, std::numeric_limits<uint32_t>::max(), true,
+                                      stats);
+            _L = L;
+        }
+
+        // full_retset holds every node read so far, with full precision
+        // distances. Filtered indices map dummy points to the real ones.
+        std::sort(full_retset.begin(), full_retset.end());
+        indices.clear();
+        distances.clear();
+        for (size_t i = 0; i < full_retset.size() && indices.size() < k; i++)
+        {
+            uint64_t id = full_retset[i].id;
+            if (_index._dummy_pts.find((uint32_t)id) != _index._dummy_pts.end())
+            {
+                id = _index._dummy_to_real_map[(uint32_t)id];
+                if (std::find(indices.begin(), indices.end(), id) != indices.end())
+                    continue;
+            }
+            if (_returned.find(id) != _returned.end())
+                continue;
+            indices.push_back(id);
+            distances.push_back(_index.to_output_distance(full_retset[i].distance, _query_norm));
+        }
+
+        // a retset that is not full has every node the search can reach
+        if (indices.size() == k || retset.size() < retset.capacity())
+            break;
+        L += k - indices.size();
+    }
+    _returned.insert(indices.begin(), indices.end());
+
+    if (stats != nullptr)
+    {
+        stats->total_us += (float)query_timer.elapsed();
+    }
+    return (uint32_t)indices.size();
+}
+
+template <typename T, typename LabelT> uint64_t PQFlashSearchIterator<T, LabelT>::num_returned() const
+{
+    return _returned.size();
+}
+
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, int32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, int32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, int32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, uint32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, uint32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, uint32_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, int64_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, int64_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, int64_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, uint64_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, uint64_t, uint32_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, uint64_t, uint32_t>;
+// Label with short int 2 byte
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, int32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, int32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, int32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, uint32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, uint32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, uint32_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, int64_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, int64_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, int64_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<float, uint64_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<int8_t, uint64_t, uint16_t>;
+template DISKANN_DLLEXPORT class IndexSearchIterator<uint8_t, uint64_t, uint16_t>;
+
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<uint8_t>;
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<int8_t>;
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<float>;
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<uint8_t, uint16_t>;
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<int8_t, uint16_t>;
+template DISKANN_DLLEXPORT class PQFlashSearchIterator<float, uint16_t>;
+
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint64_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint64_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint64_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint64_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint64_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint64_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint32_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint32_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint32_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint32_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint32_t, uint32_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint32_t, uint32_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint64_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint64_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint64_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint64_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint64_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint64_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint64_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint32_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<float, uint32_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint32_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<uint8_t, uint32_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint32_t, uint16_t>::next<uint64_t>(
+    const uint32_t k, std::vector<uint64_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+template DISKANN_DLLEXPORT uint32_t IndexSearchIterator<int8_t, uint32_t, uint16_t>::next<uint32_t>(
+    const uint32_t k, std::vector<uint32_t> &indices, std::vector<float> &distances, std::vector<uint32_t> *tags);
+
+} // namespace diskann
@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "thread_io_contexts.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+struct ThreadIOContexts::RegisteredCtx
+{
+    IOContext ctx;
+    std::mutex mut;
+    AlignedFileReader *reader = nullptr; // nullptr once ctx is destroyed
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        if (reader != nullptr)
+        {
+            reader->destroy_ctx(ctx);
+            reader = nullptr;
+        }
+    }
+    bool released()
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        return reader == nullptr;
+    }
+};
+
+namespace
+{
+struct ThreadCtx
+{
+    uint64_t registry_id;
+    std::shared_ptr<ThreadIOContexts::RegisteredCtx> registered;
+};
+
+struct ThreadCtxs
+{
+    std::vector<ThreadCtx> ctxs;
+
+    // the thread exits without deregistering
+    ~ThreadCtxs()
+    {
+        for (auto &thread_ctx : ctxs)
+        {
+            thread_ctx.registered->release();
+        }
+    }
+};
+
+// contexts the calling thread registered, with any registry
+std::vector<ThreadCtx> &thread_ctxs()
+{
+    static thread_local ThreadCtxs ctxs;
+    return ctxs.ctxs;
+}
+
+uint64_t next_registry_id()
+{
+    static std::atomic<uint64_t> next_id(1);
+    return next_id++;
+}
+} // namespace
+
+ThreadIOContexts::ThreadIOContexts(AlignedFileReader *reader) : _reader(reader), _id(next_registry_id())
+{
+}
+
+IOContext *ThreadIOContexts::find()
+{
+    const uint64_t id = _id.load(std::memory_order_acquire);
+    for (auto &thread_ctx : thread_ctxs())
+    {
+        if (thread_ctx.registry_id == id)
+        {
+            return &thread_ctx.registered->ctx;
+        }
+    }
+    return nullptr;
+}
+
+IOContext *ThreadIOContexts::register_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    auto &ctxs = thread_ctxs();
+    // entries of contexts their readers destroyed
+    ctxs.erase(std::remove_if(ctxs.begin(), ctxs.end(), [](const ThreadCtx &c) { return c.registered->released(); }),
+               ctxs.end());
+    if (find() != nullptr)
+    {
+        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
+        return nullptr;
+    }
+    ctxs.reserve(ctxs.size() + 1);
+    std::unique_lock<std::mutex> lk(_mut);
+    // contexts of threads that exited without deregistering
+    for (auto x = _registered.begin(); x != _registered.end();)
+    {
+        x = x->second->released() ? _registered.erase(x) : std::next(x);
+    }
+    auto registered = std::make_shared<RegisteredCtx>();
+    registered->ctx = _reader->create_ctx();
+    registered->reader = _reader;
+    ctxs.push_back({_id.load(), registered});
+    _registered[my_id] = registered;
+    return &registered->ctx;
+}
+
+void ThreadIOContexts::deregister_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    auto &ctxs = thread_ctxs();
+    const uint64_t id = _id.load();
+    auto iter = std::find_if(ctxs.begin(), ctxs.end(), [id](const ThreadCtx &c) { return c.registry_id == id; });
+    assert(iter != ctxs.end());
+    if (iter == ctxs.end())
+        return;
+
+    std::unique_lock<std::mutex> lk(_mut);
+    _registered.erase(my_id);
+    lk.unlock();
+
+    iter->registered->release();
+    ctxs.erase(iter);
+    std::cerr << "returned ctx from thread-id:" << my_id << std::endl;
+}
+
+void ThreadIOContexts::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(_mut);
+    for (auto x = _registered.begin(); x != _registered.end(); x++)
+    {
+        x->second->release();
+    }
+    _registered.clear();
+    // the destroyed contexts are still listed in the thread_ctxs of their
+    // threads, a new id makes find skip them
+    _id = next_registry_id();
+}
@@ -61,13 +61,44 @@ bool cpuHasAvx2Support()
     return false;
 }
 
+// AVX-512 F, BW and VL, with the OS saving the opmask and ZMM registers
+bool cpuHasAvx512Support()
+{
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+        return false;
+    __cpuid(cpuInfo, 1);
+    if ((cpuInfo[2] & (1 << 27)) == 0)
+        return false;
+    if ((_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0xE6) != 0xE6)
+        return false;
+    __cpuidex(cpuInfo, 7, 0);
+    const unsigned avx512Mask = (1u << 16) | (1u << 30) | (1u << 31);
+    return ((unsigned)cpuInfo[1] & avx512Mask) == avx512Mask;
+}
+
+bool cpuHasAvx512VnniSupport()
+{
+    if (!cpuHasAvx512Support())
+        return false;
+    int cpuInfo[4];
+    __cpuidex(cpuInfo, 7, 0);
+    return (cpuInfo[2] & (1 << 11)) != 0;
+}
+
 bool AvxSupportedCPU = cpuHasAvxSupport();
 bool Avx2SupportedCPU = cpuHasAvx2Support();
+bool Avx512SupportedCPU = cpuHasAvx512Support();
+bool Avx512VnniSupportedCPU = cpuHasAvx512VnniSupport();
 
 #else
 
 bool Avx2SupportedCPU = true;
 bool AvxSupportedCPU = false;
+bool Avx512SupportedCPU = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                          __builtin_cpu_supports("avx512vl");
+bool Avx512VnniSupportedCPU = Avx512SupportedCPU && __builtin_cpu_supports("avx512vnni");
 #endif
 
 namespace diskann
@@ -0,0 +1,248 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+#include "cached_aligned_file_reader.h"
+#include "defaults.h"
+
+namespace
+{
+const uint64_t sector_len = diskann::defaults::SECTOR_LEN;
+const uint64_t num_sectors = 16;
+
+// serves reads from memory, sector i of every file is filled with byte i
+class MemoryFileReader : public AlignedFileReader
+{
+  public:
+    uint64_t num_reads = 0;
+
+    IOContext &get_ctx()
+    {
+        return _ctx;
+    }
+    void register_thread()
+    {
+    }
+    void deregister_thread()
+    {
+    }
+    void deregister_all_threads()
+    {
+    }
+    void open(const std::string &fname)
+    {
+    }
+    void close()
+    {
+    }
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false)
+    {
+        for (auto &req : read_reqs)
+        {
+            for (uint64_t i = 0; i < req.len / sector_len; i++)
+                std::memset((char *)req.buf + i * sector_len, (int)(req.offset / sector_len + i), sector_len);
+            num_reads++;
+        }
+    }
+
+  private:
+    IOContext _ctx{};
+};
+
+// reads the file it opened, with plain streams
+class StreamFileReader : public MemoryFileReader
+{
+  public:
+    void open(const std::string &fname)
+    {
+        _fname = fname;
+    }
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false)
+    {
+        std::ifstream in(_fname, std::ios::binary);
+        for (auto &req : read_reqs)
+        {
+            in.seekg(req.offset);
+            in.read((char *)req.buf, req.len);
+            num_reads++;
+        }
+    }
+
+  private:
+    std::string _fname;
+};
+
+// num_sectors sectors of byte value
+void write_file(const std::string &fname, char value)
+{
+    std::ofstream out(fname, std::ios::binary | std::ios::trunc);
+    std::vector<char> data(num_sectors * sector_len, value);
+    out.write(data.data(), data.size());
+}
+
+struct ReaderFixture
+{
+    std::shared_ptr<MemoryFileReader> file_reader = std::make_shared<MemoryFileReader>();
+    std::shared_ptr<diskann::NodeCache> sector_cache =
+        std::make_shared<diskann::NodeCache>(num_sectors * 2 * sector_len, sector_len);
+    CachedAlignedFileReader reader{file_reader, sector_cache};
+    char *buf = nullptr;
+
+    ReaderFixture()
+    {
+        diskann::alloc_aligned((void **)&buf, 2 * sector_len, sector_len);
+        reader.open("test_file");
+    }
+    ~ReaderFixture()
+    {
+        diskann::aligned_free(buf);
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CachedAlignedFileReader_tests)
+
+BOOST_FIXTURE_TEST_CASE(test_read_through_cache, ReaderFixture)
+{
+    std::vector<AlignedRead> reqs{AlignedRead(3 * sector_len, 2 * sector_len, buf)};
+    reader.read(reqs, reader.get_ctx());
+    BOOST_TEST(file_reader->num_reads == 1u);
+    BOOST_TEST(reader.get_misses() == 1u);
+
+    std::memset(buf, 0, 2 * sector_len);
+    reader.read(reqs, reader.get_ctx());
+    BOOST_TEST(file_reader->num_reads == 1u);
+    BOOST_TEST(reader.get_hits() == 1u);
+    BOOST_TEST(buf[0] == 3);
+    BOOST_TEST(buf[sector_len] == 4);
+
+    // a request that is only partly cached goes to the file
+    reqs[0].offset = 4 * sector_len;
+    reader.read(reqs, reader.get_ctx());
+    BOOST_TEST(file_reader->num_reads == 2u);
+    BOOST_TEST(buf[sector_len] == 5);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_async_reads_through_cache, ReaderFixture)
+{
+    std::vector<AlignedRead> reqs{AlignedRead(7 * sector_len, sector_len, buf)};
+    std::vector<void *> completed;
+    for (int i = 0; i < 2; i++)
+    {
+        completed.clear();
+        reader.submit_reads(reqs, reader.get_ctx());
+        BOOST_TEST(reader.get_completed_reads(reader.get_ctx(), 1, completed) == 1u);
+        BOOST_TEST(completed.size() == 1u);
+        BOOST_TEST(completed[0] == (void *)buf);
+        BOOST_TEST(buf[0] == 7);
+    }
+    BOOST_TEST(file_reader->num_reads == 1u);
+    BOOST_TEST(reader.get_hits() == 1u);
+    BOOST_TEST(reader.get_misses() == 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_drain_drops_reads_in_flight, ReaderFixture)
+{
+    // one request served by the cache, one passed on to the file
+    std::vector<AlignedRead> reqs{AlignedRead(2 * sector_len, sector_len, buf)};
+    reader.read(reqs, reader.get_ctx());
+    reqs.emplace_back(9 * sector_len, sector_len, buf + sector_len);
+    reader.submit_reads(reqs, reader.get_ctx());
+    reader.drain_reads(reader.get_ctx());
+
+    std::vector<void *> completed;
+    BOOST_TEST(reader.get_completed_reads(reader.get_ctx(), 0, completed) == 0u);
+    BOOST_TEST(completed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_pending_reads_kept_per_reader_and_ctx)
+{
+    ReaderFixture first, second;
+    IOContext other_ctx{};
+    std::vector<AlignedRead> reqs{AlignedRead(5 * sector_len, sector_len, first.buf)};
+    first.reader.submit_reads(reqs, first.reader.get_ctx());
+
+    std::vector<void *> completed;
+    BOOST_TEST(second.reader.get_completed_reads(second.reader.get_ctx(), 0, completed) == 0u);
+    BOOST_TEST(first.reader.get_completed_reads(other_ctx, 0, completed) == 0u);
+    BOOST_TEST(completed.empty());
+
+    BOOST_TEST(first.reader.get_completed_reads(first.reader.get_ctx(), 1, completed) == 1u);
+    BOOST_TEST(completed.size() == 1u);
+    BOOST_TEST(completed[0] == (void *)first.buf);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_shared_by_readers_of_same_file)
+{
+    ReaderFixture first, second;
+    CachedAlignedFileReader shared_reader(second.file_reader, first.sector_cache);
+    shared_reader.open("test_file");
+
+    std::vector<AlignedRead> reqs{AlignedRead(0, sector_len, first.buf)};
+    first.reader.read(reqs, first.reader.get_ctx());
+    reqs[0].buf = second.buf;
+    shared_reader.read(reqs, shared_reader.get_ctx());
+    BOOST_TEST(shared_reader.get_hits() == 1u);
+    BOOST_TEST(second.file_reader->num_reads == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_rewritten_file_not_served_from_cache)
+{
+    const std::string fname = "cached_reader_test.bin";
+    ReaderFixture fixture;
+    auto file_reader = std::make_shared<StreamFileReader>();
+    CachedAlignedFileReader reader(file_reader, fixture.sector_cache);
+    std::vector<AlignedRead> reqs{AlignedRead(0, sector_len, fixture.buf)};
+
+    write_file(fname, 1);
+    reader.open(fname);
+    reader.read(reqs, reader.get_ctx());
+    BOOST_TEST(fixture.buf[0] == 1);
+
+    // a second reader of the open file shares its sectors
+    CachedAlignedFileReader other_reader(std::make_shared<StreamFileReader>(), fixture.sector_cache);
+    other_reader.open(fname);
+    other_reader.read(reqs, other_reader.get_ctx());
+    BOOST_TEST(other_reader.get_hits() == 1u);
+    other_reader.close();
+    reader.close();
+
+    write_file(fname, 2);
+    reader.open(fname);
+    reader.read(reqs, reader.get_ctx());
+    BOOST_TEST(fixture.buf[0] == 2);
+    BOOST_TEST(reader.get_misses() == 2u);
+    BOOST_TEST(file_reader->num_reads == 2u);
+    reader.close();
+    std::remove(fname.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_default_async_reads_kept_per_reader_and_ctx)
+{
+    // readers without native async support complete the batch in
+    // submit_reads, the buffers still come back on the reader and ctx only
+    ReaderFixture first, second;
+    IOContext other_ctx{};
+    std::vector<AlignedRead> reqs{AlignedRead(5 * sector_len, sector_len, first.buf)};
+    first.file_reader->submit_reads(reqs, first.file_reader->get_ctx());
+
+    std::vector<void *> completed;
+    BOOST_TEST(second.file_reader->get_completed_reads(second.file_reader->get_ctx(), 0, completed) == 0u);
+    BOOST_TEST(first.file_reader->get_completed_reads(other_ctx, 0, completed) == 0u);
+    second.file_reader->drain_reads(second.file_reader->get_ctx());
+    first.file_reader->drain_reads(other_ctx);
+    BOOST_TEST(completed.empty());
+
+    BOOST_TEST(first.file_reader->get_completed_reads(first.file_reader->get_ctx(), 1, completed) == 1u);
+    BOOST_TEST(completed.size() == 1u);
+    BOOST_TEST(completed[0] == (void *)first.buf);
+    BOOST_TEST(first.buf[0] == 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
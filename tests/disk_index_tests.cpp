@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <random>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include "disk_utils.h"
+#include "index.h"
+#include "pq.h"
+#include "pq_flash_index.h"
+#ifdef _WINDOWS
+#include "windows_aligned_file_reader.h"
+#else
+#include "linux_aligned_file_reader.h"
+#endif
+
+namespace
+{
+const size_t num_points = 1000, dim = 16, num_pq_chunks = 8;
+const uint64_t num_queries = 10, k_search = 10, l_search = 32, beam_width = 4;
+
+const std::string prefix = "disk_index_test";
+const std::string base_file = prefix + "_base.bin";
+const std::string mem_index_file = prefix + "_mem.index";
+const std::string pq_pivots_file = prefix + "_pq_pivots.bin";
+const std::string pq_compressed_file = prefix + "_pq_compressed.bin";
+const std::string plain_disk_file = prefix + "_plain_disk.index";
+const std::string layout_disk_file = prefix + "_layout_disk.index";
+
+// a disk index of the same graph and PQ data written twice, in id order and
+// in the locality layout
+struct DiskIndexFixture
+{
+    std::vector<float> data, queries;
+    // a PQFlashIndex keeps a reference to the shared_ptr of its reader, so the
+    // readers live here, in a container that does not move them
+    std::list<std::shared_ptr<AlignedFileReader>> readers;
+
+    DiskIndexFixture() : data(num_points * dim), queries(num_queries * dim)
+    {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<float> dis(0, 1);
+        for (auto &x : data)
+            x = dis(gen);
+        for (auto &x : queries)
+            x = dis(gen);
+        diskann::save_bin<float>(base_file, data.data(), num_points, dim);
+
+        auto write_params = std::make_shared<diskann::IndexWriteParameters>(
+            diskann::IndexWriteParametersBuilder(64, 32).with_num_threads(1).build());
+        auto search_params = std::make_shared<diskann::IndexSearchParams>(16, 1);
+        diskann::Index<float> index(diskann::Metric::L2, dim, num_points, write_params, search_params);
+        index.build(base_file.c_str(), num_points);
+        index.save(mem_index_file.c_str());
+
+        diskann::generate_quantized_data<float>(base_file, pq_pivots_file, pq_compressed_file, diskann::Metric::L2,
+                                                1.0, num_pq_chunks, false);
+        diskann::create_disk_layout<float>(base_file, mem_index_file, plain_disk_file);
+        diskann::create_disk_layout<float>(base_file, mem_index_file, layout_disk_file, "", true);
+    }
+
+    ~DiskIndexFixture()
+    {
+        for (const auto &file : {base_file, mem_index_file, mem_index_file + ".data", pq_pivots_file,
+                                 pq_compressed_file, plain_disk_file, layout_disk_file,
+                                 layout_disk_file + "_layout_perm.bin"})
+            std::remove(file.c_str());
+    }
+
+    std::unique_ptr<diskann::PQFlashIndex<float>> load(const std::string &disk_file)
+    {
+#ifdef _WINDOWS
+        readers.emplace_back(new WindowsAlignedFileReader());
+#else
+        readers.emplace_back(new LinuxAlignedFileReader());
+#endif
+        std::unique_ptr<diskann::PQFlashIndex<float>> flash_index(
+            new diskann::PQFlashIndex<float>(readers.back(), diskann::Metric::L2));
+        flash_index->load_from_separate_paths(2, disk_file.c_str(), pq_pivots_file.c_str(),
+                                              pq_compressed_file.c_str());
+        return flash_index;
+    }
+
+    // k_search ids and distances of every query, with cached_beam_search or
+    // batch_search
+    void search(diskann::PQFlashIndex<float> &flash_index, bool batch, std::vector<uint64_t> &ids,
+                std::vector<float> &dists)
+    {
+        ids.assign(num_queries * k_search, 0);
+        dists.assign(num_queries * k_search, 0);
+        if (batch)
+        {
+            flash_index.batch_search(queries.data(), num_queries, dim, k_search, l_search, ids.data(), dists.data(),
+                                     beam_width);
+            return;
+        }
+        for (uint64_t q = 0; q < num_queries; q++)
+            flash_index.cached_beam_search(queries.data() + q * dim, k_search, l_search, ids.data() + q * k_search,
+                                           dists.data() + q * k_search, beam_width);
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(DiskIndex_tests, DiskIndexFixture)
+
+BOOST_AUTO_TEST_CASE(test_locality_layout_keeps_results)
+{
+    std::ifstream layout_file(layout_disk_file + "_layout_perm.bin");
+    BOOST_REQUIRE(layout_file.good());
+
+    auto plain_index = load(plain_disk_file);
+    auto layout_index = load(layout_disk_file);
+    for (bool batch : {false, true})
+    {
+        std::vector<uint64_t> plain_ids, layout_ids;
+        std::vector<float> plain_dists, layout_dists;
+        search(*plain_index, batch, plain_ids, plain_dists);
+        search(*layout_index, batch, layout_ids, layout_dists);
+        BOOST_TEST(plain_ids == layout_ids, boost::test_tools::per_element());
+        BOOST_TEST(plain_dists == layout_dists, boost::test_tools::per_element());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_search_matches_cached_beam_search)
+{
+    auto flash_index = load(plain_disk_file);
+    for (bool node_cache : {false, true})
+    {
+        if (node_cache)
+        {
+            std::vector<uint32_t> node_list;
+            flash_index->cache_bfs_levels(num_points / 10, node_list);
+            flash_index->load_cache_list(node_list);
+        }
+        std::vector<uint64_t> beam_ids, batch_ids;
+        std::vector<float> beam_dists, batch_dists;
+        search(*flash_index, false, beam_ids, beam_dists);
+        search(*flash_index, true, batch_ids, batch_dists);
+        BOOST_TEST(beam_ids == batch_ids, boost::test_tools::per_element());
+        BOOST_TEST(beam_dists == batch_dists, boost::test_tools::per_element());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_exact_visited_sets_keep_results)
+{
+    auto flash_index = load(plain_disk_file);
+    std::vector<uint64_t> expected_ids;
+    std::vector<float> expected_dists;
+    search(*flash_index, false, expected_ids, expected_dists);
+
+    // the small index picks a visited set by itself, any exact one can be set
+    for (auto type : {diskann::VisitedSetType::HASH_SET, diskann::VisitedSetType::EPOCH_ARRAY,
+                      diskann::VisitedSetType::BITSET})
+    {
+        flash_index->set_visited_set_type(type);
+        for (bool batch : {false, true})
+        {
+            std::vector<uint64_t> ids;
+            std::vector<float> dists;
+            search(*flash_index, batch, ids, dists);
+            BOOST_TEST(ids == expected_ids, boost::test_tools::per_element());
+            BOOST_TEST(dists == expected_dists, boost::test_tools::per_element());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_dynamic_cache_budget_changes_during_search)
+{
+    auto flash_index = load(plain_disk_file);
+    std::vector<uint64_t> expected_ids;
+    std::vector<float> expected_dists;
+    search(*flash_index, false, expected_ids, expected_dists);
+
+    // the cache only serves node records read from disk, so searches see the
+    // same results whether it is there, swapped or removed mid-search
+    bool same_results = true;
+    std::thread searcher([&]() {
+        for (int round = 0; round < 20; round++)
+        {
+            for (bool batch : {false, true})
+            {
+                std::vector<uint64_t> ids;
+                std::vector<float> dists;
+                search(*flash_index, batch, ids, dists);
+                same_results = same_results && ids == expected_ids && dists == expected_dists;
+            }
+        }
+    });
+    for (int i = 0; i < 200; i++)
+        flash_index->set_dynamic_cache_budget(i % 2 == 0 ? 1024 * 1024 : 0);
+    searcher.join();
+    BOOST_TEST(same_results);
+}
+
+BOOST_AUTO_TEST_CASE(test_rejects_invalid_layout)
+{
+    const std::string layout_file = layout_disk_file + "_layout_perm.bin";
+    std::unique_ptr<uint32_t[]> layout;
+    size_t npts, ndims;
+    diskann::load_bin<uint32_t>(layout_file, layout, npts, ndims);
+
+    // an id twice, and so another one missing
+    std::vector<uint32_t> bad(layout.get(), layout.get() + npts);
+    bad[1] = bad[0];
+    diskann::save_bin<uint32_t>(layout_file, bad.data(), npts, 1);
+    BOOST_CHECK_THROW(load(layout_disk_file), diskann::ANNException);
+
+    // an id past the last point
+    bad[1] = (uint32_t)num_points;
+    diskann::save_bin<uint32_t>(layout_file, bad.data(), npts, 1);
+    BOOST_CHECK_THROW(load(layout_disk_file), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_CASE(test_rejects_too_many_pq_chunks)
+{
+    // R L B M T disk_PQ reorder build_PQ QD locality_layout PQ_bits, with QD
+    // past MAX_PQ_CHUNKS
+    const std::string qd_prefix = prefix + "_qd";
+    const std::string params = "32 64 0.001 1 1 0 0 0 " + std::to_string(MAX_PQ_CHUNKS + 1) + " 0 4";
+    BOOST_TEST(diskann::build_disk_index<float>(base_file.c_str(), qd_prefix.c_str(), params.c_str(),
+                                                diskann::Metric::L2) == -1);
+    // nothing was built
+    BOOST_TEST(!file_exists(qd_prefix + "_pq_pivots.bin"));
+    BOOST_TEST(!file_exists(qd_prefix + "_mem.index"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "distance.h"
+#include "distance_kernels.h"
+#include "utils.h"
+
+namespace
+{
+template <typename T> float reference_l2(const T *a, const T *b, uint32_t length)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < length; i++)
+        sum += ((double)a[i] - (double)b[i]) * ((double)a[i] - (double)b[i]);
+    return (float)sum;
+}
+
+template <typename T> float reference_inner_product(const T *a, const T *b, uint32_t length)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < length; i++)
+        sum += (double)a[i] * (double)b[i];
+    return (float)-sum;
+}
+
+template <typename T> float reference_cosine(const T *a, const T *b, uint32_t length)
+{
+    double dot = 0, norm_a = 0, norm_b = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        dot += (double)a[i] * (double)b[i];
+        norm_a += (double)a[i] * (double)a[i];
+        norm_b += (double)b[i] * (double)b[i];
+    }
+    return (float)(1.0 - dot / std::sqrt(norm_a * norm_b));
+}
+
+bool close(float got, float expected)
+{
+    return std::fabs(got - expected) <= 1e-4f * std::max(1.0f, std::fabs(expected));
+}
+
+// compares every kernel of the table against the scalar reference, for all
+// lengths up to max_length and unaligned starting points
+void check_kernels(const diskann::DistanceKernels &kernels)
+{
+    const uint32_t max_length = 100;
+    std::mt19937 gen{7};
+    std::normal_distribution<float> normal_rand{0, 1};
+    std::uniform_int_distribution<int> int_rand(-127, 127);
+    std::uniform_int_distribution<int> uint_rand(0, 255);
+
+    std::vector<float> fa(max_length + 1), fb(max_length + 1);
+    std::vector<int8_t> ia(max_length + 1), ib(max_length + 1);
+    std::vector<uint8_t> ua(max_length + 1), ub(max_length + 1);
+    // odd bytes, so that no prefix is a zero vector with an undefined cosine
+    for (uint32_t i = 0; i <= max_length; i++)
+    {
+        fa[i] = normal_rand(gen), fb[i] = normal_rand(gen);
+        ia[i] = (int8_t)(int_rand(gen) | 1), ib[i] = (int8_t)(int_rand(gen) | 1);
+        ua[i] = (uint8_t)(uint_rand(gen) | 1), ub[i] = (uint8_t)(uint_rand(gen) | 1);
+    }
+
+    for (uint32_t length = 1; length <= max_length; length++)
+    {
+        BOOST_TEST_CONTEXT(kernels.name << " length " << length)
+        {
+            const float *fx = fa.data() + 1, *fy = fb.data();
+            BOOST_TEST(close(kernels.l2_float(fx, fy, length), reference_l2(fx, fy, length)));
+            BOOST_TEST(close(kernels.inner_product_float(fx, fy, length), reference_inner_product(fx, fy, length)));
+            BOOST_TEST(close(kernels.cosine_float(fx, fy, length), reference_cosine(fx, fy, length)));
+
+            const int8_t *ix = ia.data() + 1, *iy = ib.data();
+            BOOST_TEST(close(kernels.l2_int8(ix, iy, length), reference_l2(ix, iy, length)));
+            BOOST_TEST(close(kernels.cosine_int8(ix, iy, length), reference_cosine(ix, iy, length)));
+
+            const uint8_t *ux = ua.data() + 1, *uy = ub.data();
+            BOOST_TEST(close(kernels.l2_uint8(ux, uy, length), reference_l2(ux, uy, length)));
+            BOOST_TEST(close(kernels.cosine_uint8(ux, uy, length), reference_cosine(ux, uy, length)));
+        }
+    }
+}
+
+// compare_batch must return what compare does for every id, including
+// repeated ones and batches shorter than the prefetch distance
+template <typename T> void check_compare_batch(diskann::Metric metric)
+{
+    const uint32_t dim = 104, npts = 64;
+    std::mt19937 gen{3};
+    std::uniform_int_distribution<int> value_rand(std::is_same<T, uint8_t>::value ? 0 : -100, 100);
+    T *data = nullptr;
+    diskann::alloc_aligned((void **)&data, npts * dim * sizeof(T), 64);
+    for (uint32_t i = 0; i < npts * dim; i++)
+        data[i] = (T)value_rand(gen);
+
+    std::unique_ptr<diskann::Distance<T>> distance(diskann::get_distance_function<T>(metric));
+    const std::vector<uint32_t> ids{7, 0, 63, 7, 13, 21, 3};
+    std::vector<float> distances(ids.size());
+    for (uint32_t count : {0u, 1u, 2u, (uint32_t)ids.size()})
+    {
+        distance->compare_batch(data + dim, data, dim, ids.data(), count, dim, distances.data());
+        for (uint32_t i = 0; i < count; i++)
+            BOOST_TEST(distances[i] == distance->compare(data + dim, data + ids[i] * dim, dim));
+    }
+    diskann::aligned_free(data);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DistanceKernels_tests)
+
+BOOST_AUTO_TEST_CASE(test_avx512_kernels_match_reference)
+{
+    if (diskann::get_avx512_distance_kernels() == nullptr)
+        return;
+    check_kernels(*diskann::get_avx512_distance_kernels());
+}
+
+BOOST_AUTO_TEST_CASE(test_avx512_vnni_kernels_match_reference)
+{
+    if (diskann::get_avx512_vnni_distance_kernels() == nullptr)
+        return;
+    check_kernels(*diskann::get_avx512_vnni_distance_kernels());
+}
+
+BOOST_AUTO_TEST_CASE(test_dispatch_picks_widest_supported_kernels)
+{
+    const diskann::DistanceKernels &kernels = diskann::get_distance_kernels();
+    if (diskann::get_avx512_vnni_distance_kernels() != nullptr)
+        BOOST_TEST(&kernels == diskann::get_avx512_vnni_distance_kernels());
+    else if (diskann::get_avx512_distance_kernels() != nullptr)
+        BOOST_TEST(&kernels == diskann::get_avx512_distance_kernels());
+    else
+        BOOST_TEST(&kernels == &diskann::get_baseline_distance_kernels());
+}
+
+BOOST_AUTO_TEST_CASE(test_compare_batch_matches_compare)
+{
+    for (auto metric : {diskann::Metric::L2, diskann::Metric::COSINE})
+    {
+        check_compare_batch<float>(metric);
+        check_compare_batch<int8_t>(metric);
+        check_compare_batch<uint8_t>(metric);
+    }
+    check_compare_batch<float>(diskann::Metric::INNER_PRODUCT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ann_exception.h"
+#include "filter_expression.h"
+
+namespace
+{
+// labels a to z are 1 to 26
+uint32_t convert_label(const std::string &raw_label)
+{
+    if (raw_label.size() != 1 || raw_label[0] < 'a' || raw_label[0] > 'z')
+        throw diskann::ANNException("Unknown label " + raw_label, -1);
+    return raw_label[0] - 'a' + 1;
+}
+
+diskann::FilterExpression<uint32_t> parse(const std::string &expression)
+{
+    return diskann::FilterExpression<uint32_t>::parse(expression, convert_label);
+}
+
+// point i has label j in 1 to 5 if bit j - 1 of i is set, and points 32 to
+// 63 also have the universal label
+bool point_has_label(const uint32_t point, const uint32_t label)
+{
+    if (label == 100)
+        return point >= 32;
+    return (point >> (label - 1)) & 1;
+}
+
+struct LabelIndexFixture
+{
+    const uint32_t num_points = 64;
+    diskann::LabelBitmapIndex<uint32_t> index;
+
+    LabelIndexFixture()
+    {
+        index.reset(num_points);
+        for (uint32_t point = 0; point < num_points; point++)
+        {
+            std::vector<uint32_t> labels;
+            for (uint32_t label : {1, 2, 3, 4, 5, 100})
+            {
+                if (point_has_label(point, label))
+                    labels.push_back(label);
+            }
+            index.add_point(point, labels.data(), (uint32_t)labels.size());
+        }
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(FilterExpression_tests, LabelIndexFixture)
+
+BOOST_AUTO_TEST_CASE(test_matches_like_boolean_formula)
+{
+    const std::vector<std::pair<std::string, bool (*)(bool, bool, bool, bool, bool)>> cases = {
+        {"a", [](bool a, bool, bool, bool, bool) { return a; }},
+        {"a AND (b OR c)", [](bool a, bool b, bool c, bool, bool) { return a && (b || c); }},
+        {"a OR b AND c", [](bool a, bool b, bool c, bool, bool) { return a || (b && c); }},
+        {"NOT a", [](bool a, bool, bool, bool, bool) { return !a; }},
+        {"NOT (a AND NOT b)", [](bool a, bool b, bool, bool, bool) { return !(a && !b); }},
+        {"(a OR b) AND (c OR d) AND NOT e",
+         [](bool a, bool b, bool c, bool d, bool e) { return (a || b) && (c || d) && !e; }},
+        {"a AND NOT a", [](bool, bool, bool, bool, bool) { return false; }},
+        {"NOT NOT (b)", [](bool, bool b, bool, bool, bool) { return b; }},
+    };
+
+    for (const auto &test : cases)
+    {
+        const auto filter = parse(test.first);
+        const diskann::FilterExpression<uint32_t>::Matcher matcher(filter, index, false, 100);
+        for (uint32_t point = 0; point < num_points; point++)
+        {
+            const bool expected = test.second(point & 1, point & 2, point & 4, point & 8, point & 16);
+            auto has_label = [point](const uint32_t label) { return point_has_label(point, label); };
+            BOOST_TEST_INFO(test.first << " on point " << point);
+            BOOST_TEST(matcher.matches(point) == expected);
+            BOOST_TEST(filter.matches(has_label, false) == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_universal_label_has_required_labels)
+{
+    // a point with the universal label has a and b, but is still excluded by
+    // the labels it has
+    const auto filter = parse("a AND b AND NOT c");
+    const diskann::FilterExpression<uint32_t>::Matcher matcher(filter, index, true, 100);
+    for (uint32_t point = 0; point < num_points; point++)
+    {
+        const bool expected = (point >= 32 || ((point & 1) && (point & 2))) && !(point & 4);
+        BOOST_TEST(matcher.matches(point) == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_clauses)
+{
+    const auto filter = parse("(a OR b) AND NOT c");
+    BOOST_TEST(filter.clauses().size() == 2u);
+    BOOST_TEST(filter.clauses()[0].labels == std::vector<uint32_t>{1});
+    BOOST_TEST(filter.clauses()[0].excluded_labels == std::vector<uint32_t>{3});
+    BOOST_TEST(filter.clauses()[1].labels == std::vector<uint32_t>{2});
+
+    // a clause without required labels, for which a search starts from the
+    // start points of the index
+    const auto negation = parse("NOT (a OR b)");
+    BOOST_TEST(negation.clauses().size() == 1u);
+    BOOST_TEST(negation.clauses()[0].labels.empty());
+    BOOST_TEST(negation.clauses()[0].excluded_labels == (std::vector<uint32_t>{1, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_malformed_expressions)
+{
+    for (const std::string expression : {"", "a AND", "(a OR b", "a b", "OR a", "a AND ()", "NOT", "a )", "A"})
+    {
+        BOOST_TEST_INFO(expression);
+        BOOST_CHECK_THROW(parse(expression), diskann::ANNException);
+    }
+
+    // the same clauses are kept once
+    std::string expression = "(a OR b)";
+    for (uint32_t i = 0; i < 8; i++)
+        expression += " AND (a OR b)";
+    BOOST_TEST(parse(expression).clauses().size() == 3u);
+
+    // 2^9 clauses once expanded
+    expression = "(a OR b)";
+    for (char label = 'c'; label < 'c' + 16; label += 2)
+        expression += " AND (" + std::string(1, label) + " OR " + std::string(1, label + 1) + ")";
+    BOOST_CHECK_THROW(parse(expression), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
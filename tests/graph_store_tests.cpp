@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstdio>
+
+#include <boost/test/unit_test.hpp>
+
+#include "index_factory.h"
+
+namespace
+{
+const diskann::GraphStoreStrategy strategies[] = {diskann::GraphStoreStrategy::MEMORY,
+                                                  diskann::GraphStoreStrategy::COMPRESSED,
+                                                  diskann::GraphStoreStrategy::FLAT};
+
+std::vector<uint32_t> sorted(std::vector<uint32_t> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(GraphStore_tests)
+
+BOOST_AUTO_TEST_CASE(test_set_add_swap)
+{
+    const size_t num_points = 8, reserve_degree = 16;
+    for (auto strategy : strategies)
+    {
+        auto store = diskann::IndexFactory::construct_graphstore(strategy, num_points, reserve_degree);
+
+        std::vector<uint32_t> nbrs = {7, 3, 5};
+        store->set_neighbours(0, nbrs);
+        for (uint32_t id = 1; id <= 6; id++)
+        {
+            store->add_neighbour(1, id);
+        }
+
+        std::vector<uint32_t> out;
+        BOOST_TEST(store->get_neighbours(0, out) == 3u);
+        BOOST_TEST(sorted(out) == sorted(nbrs));
+        std::vector<uint32_t> buffer;
+        auto view = store->get_neighbours_view(0, buffer);
+        BOOST_TEST(sorted(std::vector<uint32_t>(view.begin(), view.end())) == sorted(nbrs));
+        // the flat store hands out its row instead of a copy
+        if (strategy == diskann::GraphStoreStrategy::FLAT)
+            BOOST_TEST(buffer.empty());
+        BOOST_TEST(store->get_degree(1) == 6u);
+        BOOST_TEST(sorted(store->get_neighbours(1)) == std::vector<uint32_t>({1, 2, 3, 4, 5, 6}));
+
+        store->swap_neighbours(0, 1);
+        BOOST_TEST(store->get_degree(0) == 6u);
+        BOOST_TEST(sorted(store->get_neighbours(1)) == sorted(nbrs));
+
+        store->clear_neighbours(0);
+        BOOST_TEST(store->get_degree(0) == 0u);
+        BOOST_TEST(store->get_max_observed_degree() == 6u);
+    }
+}
+
+// All strategies write the same graph file, so any of them can load it.
+BOOST_AUTO_TEST_CASE(test_store_load_across_strategies)
+{
+    const size_t num_points = 5, reserve_degree = 8;
+    const std::string graph_file = "graph_store_tests.graph";
+
+    for (auto writer : strategies)
+    {
+        auto store = diskann::IndexFactory::construct_graphstore(writer, num_points, reserve_degree);
+        for (uint32_t i = 0; i < num_points; i++)
+        {
+            std::vector<uint32_t> nbrs;
+            for (uint32_t j = 0; j <= i; j++)
+                nbrs.push_back((i + j + 1) % num_points);
+            store->set_neighbours(i, nbrs);
+        }
+        store->store(graph_file, num_points, 0, 2);
+
+        for (auto reader : strategies)
+        {
+            auto loaded = diskann::IndexFactory::construct_graphstore(reader, num_points, 0);
+            auto res = loaded->load(graph_file, num_points);
+            BOOST_TEST(std::get<0>(res) == (uint32_t)num_points);
+            BOOST_TEST(std::get<1>(res) == 2u);
+            for (uint32_t i = 0; i < num_points; i++)
+            {
+                BOOST_TEST(sorted(loaded->get_neighbours(i)) == sorted(store->get_neighbours(i)));
+            }
+        }
+    }
+    std::remove(graph_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_release_build_memory)
+{
+    const size_t num_points = 100, reserve_degree = 64;
+    for (auto strategy : strategies)
+    {
+        auto store = diskann::IndexFactory::construct_graphstore(strategy, num_points, reserve_degree);
+        for (uint32_t i = 0; i < num_points; i++)
+        {
+            for (uint32_t j = 1; j <= 4; j++)
+                store->add_neighbour(i, (i + j) % num_points);
+        }
+        const size_t bytes = store->get_memory_in_bytes();
+        store->release_build_memory();
+        // the compressed store frees its append slots, the others keep theirs
+        if (strategy == diskann::GraphStoreStrategy::COMPRESSED)
+            BOOST_TEST(store->get_memory_in_bytes() < bytes);
+        BOOST_TEST(sorted(store->get_neighbours(7)) == std::vector<uint32_t>({8, 9, 10, 11}));
+
+        // edges can still be added, just no longer in place
+        store->add_neighbour(7, 50);
+        BOOST_TEST(sorted(store->get_neighbours(7)) == std::vector<uint32_t>({8, 9, 10, 11, 50}));
+        store->swap_neighbours(7, 8);
+        BOOST_TEST(store->get_degree(8) == 5u);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
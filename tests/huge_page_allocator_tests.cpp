@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstdint>
+
+#include <boost/test/unit_test.hpp>
+
+#include "huge_page_allocator.h"
+#include "utils.h"
+
+namespace
+{
+// restores the process wide configuration at the end of a test
+struct ConfigGuard
+{
+    diskann::HugePageConfig saved = diskann::get_huge_page_config();
+    ~ConfigGuard()
+    {
+        diskann::set_huge_page_config(saved);
+    }
+};
+
+size_t total_bytes(const diskann::HugePageStats &stats)
+{
+    return stats.regular_bytes + stats.transparent_bytes + stats.huge_2mb_bytes + stats.huge_1gb_bytes;
+}
+
+bool all_zero(const char *buf, size_t size)
+{
+    return std::all_of(buf, buf + size, [](char c) { return c == 0; });
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HugePageAllocator_tests)
+
+BOOST_AUTO_TEST_CASE(test_every_policy_falls_back_to_usable_memory)
+{
+    ConfigGuard guard;
+    const size_t size = 3 * diskann::HUGE_PAGE_MIN_ALLOCATION + 4096;
+    for (auto policy : {diskann::HugePagePolicy::NONE, diskann::HugePagePolicy::TRANSPARENT,
+                        diskann::HugePagePolicy::HUGE_2MB, diskann::HugePagePolicy::HUGE_1GB})
+    {
+        diskann::HugePageConfig config;
+        config.page_policy = policy;
+        diskann::set_huge_page_config(config);
+
+        const auto before = diskann::get_huge_page_stats();
+        char *buf = nullptr;
+        diskann::huge_page_alloc((void **)&buf, size, 64);
+        BOOST_REQUIRE(buf != nullptr);
+        BOOST_TEST(IS_ALIGNED(buf, 64));
+        BOOST_TEST(all_zero(buf, size));
+        std::fill(buf, buf + size, 1);
+
+        const auto during = diskann::get_huge_page_stats();
+        BOOST_TEST(during.num_allocations == before.num_allocations + 1);
+        BOOST_TEST(total_bytes(during) >= total_bytes(before) + size);
+
+        diskann::huge_page_free(buf);
+        const auto after = diskann::get_huge_page_stats();
+        BOOST_TEST(after.num_allocations == before.num_allocations);
+        BOOST_TEST(total_bytes(after) == total_bytes(before));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_small_allocations_are_not_tracked)
+{
+    const auto before = diskann::get_huge_page_stats();
+    char *buf = nullptr;
+    diskann::huge_page_alloc((void **)&buf, 4096, 4096);
+    BOOST_TEST(IS_ALIGNED(buf, 4096));
+    BOOST_TEST(all_zero(buf, 4096));
+    BOOST_TEST(diskann::get_huge_page_stats().num_allocations == before.num_allocations);
+    diskann::huge_page_free(buf);
+    diskann::huge_page_free(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_config)
+{
+    BOOST_TEST((diskann::HugePageConfig().page_policy == diskann::HugePagePolicy::NONE));
+
+    auto config = diskann::parse_huge_page_config("2mb", "interleave");
+    BOOST_TEST((config.page_policy == diskann::HugePagePolicy::HUGE_2MB));
+    BOOST_TEST((config.numa_policy == diskann::NumaPolicy::INTERLEAVE));
+
+    config = diskann::parse_huge_page_config("none", "1");
+    BOOST_TEST((config.page_policy == diskann::HugePagePolicy::NONE));
+    BOOST_TEST((config.numa_policy == diskann::NumaPolicy::BIND));
+    BOOST_TEST(config.numa_node == 1);
+
+    BOOST_CHECK_THROW(diskann::parse_huge_page_config("4kb", "none"), diskann::ANNException);
+    BOOST_CHECK_THROW(diskann::parse_huge_page_config("none", "-1"), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "index.h"
+#include "utils.h"
+
+// Data and indices shared by the unit tests
+namespace index_test_utils
+{
+// npts vectors of dim standard normal values
+inline std::vector<float> random_vectors(size_t npts, size_t dim, uint32_t seed)
+{
+    std::mt19937 gen{seed};
+    std::normal_distribution<float> normal_rand{0, 1};
+    std::vector<float> data(npts * dim);
+    for (auto &value : data)
+        value = normal_rand(gen);
+    return data;
+}
+
+// squared l2 distances from the query to each of the points in data, with
+// their ids, closest first
+inline std::vector<std::pair<float, uint32_t>> brute_force(const float *query, const std::vector<float> &data,
+                                                           size_t dim)
+{
+    std::vector<std::pair<float, uint32_t>> res;
+    for (uint32_t i = 0; i < data.size() / dim; i++)
+    {
+        float dist = 0;
+        for (size_t d = 0; d < dim; d++)
+            dist += (query[d] - data[i * dim + d]) * (query[d] - data[i * dim + d]);
+        res.emplace_back(dist, i);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+// writes a pq pivots file in the layout of generate_pq_pivots: the
+// tables.size() / centroid.size() centers, the centroid and the chunk offsets
+inline void save_pq_pivots(const std::string &path, const std::vector<float> &tables,
+                           const std::vector<float> &centroid, const std::vector<uint32_t> &chunk_offsets)
+{
+    const size_t dim = centroid.size();
+    std::vector<size_t> cumul_bytes(4, 0);
+    cumul_bytes[0] = METADATA_SIZE;
+    cumul_bytes[1] = cumul_bytes[0] + diskann::save_bin<float>(path, (float *)tables.data(), tables.size() / dim, dim,
+                                                               cumul_bytes[0]);
+    cumul_bytes[2] =
+        cumul_bytes[1] + diskann::save_bin<float>(path, (float *)centroid.data(), dim, 1, cumul_bytes[1]);
+    cumul_bytes[3] = cumul_bytes[2] + diskann::save_bin<uint32_t>(path, (uint32_t *)chunk_offsets.data(),
+                                                                  chunk_offsets.size(), 1, cumul_bytes[2]);
+    diskann::save_bin<size_t>(path, cumul_bytes.data(), cumul_bytes.size(), 1, 0);
+}
+
+// A static in-memory index of num_points uniform random points, built from
+// memory with the tags id + tag_offset
+struct InMemIndexFixture
+{
+    static constexpr size_t num_points = 1000, dim = 8;
+    static constexpr uint32_t tag_offset = 1000;
+
+    std::vector<float> data;
+    std::vector<uint32_t> tags;
+    std::unique_ptr<diskann::Index<float>> index;
+
+    explicit InMemIndexFixture(uint32_t seed) : data(num_points * dim), tags(num_points)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dis(0, 1);
+        for (auto &x : data)
+            x = dis(gen);
+        for (uint32_t i = 0; i < num_points; i++)
+            tags[i] = i + tag_offset;
+
+        auto write_params = std::make_shared<diskann::IndexWriteParameters>(
+            diskann::IndexWriteParametersBuilder(64, 32).with_num_threads(1).build());
+        auto search_params = std::make_shared<diskann::IndexSearchParams>(16, 1);
+        index.reset(new diskann::Index<float>(diskann::Metric::L2, dim, num_points, write_params, search_params, 0,
+                                              false, true));
+        index->build(data.data(), num_points, tags);
+    }
+
+    std::vector<std::pair<float, uint32_t>> brute_force(const float *query) const
+    {
+        return index_test_utils::brute_force(query, data, dim);
+    }
+};
+} // namespace index_test_utils
@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <random>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "label_bitmap_index.h"
+
+BOOST_AUTO_TEST_SUITE(LabelBitmapIndex_tests)
+
+BOOST_AUTO_TEST_CASE(test_roaring_bitmap_matches_set)
+{
+    std::mt19937 gen(3);
+    diskann::RoaringBitmap bitmap;
+    std::set<uint32_t> expected;
+
+    // a dense chunk that turns into a bitmap, a sparse one, and ids added
+    // out of order across chunks
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        const uint32_t id = (1 << 16) + (uint32_t)(gen() % (1 << 16));
+        bitmap.add(id);
+        expected.insert(id);
+    }
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        const uint32_t id = (uint32_t)(gen() % (1 << 16));
+        bitmap.add(id);
+        expected.insert(id);
+    }
+    bitmap.add(std::numeric_limits<uint32_t>::max());
+    expected.insert(std::numeric_limits<uint32_t>::max());
+    bitmap.add(5 << 16);
+    bitmap.add(5 << 16);
+    expected.insert(5 << 16);
+
+    BOOST_TEST(bitmap.cardinality() == expected.size());
+    for (uint32_t id = 0; id < (3 << 16); id++)
+        BOOST_TEST_REQUIRE(bitmap.contains(id) == (expected.count(id) == 1));
+    BOOST_TEST(bitmap.contains(5 << 16));
+    BOOST_TEST(!bitmap.contains((5 << 16) + 1));
+    BOOST_TEST(bitmap.contains(std::numeric_limits<uint32_t>::max()));
+    BOOST_TEST(!bitmap.contains(std::numeric_limits<uint32_t>::max() - 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_label_index)
+{
+    // point i has label i % 7, every third point also has label 100, and
+    // point 9 has none
+    const uint32_t num_points = 50;
+    diskann::LabelBitmapIndex<uint32_t> index;
+    BOOST_TEST(index.empty());
+    index.reset(num_points);
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        std::vector<uint32_t> labels{i % 7};
+        if (i % 3 == 0)
+            labels.push_back(100);
+        if (i != 9)
+            index.add_point(i, labels.data(), (uint32_t)labels.size());
+    }
+    index.shrink_to_fit();
+    BOOST_TEST(!index.empty());
+    BOOST_TEST(index.num_labels() == 8u);
+
+    const auto matcher = index.matcher(100);
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        BOOST_TEST(index.has_label(i, i % 7) == (i != 9));
+        BOOST_TEST(index.has_label(i, (i + 1) % 7) == false);
+        BOOST_TEST(index.has_label(i, 100) == (i % 3 == 0 && i != 9));
+        BOOST_TEST(matcher.matches(i) == index.has_label(i, 100));
+        BOOST_TEST(index.has_label(i, 5000) == false);
+    }
+
+    std::vector<uint32_t> labels;
+    std::vector<uint64_t> counts;
+    index.get_label_counts(labels, counts);
+    BOOST_TEST(labels.size() == 8u);
+    uint64_t total = 0;
+    for (size_t i = 0; i < labels.size(); i++)
+    {
+        // label 0 is on 8 points, label 2 on 6 without point 9, the others on 7
+        const uint64_t expected = labels[i] == 100 ? 16 : (labels[i] == 0 ? 8 : (labels[i] == 2 ? 6 : 7));
+        BOOST_TEST(counts[i] == expected);
+        total += counts[i];
+    }
+    BOOST_TEST(total == 49u + 16u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef _WINDOWS
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "defaults.h"
+#include "linux_aligned_file_reader.h"
+#include "utils.h"
+
+namespace
+{
+const uint64_t sector_len = diskann::defaults::SECTOR_LEN;
+const uint64_t num_sectors = 16;
+
+// the next io_submit with more than submit_accept iocbs accepts only
+// submit_accept of them, and the call after it fails with -EIO
+long submit_accept = 0;
+bool fail_next_submit = false;
+
+// iocbs accepted by io_submit and events returned by io_getevents, the two
+// are equal when no read is in flight
+uint64_t num_submitted = 0;
+uint64_t num_reaped = 0;
+} // namespace
+
+// interpose libaio so the test can make io_submit accept part of a batch
+extern "C" int io_submit(io_context_t ctx, long nr, struct iocb *ios[])
+{
+    using io_submit_fn = int (*)(io_context_t, long, struct iocb **);
+    static io_submit_fn real_io_submit = (io_submit_fn)dlsym(RTLD_NEXT, "io_submit");
+    if (fail_next_submit)
+    {
+        fail_next_submit = false;
+        return -EIO;
+    }
+    if (submit_accept > 0 && nr > submit_accept)
+    {
+        nr = submit_accept;
+        submit_accept = 0;
+        fail_next_submit = true;
+    }
+    int ret = real_io_submit(ctx, nr, ios);
+    if (ret > 0)
+        num_submitted += ret;
+    return ret;
+}
+
+extern "C" int io_getevents(io_context_t ctx, long min_nr, long nr, struct io_event *events, struct timespec *timeout)
+{
+    using io_getevents_fn = int (*)(io_context_t, long, long, struct io_event *, struct timespec *);
+    static io_getevents_fn real_io_getevents = (io_getevents_fn)dlsym(RTLD_NEXT, "io_getevents");
+    int ret = real_io_getevents(ctx, min_nr, nr, events, timeout);
+    if (ret > 0)
+        num_reaped += ret;
+    return ret;
+}
+
+namespace
+{
+// sector i of the file is filled with byte i
+struct LinuxReaderFixture
+{
+    const std::string file_name = "linux_aligned_file_reader_test.bin";
+    LinuxAlignedFileReader reader;
+    IOContext ctx;
+    char *buf = nullptr;
+
+    LinuxReaderFixture()
+    {
+        {
+            std::ofstream writer(file_name, std::ios::binary);
+            std::vector<char> sector(sector_len);
+            for (uint64_t i = 0; i < num_sectors; i++)
+            {
+                std::memset(sector.data(), (int)i, sector_len);
+                writer.write(sector.data(), sector_len);
+            }
+        }
+        reader.open(file_name);
+        ctx = reader.create_ctx();
+        diskann::alloc_aligned((void **)&buf, num_sectors * sector_len, sector_len);
+        std::memset(buf, 0xff, num_sectors * sector_len);
+    }
+
+    ~LinuxReaderFixture()
+    {
+        reader.destroy_ctx(ctx);
+        reader.close();
+        diskann::aligned_free(buf);
+        std::remove(file_name.c_str());
+        submit_accept = 0;
+        fail_next_submit = false;
+    }
+
+    // reads of sectors [first, first + count) into the same sectors of buf
+    std::vector<AlignedRead> sector_reads(uint64_t first, uint64_t count)
+    {
+        std::vector<AlignedRead> reqs;
+        for (uint64_t i = first; i < first + count; i++)
+            reqs.emplace_back(i * sector_len, sector_len, buf + i * sector_len);
+        return reqs;
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LinuxAlignedFileReader_tests)
+
+BOOST_FIXTURE_TEST_CASE(read_reaps_partially_submitted_batch, LinuxReaderFixture)
+{
+    auto reqs = sector_reads(0, 4);
+    submit_accept = 2;
+    BOOST_REQUIRE_THROW(reader.read(reqs, ctx), diskann::ANNException);
+
+    // the accepted reads are back before read throws
+    BOOST_TEST(num_submitted == num_reaped);
+    BOOST_TEST(buf[0] == 0);
+    BOOST_TEST(buf[sector_len] == 1);
+
+    // and their completions do not leak into the next batch
+    reqs = sector_reads(4, 4);
+    reader.read(reqs, ctx);
+    BOOST_TEST(num_submitted == num_reaped);
+    for (uint64_t i = 4; i < 8; i++)
+        BOOST_TEST(buf[i * sector_len] == (char)i);
+}
+
+BOOST_FIXTURE_TEST_CASE(submit_reads_reaps_partially_submitted_batch, LinuxReaderFixture)
+{
+    // reads of an earlier batch are in flight while the next one fails
+    auto pending = sector_reads(0, 3);
+    reader.submit_reads(pending, ctx);
+
+    auto reqs = sector_reads(3, 4);
+    submit_accept = 2;
+    BOOST_REQUIRE_THROW(reader.submit_reads(reqs, ctx), diskann::ANNException);
+    BOOST_TEST(buf[3 * sector_len] == 3);
+    BOOST_TEST(buf[4 * sector_len] == 4);
+
+    // only the earlier batch comes back, whether or not it completed while
+    // the failed one was reaped
+    std::vector<void *> completed;
+    BOOST_TEST(reader.get_completed_reads(ctx, 3, completed) == 3);
+    BOOST_TEST(num_submitted == num_reaped);
+    for (uint64_t i = 0; i < 3; i++)
+        BOOST_TEST((std::find(completed.begin(), completed.end(), buf + i * sector_len) != completed.end()));
+    completed.clear();
+    BOOST_TEST(reader.get_completed_reads(ctx, 0, completed) == 0);
+
+    // every slot is usable again
+    reqs = sector_reads(0, num_sectors);
+    reader.submit_reads(reqs, ctx);
+    BOOST_TEST(reader.get_completed_reads(ctx, num_sectors, completed) == num_sectors);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include "neighbor.h"
+
+namespace
+{
+// a full queue of capacity 3 with ids 0, 1, 2 at distances 0, 1, 2
+diskann::NeighborPriorityQueue full_queue()
+{
+    diskann::NeighborPriorityQueue queue(3);
+    for (uint32_t i = 0; i < 3; i++)
+        queue.insert(diskann::Neighbor(i, (float)i));
+    return queue;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(NeighborPriorityQueue_tests)
+
+BOOST_AUTO_TEST_CASE(test_insert_drops_evicted_last)
+{
+    auto queue = full_queue();
+    std::vector<diskann::Neighbor> dropped;
+    queue.insert(diskann::Neighbor(3, 0.5f), dropped);
+    BOOST_TEST(queue.size() == 3);
+    BOOST_TEST(queue[1].id == 3);
+    BOOST_REQUIRE(dropped.size() == 1);
+    BOOST_TEST(dropped[0].id == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_drops_item_past_last)
+{
+    auto queue = full_queue();
+    std::vector<diskann::Neighbor> dropped;
+    queue.insert(diskann::Neighbor(3, 5.0f), dropped);
+    // a tie with the last item is ordered by id
+    queue.insert(diskann::Neighbor(4, 2.0f), dropped);
+    BOOST_TEST(queue[2].id == 2);
+    BOOST_REQUIRE(dropped.size() == 2);
+    BOOST_TEST(dropped[0].id == 3);
+    BOOST_TEST(dropped[1].id == 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_keeps_last_on_duplicate)
+{
+    auto queue = full_queue();
+    std::vector<diskann::Neighbor> dropped;
+    queue.insert(diskann::Neighbor(1, 1.0f), dropped);
+    queue.insert(diskann::Neighbor(2, 2.0f), dropped);
+    BOOST_TEST(dropped.empty());
+    BOOST_TEST(queue.size() == 3);
+    for (uint32_t i = 0; i < 3; i++)
+        BOOST_TEST(queue[i].id == i);
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_forgets_expanded_last)
+{
+    auto queue = full_queue();
+    for (uint32_t i = 0; i < 3; i++)
+        queue.closest_unexpanded();
+    std::vector<diskann::Neighbor> dropped;
+    queue.insert(diskann::Neighbor(3, 0.5f), dropped);
+    BOOST_TEST(dropped.empty());
+    BOOST_TEST(queue.has_unexpanded_node());
+    BOOST_TEST(queue.closest_unexpanded().id == 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_grow_reinserts_dropped)
+{
+    auto queue = full_queue();
+    std::vector<diskann::Neighbor> dropped;
+    for (uint32_t i = 3; i < 7; i++)
+        queue.insert(diskann::Neighbor(i, (float)i), dropped);
+    BOOST_TEST(dropped.size() == 4);
+
+    // room for two of the four, the others stay dropped
+    queue.grow(5, dropped);
+    BOOST_TEST(queue.size() == 5);
+    for (uint32_t i = 0; i < 5; i++)
+        BOOST_TEST(queue[i].id == i);
+    BOOST_REQUIRE(dropped.size() == 2);
+    BOOST_TEST(dropped[0].id == 5);
+    BOOST_TEST(dropped[1].id == 6);
+
+    queue.grow(8, dropped);
+    BOOST_TEST(queue.size() == 7);
+    BOOST_TEST(dropped.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
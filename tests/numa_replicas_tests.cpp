@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <omp.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "numa_replicas.h"
+
+namespace
+{
+struct Replica
+{
+    uint32_t node;
+    std::thread::id loaded_by;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(NumaReplicas_tests)
+
+BOOST_AUTO_TEST_CASE(test_single_replica_is_loaded_in_place)
+{
+    diskann::NumaReplicatedIndex<Replica> replicas(1, [](uint32_t node) {
+        return std::unique_ptr<Replica>(new Replica{node, std::this_thread::get_id()});
+    });
+    BOOST_TEST(replicas.num_replicas() == 1u);
+    BOOST_TEST((replicas.local().loaded_by == std::this_thread::get_id()));
+    BOOST_TEST(&replicas.local() == &replicas.replica(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_threads_find_the_replica_of_their_node)
+{
+    // more replicas than nodes still works, the extra threads are not pinned
+    const uint32_t num_replicas = 3;
+    diskann::NumaReplicatedIndex<Replica> replicas(num_replicas, [](uint32_t node) {
+        return std::unique_ptr<Replica>(new Replica{node, std::this_thread::get_id()});
+    });
+    BOOST_TEST(replicas.num_replicas() == num_replicas);
+    for (uint32_t node = 0; node < num_replicas; node++)
+    {
+        BOOST_TEST(replicas.replica(node).node == node);
+        BOOST_TEST((replicas.replica(node).loaded_by != std::this_thread::get_id()));
+    }
+
+    // new threads are spread round robin and keep their node
+    std::vector<uint32_t> first(2 * num_replicas), second(2 * num_replicas);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < first.size(); i++)
+    {
+        threads.emplace_back([&, i]() {
+            first[i] = replicas.local().node;
+            second[i] = replicas.local().node;
+        });
+        threads.back().join();
+    }
+    BOOST_TEST(first == second);
+    BOOST_TEST(std::set<uint32_t>(first.begin(), first.end()).size() == num_replicas);
+
+    // OpenMP threads are split in blocks over the nodes
+    replicas.scheduler().pin_omp_threads(2 * num_replicas);
+    std::vector<uint32_t> omp_nodes(2 * num_replicas);
+#pragma omp parallel num_threads(2 * num_replicas)
+    omp_nodes[omp_get_thread_num()] = replicas.local().node;
+    BOOST_TEST(omp_nodes == std::vector<uint32_t>({0, 0, 1, 1, 2, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_load_errors_are_rethrown)
+{
+    auto load = [](uint32_t node) -> std::unique_ptr<Replica> {
+        if (node == 1)
+            throw std::runtime_error("cannot load");
+        return std::unique_ptr<Replica>(new Replica{node, std::this_thread::get_id()});
+    };
+    BOOST_CHECK_THROW(diskann::NumaReplicatedIndex<Replica>(2, load), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cstdio>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "in_mem_data_store.h"
+#include "packed_data_store.h"
+#include "packed_graph_store.h"
+#include "index_test_utils.h"
+#include "utils.h"
+
+namespace
+{
+const size_t num_points = 100;
+const size_t dim = 37;
+const size_t max_degree = 12;
+
+std::vector<uint32_t> neighbours_of(uint32_t i)
+{
+    std::vector<uint32_t> nbrs;
+    for (uint32_t j = 0; j < i % (max_degree + 1); j++)
+        nbrs.push_back((i * 7 + j * 13) % num_points);
+    return nbrs;
+}
+
+std::unique_ptr<diskann::Distance<float>> l2()
+{
+    return std::unique_ptr<diskann::Distance<float>>(diskann::get_distance_function<float>(diskann::Metric::L2));
+}
+
+std::shared_ptr<diskann::PackedNodeStore> make_nodes(size_t capacity)
+{
+    return std::make_shared<diskann::PackedNodeStore>(capacity, dim, sizeof(float), ROUND_UP(dim, 8) * sizeof(float),
+                                                      max_degree);
+}
+
+// fills the vectors and the lists of the first num_points rows
+void fill(std::shared_ptr<diskann::PackedNodeStore> nodes, const std::vector<float> &data)
+{
+    diskann::PackedDataStore<float> data_store(nodes, l2());
+    diskann::PackedGraphStore graph_store(nodes);
+    data_store.populate_data(data.data(), (diskann::location_t)num_points);
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        auto nbrs = neighbours_of(i);
+        graph_store.set_neighbours(i, nbrs);
+    }
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PackedLayout_tests)
+
+BOOST_AUTO_TEST_CASE(test_views_match_regular_stores)
+{
+    const auto data = index_test_utils::random_vectors(num_points + 1, dim, 17);
+    auto nodes = make_nodes(num_points);
+    BOOST_TEST(nodes->row_size() % 64 == 0u);
+    fill(nodes, data);
+
+    diskann::PackedDataStore<float> packed(nodes, l2());
+    diskann::InMemDataStore<float> regular((diskann::location_t)num_points, dim, l2());
+    regular.populate_data(data.data(), (diskann::location_t)num_points);
+    BOOST_TEST(packed.get_aligned_dim() == regular.get_aligned_dim());
+
+    std::vector<float> query(regular.get_aligned_dim(), 0);
+    std::copy(data.begin() + num_points * dim, data.end(), query.begin());
+    std::vector<diskann::location_t> locations{5, 0, 99, 5, 42, 17, 63};
+    std::vector<float> packed_distances(locations.size()), regular_distances(locations.size());
+    packed.get_distance(query.data(), locations.data(), (uint32_t)locations.size(), packed_distances.data());
+    regular.get_distance(query.data(), locations.data(), (uint32_t)locations.size(), regular_distances.data());
+    BOOST_TEST(packed_distances == regular_distances);
+    BOOST_TEST(packed.get_distance(3, 8) == regular.get_distance(3, 8));
+
+    // moving adjacency lists leaves the vectors where they are
+    diskann::PackedGraphStore graph(nodes);
+    std::vector<float> before(dim), after(dim);
+    packed.get_vector(7, before.data());
+    graph.swap_neighbours(7, 8);
+    packed.get_vector(7, after.data());
+    BOOST_TEST(before == after);
+    BOOST_TEST(graph.get_neighbours(7) == neighbours_of(8));
+    BOOST_TEST(graph.get_neighbours(8) == neighbours_of(7));
+    BOOST_TEST(graph.get_max_observed_degree() == (uint32_t)max_degree);
+}
+
+BOOST_AUTO_TEST_CASE(test_capacity_and_degree_are_fixed)
+{
+    auto nodes = make_nodes(num_points);
+    diskann::PackedDataStore<float> data_store(nodes, l2());
+    diskann::PackedGraphStore graph_store(nodes);
+
+    std::vector<uint32_t> too_many(max_degree + 1, 1);
+    BOOST_CHECK_THROW(graph_store.set_neighbours(0, too_many), diskann::ANNException);
+    too_many.pop_back();
+    graph_store.set_neighbours(0, too_many);
+    BOOST_CHECK_THROW(graph_store.add_neighbour(0, 2), diskann::ANNException);
+
+    BOOST_CHECK_THROW(data_store.resize((diskann::location_t)num_points + 1), diskann::ANNException);
+    BOOST_CHECK_THROW(graph_store.resize_graph(num_points + 1), diskann::ANNException);
+    BOOST_TEST(data_store.resize((diskann::location_t)num_points / 2) == (diskann::location_t)num_points);
+}
+
+BOOST_AUTO_TEST_CASE(test_save_and_load)
+{
+    const std::string packed_file = "packed_layout_test.packed";
+    const auto data = index_test_utils::random_vectors(num_points, dim, 17);
+    auto nodes = make_nodes(num_points);
+    fill(nodes, data);
+    nodes->save(packed_file, num_points, 1, 42);
+
+    const auto header = diskann::PackedNodeStore::read_header(packed_file);
+    BOOST_TEST(header.num_points == num_points);
+    BOOST_TEST(header.num_frozen_points == 1u);
+    BOOST_TEST(header.start == 42u);
+    BOOST_TEST(header.dim == dim);
+    BOOST_TEST(header.row_size == nodes->row_size());
+    BOOST_CHECK_THROW(diskann::PackedNodeStore::load(packed_file, num_points - 1), diskann::ANNException);
+
+    // the extra capacity is left empty
+    auto loaded = diskann::PackedNodeStore::load(packed_file, num_points + 10);
+    diskann::PackedDataStore<float> data_store(loaded, l2());
+    diskann::PackedGraphStore graph_store(loaded);
+    BOOST_TEST(data_store.capacity() == (diskann::location_t)(num_points + 10));
+    std::vector<float> vector(dim);
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        data_store.get_vector(i, vector.data());
+        BOOST_TEST(std::equal(vector.begin(), vector.end(), data.begin() + i * dim));
+        BOOST_TEST(graph_store.get_neighbours(i) == neighbours_of(i));
+    }
+    BOOST_TEST(graph_store.get_degree((diskann::location_t)num_points) == 0u);
+    std::remove(packed_file.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
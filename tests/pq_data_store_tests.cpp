@@ -0,0 +1,241 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "defaults.h"
+#include "index.h"
+#include "index_test_utils.h"
+#include "pq_data_store.h"
+#include "utils.h"
+
+namespace
+{
+const size_t num_points = 300;
+const size_t dim = 16;
+const size_t num_chunks = 4;
+
+// handcrafted pivots, so that no k-means training is needed: chunk k covers
+// dimensions [4k, 4k + 4) and every center is distinct within every chunk
+struct Pivots
+{
+    std::vector<float> tables = std::vector<float>(NUM_PQ_CENTROIDS * dim);
+    std::vector<float> centroid = std::vector<float>(dim);
+    std::vector<uint32_t> chunk_offsets{0, 4, 8, 12, 16};
+
+    Pivots()
+    {
+        for (size_t c = 0; c < NUM_PQ_CENTROIDS; c++)
+            for (size_t j = 0; j < dim; j++)
+                tables[c * dim + j] = (float)((c * 7 + j * 13) % 256) / 16.0f;
+        for (size_t j = 0; j < dim; j++)
+            centroid[j] = 0.5f * (float)j;
+    }
+
+    void save(const std::string &pivots_file) const
+    {
+        index_test_utils::save_pq_pivots(pivots_file, tables, centroid, chunk_offsets);
+    }
+
+    // a vector that is exactly the reconstruction of its code
+    std::vector<float> vector(size_t i) const
+    {
+        std::vector<float> v(dim);
+        for (size_t k = 0; k < num_chunks; k++)
+        {
+            const size_t code = (i * 31 + k * 17) % NUM_PQ_CENTROIDS;
+            for (uint32_t j = chunk_offsets[k]; j < chunk_offsets[k + 1]; j++)
+                v[j] = tables[code * dim + j] + centroid[j];
+        }
+        return v;
+    }
+};
+
+float l2(const float *a, const float *b)
+{
+    float sum = 0;
+    for (size_t d = 0; d < dim; d++)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+
+std::unique_ptr<diskann::PQDataStore<float>> make_store(size_t chunks = num_chunks)
+{
+    std::unique_ptr<diskann::Distance<float>> distance(diskann::get_distance_function<float>(diskann::Metric::L2));
+    return std::make_unique<diskann::PQDataStore<float>>((diskann::location_t)num_points, dim, chunks, false,
+                                                         std::move(distance));
+}
+
+// writes the data file and the pivots that load picks up next to it
+std::vector<float> write_data(const std::string &data_file)
+{
+    Pivots pivots;
+    pivots.save(data_file + "_pq_pivots.bin");
+    std::vector<float> data;
+    for (size_t i = 0; i < num_points; i++)
+    {
+        const auto v = pivots.vector(i);
+        data.insert(data.end(), v.begin(), v.end());
+    }
+    diskann::save_bin<float>(data_file, data.data(), num_points, dim);
+    return data;
+}
+
+void remove_files(const std::string &data_file)
+{
+    std::remove(data_file.c_str());
+    std::remove((data_file + "_pq_pivots.bin").c_str());
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PQDataStore_tests)
+
+BOOST_AUTO_TEST_CASE(test_distances_from_codes)
+{
+    const std::string data_file = "pq_data_store_test.data";
+    const auto data = write_data(data_file);
+    auto store = make_store();
+    BOOST_TEST(store->load(data_file) == num_points);
+
+    std::vector<float> vector(dim);
+    for (diskann::location_t i = 0; i < num_points; i++)
+    {
+        store->get_vector(i, vector.data());
+        BOOST_TEST(l2(vector.data(), data.data() + i * dim) <= 1e-8f);
+    }
+    for (diskann::location_t i = 0; i + 1 < num_points; i += 7)
+    {
+        const float exact = l2(data.data() + i * dim, data.data() + (i + 1) * dim);
+        BOOST_TEST(std::fabs(store->get_distance(i, i + 1) - exact) <= 1e-4f * std::max(1.0f, exact));
+    }
+
+    // asymmetric distances, through the per-query tables of the scratch
+    std::mt19937 gen{5};
+    std::normal_distribution<float> normal_rand{4, 4};
+    std::vector<float> query(store->get_aligned_dim(), 0);
+    for (size_t d = 0; d < dim; d++)
+        query[d] = normal_rand(gen);
+    auto scratch =
+        std::make_unique<diskann::PQScratch<float>>(diskann::defaults::MAX_GRAPH_DEGREE, store->get_aligned_dim());
+    store->preprocess_query(query.data(), scratch.get());
+
+    std::vector<diskann::location_t> locations(num_points);
+    for (diskann::location_t i = 0; i < num_points; i++)
+        locations[i] = i;
+    std::vector<float> distances(num_points), decoded_distances(num_points);
+    store->get_distance(query.data(), locations.data(), (uint32_t)num_points, distances.data(), scratch.get());
+    store->get_distance(query.data(), locations.data(), (uint32_t)num_points, decoded_distances.data());
+    for (size_t i = 0; i < num_points; i++)
+    {
+        const float exact = l2(query.data(), data.data() + i * dim);
+        BOOST_TEST(std::fabs(distances[i] - exact) <= 1e-4f * std::max(1.0f, exact));
+        BOOST_TEST(std::fabs(decoded_distances[i] - exact) <= 1e-4f * std::max(1.0f, exact));
+    }
+    remove_files(data_file);
+}
+
+BOOST_AUTO_TEST_CASE(test_set_vector_encodes_after_training)
+{
+    const std::string data_file = "pq_data_store_set_test.data";
+    const auto data = write_data(data_file);
+    std::vector<float> vector(dim);
+
+    auto untrained = make_store();
+    BOOST_CHECK_THROW(untrained->set_vector(0, data.data()), diskann::ANNException);
+
+    auto store = make_store();
+    store->load(data_file);
+    store->set_vector(0, data.data() + 5 * dim);
+    store->get_vector(0, vector.data());
+    BOOST_TEST(l2(vector.data(), data.data() + 5 * dim) <= 1e-8f);
+
+    // a point off the codebook is encoded to its nearest reconstruction
+    std::vector<float> shifted(data.begin() + 9 * dim, data.begin() + 10 * dim);
+    shifted[3] += 1e-3f;
+    store->set_vector(1, shifted.data());
+    store->get_vector(1, vector.data());
+    BOOST_TEST(l2(vector.data(), data.data() + 9 * dim) <= 1e-8f);
+    remove_files(data_file);
+}
+
+BOOST_AUTO_TEST_CASE(test_save_and_load_infer_chunks)
+{
+    const std::string data_file = "pq_data_store_save_test.data";
+    const std::string saved_file = "pq_data_store_saved_test.data";
+    const auto data = write_data(data_file);
+    auto store = make_store();
+    store->load(data_file);
+    store->save(saved_file, (diskann::location_t)num_points);
+
+    auto loaded = make_store(0);
+    BOOST_TEST(loaded->load(saved_file) == num_points);
+    BOOST_TEST(loaded->get_num_chunks() == num_chunks);
+    std::vector<float> before(dim), after(dim);
+    for (diskann::location_t i = 0; i < num_points; i++)
+    {
+        store->get_vector(i, before.data());
+        loaded->get_vector(i, after.data());
+        BOOST_TEST(l2(before.data(), after.data()) <= 1e-8f);
+    }
+    remove_files(data_file);
+    remove_files(saved_file);
+}
+
+BOOST_AUTO_TEST_CASE(test_dynamic_index_inserts_with_pq)
+{
+    const std::string index_file = "pq_dynamic_index_test.index";
+    const uint32_t num_built = 150, num_inserted = 100;
+    Pivots pivots;
+    std::vector<float> data;
+    for (size_t i = 0; i < num_built + num_inserted; i++)
+    {
+        const auto v = pivots.vector(i);
+        data.insert(data.end(), v.begin(), v.end());
+    }
+    std::vector<uint32_t> tags(num_built);
+    for (uint32_t i = 0; i < num_built; i++)
+        tags[i] = i + 1;
+
+    auto write_params = std::make_shared<diskann::IndexWriteParameters>(
+        diskann::IndexWriteParametersBuilder(32, 16).with_num_threads(1).build());
+    auto search_params = std::make_shared<diskann::IndexSearchParams>(32, 1);
+
+    // without pivots there is nothing to encode the points with
+    diskann::Index<float> untrained(diskann::Metric::L2, dim, num_points, write_params, search_params, 1, true, true,
+                                    false, true, num_chunks);
+    BOOST_CHECK_THROW(untrained.insert_point(data.data(), 1), diskann::ANNException);
+
+    // a dynamic index saved without PQ, loaded with the pivots next to its data
+    {
+        diskann::Index<float> plain(diskann::Metric::L2, dim, num_points, write_params, search_params, 1, true, true);
+        plain.build(data.data(), num_built, tags);
+        plain.save(index_file.c_str());
+    }
+    pivots.save(index_file + ".data_pq_pivots.bin");
+
+    diskann::Index<float> index(diskann::Metric::L2, dim, num_points, write_params, search_params, 1, true, true,
+                                false, true, num_chunks);
+    index.load(index_file.c_str(), 1, 32);
+    for (uint32_t i = num_built; i < num_built + num_inserted; i++)
+        BOOST_TEST(index.insert_point(data.data() + i * dim, i + 1) == 0);
+
+    std::vector<float *> res_vectors;
+    for (uint32_t i = num_built; i < num_built + num_inserted; i++)
+    {
+        uint32_t tag;
+        float distance;
+        BOOST_TEST(index.search_with_tags(data.data() + i * dim, 1, 32, &tag, &distance, res_vectors) == 1u);
+        BOOST_TEST(tag == i + 1);
+    }
+
+    for (const std::string suffix : {"", ".data", ".tags", ".del", ".data_pq_pivots.bin"})
+        std::remove((index_file + suffix).c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
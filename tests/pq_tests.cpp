@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "index_test_utils.h"
+#include "pq.h"
+
+namespace
+{
+const uint32_t dim = 8;
+const uint32_t num_chunks = 5; // odd, so the last code byte has one chunk
+const uint32_t num_pts = 40;   // two blocks, the second one partial
+
+// writes a 4-bit pivots file the way generate_pq_pivots does
+void write_pivots(const std::string &path, std::mt19937 &gen)
+{
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<float> pivots(NUM_PQ_CENTROIDS_FAST_SCAN * dim);
+    for (auto &v : pivots)
+        v = dis(gen);
+    std::vector<float> centroid(dim, 0.0f);
+    std::vector<uint32_t> chunk_offsets{0, 2, 4, 6, 7, 8};
+
+    index_test_utils::save_pq_pivots(path, pivots, centroid, chunk_offsets);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PQ_tests)
+
+BOOST_AUTO_TEST_CASE(test_transposed_lookup_matches_row_major)
+{
+    std::mt19937 gen(11);
+    const uint32_t n_chunks = 12, n_coords = 100, n_ids = 37;
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> code_dis(0, NUM_PQ_CENTROIDS - 1), id_dis(0, n_coords - 1);
+
+    std::vector<float> pq_dists(NUM_PQ_CENTROIDS * n_chunks);
+    for (auto &v : pq_dists)
+        v = dis(gen);
+    std::vector<uint8_t> all_coords(n_coords * n_chunks);
+    for (auto &c : all_coords)
+        c = (uint8_t)code_dis(gen);
+    std::vector<uint32_t> ids(n_ids);
+    for (auto &id : ids)
+        id = id_dis(gen);
+
+    std::vector<uint8_t> blocks(ROUND_UP(n_ids, PQ_TRANSPOSED_BLOCK) * n_chunks);
+    std::vector<float> dists;
+    diskann::aggregate_coords(ids, all_coords.data(), n_chunks, blocks.data());
+    diskann::pq_dist_lookup(blocks.data(), n_ids, n_chunks, pq_dists.data(), dists);
+
+    BOOST_TEST(dists.size() == n_ids);
+    for (uint32_t i = 0; i < n_ids; i++)
+    {
+        float expected = 0;
+        for (uint32_t c = 0; c < n_chunks; c++)
+            expected += pq_dists[NUM_PQ_CENTROIDS * c + all_coords[ids[i] * n_chunks + c]];
+        BOOST_TEST(std::fabs(dists[i] - expected) <= 1e-5f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_fast_scan_matches_float_tables)
+{
+    std::mt19937 gen(17);
+    const std::string pivots_path = "pq_fast_scan_test_pivots.bin";
+    write_pivots(pivots_path, gen);
+
+    diskann::FixedChunkPQTable table;
+    table.load_pq_centroid_bin(pivots_path.c_str(), num_chunks);
+    BOOST_TEST(table.get_num_centers() == (uint32_t)NUM_PQ_CENTROIDS_FAST_SCAN);
+    BOOST_TEST(table.get_code_len() == 3u);
+
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<float> query(dim);
+    for (auto &v : query)
+        v = dis(gen);
+    table.preprocess_query(query.data());
+    std::vector<float> pq_dists(NUM_PQ_CENTROIDS * num_chunks);
+    table.populate_chunk_distances(query.data(), pq_dists.data());
+
+    // packed codes, and the distances they should give
+    std::uniform_int_distribution<uint32_t> code_dis(0, NUM_PQ_CENTROIDS_FAST_SCAN - 1);
+    std::vector<uint8_t> codes(num_pts * table.get_code_len(), 0);
+    std::vector<float> expected(num_pts, 0.0f);
+    for (uint32_t p = 0; p < num_pts; p++)
+    {
+        for (uint32_t c = 0; c < num_chunks; c++)
+        {
+            const uint32_t code = code_dis(gen);
+            codes[p * table.get_code_len() + c / 2] |= (uint8_t)(code << (4 * (c % 2)));
+            expected[p] += pq_dists[NUM_PQ_CENTROIDS_FAST_SCAN * c + code];
+        }
+    }
+
+    // every entry is rounded to a multiple of the scale
+    float max_range = 0;
+    for (uint32_t c = 0; c < num_chunks; c++)
+    {
+        auto chunk_begin = pq_dists.begin() + NUM_PQ_CENTROIDS_FAST_SCAN * c;
+        auto minmax = std::minmax_element(chunk_begin, chunk_begin + NUM_PQ_CENTROIDS_FAST_SCAN);
+        max_range = (std::max)(max_range, *minmax.second - *minmax.first);
+    }
+    const float tolerance = num_chunks * max_range / 255 / 2 + 1e-4f;
+
+    std::vector<uint32_t> ids(num_pts);
+    for (uint32_t i = 0; i < num_pts; i++)
+        ids[i] = num_pts - 1 - i;
+    std::vector<uint8_t> blocks(ROUND_UP(num_pts, PQ_FAST_SCAN_BLOCK) * table.get_code_len());
+    std::vector<float> dists(num_pts);
+    diskann::aggregate_coords_fast_scan(ids.data(), num_pts, codes.data(), num_chunks, blocks.data());
+    diskann::pq_dist_lookup_fast_scan(blocks.data(), num_pts, num_chunks, pq_dists.data(), dists.data());
+
+    for (uint32_t i = 0; i < num_pts; i++)
+        BOOST_TEST(std::fabs(dists[i] - expected[ids[i]]) <= tolerance);
+
+    std::remove(pivots_path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "in_mem_quantized_data_store.h"
+#include "index_test_utils.h"
+#include "utils.h"
+
+namespace
+{
+const size_t num_points = 200;
+const size_t dim = 37;
+
+float l2(const float *a, const float *b)
+{
+    float sum = 0;
+    for (size_t d = 0; d < dim; d++)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+
+std::unique_ptr<diskann::InMemQuantizedDataStore> make_store(diskann::ScalarQuantization quantization,
+                                                             const std::string &rerank_data_file = "")
+{
+    std::unique_ptr<diskann::Distance<float>> distance(diskann::get_distance_function<float>(diskann::Metric::L2));
+    return std::make_unique<diskann::InMemQuantizedDataStore>((diskann::location_t)num_points, dim, quantization,
+                                                              std::move(distance), rerank_data_file);
+}
+
+// query padded to the aligned dimension, as the index hands it over
+std::vector<float> aligned_query(const diskann::InMemQuantizedDataStore &store, const float *query)
+{
+    std::vector<float> aligned(store.get_aligned_dim(), 0);
+    std::copy(query, query + dim, aligned.begin());
+    return aligned;
+}
+
+void check_distances(diskann::ScalarQuantization quantization, float tolerance)
+{
+    const auto data = index_test_utils::random_vectors(num_points + 1, dim, 11);
+    auto store = make_store(quantization);
+    store->populate_data(data.data(), (diskann::location_t)num_points);
+
+    const float *query = data.data() + num_points * dim;
+    const auto aligned = aligned_query(*store, query);
+    std::vector<diskann::location_t> locations(num_points);
+    std::vector<float> distances(num_points);
+    for (diskann::location_t i = 0; i < num_points; i++)
+        locations[i] = i;
+    store->get_distance(aligned.data(), locations.data(), (uint32_t)num_points, distances.data());
+
+    for (size_t i = 0; i < num_points; i++)
+    {
+        const float exact = l2(query, data.data() + i * dim);
+        BOOST_TEST(std::fabs(distances[i] - exact) <= tolerance * exact);
+        BOOST_TEST(store->get_distance(aligned.data(), (diskann::location_t)i) == distances[i]);
+    }
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(QuantizedDataStore_tests)
+
+BOOST_AUTO_TEST_CASE(test_int8_distances_close_to_exact)
+{
+    check_distances(diskann::ScalarQuantization::INT8, 0.05f);
+}
+
+BOOST_AUTO_TEST_CASE(test_fp16_distances_close_to_exact)
+{
+    check_distances(diskann::ScalarQuantization::FP16, 0.005f);
+}
+
+BOOST_AUTO_TEST_CASE(test_save_and_load_keep_codes)
+{
+    const std::string data_file = "quantized_data_store_test.data";
+    const auto data = index_test_utils::random_vectors(num_points, dim, 11);
+    for (auto quantization : {diskann::ScalarQuantization::INT8, diskann::ScalarQuantization::FP16})
+    {
+        auto store = make_store(quantization);
+        store->populate_data(data.data(), (diskann::location_t)num_points);
+        store->save(data_file, (diskann::location_t)num_points);
+
+        auto loaded = make_store(quantization);
+        BOOST_TEST(loaded->load(data_file) == num_points);
+        std::vector<float> before(dim), after(dim);
+        for (diskann::location_t i = 0; i < num_points; i++)
+        {
+            store->get_vector(i, before.data());
+            loaded->get_vector(i, after.data());
+            BOOST_TEST(l2(before.data(), after.data()) <= 1e-10f);
+        }
+    }
+    std::remove(data_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_resize_keeps_codes)
+{
+    const auto data = index_test_utils::random_vectors(num_points, dim, 11);
+    for (auto quantization : {diskann::ScalarQuantization::INT8, diskann::ScalarQuantization::FP16})
+    {
+        auto store = make_store(quantization);
+        store->populate_data(data.data(), (diskann::location_t)num_points);
+        std::vector<float> before(num_points * dim);
+        for (diskann::location_t i = 0; i < num_points; i++)
+            store->get_vector(i, before.data() + i * dim);
+
+        // capacities whose codes are not a whole number of 64 byte lines
+        for (diskann::location_t capacity : {(diskann::location_t)num_points + 1, (diskann::location_t)num_points - 1})
+        {
+            BOOST_TEST(store->resize(capacity) == capacity);
+            std::vector<float> after(dim);
+            for (diskann::location_t i = 0; i < std::min<diskann::location_t>(capacity, num_points); i++)
+            {
+                store->get_vector(i, after.data());
+                BOOST_TEST(l2(before.data() + i * dim, after.data()) == 0.0f);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_set_vector_needs_trained_int8_ranges)
+{
+    const auto data = index_test_utils::random_vectors(1, dim, 11);
+    auto store = make_store(diskann::ScalarQuantization::INT8);
+    BOOST_CHECK_THROW(store->set_vector(0, data.data()), diskann::ANNException);
+    make_store(diskann::ScalarQuantization::FP16)->set_vector(0, data.data());
+}
+
+BOOST_AUTO_TEST_CASE(test_full_precision_distances_from_rerank_file)
+{
+    const std::string data_file = "quantized_data_store_rerank_test.bin";
+    const auto data = index_test_utils::random_vectors(num_points + 1, dim, 11);
+    // the last point is added after the file was written
+    diskann::save_bin<float>(data_file, (float *)data.data(), num_points - 1, dim);
+
+    auto store = make_store(diskann::ScalarQuantization::INT8, data_file);
+    store->populate_data(data.data(), (diskann::location_t)num_points);
+    const float *query = data.data() + num_points * dim;
+    const auto aligned = aligned_query(*store, query);
+    std::vector<float> vector_scratch(store->get_aligned_dim(), 0);
+
+    std::vector<diskann::location_t> locations{3, 150, 42, (diskann::location_t)num_points - 1};
+    std::vector<float> distances(locations.size());
+    BOOST_TEST(store->get_full_precision_distance(aligned.data(), locations.data(), (uint32_t)locations.size(),
+                                                  distances.data(), vector_scratch.data()));
+    for (size_t i = 0; i + 1 < locations.size(); i++)
+    {
+        const float exact = l2(query, data.data() + locations[i] * dim);
+        BOOST_TEST(std::fabs(distances[i] - exact) <= 1e-4f * exact);
+    }
+    BOOST_TEST(distances.back() == (std::numeric_limits<float>::max)());
+
+    BOOST_TEST(!make_store(diskann::ScalarQuantization::INT8)
+                    ->get_full_precision_distance(aligned.data(), locations.data(), 1, distances.data(),
+                                                  vector_scratch.data()));
+    std::remove(data_file.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "index_factory.h"
+#include "index_test_utils.h"
+
+namespace
+{
+std::shared_ptr<diskann::IndexWriteParameters> write_params()
+{
+    return std::make_shared<diskann::IndexWriteParameters>(
+        diskann::IndexWriteParametersBuilder(64, 32).with_num_threads(1).build());
+}
+
+struct RangeSearchFixture : index_test_utils::InMemIndexFixture
+{
+    RangeSearchFixture() : InMemIndexFixture(7)
+    {
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(RangeSearch_tests, RangeSearchFixture)
+
+BOOST_AUTO_TEST_CASE(test_finds_points_in_range)
+{
+    const float *query = data.data() + 3 * dim;
+    const auto truth = brute_force(query);
+    // 40 points in range, far more than the first L of 4 can hold
+    const float range = (truth[39].first + truth[40].first) / 2;
+
+    std::vector<uint32_t> indices;
+    std::vector<float> distances;
+    std::vector<uint32_t> result_tags;
+    const uint32_t num_results = index->range_search(query, range, 4, 256, indices, distances, &result_tags);
+
+    BOOST_TEST(num_results == indices.size());
+    BOOST_TEST(num_results == distances.size());
+    BOOST_TEST(num_results == result_tags.size());
+    BOOST_TEST(num_results <= 40u);
+    BOOST_TEST(num_results >= 36u);
+    BOOST_TEST(std::is_sorted(distances.begin(), distances.end()));
+
+    std::set<uint32_t> in_range;
+    for (size_t i = 0; i < 40; i++)
+        in_range.insert(truth[i].second);
+    for (uint32_t i = 0; i < num_results; i++)
+    {
+        BOOST_TEST(distances[i] <= range);
+        BOOST_TEST(in_range.count(indices[i]) == 1u);
+        BOOST_TEST(result_tags[i] == indices[i] + tag_offset);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_stops_at_max_l_search)
+{
+    // every point is in range, L can not grow past max_l_search
+    std::vector<uint64_t> indices;
+    std::vector<float> distances;
+    BOOST_TEST(index->range_search(data.data(), 1000.0f, 8, 50, indices, distances) == 50u);
+    BOOST_TEST(indices.size() == 50u);
+
+    // nothing is in range
+    BOOST_TEST(index->range_search(data.data() + dim, -1.0f, 8, 50, indices, distances) == 0u);
+    BOOST_TEST(indices.empty());
+    BOOST_TEST(distances.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_l_search)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float> distances;
+    BOOST_CHECK_THROW(index->range_search(data.data(), 1.0f, 0, 50, indices, distances), diskann::ANNException);
+    BOOST_CHECK_THROW(index->range_search(data.data(), 1.0f, 64, 50, indices, distances), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_CASE(test_points_not_reranked_are_kept)
+{
+    // the re-rank file holds the first half of the points, the others keep
+    // their quantized distances and come after the reranked candidates
+    const std::string rerank_file = "range_search_rerank_test.bin";
+    diskann::save_bin<float>(rerank_file, data.data(), num_points / 2, dim);
+    auto config = diskann::IndexConfigBuilder()
+                      .with_metric(diskann::Metric::L2)
+                      .with_dimension(dim)
+                      .with_max_points(num_points)
+                      .with_data_load_store_strategy(diskann::DataStoreStrategy::QUANTIZED_INT8)
+                      .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                      .with_rerank_data_file(rerank_file)
+                      .with_data_type("float")
+                      .is_dynamic_index(false)
+                      .with_index_write_params(write_params())
+                      .with_index_search_params(std::make_shared<diskann::IndexSearchParams>(16, 1))
+                      .is_enable_tags(false)
+                      .build();
+    diskann::Index<float> quantized_index(
+        config,
+        diskann::IndexFactory::construct_datastore<float>(diskann::DataStoreStrategy::QUANTIZED_INT8, num_points, dim,
+                                                          diskann::Metric::L2, rerank_file),
+        diskann::IndexFactory::construct_graphstore(diskann::GraphStoreStrategy::MEMORY, num_points, 64));
+    quantized_index.build(data.data(), num_points, std::vector<uint32_t>());
+
+    const uint32_t query_id = (uint32_t)num_points - 1;
+    const float *query = data.data() + query_id * dim;
+    const auto truth = brute_force(query);
+    const float range = (truth[19].first + truth[20].first) / 2;
+
+    std::vector<uint32_t> indices;
+    std::vector<float> distances;
+    quantized_index.range_search(query, range, 64, 64, indices, distances);
+    BOOST_TEST((std::find(indices.begin(), indices.end(), query_id) != indices.end()));
+    // the reranked points, sorted, then the others, sorted on their own scale
+    const auto first_not_reranked =
+        std::find_if(indices.begin(), indices.end(), [](uint32_t id) { return id >= num_points / 2; });
+    const size_t num_reranked = first_not_reranked - indices.begin();
+    BOOST_TEST(std::all_of(first_not_reranked, indices.end(), [](uint32_t id) { return id >= num_points / 2; }));
+    BOOST_TEST(std::is_sorted(distances.begin(), distances.begin() + num_reranked));
+    BOOST_TEST(std::is_sorted(distances.begin() + num_reranked, distances.end()));
+    BOOST_TEST(indices.size() - num_reranked > 1u);
+    for (size_t i = 0; i < indices.size(); i++)
+        BOOST_TEST(distances[i] <= range);
+    std::remove(rerank_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_skips_deleted_points)
+{
+    auto search_params = std::make_shared<diskann::IndexSearchParams>(16, 1);
+    diskann::Index<float> dynamic_index(diskann::Metric::L2, dim, num_points, write_params(), search_params, 1, true,
+                                        true);
+    dynamic_index.build(data.data(), num_points, tags);
+    BOOST_TEST(dynamic_index.lazy_delete(tags[3]) == 0);
+
+    // with or without tags asked for
+    std::vector<uint32_t> indices, result_tags;
+    std::vector<float> distances;
+    BOOST_TEST(dynamic_index.range_search(data.data() + 3 * dim, 1000.0f, 32, 32, indices, distances) > 0u);
+    BOOST_TEST((std::find(indices.begin(), indices.end(), 3u) == indices.end()));
+    BOOST_TEST(dynamic_index.range_search(data.data() + 3 * dim, 1000.0f, 32, 32, indices, distances,
+                                          &result_tags) > 0u);
+    BOOST_TEST((std::find(indices.begin(), indices.end(), 3u) == indices.end()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "index_test_utils.h"
+#include "search_iterator.h"
+
+namespace
+{
+struct SearchIteratorFixture : index_test_utils::InMemIndexFixture
+{
+    SearchIteratorFixture() : InMemIndexFixture(11)
+    {
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(SearchIterator_tests, SearchIteratorFixture)
+
+BOOST_AUTO_TEST_CASE(test_pages_follow_search)
+{
+    const float *query = data.data() + 5 * dim;
+    const auto truth = brute_force(query);
+
+    diskann::IndexSearchIterator<float> iterator(*index, 20);
+    iterator.start(query);
+
+    std::vector<uint32_t> indices;
+    std::vector<float> distances;
+    std::vector<uint32_t> result_tags;
+    std::set<uint32_t> returned;
+    for (uint32_t page = 0; page < 5; page++)
+    {
+        BOOST_TEST(iterator.next(10, indices, distances, &result_tags) == 10u);
+        BOOST_TEST(indices.size() == 10u);
+        BOOST_TEST(distances.size() == 10u);
+        BOOST_TEST(std::is_sorted(distances.begin(), distances.end()));
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            BOOST_TEST(result_tags[i] == indices[i] + tag_offset);
+            BOOST_TEST(returned.insert(indices[i]).second);
+        }
+    }
+    BOOST_TEST(iterator.num_returned() == 50u);
+
+    // the 50 results are close to the 50 nearest points
+    size_t hits = 0;
+    for (size_t i = 0; i < 50; i++)
+        hits += returned.count(truth[i].second);
+    BOOST_TEST(hits >= 45u);
+}
+
+BOOST_AUTO_TEST_CASE(test_runs_out_of_points)
+{
+    diskann::IndexSearchIterator<float> iterator(*index, 64);
+    iterator.start(data.data());
+
+    std::vector<uint64_t> indices;
+    std::vector<float> distances;
+    std::set<uint64_t> returned;
+    uint32_t num_results;
+    while ((num_results = iterator.next(300, indices, distances)) > 0)
+    {
+        BOOST_TEST(num_results == indices.size());
+        for (auto id : indices)
+            BOOST_TEST(returned.insert(id).second);
+    }
+    BOOST_TEST(returned.size() == num_points);
+    BOOST_TEST(indices.empty());
+
+    // start() reuses the iterator for another query
+    iterator.start(data.data() + dim);
+    BOOST_TEST(iterator.num_returned() == 0u);
+    BOOST_TEST(iterator.next(5, indices, distances) == 5u);
+    BOOST_TEST(indices[0] == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(test_next_before_start)
+{
+    diskann::IndexSearchIterator<float> iterator(*index, 16);
+    std::vector<uint32_t> indices;
+    std::vector<float> distances;
+    BOOST_CHECK_THROW(iterator.next(10, indices, distances), diskann::ANNException);
+    BOOST_CHECK_THROW(diskann::IndexSearchIterator<float>(*index, 0), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
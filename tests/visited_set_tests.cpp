@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "visited_set.h"
+
+BOOST_AUTO_TEST_SUITE(VisitedSet_tests)
+
+BOOST_AUTO_TEST_CASE(test_exact_sets_across_clears)
+{
+    const uint64_t num_points = 1000;
+    for (auto type :
+         {diskann::VisitedSetType::HASH_SET, diskann::VisitedSetType::EPOCH_ARRAY, diskann::VisitedSetType::BITSET})
+    {
+        diskann::VisitedSet visited;
+        visited.init(type, num_points, 16);
+        // enough queries for the 16-bit epoch to wrap around
+        for (uint32_t query = 0; query < 70000; query++)
+        {
+            const uint64_t id = (query * 37) % num_points;
+            BOOST_REQUIRE(!visited.contains(id));
+            BOOST_REQUIRE(visited.insert(id));
+            BOOST_REQUIRE(!visited.insert(id));
+            BOOST_REQUIRE(visited.contains(id));
+            BOOST_REQUIRE(!visited.contains((id + 1) % num_points));
+            visited.clear();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_bloom_filter_has_no_false_negatives)
+{
+    diskann::VisitedSet visited;
+    visited.init(diskann::VisitedSetType::BLOOM_FILTER, 1ULL << 40, 4096);
+
+    std::mt19937_64 gen{9};
+    std::vector<uint64_t> ids(4096);
+    for (auto &id : ids)
+        id = gen() >> 24;
+    for (auto id : ids)
+        visited.insert(id);
+    for (auto id : ids)
+        BOOST_TEST(visited.contains(id));
+
+    uint32_t false_positives = 0;
+    for (uint32_t i = 0; i < 10000; i++)
+        false_positives += visited.contains(gen() >> 24) ? 1 : 0;
+    BOOST_TEST(false_positives < 100);
+
+    visited.clear();
+    for (auto id : ids)
+        BOOST_TEST(visited.insert(id));
+}
+
+BOOST_AUTO_TEST_CASE(test_choose_and_covers)
+{
+    // the budget is shared by all scratches
+    BOOST_TEST((diskann::VisitedSet::choose(1000, 1, 1 << 20) == diskann::VisitedSetType::EPOCH_ARRAY));
+    BOOST_TEST((diskann::VisitedSet::choose(1000, 1024, 1 << 20) == diskann::VisitedSetType::BITSET));
+    BOOST_TEST((diskann::VisitedSet::choose(1000, 1 << 20, 1 << 20) == diskann::VisitedSetType::HASH_SET));
+    BOOST_TEST((diskann::VisitedSet::choose(1ULL << 30, 1, 1ULL << 40) == diskann::VisitedSetType::EPOCH_ARRAY));
+    BOOST_TEST((diskann::VisitedSet::choose(1ULL << 30, 1, 1ULL << 20) == diskann::VisitedSetType::HASH_SET));
+    // bloom filters only when allowed, and only for billion-scale indices
+    BOOST_TEST((diskann::VisitedSet::choose(1ULL << 30, 1, 1ULL << 20, true) == diskann::VisitedSetType::BLOOM_FILTER));
+    BOOST_TEST((diskann::VisitedSet::choose(1ULL << 24, 1, 1ULL << 20, true) == diskann::VisitedSetType::HASH_SET));
+
+    diskann::VisitedSet visited;
+    BOOST_TEST(!visited.covers(0));
+    visited.init(diskann::VisitedSetType::EPOCH_ARRAY, 100, 0);
+    BOOST_TEST(visited.covers(100));
+    BOOST_TEST(!visited.covers(101));
+    visited.init(diskann::VisitedSetType::BITSET, 100, 0);
+    BOOST_TEST(visited.covers(100));
+    BOOST_TEST(!visited.covers(101));
+    visited.init(diskann::VisitedSetType::HASH_SET, 0, 10);
+    BOOST_TEST(visited.covers(1ULL << 40));
+}
+
+BOOST_AUTO_TEST_SUITE_END()